@@ -18,6 +18,12 @@ option ( ENABLE_STATIC_DAQ "link static DAQ modules" ON )
 option ( ENABLE_SHELL "enable shell support" OFF )
 option ( ENABLE_UNIT_TESTS "enable unit tests" OFF )
 option ( ENABLE_PIGLET "enable piglet test harness" OFF )
+option ( ENABLE_BENCHMARKS "enable snort_bench benchmark target (implies unit tests)" OFF )
+
+# benchmarks are built into the unit test cases
+if ( ENABLE_BENCHMARKS )
+    set ( ENABLE_UNIT_TESTS ON )
+endif ( ENABLE_BENCHMARKS )
 
 option ( ENABLE_COREFILES "Prevent Snort from generating core files" ON )
 option ( ENABLE_LARGE_PCAP "Enable support for pcaps larger than 2 GB" OFF )
@@ -14,6 +14,7 @@ test_big_endian(WORDS_BIGENDIAN)
 #--------------------------------------------------------------------------
 
 check_function_exists(malloc_trim HAVE_MALLOC_TRIM)
+check_function_exists(mallinfo2 HAVE_MALLINFO2)
 check_function_exists(memrchr HAVE_MEMRCHR)
 check_function_exists(sigaction HAVE_SIGACTION)
 check_function_exists(basename_r HAVE_BASENAME_R)
@@ -141,6 +142,14 @@ if (HS_FOUND)
     endif()
 endif()
 
+# zlib-ng built with ZLIB_COMPAT is a drop-in replacement for zlib with
+# vectorized inflate; note it so the version banner reports what is in use
+cmake_push_check_state(RESET)
+set(CMAKE_REQUIRED_INCLUDES ${ZLIB_INCLUDE_DIRS})
+set(CMAKE_REQUIRED_LIBRARIES ${ZLIB_LIBRARIES})
+check_symbol_exists(zlibng_version "zlib.h" HAVE_ZLIB_NG)
+cmake_pop_check_state()
+
 if (DEFINED LIBLZMA_LIBRARIES)
     check_library_exists (${LIBLZMA_LIBRARIES} lzma_code "" HAVE_LZMA)
 endif()
@@ -66,6 +66,7 @@ Optional Features:
                             enable third party appid
     --enable-unit-tests     build unit tests
     --enable-piglet         build piglet test harness
+    --enable-benchmarks     build unit tests and the snort_bench target
     --disable-static-daq    link static DAQ modules
     --disable-html-docs     don't create the HTML documentation
     --disable-pdf-docs      don't create the PDF documentation
@@ -318,6 +319,12 @@ while [ $# -ne 0 ]; do
         --disable-piglet)
             append_cache_entry ENABLE_PIGLET            BOOL false
             ;;
+        --enable-benchmarks)
+            append_cache_entry ENABLE_BENCHMARKS        BOOL true
+            ;;
+        --disable-benchmarks)
+            append_cache_entry ENABLE_BENCHMARKS        BOOL false
+            ;;
         --disable-static-daq)
             append_cache_entry ENABLE_STATIC_DAQ        BOOL false
             ;;
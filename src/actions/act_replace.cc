@@ -26,6 +26,7 @@
 #include "framework/module.h"
 #include "packet_io/active.h"
 #include "protocols/packet.h"
+#include "protocols/packet_manager.h"
 
 using namespace snort;
 
@@ -49,23 +50,19 @@ static inline void Replace_ApplyChange(Packet* p, std::string& data, unsigned of
     else
         len = data.size();
 
+    std::string old((const char*)start, len);
     memcpy(start, data.c_str(), len);
+
+    PacketManager::encode_rewrite(p, start, (const uint8_t*)old.c_str(), len);
 }
 
 static void Replace_ModifyPacket(Packet* p)
 {
     std::string data;
     unsigned offset;
-    bool modified = false;
 
     while ( DetectionEngine::get_replacement(data, offset) )
-    {
-        modified = true;
         Replace_ApplyChange(p, data, offset);
-    }
-
-    if ( modified )
-        p->packet_flags |= PKT_MODIFIED;
 
     DetectionEngine::clear_replacement();
 }
@@ -30,6 +30,8 @@ using namespace snort;
 
 static bool s_catch = false;
 static std::vector<std::string> test_tags;
+static std::string reporter;
+static std::string output;
 
 void catch_set_filter(const char* s)
 {
@@ -39,6 +41,12 @@ void catch_set_filter(const char* s)
     s_catch = true;
 }
 
+void catch_set_reporter(const char* s)
+{ reporter = s; }
+
+void catch_set_output(const char* s)
+{ output = s; }
+
 bool catch_enabled()
 {
     return s_catch;
@@ -51,6 +59,12 @@ static bool run_catch()
     if ( !test_tags.empty() )
         session.configData().testsOrTags = test_tags;
 
+    if ( !reporter.empty() )
+        session.configData().reporterName = reporter;
+
+    if ( !output.empty() )
+        session.configData().outputFilename = output;
+
     return session.run() == 0;
 }
 
@@ -25,6 +25,8 @@
 // Unit test interface
 
 void catch_set_filter(const char* s);
+void catch_set_reporter(const char* s);
+void catch_set_output(const char* s);
 
 bool catch_enabled();
 
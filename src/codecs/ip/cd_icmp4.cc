@@ -129,6 +129,9 @@ void Icmp4Codec::get_protocol_ids(std::vector<ProtocolId>& v)
 
 inline bool Icmp4Codec::valid_checksum_from_daq(const RawData& raw)
 {
+    if ( !SnortConfig::checksum_trust_daq() )
+        return false;
+
     const DAQ_PktDecodeData_t* pdd =
         (const DAQ_PktDecodeData_t*) daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_DECODE_DATA);
     if (!pdd || !pdd->flags.bits.l4_checksum || !pdd->flags.bits.icmp || !pdd->flags.bits.l4)
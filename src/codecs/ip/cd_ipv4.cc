@@ -131,6 +131,9 @@ private:
 
 inline bool Ipv4Codec::valid_checksum_from_daq(const RawData& raw)
 {
+    if ( !SnortConfig::checksum_trust_daq() )
+        return false;
+
     const DAQ_PktDecodeData_t* pdd =
         (const DAQ_PktDecodeData_t*) daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_DECODE_DATA);
     if (!pdd || !pdd->flags.bits.l3_checksum || !pdd->flags.bits.ipv4 || !pdd->flags.bits.l3)
@@ -237,6 +237,9 @@ private:
 
 inline bool UdpCodec::valid_checksum_from_daq(const RawData& raw)
 {
+    if ( !SnortConfig::checksum_trust_daq() )
+        return false;
+
     const DAQ_PktDecodeData_t* pdd =
         (const DAQ_PktDecodeData_t*) daq_msg_get_meta(raw.daq_msg, DAQ_PKT_META_DECODE_DATA);
     if (!pdd || !pdd->flags.bits.l4_checksum || !pdd->flags.bits.udp || !pdd->flags.bits.l4)
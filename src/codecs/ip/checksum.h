@@ -23,6 +23,11 @@
 #include <cstddef>
 
 #include <protocols/protocol_ids.h>
+#include <utils/cpu_features.h>
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
 
 namespace checksum
 {
@@ -64,6 +69,13 @@ inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len, const Pseudohea
 inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len);
 inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
 
+//  rfc 1624 incremental update of a checksum after data it covers changed.
+//  odd is true if the changed range starts at an odd offset from the start
+//  of the checksummed data.  a bad checksum stays bad.
+inline uint16_t cksum_update(uint16_t cksum, uint16_t old_word, uint16_t new_word);
+inline uint16_t cksum_update(uint16_t cksum, const uint16_t* old_buf, const uint16_t* new_buf,
+    std::size_t len, bool odd = false);
+
 /*
  *  NOTE: Since multiple dynamic libraries use checksums, the choice
  *          is to either include all of the checksum details in a header,
@@ -79,7 +91,81 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
  */
 namespace detail
 {
-inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+#ifdef HAVE_X86_SIMD
+// these sum the 16 bit words of whole 16 or 32 byte blocks into 32 bit lanes
+// and advance buf and len past them.  the result is folded to 16 bits.  the
+// lanes can't overflow for anything up to 256K bytes, well beyond an IP
+// datagram.  unaligned loads are fine since the words are summed in memory
+// order, same as the scalar loop.
+inline uint16_t fold_lanes(const uint32_t* lanes, unsigned n)
+{
+    uint64_t sum = 0;
+
+    for ( unsigned i = 0; i < n; ++i )
+        sum += lanes[i];
+
+    while ( sum >> 16 )
+        sum = (sum >> 16) + (sum & 0xffff);
+
+    return (uint16_t)sum;
+}
+
+SIMD_TARGET("sse2")
+inline uint16_t add_sse2(const uint16_t*& buf, std::size_t& len)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(buf);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+
+    while ( len >= 16 )
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+        acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+        b += 16;
+        len -= 16;
+    }
+    buf = reinterpret_cast<const uint16_t*>(b);
+
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return fold_lanes(lanes, 4);
+}
+
+SIMD_TARGET("avx2")
+inline uint16_t add_avx2(const uint16_t*& buf, std::size_t& len)
+{
+    const uint8_t* b = reinterpret_cast<const uint8_t*>(buf);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+
+    while ( len >= 32 )
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+        acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+        b += 32;
+        len -= 32;
+    }
+    buf = reinterpret_cast<const uint16_t*>(b);
+
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return fold_lanes(lanes, 8);
+}
+
+// 2 = avx2, 1 = sse2, 0 = neither
+inline int simd_level()
+{
+    static const int level = snort::cpu_has_avx2() ? 2 : (snort::cpu_has_sse2() ? 1 : 0);
+    return level;
+}
+#endif
+
+// shorter buffers (most headers) are summed faster without the vector setup
+constexpr std::size_t simd_min_len = 64;
+
+inline uint16_t cksum_add_scalar(const uint16_t* buf, std::size_t len, uint32_t cksum)
 {
     const uint16_t* sp = buf;
 
@@ -169,6 +255,33 @@ inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
     return (uint16_t)(~cksum);
 }
 
+inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+{
+#ifdef HAVE_X86_SIMD
+    if ( len >= simd_min_len )
+    {
+        const int level = simd_level();
+
+        if ( level > 1 )
+            cksum += add_avx2(buf, len);
+
+        else if ( level > 0 )
+            cksum += add_sse2(buf, len);
+    }
+#endif
+    return cksum_add_scalar(buf, len, cksum);
+}
+
+inline uint16_t swap_bytes(uint16_t w)
+{ return (uint16_t)((w << 8) | (w >> 8)); }
+
+inline uint16_t fold(uint32_t sum)
+{
+    sum = (sum >> 16) + (sum & 0x0000ffff);
+    sum += (sum >> 16);
+    return (uint16_t)sum;
+}
+
 inline void add_ipv4_pseudoheader(const Pseudoheader& ph4, uint32_t& cksum)
 {
     const uint16_t* h = ph4.arr;
@@ -328,6 +441,35 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len)
 
 inline uint16_t cksum_add(const uint16_t* buf, std::size_t len)
 { return detail::cksum_add(buf, len, 0); }
+
+// HC' = ~(~HC + ~m + m'), eqn 3 of rfc 1624
+inline uint16_t cksum_update(uint16_t cksum, uint16_t old_word, uint16_t new_word)
+{
+    uint32_t sum = (uint16_t)~cksum;
+    sum += (uint16_t)~old_word;
+    sum += new_word;
+    return (uint16_t)~detail::fold(sum);
+}
+
+// the words of a range starting at an odd offset are byte swapped relative
+// to the checksummed data, and so is their ones' complement sum (rfc 1071)
+inline uint16_t cksum_update(uint16_t cksum, const uint16_t* old_buf, const uint16_t* new_buf,
+    std::size_t len, bool odd)
+{
+    uint16_t old_sum = detail::cksum_add(old_buf, len, 0);             // ~m
+    uint16_t new_sum = (uint16_t)~detail::cksum_add(new_buf, len, 0);  // m'
+
+    if ( odd )
+    {
+        old_sum = detail::swap_bytes(old_sum);
+        new_sum = detail::swap_bytes(new_sum);
+    }
+
+    uint32_t sum = (uint16_t)~cksum;
+    sum += old_sum;
+    sum += new_sum;
+    return (uint16_t)~detail::fold(sum);
+}
 } // namespace checksum
 
 #endif  /* CODECS_CHECKSUM_H */
@@ -63,7 +63,7 @@ enum fd_ZIP_states
 struct fd_ZIP_t
 {
     // zlib stream
-    z_stream Stream;
+    z_stream* Stream;
 
     // decompression progress
     unsigned progress;
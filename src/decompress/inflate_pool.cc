@@ -0,0 +1,368 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "inflate_pool.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "latency/latency_config.h"
+#include "latency/latency_stats.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "time/clock_defs.h"
+
+#ifdef UNIT_TEST
+#include <vector>
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+// the z_stream must be the first member so that the pointers handed out by
+// acquire() can be converted back to the containing PooledStream
+struct PooledStream
+{
+    z_stream zs;
+    hr_duration elapsed;
+    PooledStream* next;
+    bool over_budget;
+};
+
+// enough for a few concurrent sessions per thread without holding much
+// memory after a burst of compressed traffic subsides
+static const unsigned max_idle = 32;
+
+static THREAD_LOCAL PooledStream* idle = nullptr;
+static THREAD_LOCAL unsigned num_idle = 0;
+static THREAD_LOCAL bool closed = false;
+
+static inline PooledStream* get_pooled(z_stream* zs)
+{ return reinterpret_cast<PooledStream*>(zs); }
+
+static inline void free_pooled(PooledStream* ps)
+{
+    inflateEnd(&ps->zs);
+    delete ps;
+}
+
+static inline const DecompressLatencyConfig* get_budget()
+{
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( !sc or !sc->latency or !sc->latency->decompress_latency.enabled() )
+        return nullptr;
+
+    return &sc->latency->decompress_latency;
+}
+
+// the budget can run out on a call that ends the stream or fails; the
+// stream is counted once, when its exhaustion is first reported
+static inline int exceeded(PooledStream* ps)
+{
+    if ( !ps->over_budget )
+    {
+        ps->over_budget = true;
+        ++latency_stats.decompress_timeouts;
+    }
+    return Z_BUDGET_EXCEEDED;
+}
+
+z_stream* InflatePool::acquire(int window_bits)
+{
+    PooledStream* ps = idle;
+
+    if ( ps )
+    {
+        idle = ps->next;
+        --num_idle;
+
+        // inflateReset2() keeps the state and the window unless the window
+        // size changes; it fails only if window_bits is invalid
+        if ( inflateReset2(&ps->zs, window_bits) != Z_OK )
+        {
+            free_pooled(ps);
+            return nullptr;
+        }
+        ps->zs.next_in = Z_NULL;
+        ps->zs.avail_in = 0;
+    }
+    else
+    {
+        // value initialization clears zalloc, zfree, and opaque
+        ps = new PooledStream();
+
+        if ( inflateInit2(&ps->zs, window_bits) != Z_OK )
+        {
+            delete ps;
+            return nullptr;
+        }
+    }
+    ps->elapsed = CLOCK_ZERO;
+    ps->next = nullptr;
+    ps->over_budget = false;
+
+    return &ps->zs;
+}
+
+void InflatePool::release(z_stream* zs)
+{
+    if ( !zs )
+        return;
+
+    PooledStream* ps = get_pooled(zs);
+
+    if ( closed or num_idle >= max_idle )
+    {
+        free_pooled(ps);
+        return;
+    }
+    ps->next = idle;
+    idle = ps;
+    ++num_idle;
+}
+
+bool InflatePool::reset(z_stream* zs, int window_bits)
+{
+    assert(zs);
+    PooledStream* ps = get_pooled(zs);
+    ps->elapsed = CLOCK_ZERO;
+    ps->over_budget = false;
+    return inflateReset2(zs, window_bits) == Z_OK;
+}
+
+int InflatePool::inflate(z_stream* zs, int flush)
+{
+    const DecompressLatencyConfig* budget = get_budget();
+
+    if ( !budget )
+        return ::inflate(zs, flush);
+
+    PooledStream* ps = get_pooled(zs);
+
+    if ( ps->elapsed > budget->max_time )
+        return exceeded(ps);
+
+    auto start = SnortClock::now();
+    int ret = ::inflate(zs, flush);
+    ps->elapsed += SnortClock::now() - start;
+
+    if ( ret == Z_OK and ps->elapsed > budget->max_time )
+        return exceeded(ps);
+
+    return ret;
+}
+
+void InflatePool::tterm()
+{
+    while ( idle )
+    {
+        PooledStream* ps = idle;
+        idle = ps->next;
+        free_pooled(ps);
+    }
+    num_idle = 0;
+    closed = true;
+}
+
+unsigned InflatePool::get_idle()
+{ return num_idle; }
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static std::vector<uint8_t> deflate_body(const std::string& body, int window_bits)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    REQUIRE(deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits, 8,
+        Z_DEFAULT_STRATEGY) == Z_OK);
+
+    std::vector<uint8_t> out(deflateBound(&zs, body.size()));
+    zs.next_in = (Bytef*)body.c_str();
+    zs.avail_in = body.size();
+    zs.next_out = out.data();
+    zs.avail_out = out.size();
+
+    REQUIRE(deflate(&zs, Z_FINISH) == Z_STREAM_END);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    return out;
+}
+
+static size_t inflate_body(z_stream* zs, const std::vector<uint8_t>& in, uint8_t* out, size_t len)
+{
+    zs->next_in = const_cast<Bytef*>(in.data());
+    zs->avail_in = in.size();
+    zs->next_out = out;
+    zs->avail_out = len;
+
+    int ret = InflatePool::inflate(zs, Z_SYNC_FLUSH);
+    CHECK(ret == Z_STREAM_END);
+
+    return len - zs->avail_out;
+}
+
+static std::string make_body(unsigned n)
+{
+    std::string s;
+
+    for ( unsigned i = 0; i < n; ++i )
+        s += "<tr><td>" + std::to_string(i * 7919 % 1000) + "</td><td>row</td></tr>\n";
+
+    return s;
+}
+
+TEST_CASE("inflate_pool reuse", "[inflate_pool]")
+{
+    const std::string body = make_body(100);
+    const std::vector<uint8_t> gz = deflate_body(body, 31);
+    const std::vector<uint8_t> raw = deflate_body(body, -15);
+    uint8_t out[8192];
+
+    z_stream* zs = InflatePool::acquire(31);
+    REQUIRE(zs);
+    CHECK(inflate_body(zs, gz, out, sizeof(out)) == body.size());
+    CHECK(!memcmp(out, body.c_str(), body.size()));
+
+    unsigned idle_before = InflatePool::get_idle();
+    InflatePool::release(zs);
+    CHECK(InflatePool::get_idle() == idle_before + 1);
+
+    // a released state is reset for a different format
+    z_stream* zs2 = InflatePool::acquire(-15);
+    REQUIRE(zs2 == zs);
+    CHECK(zs2->total_in == 0);
+    CHECK(inflate_body(zs2, raw, out, sizeof(out)) == body.size());
+    CHECK(!memcmp(out, body.c_str(), body.size()));
+
+    InflatePool::release(zs2);
+    InflatePool::release(nullptr);
+}
+
+TEST_CASE("inflate_pool bad window", "[inflate_pool]")
+{
+    CHECK(InflatePool::acquire(99) == nullptr);
+}
+
+TEST_CASE("inflate_pool budget", "[inflate_pool]")
+{
+    SnortConfig* sc = SnortConfig::get_conf();
+    LatencyConfig* saved = sc->latency;
+    LatencyConfig lc;
+    lc.decompress_latency.max_time = hr_duration(1);
+    sc->latency = &lc;
+
+    const std::vector<uint8_t> gz = deflate_body(make_body(1000), 31);
+    uint8_t out[256];
+    PegCount timeouts = latency_stats.decompress_timeouts;
+
+    z_stream* zs = InflatePool::acquire(31);
+    REQUIRE(zs);
+    zs->next_in = const_cast<Bytef*>(gz.data());
+    zs->avail_in = gz.size();
+    zs->next_out = out;
+    zs->avail_out = sizeof(out);
+
+    // the output of the call that ran out of budget is kept
+    CHECK(InflatePool::inflate(zs, Z_SYNC_FLUSH) == Z_BUDGET_EXCEEDED);
+    CHECK(zs->avail_out == 0);
+
+    zs->next_out = out;
+    zs->avail_out = sizeof(out);
+    CHECK(InflatePool::inflate(zs, Z_SYNC_FLUSH) == Z_BUDGET_EXCEEDED);
+    CHECK(zs->avail_out == sizeof(out));
+    CHECK(latency_stats.decompress_timeouts == timeouts + 1);
+
+    // a reset stream gets a new budget
+    REQUIRE(InflatePool::reset(zs, 31));
+    zs->next_in = const_cast<Bytef*>(gz.data());
+    zs->avail_in = gz.size();
+    CHECK(InflatePool::inflate(zs, Z_SYNC_FLUSH) == Z_BUDGET_EXCEEDED);
+    CHECK(latency_stats.decompress_timeouts == timeouts + 2);
+
+    InflatePool::release(zs);
+    sc->latency = saved;
+}
+
+TEST_CASE("inflate_pool throughput", "[inflate_pool][.benchmark]")
+{
+    // corpus of compressed bodies of varying sizes and formats
+    std::vector<std::vector<uint8_t>> corpus;
+    std::vector<int> bits;
+    size_t max_len = 0;
+
+    for ( unsigned n : { 10, 100, 1000, 5000 } )
+    {
+        std::string body = make_body(n);
+        max_len = std::max(max_len, body.size());
+
+        for ( int w : { 31, 15, -15 } )
+        {
+            corpus.emplace_back(deflate_body(body, w));
+            bits.emplace_back(w);
+        }
+    }
+    std::vector<uint8_t> out(max_len);
+
+    BENCHMARK("fresh inflateInit2")
+    {
+        size_t total = 0;
+        for ( unsigned i = 0; i < corpus.size(); ++i )
+        {
+            z_stream zs;
+            memset(&zs, 0, sizeof(zs));
+            inflateInit2(&zs, bits[i]);
+            zs.next_in = corpus[i].data();
+            zs.avail_in = corpus[i].size();
+            zs.next_out = out.data();
+            zs.avail_out = out.size();
+            ::inflate(&zs, Z_SYNC_FLUSH);
+            total += zs.total_out;
+            inflateEnd(&zs);
+        }
+        return total;
+    };
+
+    BENCHMARK("pooled")
+    {
+        size_t total = 0;
+        for ( unsigned i = 0; i < corpus.size(); ++i )
+        {
+            z_stream* zs = InflatePool::acquire(bits[i]);
+            zs->next_in = corpus[i].data();
+            zs->avail_in = corpus[i].size();
+            zs->next_out = out.data();
+            zs->avail_out = out.size();
+            InflatePool::inflate(zs, Z_SYNC_FLUSH);
+            total += zs->total_out;
+            InflatePool::release(zs);
+        }
+        return total;
+    };
+}
+
+#endif
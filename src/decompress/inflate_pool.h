@@ -0,0 +1,61 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef INFLATE_POOL_H
+#define INFLATE_POOL_H
+
+// per packet thread cache of initialized zlib inflate states.  inflateInit2()
+// allocates the inflate state and, on first use, a window of up to 32K.
+// rather than doing that for every gzip body, swf, pdf stream, or zip entry
+// we reset and reuse states released by earlier sessions on the same thread.
+//
+// inflate() also enforces the optional per stream cpu budget configured with
+// latency.decompress.max_time to cap the cost of decompression bombs.
+
+#include <zlib.h>
+
+#include "main/snort_types.h"
+
+// returned by InflatePool::inflate() when a stream exceeds its cpu budget
+#define Z_BUDGET_EXCEEDED (-64)
+
+namespace snort
+{
+class SO_PUBLIC InflatePool
+{
+public:
+    // returns a stream ready for inflate() or nullptr if zlib init fails
+    static z_stream* acquire(int window_bits);
+
+    // return the stream to this thread's pool; nullptr is ok
+    static void release(z_stream*);
+
+    // reinitialize an acquired stream for a new compressed stream
+    static bool reset(z_stream*, int window_bits);
+
+    // wrapper for zlib inflate() that charges elapsed time to the stream
+    static int inflate(z_stream*, int flush);
+
+    // free idle states; after this release() no longer caches
+    static void tterm();
+
+    static unsigned get_idle();
+};
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include "filters/sfthreshold.h"
 #include "framework/endianness.h"
 #include "helpers/ring.h"
+#include "latency/overload_control.h"
 #include "latency/packet_latency.h"
 #include "main/analyzer.h"
 #include "main/snort_config.h"
@@ -38,6 +39,7 @@
 #include "packet_io/active.h"
 #include "parser/parser.h"
 #include "profiler/profiler_defs.h"
+#include "profiler/tail_latency.h"
 #include "protocols/packet.h"
 #include "stream/stream.h"
 #include "utils/stats.h"
@@ -571,6 +573,8 @@ bool DetectionEngine::inspect(Packet* p)
     bool inspected = false;
     {
         PacketLatency::Context pkt_latency_ctx { p };
+        OverloadControl::Context overload_ctx;
+        TailLatency::Scope tail_latency(TailLatency::PACKET);
 
         if ( p->ptrs.decode_flags & DECODE_ERR_FLAGS )
         {
@@ -587,6 +591,7 @@ bool DetectionEngine::inspect(Packet* p)
 
             InspectorManager::execute(p);
             inspected = true;
+            OverloadControl::shed_flow(p);
 
             if ( !all_disabled(p) )
             {
@@ -98,6 +98,9 @@ static const Parameter detection_params[] =
       "use hyperscan for content literal searches instead of boyer-moore" },
 #endif
 
+    { "literal_search", Parameter::PT_ENUM, "auto | boyer_moore | simd", "auto",
+      "content literal search; auto uses simd for short patterns where supported" },
+
     { "offload_limit", Parameter::PT_INT, "0:max32", "99999",
       "minimum sizeof PDU to offload fast pattern search (defaults to disabled)" },
 
@@ -117,6 +120,9 @@ static const Parameter detection_params[] =
       "enable pcre match limit overrides when pattern matching (ie ignore /O)" },
 
 #ifdef HAVE_HYPERSCAN
+    { "pcre_prefilter", Parameter::PT_BOOL, nullptr, "false",
+      "skip pcre evaluation when a hyperscan prefilter of the expression finds no match" },
+
     { "pcre_to_regex", Parameter::PT_BOOL, nullptr, "false",
       "enable the use of regex instead of pcre for compatible expressions" },
 #endif
@@ -159,6 +165,9 @@ bool DetectionModule::set(const char* fqn, Value& v, SnortConfig* sc)
         sc->hyperscan_literals = v.get_bool();
 #endif
 
+    else if ( v.is("literal_search") )
+        sc->literal_search = v.get_uint8();
+
     else if ( v.is("offload_limit") )
         sc->offload_limit = v.get_uint32();
 
@@ -209,6 +218,9 @@ bool DetectionModule::set(const char* fqn, Value& v, SnortConfig* sc)
         sc->pcre_override = v.get_bool();
 
 #ifdef HAVE_HYPERSCAN
+    else if ( v.is("pcre_prefilter") )
+        sc->pcre_prefilter = v.get_bool();
+
     else if ( v.is("pcre_to_regex") )
         sc->pcre_to_regex = v.get_bool();
 #endif
@@ -827,6 +827,7 @@ detection_option_tree_root_t* new_root(OptTreeNode* otn)
 
     p->latency_state = new RuleLatencyState[ThreadConfig::get_instance_max()]();
     p->otn = otn;
+    p->priority = otn->sigInfo.priority;
 
     return p;
 }
@@ -107,6 +107,7 @@ struct detection_option_tree_root_t
     RuleLatencyState* latency_state;
 
     struct OptTreeNode* otn;  // first rule in tree
+    unsigned priority;        // best (lowest) priority of rules in tree
 };
 
 struct detection_option_eval_data_t
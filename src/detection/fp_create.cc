@@ -128,6 +128,9 @@ static int otn_create_tree(OptTreeNode* otn, void** existing_tree, Mpse::MpseTyp
 
     detection_option_tree_root_t* root = (detection_option_tree_root_t*)*existing_tree;
 
+    if ( otn->sigInfo.priority < root->priority )
+        root->priority = otn->sigInfo.priority;
+
     if (!root->children)
     {
         root->num_children++;
@@ -44,6 +44,7 @@
 #include "filters/sfthreshold.h"
 #include "framework/cursor.h"
 #include "framework/mpse.h"
+#include "latency/overload_control.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
 #include "log/messages.h"
@@ -55,6 +56,7 @@
 #include "packet_tracer/packet_tracer.h"
 #include "parser/parser.h"
 #include "profiler/profiler_defs.h"
+#include "profiler/tail_latency.h"
 #include "protocols/icmp4.h"
 #include "protocols/packet_manager.h"
 #include "protocols/udp.h"
@@ -338,6 +340,9 @@ static int detection_option_tree_evaluate(detection_option_tree_root_t* root,
     if ( !root )
         return 0;
 
+    if ( OverloadControl::shed_rules(root->priority) )
+        return 0;
+
     RuleLatency::Context rule_latency_ctx(root, eval_data.p);
 
     if ( RuleLatency::suspended() )
@@ -1306,10 +1311,12 @@ void fp_complete(Packet* p, bool search)
     if ( search )
     {
         Profile mpse_profile(mpsePerfStats);
+        TailLatency::Scope mpse_latency(TailLatency::MPSE);
         c->searches.search_sync();
     }
     {
         Profile rule_profile(rulePerfStats);
+        TailLatency::Scope rule_latency(TailLatency::RULE_EVAL);
         stash->process(rule_tree_match, c);
         print_pkt_info(p, "non-fast-patterns");
         fpEvalPacket(p, FPTask::NON_FP);
@@ -1330,11 +1337,13 @@ static void fp_immediate(Packet* p)
     MpseStash* stash = c->stash;
     {
         Profile mpse_profile(mpsePerfStats);
+        TailLatency::Scope mpse_latency(TailLatency::MPSE);
         stash->enable_process();
         c->searches.search_sync();
     }
     {
         Profile rule_profile(rulePerfStats);
+        TailLatency::Scope rule_latency(TailLatency::RULE_EVAL);
         stash->process(rule_tree_match, c);
         c->searches.items.clear();
     }
@@ -1345,12 +1354,14 @@ static void fp_immediate(MpseGroup* so, Packet* p, const uint8_t* buf, unsigned
     MpseStash* stash = p->context->stash;
     {
         Profile mpse_profile(mpsePerfStats);
+        TailLatency::Scope mpse_latency(TailLatency::MPSE);
         int start_state = 0;
         stash->init();
         so->get_normal_mpse()->search(buf, len, rule_tree_queue, p->context, &start_state);
     }
     {
         Profile rule_profile(rulePerfStats);
+        TailLatency::Scope rule_latency(TailLatency::RULE_EVAL);
         stash->process(rule_tree_match, p->context);
     }
 }
@@ -347,6 +347,23 @@ void FileFlows::add_pending_file(uint64_t file_id)
     current_file_id = pending_file_id = file_id;
 }
 
+bool FileFlows::has_pending_file() const
+{
+    if ( pending_file_id or !partially_processed_contexts.empty() )
+        return true;
+
+    for ( FileContext* context : { main_context, current_context } )
+    {
+        if ( !context or context->processing_complete )
+            continue;
+
+        if ( context->is_file_type_enabled() or context->is_file_signature_enabled() or
+            context->verdict == FILE_VERDICT_PENDING )
+            return true;
+    }
+    return false;
+}
+
 FileInspect::FileInspect(FileIdModule* fm)
 {
     fm->load_config(config);
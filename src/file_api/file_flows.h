@@ -89,6 +89,9 @@ public:
 
     void add_pending_file(uint64_t file_id);
 
+    // true while a file on this flow still needs data or a verdict
+    bool has_pending_file() const;
+
     // This is used when there is only one file per session
     bool file_process(Packet* p, const uint8_t* file_data, int data_size, FilePosition,
         bool upload, size_t file_index = 0);
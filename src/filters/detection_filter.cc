@@ -23,16 +23,58 @@
 
 #include "detection_filter.h"
 
+#include <cstring>
+#include <mutex>
+
+#include "hash/hash_defs.h"
 #include "hash/xhash.h"
 #include "log/messages.h"
+#include "main/snort_config.h"
 #include "main/thread.h"
+#include "main/thread_config.h"
 #include "utils/util.h"
 
+#include "global_counts.h"
 #include "sfthd.h"
 
 using namespace snort;
 
+// this thread's view of a global detection_filter
+struct GlobalFilterNode
+{
+    GlobalCountNode global;
+    unsigned prev;      // final count of the prior window
+    time_t tlast;       // time of the most recent hit
+};
+
+THREAD_LOCAL GlobalCountStats detection_filter_stats;
+
 static THREAD_LOCAL XHash* detection_filter_hash = nullptr;
+static THREAD_LOCAL XHash* detection_filter_global_hash = nullptr;
+
+// shared by all packet threads for global detection_filters; created by
+// the first thread to test a global filter and deleted by the last to term
+static GlobalCounts* df_global = nullptr;
+static unsigned df_global_users = 0;
+static std::mutex df_global_mutex;
+
+// set once this thread holds a reference to df_global
+static THREAD_LOCAL GlobalCounts* df_thread_global = nullptr;
+
+static GlobalCounts* get_df_global(unsigned memcap)
+{
+    if ( !df_thread_global )
+    {
+        std::lock_guard<std::mutex> lock(df_global_mutex);
+
+        if ( !df_global )
+            df_global = new GlobalCounts(memcap, ThreadConfig::get_instance_max());
+
+        df_global_users++;
+        df_thread_global = df_global;
+    }
+    return df_thread_global;
+}
 
 DetectionFilterConfig* DetectionFilterConfigNew()
 {
@@ -53,12 +95,79 @@ void DetectionFilterConfigFree(DetectionFilterConfig* config)
     snort_free(config);
 }
 
+// same semantics as the THD_TYPE_DETECT case of sfthd_test_non_suppress()
+// except the count is approximately that of all packet threads
+static int detection_filter_test_global(
+    THD_NODE* thd, const SfIp* sip, const SfIp* dip, time_t curtime)
+{
+    DetectionFilterConfig* df_config = SnortConfig::get_conf()->detection_filter_config;
+    GlobalCounts* gc = get_df_global(df_config->memcap);
+
+    if ( !detection_filter_global_hash )
+    {
+        detection_filter_global_hash = sfthd_new_hash(
+            df_config->memcap, sizeof(GlobalCountKey), sizeof(GlobalFilterNode));
+    }
+
+    GlobalCountKey key;
+    memset(&key, 0, sizeof(key));
+    key.id = thd->thd_id;
+    key.policyId = get_ips_policy()->policy_id;
+    key.ip = (thd->tracking == THD_TRK_SRC) ? *sip : *dip;
+
+    time_t window = GlobalCounts::window_start(curtime, thd->seconds);
+
+    GlobalFilterNode data;
+    memset(&data, 0, sizeof(data));
+    data.global.window = window;
+    data.global.tmerge = curtime;
+    data.tlast = curtime;
+
+    int status = detection_filter_global_hash->insert(&key, &data);
+
+    if ( status == HASH_NOMEM )
+    {
+        detection_filter_stats.no_memory++;
+        return 1;
+    }
+    else if ( status != HASH_OK and status != HASH_INTABLE )
+        return 1;
+
+    GlobalFilterNode* node = (GlobalFilterNode*)detection_filter_global_hash->get_user_data();
+
+    if ( node->global.window != window )
+    {
+        unsigned last = gc->roll(key, node->global, window, curtime,
+            detection_filter_stats);
+
+        if ( (unsigned)(curtime - node->tlast) > thd->seconds )
+            node->prev = 0;
+        else
+            node->prev = last;
+    }
+    node->tlast = curtime;
+    node->global.pending++;
+
+    unsigned count = gc->sync(key, node->global, gc->get_batch(thd->count),
+        curtime, detection_filter_stats);
+
+    if ( (int)count > thd->count or (int)node->prev > thd->count )
+        return 0;
+
+    return 1;
+}
+
 int detection_filter_test(void* pv, const SfIp* sip, const SfIp* dip, long curtime)
 {
     if (pv == nullptr)
         return 0;
 
-    return sfthd_test_rule(detection_filter_hash, (THD_NODE*)pv,
+    THD_NODE* thd = (THD_NODE*)pv;
+
+    if ( thd->global )
+        return detection_filter_test_global(thd, sip, dip, curtime);
+
+    return sfthd_test_rule(detection_filter_hash, thd,
         sip, dip, curtime, get_ips_policy()->policy_id);
 }
 
@@ -72,8 +181,11 @@ THD_NODE* detection_filter_create(DetectionFilterConfig* df_config, THDX_STRUCT*
 
     df_config->count++;
 
-    return sfthd_create_rule_threshold(df_config->count, thdx->tracking,
+    THD_NODE* thd = sfthd_create_rule_threshold(df_config->count, thdx->tracking,
         thdx->type, thdx->count, thdx->seconds);
+
+    thd->global = thdx->global;
+    return thd;
 }
 
 void detection_filter_init(DetectionFilterConfig* df_config)
@@ -92,5 +204,20 @@ void detection_filter_term()
 
     delete detection_filter_hash;
     detection_filter_hash = nullptr;
+
+    delete detection_filter_global_hash;
+    detection_filter_global_hash = nullptr;
+
+    if ( !df_thread_global )
+        return;
+
+    df_thread_global = nullptr;
+    std::lock_guard<std::mutex> lock(df_global_mutex);
+
+    if ( --df_global_users == 0 )
+    {
+        delete df_global;
+        df_global = nullptr;
+    }
 }
 
@@ -0,0 +1,361 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// global_counts.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "global_counts.h"
+
+#include <cstring>
+
+#include "time/stopwatch.h"
+
+#ifdef UNIT_TEST
+#include <thread>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+static inline unsigned add_delta(unsigned count, int delta)
+{
+    if ( delta < 0 and (unsigned)-delta > count )
+        return 0;
+
+    return count + delta;
+}
+
+size_t GlobalCounts::KeyHash::operator()(const GlobalCountKey& key) const
+{
+    // fnv-1a; keys are zero padded
+    const uint8_t* p = (const uint8_t*)&key;
+    uint64_t h = 0xcbf29ce484222325;
+
+    for ( unsigned i = 0; i < sizeof(key); ++i )
+    {
+        h ^= p[i];
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+bool GlobalCounts::KeyEqual::operator()(
+    const GlobalCountKey& a, const GlobalCountKey& b) const
+{ return !memcmp(&a, &b, sizeof(a)); }
+
+GlobalCounts::GlobalCounts(unsigned memcap, unsigned n)
+{
+    max_entries = memcap / (sizeof(GlobalCountKey) + sizeof(Entry) + 32);
+
+    if ( max_entries < num_shards )
+        max_entries = num_shards;
+
+    threads = n ? n : 1;
+}
+
+GlobalCounts::Shard& GlobalCounts::get_shard(const GlobalCountKey& key)
+{
+    // use the high bits so shard and bucket selection are independent
+    return shards[(KeyHash()(key) >> 58) % num_shards];
+}
+
+GlobalCounts::Entry* GlobalCounts::get_entry(Shard& s, const GlobalCountKey& key, time_t now)
+{
+    auto it = s.map.find(key);
+
+    if ( it != s.map.end() )
+        return &it->second;
+
+    if ( s.map.size() >= max_entries / num_shards )
+    {
+        // make room by dropping entries that haven't been touched in a while
+        for ( auto i = s.map.begin(); i != s.map.end(); )
+        {
+            if ( (unsigned)(now - i->second.tlast) > max_idle )
+                i = s.map.erase(i);
+            else
+                ++i;
+        }
+        if ( s.map.size() >= max_entries / num_shards )
+            return nullptr;
+    }
+    Entry& e = s.map[key];
+    e.window = 0;
+    e.tlast = now;
+    e.count = 0;
+    return &e;
+}
+
+void GlobalCounts::merge(
+    const GlobalCountKey& key, GlobalCountNode& node, bool zero, time_t now,
+    GlobalCountStats& stats)
+{
+    Stopwatch<SnortClock> timer;
+    timer.start();
+
+    Shard& s = get_shard(key);
+    {
+        std::lock_guard<std::mutex> lock(s.lock);
+        Entry* e = get_entry(s, key, now);
+
+        if ( !e )
+        {
+            // no room; count locally until an entry frees up
+            node.shared = zero ? 0 : add_delta(node.shared, node.pending);
+            stats.no_memory++;
+        }
+        else
+        {
+            if ( e->window < node.window )
+            {
+                e->window = node.window;
+                e->count = 0;
+            }
+            if ( e->window == node.window )
+            {
+                e->count = zero ? 0 : add_delta(e->count, node.pending);
+                node.shared = e->count;
+            }
+            else
+            {
+                // another thread already moved on; these hits belong to a
+                // closed window so keep them local until this node rolls
+                node.shared = zero ? 0 : add_delta(node.shared, node.pending);
+            }
+            e->tlast = now;
+        }
+    }
+    node.pending = 0;
+    node.tmerge = now;
+
+    timer.stop();
+    stats.merges++;
+
+    // add whole microseconds to the peg and carry the remainder so short
+    // merges aren't truncated to nothing
+    stats.merge_time += timer.get();
+    PegCount total = clock_usecs(TO_USECS(stats.merge_time));
+    stats.merge_usecs += total;
+    stats.merge_time -= TO_DURATION(stats.merge_time, clock_ticks(total));
+
+    PegCount usecs = clock_usecs(TO_USECS(timer.get()));
+
+    if ( usecs > stats.max_merge_usecs )
+        stats.max_merge_usecs = usecs;
+}
+
+unsigned GlobalCounts::roll(
+    const GlobalCountKey& key, GlobalCountNode& node, time_t window, time_t now,
+    GlobalCountStats& stats)
+{
+    if ( node.pending )
+        merge(key, node, false, now, stats);
+
+    unsigned last = node.shared;
+
+    node.window = window;
+    node.shared = 0;
+    node.pending = 0;
+
+    return last;
+}
+
+unsigned GlobalCounts::sync(
+    const GlobalCountKey& key, GlobalCountNode& node, unsigned batch, time_t now,
+    GlobalCountStats& stats)
+{
+    unsigned pending = node.pending < 0 ? -node.pending : node.pending;
+
+    if ( pending >= batch or (pending and now != node.tmerge) )
+        merge(key, node, false, now, stats);
+
+    return add_delta(node.shared, node.pending);
+}
+
+void GlobalCounts::reset(
+    const GlobalCountKey& key, GlobalCountNode& node, time_t now, GlobalCountStats& stats)
+{ merge(key, node, true, now, stats); }
+
+unsigned GlobalCounts::get_count(const GlobalCountKey& key, time_t window)
+{
+    Shard& s = get_shard(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    auto it = s.map.find(key);
+
+    if ( it == s.map.end() or it->second.window != window )
+        return 0;
+
+    return it->second.count;
+}
+
+void GlobalCounts::clear()
+{
+    for ( auto& s : shards )
+    {
+        std::lock_guard<std::mutex> lock(s.lock);
+        s.map.clear();
+    }
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static GlobalCountKey make_key(int id, const char* ip)
+{
+    GlobalCountKey key;
+    memset(&key, 0, sizeof(key));
+    key.id = id;
+    key.ip.set(ip);
+    return key;
+}
+
+TEST_CASE("global counts window", "[global_counts]")
+{
+    GlobalCounts gc(1024 * 1024, 1);
+    GlobalCountStats stats;
+    GlobalCountNode node { };
+    GlobalCountKey key = make_key(1, "1.2.3.4");
+
+    CHECK(GlobalCounts::window_start(125, 60) == 120);
+    CHECK(GlobalCounts::window_start(125, 0) == 0);
+
+    gc.roll(key, node, 120, 125, stats);
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        node.pending++;
+        CHECK(gc.sync(key, node, 1, 125, stats) == (unsigned)i + 1);
+    }
+    CHECK(gc.get_count(key, 120) == 10);
+    CHECK(stats.merges == 10);
+    CHECK(clock_usecs(TO_USECS(stats.merge_time)) == 0);
+
+    node.pending--;
+    CHECK(gc.sync(key, node, 1, 126, stats) == 9);
+
+    node.pending++;
+    CHECK(gc.roll(key, node, 180, 181, stats) == 10);
+    CHECK(gc.get_count(key, 120) == 10);
+    CHECK(gc.get_count(key, 180) == 0);
+
+    node.pending++;
+    CHECK(gc.sync(key, node, 1, 181, stats) == 1);
+    CHECK(gc.get_count(key, 180) == 1);
+
+    gc.reset(key, node, 181, stats);
+    CHECK(gc.get_count(key, 180) == 0);
+}
+
+TEST_CASE("global counts batch", "[global_counts]")
+{
+    GlobalCounts gc(1024 * 1024, 4);
+    GlobalCountStats stats;
+    GlobalCountNode node { };
+    GlobalCountKey key = make_key(2, "1.2.3.4");
+    node.tmerge = 100;
+
+    CHECK(gc.get_batch(1) == 1);
+    CHECK(gc.get_batch(160) == 10);
+
+    for ( int i = 0; i < 9; ++i )
+    {
+        node.pending++;
+        CHECK(gc.sync(key, node, 10, 100, stats) == (unsigned)i + 1);
+    }
+    CHECK(stats.merges == 0);
+    CHECK(gc.get_count(key, 0) == 0);
+
+    node.pending++;
+    CHECK(gc.sync(key, node, 10, 100, stats) == 10);
+    CHECK(stats.merges == 1);
+    CHECK(gc.get_count(key, 0) == 10);
+
+    // pending hits are merged once the second changes
+    node.pending++;
+    CHECK(gc.sync(key, node, 10, 101, stats) == 11);
+    CHECK(stats.merges == 2);
+}
+
+TEST_CASE("global counts memcap", "[global_counts]")
+{
+    GlobalCounts gc(0, 1);
+    GlobalCountStats stats;
+    unsigned i;
+
+    // minimum capacity is one entry per shard
+    for ( i = 0; i < 1000 and !stats.no_memory; ++i )
+    {
+        GlobalCountNode node { };
+        node.pending = 1;
+        GlobalCountKey key = make_key(i, "1.2.3.4");
+        CHECK(gc.sync(key, node, 1, 100, stats) == 1);
+    }
+    CHECK(stats.no_memory == 1);
+    CHECK(i > 1);
+
+    // idle entries are dropped to make room
+    for ( i = 0; i < 1000; ++i )
+    {
+        GlobalCountNode node { };
+        node.pending = 1;
+        GlobalCountKey key = make_key(i, "1.2.3.4");
+        gc.sync(key, node, 1, 10000, stats);
+    }
+    CHECK(stats.no_memory < 1000);
+}
+
+TEST_CASE("global counts threads", "[global_counts]")
+{
+    const unsigned num_threads = 4;
+    const unsigned hits = 10000;
+
+    GlobalCounts gc(1024 * 1024, num_threads);
+    GlobalCountKey key = make_key(3, "1:2::8");
+    std::vector<std::thread> threads;
+
+    for ( unsigned t = 0; t < num_threads; ++t )
+    {
+        threads.emplace_back([&gc, &key]()
+        {
+            GlobalCountStats stats;
+            GlobalCountNode node { };
+
+            for ( unsigned i = 0; i < hits; ++i )
+            {
+                node.pending++;
+                gc.sync(key, node, 16, 100, stats);
+            }
+            // force out the remainder
+            gc.sync(key, node, 1, 100, stats);
+        });
+    }
+    for ( auto& t : threads )
+        t.join();
+
+    CHECK(gc.get_count(key, 0) == num_threads * hits);
+}
+
+#endif
@@ -0,0 +1,147 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// global_counts.h
+
+#ifndef GLOBAL_COUNTS_H
+#define GLOBAL_COUNTS_H
+
+// Shared event counts for rate_filter and detection_filter instances
+// configured with global tracking.  Each packet thread keeps a local node
+// per tracked key which accumulates hits; these deltas are merged into a
+// sharded table common to all packet threads when enough hits accumulate
+// or the last merge is from a prior second.  Threshold decisions use the
+// shared count from the last merge plus the local hits not yet merged, so
+// the combined error across N threads is bounded by N * batch hits and
+// one second of staleness.
+
+#include <ctime>
+#include <mutex>
+#include <unordered_map>
+
+#include "framework/counts.h"
+#include "main/policy.h"
+#include "sfip/sf_ip.h"
+#include "time/clock_defs.h"
+#include "utils/cpp_macros.h"
+
+PADDING_GUARD_BEGIN
+struct GlobalCountKey
+{
+    int id;
+    PolicyId policyId;
+    snort::SfIp ip;
+    uint16_t padding;
+};
+PADDING_GUARD_END
+
+// thread local view of a shared count
+struct GlobalCountNode
+{
+    time_t window;      // start of the current counting window
+    time_t tmerge;      // time of the last merge
+    unsigned shared;    // shared count as of the last merge
+    int pending;        // local hits not yet merged
+};
+
+struct GlobalCountStats
+{
+    PegCount merges = 0;
+    PegCount merge_usecs = 0;
+    PegCount max_merge_usecs = 0;
+    PegCount no_memory = 0;
+
+    // not a peg; time under 1 usec not yet added to merge_usecs
+    hr_duration merge_time = CLOCK_ZERO;
+};
+
+class GlobalCounts
+{
+public:
+    // memcap bounds the number of shared entries
+    // threads is the number of packet threads sharing the table
+    GlobalCounts(unsigned memcap, unsigned threads);
+
+    // fixed time windows so all threads agree on when a period starts
+    static time_t window_start(time_t now, unsigned seconds)
+    { return seconds ? now - (now % seconds) : 0; }
+
+    // number of local hits that may accumulate before a merge is forced
+    unsigned get_batch(unsigned limit) const
+    {
+        unsigned b = limit / (4 * threads);
+        return b ? b : 1;
+    }
+
+    // start a new window for the node, flushing any hits from the old one
+    // returns the final shared count of the old window
+    unsigned roll(const GlobalCountKey&, GlobalCountNode&, time_t window, time_t now,
+        GlobalCountStats&);
+
+    // merge if the node has batch or more pending hits or if the last merge
+    // was in a prior second; returns the approximate global count
+    unsigned sync(const GlobalCountKey&, GlobalCountNode&, unsigned batch, time_t now,
+        GlobalCountStats&);
+
+    // zero the shared count for the node's key and window
+    void reset(const GlobalCountKey&, GlobalCountNode&, time_t now, GlobalCountStats&);
+
+    unsigned get_count(const GlobalCountKey&, time_t window);
+    void clear();
+
+private:
+    struct Entry
+    {
+        time_t window;
+        time_t tlast;
+        unsigned count;
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const GlobalCountKey&) const;
+    };
+
+    struct KeyEqual
+    {
+        bool operator()(const GlobalCountKey&, const GlobalCountKey&) const;
+    };
+
+    typedef std::unordered_map<GlobalCountKey, Entry, KeyHash, KeyEqual> Map;
+
+    struct Shard
+    {
+        std::mutex lock;
+        Map map;
+    };
+
+    void merge(const GlobalCountKey&, GlobalCountNode&, bool zero, time_t now,
+        GlobalCountStats&);
+    Entry* get_entry(Shard&, const GlobalCountKey&, time_t now);
+    Shard& get_shard(const GlobalCountKey&);
+
+private:
+    static constexpr unsigned num_shards = 64;
+    static constexpr unsigned max_idle = 3600;
+
+    Shard shards[num_shards];
+    size_t max_entries;
+    unsigned threads;
+};
+
+#endif
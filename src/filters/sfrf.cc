@@ -26,7 +26,11 @@
 
 #include "sfrf.h"
 
+#include <cstring>
+#include <mutex>
+
 #include "main/thread.h"
+#include "main/thread_config.h"
 #include "detection/rules.h"
 #include "hash/ghash.h"
 #include "hash/hash_defs.h"
@@ -98,10 +102,39 @@ typedef struct
     /*  time when new action was activated due to rate limit exceeding.
     */
     time_t revertTime;
+
+    /* this thread's share of the count for global rate_filters.
+    */
+    GlobalCountNode global;
 } tSFRFTrackingNode;
 
 static THREAD_LOCAL XHash* rf_hash = nullptr;
 
+// shared by all packet threads for global rate_filters; created by the
+// first thread to test a global filter and deleted by the last to exit
+static GlobalCounts* rf_global = nullptr;
+static unsigned rf_global_users = 0;
+static std::mutex rf_global_mutex;
+
+// set once this thread holds a reference to rf_global
+static THREAD_LOCAL GlobalCounts* rf_thread_global = nullptr;
+static THREAD_LOCAL unsigned rf_memcap = 0;
+
+static GlobalCounts* get_rf_global()
+{
+    if ( !rf_thread_global )
+    {
+        std::lock_guard<std::mutex> lock(rf_global_mutex);
+
+        if ( !rf_global )
+            rf_global = new GlobalCounts(rf_memcap, ThreadConfig::get_instance_max());
+
+        rf_global_users++;
+        rf_thread_global = rf_global;
+    }
+    return rf_thread_global;
+}
+
 // private methods ...
 static int _checkThreshold(
     tSFRFConfigNode*,
@@ -117,7 +150,7 @@ static int _checkSamplingPeriod(
 
 static tSFRFTrackingNode* _getSFRFTrackingNode(
     const SfIp*,
-    unsigned tid,
+    tSFRFConfigNode*,
     time_t curTime
     );
 
@@ -162,12 +195,29 @@ void SFRF_Delete()
 
     delete rf_hash;
     rf_hash = nullptr;
+
+    if ( !rf_thread_global )
+        return;
+
+    rf_thread_global = nullptr;
+    std::lock_guard<std::mutex> lock(rf_global_mutex);
+
+    if ( --rf_global_users == 0 )
+    {
+        delete rf_global;
+        rf_global = nullptr;
+    }
 }
 
 void SFRF_Flush()
 {
     if ( rf_hash )
         rf_hash->clear_hash();
+
+    std::lock_guard<std::mutex> lock(rf_global_mutex);
+
+    if ( rf_global )
+        rf_global->clear();
 }
 
 static void SFRF_ConfigNodeFree(void* item)
@@ -205,6 +255,8 @@ int SFRF_Alloc(unsigned int memcap)
 
         if ( rf_hash == nullptr )
             return -1;
+
+        rf_memcap = memcap;
     }
     return 0;
 }
@@ -357,18 +409,40 @@ static int SFRF_TestObject(
 {
     tSFRFTrackingNode* dynNode;
     int retValue = -1;
+    int delta = 0;
 
-    dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime);
+    dynNode = _getSFRFTrackingNode(ip, cfgNode, curTime);
 
     if ( dynNode == nullptr )
         return retValue;
 
+    GlobalCounts* gc = cfgNode->global ? get_rf_global() : nullptr;
+    GlobalCountKey key;
+
+    if ( gc )
+    {
+        memset(&key, 0, sizeof(key));
+        key.id = cfgNode->tid;
+        key.policyId = get_ips_policy()->policy_id;
+        key.ip = *ip;
+
+        // pick up the final count of the last window so the sampling
+        // period check below sees all threads' hits
+        time_t window = GlobalCounts::window_start(curTime, cfgNode->seconds);
+
+        if ( window != dynNode->global.window )
+            dynNode->count = gc->roll(key, dynNode->global, window, curTime,
+                rate_filter_stats.global);
+    }
+
     if ( _checkSamplingPeriod(cfgNode, dynNode, curTime) != 0 )
     {
 #ifdef SFRF_DEBUG
         printf("...Sampling period reset\n");
         fflush(stdout);
 #endif
+        if ( gc )
+            dynNode->tstart = dynNode->global.window;
     }
 
     switch (op)
@@ -377,6 +451,7 @@ static int SFRF_TestObject(
         if ( (dynNode->count+1) != 0 )
         {
             dynNode->count++;
+            delta = 1;
         }
         break;
     case SFRF_COUNT_DECREMENT:
@@ -386,6 +461,7 @@ static int SFRF_TestObject(
             if ( dynNode->count != 0 )
             {
                 dynNode->count--;
+                delta = -1;
             }
         }
         break;
@@ -396,6 +472,17 @@ static int SFRF_TestObject(
         break;
     }
 
+    if ( gc )
+    {
+        if ( op == SFRF_COUNT_RESET )
+            gc->reset(key, dynNode->global, curTime, rate_filter_stats.global);
+        else
+            dynNode->global.pending += delta;
+
+        dynNode->count = gc->sync(key, dynNode->global, gc->get_batch(cfgNode->count),
+            curTime, rate_filter_stats.global);
+    }
+
     retValue = _checkThreshold(cfgNode, dynNode, curTime);
 
     // we drop after the session count has been incremented
@@ -404,8 +491,13 @@ static int SFRF_TestObject(
     // threshold would never be exceeded.
     if ( !cfgNode->seconds && dynNode->count > cfgNode->count )
         if ( cfgNode->newAction == Actions::DROP )
+        {
             dynNode->count--;
 
+            if ( gc )
+                dynNode->global.pending--;
+        }
+
 #ifdef SFRF_DEBUG
     printf("--SFRF_DEBUG: %d-%u-%u: %u Packet IP %s, op: %d, count %u, action %d\n",
         cfgNode->tid, cfgNode->gid,
@@ -770,14 +862,15 @@ static void _updateDependentThresholds(
     }
 }
 
-static tSFRFTrackingNode* _getSFRFTrackingNode(const SfIp* ip, unsigned tid, time_t curTime)
+static tSFRFTrackingNode* _getSFRFTrackingNode(
+    const SfIp* ip, tSFRFConfigNode* cfgNode, time_t curTime)
 {
     tSFRFTrackingNode* dynNode = nullptr;
     tSFRFTrackingNodeKey key;
 
     /* Setup key */
     key.ip = *(ip);
-    key.tid = tid;
+    key.tid = cfgNode->tid;
     key.policyId = get_ips_policy()->policy_id;
     key.padding = 0;
 
@@ -798,6 +891,14 @@ static tSFRFTrackingNode* _getSFRFTrackingNode(const SfIp* ip, unsigned tid, tim
         dynNode->tlast = curTime;
 #endif
         dynNode->filterState = FS_OFF;
+
+        if ( cfgNode->global )
+        {
+            // global windows are aligned so all threads share them
+            dynNode->tstart = GlobalCounts::window_start(curTime, cfgNode->seconds);
+            dynNode->global.window = dynNode->tstart;
+            dynNode->global.tmerge = curTime;
+        }
     }
 
     return dynNode;
@@ -27,6 +27,7 @@
 #include <ctime>
 
 #include "actions/actions.h"
+#include "filters/global_counts.h"
 #include "framework/counts.h"
 #include "main/policy.h"
 
@@ -102,6 +103,9 @@ struct tSFRFConfigNode
 
     // ip set to restrict rate_filter
     sfip_var_t* applyTo;
+
+    // count hits from all packet threads instead of just this one
+    bool global;
 };
 
 /* tSFRFSidNode acts as a container of gid+sid based threshold objects,
@@ -150,6 +154,7 @@ struct RateFilterConfig
 struct RateFilterStats
 {
     PegCount xhash_nomem_peg = 0;
+    GlobalCountStats global;
 };
 
 /*
@@ -22,7 +22,11 @@
 #include "config.h"
 #endif
 
+#include <thread>
+
 #include "catch/snort_catch.h"
+#include "main/policy.h"
+#include "main/thread.h"
 #include "parser/parse_ip.h"
 #include "sfip/sf_ip.h"
 
@@ -31,6 +35,8 @@
 
 using namespace snort;
 
+extern THREAD_LOCAL RateFilterStats rate_filter_stats;
+
 //---------------------------------------------------------------
 
 #define IP_ANY   nullptr          // used to get "unset"
@@ -913,6 +919,7 @@ static void Init(unsigned cap)
         cfg.newAction = (Actions::Type)RULE_NEW;
         cfg.timeout = p->timeout;
         cfg.applyTo = p->ip ? sfip_var_from_string(p->ip, "sfrf_test") : nullptr;
+        cfg.global = false;
 
         p->create = SFRF_ConfigAdd(nullptr, rfc, &cfg);
     }
@@ -1018,3 +1025,60 @@ TEST_CASE("sfrf minimum memcap", "[sfrf]")
     }
     Term();
 }
+
+TEST_CASE("sfrf global", "[sfrf]")
+{
+    set_default_policy();
+    rfc = RateFilter_ConfigNew();
+    SFRF_Alloc(rfc->memcap);
+
+    tSFRFConfigNode cfg { };
+
+    cfg.gid = 1;
+    cfg.sid = 1;
+    cfg.tracking = SFRF_TRACK_BY_SRC;
+    cfg.count = 2;
+    cfg.seconds = 10;
+    cfg.newAction = (Actions::Type)RULE_NEW;
+    cfg.timeout = 10;
+    cfg.global = true;
+
+    REQUIRE(SFRF_ConfigAdd(nullptr, rfc, &cfg) == 0);
+
+    SfIp sip, dip;
+    sip.set(IP4_SRC);
+    dip.set(IP4_DST);
+
+    PegCount merges = rate_filter_stats.global.merges;
+
+    // windows are aligned to multiples of seconds so all hits are in [100, 110)
+    CHECK(SFRF_TestThreshold(rfc, 1, 1, &sip, &dip, 101, SFRF_COUNT_INCREMENT) == RULE_ORIG);
+
+    // another packet thread sees the first hit and adds its own
+    IpsPolicy* policy = get_ips_policy();
+    int other = 0;
+
+    std::thread t([&]()
+    {
+        set_ips_policy(policy);
+        SFRF_Alloc(rfc->memcap);
+        other = SFRF_TestThreshold(rfc, 1, 1, &sip, &dip, 102, SFRF_COUNT_INCREMENT);
+        SFRF_Delete();
+    });
+    t.join();
+
+    CHECK(other == RULE_ORIG);
+
+    // the 3rd hit across both threads trips and the new action sticks
+    CHECK(SFRF_TestThreshold(rfc, 1, 1, &sip, &dip, 103, SFRF_COUNT_INCREMENT) ==
+        Actions::MAX + RULE_NEW);
+    CHECK(SFRF_TestThreshold(rfc, 1, 1, &sip, &dip, 104, SFRF_COUNT_INCREMENT) == RULE_NEW);
+
+    // other sources are counted separately
+    CHECK(SFRF_TestThreshold(rfc, 1, 1, &dip, &sip, 105, SFRF_COUNT_INCREMENT) == RULE_ORIG);
+
+    // a threshold of 2 merges every hit on this thread
+    CHECK(rate_filter_stats.global.merges - merges == 4);
+
+    Term();
+}
@@ -134,6 +134,7 @@ struct THD_NODE
     int count;
     unsigned seconds;
     sfip_var_t* ip_address;
+    bool global;       /* count hits from all packet threads */
 };
 
 /*!
@@ -170,6 +171,7 @@ struct THDX_STRUCT
     int priority;
 
     sfip_var_t* ip_address;
+    bool global;
 };
 
 struct tThdItemKey
@@ -23,7 +23,12 @@
 
 #include "expect_cache.h"
 
+#include <atomic>
+#include <mutex>
+
+#include "framework/inspector.h"
 #include "hash/zhash.h"
+#include "main/thread_config.h"
 #include "packet_io/sfdaq_instance.h"
 #include "protocols/packet.h"
 #include "protocols/vlan.h"
@@ -41,8 +46,17 @@ using namespace snort;
 #define MAX_DATA    4
 #define MAX_WAIT  300
 
+// slots checked from the home slot before giving up
+#define MAX_PROBE  16
+
 static THREAD_LOCAL std::vector<ExpectFlow*>* packet_expect_flows = nullptr;
 
+// shared slots added by the current packet; they are kept BUSY until the
+// packet is done so the flows in packet_expect_flows stay valid
+static THREAD_LOCAL std::vector<ExpectSlot*>* packet_expect_slots = nullptr;
+
+static void unpin_slots();
+
 ExpectFlow::~ExpectFlow()
 {
     clear();
@@ -82,6 +96,8 @@ void ExpectFlow::reset_expect_flows()
 {
     if(packet_expect_flows)
         packet_expect_flows->clear();
+
+    unpin_slots();
 }
 
 FlowData* ExpectFlow::get_flow_data(unsigned id)
@@ -122,10 +138,148 @@ void ExpectNode::clear(ExpectFlow*& list)
     count = 0;
 }
 
+//-------------------------------------------------------------------------
+// shared expect table
+// -- each slot holds one expected session with its own expiration; several
+//    slots may have the same 3-tuple key
+// -- slots are found by linear probing from the key's home slot
+// -- a thread must move a slot from READY to BUSY before it reads or
+//    changes it and BUSY slots are skipped, so an expected flow is claimed
+//    by exactly one thread without locks
+// -- the tag is the key hash and is checked before trying to acquire a
+//    slot so lookups for flows that aren't expected don't touch the slots
+// -- the tag and expiration can be read without acquiring the slot; adds
+//    only acquire slots with their tag and the free or expired slot they
+//    take, so they don't hide other sessions from concurrent lookups
+// -- unexpired sessions are never evicted; the add fails when no slot in
+//    the probe range is free or expired
+// -- flow data keeps a reference to its inspector on the adding thread;
+//    the reference is moved when the data is taken on another thread
+//-------------------------------------------------------------------------
+
+enum ExpectSlotState : uint8_t { SLOT_FREE, SLOT_BUSY, SLOT_READY };
+
+struct ExpectSlot
+{
+    std::atomic<uint8_t> state;
+    std::atomic<uint32_t> tag;
+
+    FlowKey key;
+    std::atomic<time_t> expires;
+    unsigned owner;
+    bool reversed_key;
+    int direction;
+    SnortProtocolId snort_protocol_id;
+    ExpectFlow flow;
+
+    bool acquire(uint8_t from = SLOT_READY)
+    { return state.compare_exchange_strong(from, SLOT_BUSY, std::memory_order_acquire); }
+
+    void release(uint8_t to = SLOT_READY)
+    { state.store(to, std::memory_order_release); }
+
+    void adopt();
+
+    bool expired(time_t now) const
+    { return now > expires.load(std::memory_order_relaxed); }
+};
+
+static void unpin_slots()
+{
+    if ( !packet_expect_slots )
+        return;
+
+    for ( auto* slot : *packet_expect_slots )
+        slot->release();
+
+    packet_expect_slots->clear();
+}
+
+// a slot pinned by this thread for the current packet for the given key
+// and without data with the given id
+static ExpectSlot* find_pinned(uint32_t tag, const FlowKey& key, unsigned id)
+{
+    for ( auto* slot : *packet_expect_slots )
+    {
+        if ( slot->tag.load(std::memory_order_relaxed) == tag and
+            FlowKey::is_equal(&slot->key, &key, sizeof(key)) and
+            !slot->flow.get_flow_data(id) )
+            return slot;
+    }
+    return nullptr;
+}
+
+void ExpectSlot::adopt()
+{
+    if ( owner == Inspector::slot )
+        return;
+
+    for ( FlowData* fd = flow.data; fd; fd = fd->next )
+    {
+        if ( Inspector* ins = fd->get_handler() )
+            ins->move_ref(owner);
+    }
+    owner = Inspector::slot;
+}
+
+class ExpectTable
+{
+public:
+    ExpectTable(unsigned n) : hash_ops(n)
+    {
+        slots = new ExpectSlot[n]();
+        num_slots = n;
+    }
+
+    ~ExpectTable()
+    {
+        for ( unsigned i = 0; i < num_slots; ++i )
+            slots[i].adopt();
+
+        delete[] slots;
+    }
+
+    uint32_t hash(const FlowKey& key)
+    {
+        uint32_t h = hash_ops.do_hash((const unsigned char*)&key, sizeof(key));
+        return h ? h : 1;
+    }
+
+    ExpectSlot* get(uint32_t tag, unsigned probe)
+    { return slots + (tag + probe) % num_slots; }
+
+    std::atomic<unsigned> count { 0 };
+
+private:
+    FlowHashKeyOps hash_ops;
+    ExpectSlot* slots;
+    unsigned num_slots;
+};
+
+static std::mutex shared_mutex;
+static ExpectTable* shared_table = nullptr;
+static unsigned shared_users = 0;
+
 //-------------------------------------------------------------------------
 // private ExpectCache methods
 //-------------------------------------------------------------------------
 
+void ExpectCache::clear_expired(ExpectNode* node, time_t now)
+{
+    while ( node->head and now > node->head->expires )
+    {
+        ExpectFlow* p = node->head;
+        node->head = p->next;
+        p->clear();
+        p->next = free_list;
+        free_list = p;
+        node->count--;
+        ++expired;
+    }
+    if ( !node->head )
+        node->tail = nullptr;
+}
+
 void ExpectCache::prune_lru()
 {
     ExpectNode* node = static_cast<ExpectNode*>( hash_table->lru_first() );
@@ -135,11 +289,8 @@ void ExpectCache::prune_lru()
     ++prunes;
 }
 
-ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
+static bool init_key(Packet* p, FlowKey& key)
 {
-    if (!hash_table->get_num_nodes())
-        return nullptr;
-
     const SfIp* srcIP = p->ptrs.ip_api.get_src();
     const SfIp* dstIP = p->ptrs.ip_api.get_dst();
     uint16_t vlanId = (p->proto_bits & PROTO_BIT__VLAN) ? layer::get_vlan_layer(p)->vid() : 0;
@@ -148,8 +299,16 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
     PktType type = p->type();
     IpProtocol ip_proto = p->get_ip_proto_next();
 
-    bool reversed_key = key.init(type, ip_proto, dstIP, p->ptrs.dp, srcIP, p->ptrs.sp,
+    return key.init(type, ip_proto, dstIP, p->ptrs.dp, srcIP, p->ptrs.sp,
             vlanId, mplsId, addressSpaceId);
+}
+
+ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
+{
+    if (!hash_table->get_num_nodes())
+        return nullptr;
+
+    bool reversed_key = init_key(p, key);
 
     /*
         Lookup order:
@@ -192,10 +351,10 @@ ExpectNode* ExpectCache::find_node_by_packet(Packet* p, FlowKey &key)
                 return nullptr;
         }
     }
-    if (!node->head || (p->pkth->ts.tv_sec > node->expires))
+    clear_expired(node, p->pkth->ts.tv_sec);
+
+    if (!node->head)
     {
-        if (node->head)
-            node->clear(free_list);
         hash_table->release_node(&key);
         return nullptr;
     }
@@ -252,12 +411,282 @@ bool ExpectCache::process_expected(ExpectNode* node, FlowKey& key, Packet* p, Fl
     return ignoring;
 }
 
+// release the slot's flow data on this thread; caller owns the slot
+void ExpectCache::clear_slot(ExpectSlot* slot)
+{
+    slot->adopt();
+    slot->flow.clear();
+}
+
+ExpectSlot* ExpectCache::find_shared(const FlowKey& key, bool reversed_key, time_t now)
+{
+    uint32_t tag = shared->hash(key);
+
+    for ( unsigned i = 0; i < MAX_PROBE; ++i )
+    {
+        ExpectSlot* slot = shared->get(tag, i);
+
+        if ( slot->tag.load(std::memory_order_relaxed) != tag or !slot->acquire() )
+            continue;
+
+        if ( !FlowKey::is_equal(&slot->key, &key, sizeof(key)) )
+        {
+            slot->release();
+            continue;
+        }
+
+        if ( slot->expired(now) )
+        {
+            clear_slot(slot);
+            shared->count--;
+            slot->release(SLOT_FREE);
+            ++expired;
+            continue;
+        }
+
+        /* Make sure the packet direction is correct */
+        if ( (slot->direction == SSN_DIR_FROM_CLIENT or slot->direction == SSN_DIR_FROM_SERVER)
+            and slot->reversed_key != reversed_key )
+        {
+            slot->release();
+            continue;
+        }
+        return slot;
+    }
+    return nullptr;
+}
+
+// same lookup order as find_node_by_packet(); the returned slot is BUSY
+ExpectSlot* ExpectCache::find_shared(Packet* p)
+{
+    if ( !shared->count.load(std::memory_order_relaxed) )
+        return nullptr;
+
+    FlowKey key;
+    bool reversed_key = init_key(p, key);
+    time_t now = p->pkth->ts.tv_sec;
+
+    if ( ExpectSlot* slot = find_shared(key, reversed_key, now) )
+        return slot;
+
+    uint16_t port_l = key.port_l;
+    uint16_t port_h = key.port_h;
+
+    if ( reversed_key )
+        key.port_l = 0;
+    else
+        key.port_h = 0;
+
+    if ( ExpectSlot* slot = find_shared(key, reversed_key, now) )
+        return slot;
+
+    key.port_l = reversed_key ? port_l : 0;
+    key.port_h = reversed_key ? 0 : port_h;
+
+    return find_shared(key, reversed_key, now);
+}
+
+bool ExpectCache::process_shared(ExpectSlot* slot, Packet* p, Flow* lws)
+{
+    FlowData* fd;
+    bool ignoring = false;
+
+    if ( slot->owner != Inspector::slot )
+        ++cross_thread;
+
+    slot->adopt();
+
+    while ((fd = slot->flow.data))
+    {
+        slot->flow.data = fd->next;
+        lws->set_flow_data(fd);
+        ++realized;
+        fd->handle_expected(p);
+    }
+
+    /* If this is 0, we're ignoring, otherwise setting id of new session */
+    if (!slot->snort_protocol_id)
+        ignoring = slot->direction ? true : false;
+    else if (lws->ssn_state.snort_protocol_id != slot->snort_protocol_id)
+        lws->ssn_state.snort_protocol_id = slot->snort_protocol_id;
+
+    shared->count--;
+    slot->release(SLOT_FREE);
+
+    return ignoring;
+}
+
+// acquire a free or expired slot in the probe range for a new session
+ExpectSlot* ExpectCache::take_shared(uint32_t tag, time_t now)
+{
+    for ( unsigned i = 0; i < MAX_PROBE; ++i )
+    {
+        ExpectSlot* s = shared->get(tag, i);
+
+        if ( s->state.load(std::memory_order_relaxed) == SLOT_FREE )
+        {
+            if ( s->acquire(SLOT_FREE) )
+            {
+                shared->count++;
+                return s;
+            }
+            continue;
+        }
+
+        if ( !s->expired(now) or !s->acquire() )
+            continue;
+
+        // the session may have been taken and the slot reused since
+        if ( !s->expired(now) )
+        {
+            s->release();
+            continue;
+        }
+        clear_slot(s);
+        ++expired;
+        return s;
+    }
+    return nullptr;
+}
+
+// each call adds the data to a pending session for the 3-tuple that
+// doesn't have data with this id yet or starts a new session
+int ExpectCache::add_shared(const Packet* ctrlPkt, FlowKey& key, bool reversed_key,
+    IpProtocol ip_proto, const SfIp* cliIP, uint16_t cliPort, const SfIp* srvIP,
+    uint16_t srvPort, char direction, FlowData* fd, SnortProtocolId snort_protocol_id)
+{
+    time_t now = packet_time();
+    uint32_t tag = shared->hash(key);
+
+    // slots added earlier by this packet are still BUSY so check them first
+    ExpectSlot* slot = find_pinned(tag, key, fd->get_id());
+
+    if ( slot and slot->snort_protocol_id != snort_protocol_id )
+    {
+        //  reject if the snort_protocol_id doesn't match
+        if ( slot->snort_protocol_id && snort_protocol_id )
+            return -1;
+        slot->snort_protocol_id = snort_protocol_id;
+    }
+    bool pinned = slot != nullptr;
+
+    for ( unsigned i = 0; i < MAX_PROBE and !slot; ++i )
+    {
+        ExpectSlot* s = shared->get(tag, i);
+
+        // other keys' slots are left alone; they are only taken below once expired
+        if ( s->tag.load(std::memory_order_relaxed) != tag or !s->acquire() )
+            continue;
+
+        if ( !FlowKey::is_equal(&s->key, &key, sizeof(key)) )
+        {
+            s->release();
+            continue;
+        }
+
+        if ( s->expired(now) )
+        {
+            clear_slot(s);
+            shared->count--;
+            s->release(SLOT_FREE);
+            ++expired;
+            continue;
+        }
+
+        //  reject if the snort_protocol_id doesn't match
+        if ( s->snort_protocol_id != snort_protocol_id )
+        {
+            if ( s->snort_protocol_id && snort_protocol_id )
+            {
+                s->release();
+                return -1;
+            }
+            s->snort_protocol_id = snort_protocol_id;
+        }
+
+        if ( !s->flow.get_flow_data(fd->get_id()) )
+        {
+            slot = s;
+            break;
+        }
+        s->release();
+    }
+
+    bool new_slot = false;
+
+    if ( !slot )
+    {
+        if ( !(slot = take_shared(tag, now)) )
+        {
+            ++overflows;
+            return -1;
+        }
+
+        slot->key = key;
+        slot->tag.store(tag, std::memory_order_relaxed);
+        slot->owner = Inspector::slot;
+        slot->reversed_key = reversed_key;
+        slot->direction = direction;
+        slot->snort_protocol_id = snort_protocol_id;
+        slot->flow.next = nullptr;
+        slot->flow.data = nullptr;
+        new_slot = true;
+
+        /* Only add TCP and UDP expected flows for now via the DAQ module. */
+        if ((ip_proto == IpProtocol::TCP || ip_proto == IpProtocol::UDP) && ctrlPkt->daq_instance)
+            ctrlPkt->daq_instance->add_expected(ctrlPkt, cliIP, cliPort, srvIP, srvPort,
+                    ip_proto, 1000, 0);
+    }
+    else
+        slot->adopt();
+
+    slot->flow.add_flow_data(fd);
+    slot->flow.expires = now + MAX_WAIT;
+    slot->expires.store(slot->flow.expires, std::memory_order_relaxed);
+    ++expects;
+
+    if ( new_slot )
+    {
+        // chain all expected flows created by this packet; the slot stays
+        // BUSY until the packet is reset so these can't be taken or reused
+        // by another thread in the meantime
+        packet_expect_flows->emplace_back(&slot->flow);
+        packet_expect_slots->emplace_back(slot);
+
+        ExpectEvent event(ctrlPkt, &slot->flow, fd);
+        DataBus::publish(EXPECT_EVENT_TYPE_EARLY_SESSION_CREATE_KEY, event, ctrlPkt->flow);
+    }
+    else if ( !pinned )
+        slot->release();
+
+    return 0;
+}
+
 //-------------------------------------------------------------------------
 // public ExpectCache methods
 //-------------------------------------------------------------------------
 
-ExpectCache::ExpectCache(uint32_t max)
+ExpectCache::ExpectCache(uint32_t max, bool share)
 {
+    if (packet_expect_flows == nullptr)
+        packet_expect_flows = new std::vector<ExpectFlow*>;
+
+    if ( share )
+    {
+        // size for the per thread maximum on all threads
+        std::lock_guard<std::mutex> lock(shared_mutex);
+
+        if ( !shared_table )
+            shared_table = new ExpectTable(max * MAX_LIST * ThreadConfig::get_instance_max());
+
+        ++shared_users;
+        shared = shared_table;
+
+        if ( packet_expect_slots == nullptr )
+            packet_expect_slots = new std::vector<ExpectSlot*>;
+        return;
+    }
+
     // -size forces use of abs(size) ie w/o bumping up
     hash_table = new ZHash(-MAX_HASH, sizeof(FlowKey));
     nodes = new ExpectNode[max];
@@ -277,13 +706,24 @@ ExpectCache::ExpectCache(uint32_t max)
         p->next = free_list;
         free_list = p;
     }
-
-    if (packet_expect_flows == nullptr)
-        packet_expect_flows = new std::vector<ExpectFlow*>;
 }
 
 ExpectCache::~ExpectCache()
 {
+    if ( shared )
+    {
+        unpin_slots();
+        delete packet_expect_slots;
+        packet_expect_slots = nullptr;
+
+        std::lock_guard<std::mutex> lock(shared_mutex);
+
+        if ( !--shared_users )
+        {
+            delete shared_table;
+            shared_table = nullptr;
+        }
+    }
     delete hash_table;
     delete[] nodes;
     delete[] pool;
@@ -322,6 +762,10 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
     bool reversed_key = key.init(type, ip_proto, cliIP, cliPort, srvIP, srvPort,
             vlanId, mplsId, addressSpaceId);
 
+    if ( shared )
+        return add_shared(ctrlPkt, key, reversed_key, ip_proto, cliIP, cliPort, srvIP, srvPort,
+            direction, fd, snort_protocol_id);
+
     bool new_node = false;
     ExpectNode* node = static_cast<ExpectNode*> ( hash_table->get_user_data(&key) );
     if ( !node )
@@ -335,9 +779,12 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
     else if ( packet_time() > node->expires )
     {
         // node is past its expiration date, whack it and reuse it.
+        expired += node->count;
         node->clear(free_list);
         new_node = true;
     }
+    else
+        clear_expired(node, packet_time());
 
     ExpectFlow* last = nullptr;
     if ( !new_node )
@@ -372,6 +819,7 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
         node->direction = direction;
         node->head = node->tail = nullptr;
         node->count = 0;
+        node->expires = 0;
         last = nullptr;
         /* Only add TCP and UDP expected flows for now via the DAQ module. */
         if ((ip_proto == IpProtocol::TCP || ip_proto == IpProtocol::UDP) && ctrlPkt->daq_instance)
@@ -402,7 +850,16 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
         new_expect_flow = true;
     }
     last->add_flow_data(fd);
-    node->expires = packet_time() + MAX_WAIT;
+
+    // last is always the tail so the chain stays in expiration order as
+    // long as the tail's expiration never decreases, even if packet time
+    // goes backwards
+    time_t expires = packet_time() + MAX_WAIT;
+
+    if ( expires < node->expires )
+        expires = node->expires;
+
+    last->expires = node->expires = expires;
     ++expects;
     if ( new_expect_flow )
     {
@@ -417,12 +874,29 @@ int ExpectCache::add_flow(const Packet *ctrlPkt, PktType type, IpProtocol ip_pro
 
 bool ExpectCache::is_expected(Packet* p)
 {
+    if ( shared )
+    {
+        ExpectSlot* slot = find_shared(p);
+
+        if ( !slot )
+            return false;
+
+        slot->release();
+        return true;
+    }
+
     FlowKey key;
     return (find_node_by_packet(p, key) != nullptr);
 }
 
 bool ExpectCache::check(Packet* p, Flow* lws)
 {
+    if ( shared )
+    {
+        ExpectSlot* slot = find_shared(p);
+        return slot ? process_shared(slot, p, lws) : false;
+    }
+
     FlowKey key;
     ExpectNode* node = find_node_by_packet(p, key);
 
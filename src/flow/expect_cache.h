@@ -54,17 +54,28 @@
 // -- new list structs are appended to node's list struct chain
 // -- matching expected sessions are pulled off from the head of the node's
 //    list struct chain
+// -- each list struct expires on its own; only the tail is added to or
+//    extended and its expiration never decreases so the chain is in
+//    expiration order and expired sessions are dropped from the head when
+//    the 3-tuple is looked up
+// -- when full, nodes are still pruned as a whole, LRU first, regardless
+//    of expiration
 //
-// FIXIT-M expiration is by node struct but should be by list struct, ie
-//    individual sessions, not all sessions to a given 3-tuple
-//    (this would make pruning a little harder unless we add linkage
-//    a la FlowCache)
+// with stream.shared_expect, the hash, nodes, and list structs are not
+// used.  instead, all packet threads share one table of slots, one per
+// expected session, so an expected flow is realized by whichever thread
+// sees it first.  slots added by a packet are held by that thread until
+// the packet is reset so get_expect_flows() stays valid.  sessions are
+// not pruned; when no slot near the key's home is free or expired the add
+// fails as an overflow.  see ExpectTable in expect_cache.cc.
 //-------------------------------------------------------------------------
+#include <ctime>
 #include <vector>
 #include "flow/flow_key.h"
 #include "target_based/snort_protocols.h"
 
 struct ExpectNode;
+struct ExpectSlot;
 
 namespace snort
 {
@@ -76,6 +87,7 @@ struct SO_PUBLIC ExpectFlow
 {
     struct ExpectFlow* next;
     snort::FlowData* data;
+    time_t expires;
 
     ~ExpectFlow();
     void clear();
@@ -89,7 +101,7 @@ struct SO_PUBLIC ExpectFlow
 class ExpectCache
 {
 public:
-    ExpectCache(uint32_t max);
+    ExpectCache(uint32_t max, bool shared = false);
     ~ExpectCache();
 
     ExpectCache(const ExpectCache&) = delete;
@@ -107,9 +119,12 @@ public:
     unsigned long get_realized() { return realized; }
     unsigned long get_prunes() { return prunes; }
     unsigned long get_overflows() { return overflows; }
+    unsigned long get_expired() { return expired; }
+    unsigned long get_cross_thread() { return cross_thread; }
 
 private:
     void prune_lru();
+    void clear_expired(ExpectNode*, time_t);
 
     ExpectNode* get_node(snort::FlowKey&, bool&);
     snort::ExpectFlow* get_flow(ExpectNode*, uint32_t, int16_t);
@@ -117,16 +132,28 @@ private:
     ExpectNode* find_node_by_packet(snort::Packet*, snort::FlowKey&);
     bool process_expected(ExpectNode*, snort::FlowKey&, snort::Packet*, snort::Flow*);
 
+    int add_shared(const snort::Packet*, snort::FlowKey&, bool reversed_key, IpProtocol,
+        const snort::SfIp* cliIP, uint16_t cliPort, const snort::SfIp* srvIP, uint16_t srvPort,
+        char direction, snort::FlowData*, SnortProtocolId);
+    ExpectSlot* take_shared(uint32_t tag, time_t);
+    ExpectSlot* find_shared(snort::Packet*);
+    ExpectSlot* find_shared(const snort::FlowKey&, bool reversed_key, time_t);
+    bool process_shared(ExpectSlot*, snort::Packet*, snort::Flow*);
+    void clear_slot(ExpectSlot*);
+
 private:
-    class ZHash* hash_table;
-    ExpectNode* nodes;
-    snort::ExpectFlow* pool;
-    snort::ExpectFlow* free_list;
+    class ZHash* hash_table = nullptr;
+    ExpectNode* nodes = nullptr;
+    snort::ExpectFlow* pool = nullptr;
+    snort::ExpectFlow* free_list = nullptr;
+    class ExpectTable* shared = nullptr;
 
     unsigned long expects = 0;
     unsigned long realized = 0;
     unsigned long prunes = 0;
     unsigned long overflows = 0;
+    unsigned long expired = 0;
+    unsigned long cross_thread = 0;
 };
 
 #endif
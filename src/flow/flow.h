@@ -151,6 +151,25 @@ struct FlowStats
     uint64_t client_bytes;
     uint64_t server_bytes;
     struct timeval start_time;
+
+    // byte_rate is bytes per second over the last completed rate window
+    uint64_t window_bytes;
+    time_t window_start;
+    uint32_t byte_rate;
+
+    // a window ends with the first packet of a later second
+    void update_rate(time_t now, uint32_t bytes)
+    {
+        if ( now > window_start )
+        {
+            if ( window_start )
+                byte_rate = window_bytes / (now - window_start);
+
+            window_start = now;
+            window_bytes = 0;
+        }
+        window_bytes += bytes;
+    }
 };
 
 struct LwState
@@ -30,11 +30,24 @@ struct FlowTypeConfig
     unsigned cap_weight = 0;
 };
 
+// flows meeting all criteria are offloaded once inspection is done with them
+struct ElephantConfig
+{
+    uint64_t min_bytes = 0;        // both directions; 0 disables
+    unsigned min_rate = 0;         // bytes per second
+    unsigned min_age = 0;          // seconds
+    bool require_service = true;
+
+    bool enabled() const { return min_bytes > 0; }
+};
+
 struct FlowCacheConfig
 {
     unsigned max_flows = 0;
     unsigned pruning_timeout = 0;
+    bool shared_expect = false;
     FlowTypeConfig proto[to_utype(PktType::MAX)];
+    ElephantConfig elephant;
 };
 
 #endif
@@ -473,6 +473,8 @@ unsigned FlowControl::process(Flow* flow, Packet* p)
 
 void FlowControl::update_stats(Flow* flow, Packet* p)
 {
+    flow->flowstats.update_rate(p->pkth->ts.tv_sec, p->pktlen);
+
     if (p->is_from_client())
     {
         flow->flowstats.client_pkts++;
@@ -489,14 +491,14 @@ void FlowControl::update_stats(Flow* flow, Packet* p)
 // expected
 //-------------------------------------------------------------------------
 
-void FlowControl::init_exp(uint32_t max)
+void FlowControl::init_exp(uint32_t max, bool shared)
 {
     max >>= 9;
 
     if ( !max )
         max = 2;
 
-    exp_cache = new ExpectCache(max);
+    exp_cache = new ExpectCache(max, shared);
 }
 
 bool FlowControl::expected_flow(Flow* flow, Packet* p)
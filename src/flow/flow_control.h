@@ -55,7 +55,7 @@ public:
     void set_flow_cache_config(const FlowCacheConfig& cfg);
     const FlowCacheConfig& get_flow_cache_config() const;
     void init_proto(PktType, snort::InspectSsnFunc);
-    void init_exp(uint32_t max);
+    void init_exp(uint32_t max, bool shared = false);
     unsigned get_flows_allocated() const;
 
     bool process(PktType, snort::Packet*, bool* new_flow = nullptr);
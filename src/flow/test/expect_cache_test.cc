@@ -0,0 +1,323 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// expect_cache_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow/expect_cache.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "flow/flow.h"
+#include "framework/data_bus.h"
+#include "framework/inspector.h"
+#include "main/snort_config.h"
+#include "main/thread_config.h"
+#include "packet_io/sfdaq_instance.h"
+#include "protocols/packet.h"
+#include "protocols/vlan.h"
+#include "stream/stream.h"
+#include "time/packet_time.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+static time_t now = 1000;
+static std::vector<FlowData*> taken;
+
+static SnortConfig my_config;
+THREAD_LOCAL SnortConfig* snort_conf = &my_config;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{
+    run_flags = 0;
+    vlan_agnostic = false;
+    addressspace_agnostic = false;
+}
+
+SnortConfig::~SnortConfig() = default;
+
+SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+THREAD_LOCAL unsigned Inspector::slot = 0;
+void Inspector::move_ref(unsigned) { }
+void Inspector::add_ref() { }
+void Inspector::rem_ref() { }
+
+unsigned FlowData::flow_data_id = 0;
+
+FlowData::FlowData(unsigned u, Inspector* ph)
+{
+    id = u;
+    handler = ph;
+    prev = next = nullptr;
+}
+
+FlowData::~FlowData() { }
+
+Flow::Flow() { memset(this, 0, sizeof(*this)); }
+Flow::~Flow() { }
+
+int Flow::set_flow_data(FlowData* fd)
+{
+    taken.emplace_back(fd);
+    return 0;
+}
+
+Packet::Packet(bool) { }
+Packet::~Packet() { }
+
+void DataBus::publish(const char*, DataEvent&, Flow*) { }
+
+int SFDAQInstance::add_expected(const Packet*, const SfIp*, uint16_t, const SfIp*, uint16_t,
+    IpProtocol, unsigned, unsigned)
+{ return 0; }
+
+unsigned ThreadConfig::get_instance_max() { return 1; }
+
+namespace snort
+{
+char* snort_strdup(const char* s)
+{
+    char* d = new char[strlen(s) + 1];
+    strcpy(d, s);
+    return d;
+}
+
+namespace ip
+{
+void IpApi::set(const SfIp& sip, const SfIp& dip)
+{
+    type = IAT_DATA;
+    src = sip;
+    dst = dip;
+    iph = nullptr;
+}
+}
+
+namespace layer
+{
+const vlan::VlanTagHdr* get_vlan_layer(const Packet* const) { return nullptr; }
+}
+
+time_t packet_time() { return now; }
+}
+
+class TestData : public FlowData
+{
+public:
+    TestData(unsigned id) : FlowData(id) { }
+
+    size_t size_of() override
+    { return sizeof(*this); }
+};
+
+// the expected session is for the reply from the server port to the client
+struct TestPacket
+{
+    TestPacket(uint16_t port)
+    {
+        cli.set("10.1.1.1");
+        srv.set("10.2.2.2");
+        srv_port = port;
+
+        hdr.address_space_id = 0;
+        pkt.pkth = &hdr;
+        pkt.proto_bits = 0;
+        pkt.daq_instance = nullptr;
+        pkt.flow = nullptr;
+        pkt.ip_proto_next = IpProtocol::TCP;
+        pkt.ptrs.set_pkt_type(PktType::TCP);
+        pkt.ptrs.ip_api.set(srv, cli);
+        pkt.ptrs.sp = srv_port;
+        pkt.ptrs.dp = 2000;
+    }
+
+    int add(ExpectCache& ec, unsigned id = 1)
+    {
+        FlowData* fd = new TestData(id);
+        int rc = ec.add_flow(&pkt, PktType::TCP, IpProtocol::TCP, &cli, 0, &srv, srv_port,
+            SSN_DIR_BOTH, fd);
+
+        if ( rc )
+            delete fd;
+
+        // unpins the new sessions as when the packet is done
+        ExpectFlow::reset_expect_flows();
+        return rc;
+    }
+
+    Packet* get()
+    {
+        hdr.ts.tv_sec = now;
+        return &pkt;
+    }
+
+    SfIp cli;
+    SfIp srv;
+    uint16_t srv_port;
+    DAQ_PktHdr_t hdr;
+    Packet pkt { false };
+};
+
+// shared tables are sized for max * 8 sessions per thread
+TEST_GROUP(shared_expect)
+{
+    void setup() override
+    {
+        now = 1000;
+    }
+
+    void teardown() override
+    {
+        for ( auto* fd : taken )
+            delete fd;
+
+        taken.clear();
+    }
+};
+
+TEST(shared_expect, expiry_order)
+{
+    ExpectCache ec(1, true);
+    TestPacket tp(21);
+    Flow flow;
+
+    // the same data id can't go in one session twice so these are two sessions
+    CHECK_EQUAL(0, tp.add(ec));
+    now += 100;
+    CHECK_EQUAL(0, tp.add(ec));
+
+    // the first session expires on its own
+    now += 201;
+    CHECK_TRUE(ec.check(tp.get(), &flow));
+    CHECK_EQUAL(1, ec.get_realized());
+
+    CHECK_FALSE(ec.is_expected(tp.get()));
+    CHECK_EQUAL(1, ec.get_expired());
+}
+
+TEST(shared_expect, extend_session)
+{
+    ExpectCache ec(1, true);
+    TestPacket tp(21);
+    Flow flow;
+
+    CHECK_EQUAL(0, tp.add(ec, 1));
+    CHECK_EQUAL(0, tp.add(ec, 2));
+
+    CHECK_TRUE(ec.check(tp.get(), &flow));
+    CHECK_EQUAL(2, ec.get_realized());
+    CHECK_FALSE(ec.is_expected(tp.get()));
+}
+
+TEST(shared_expect, no_eviction)
+{
+    ExpectCache ec(1, true);
+    std::vector<TestPacket*> tps;
+
+    for ( uint16_t port = 1; port <= 9; ++port )
+        tps.emplace_back(new TestPacket(port));
+
+    for ( unsigned i = 0; i < 8; ++i )
+    {
+        if ( i == 4 )
+            now += 200;
+
+        CHECK_EQUAL(0, tps[i]->add(ec));
+    }
+
+    // live sessions of other keys are not pruned
+    CHECK_EQUAL(-1, tps[8]->add(ec));
+    CHECK_EQUAL(1, ec.get_overflows());
+    CHECK_EQUAL(0, ec.get_prunes());
+
+    for ( unsigned i = 0; i < 8; ++i )
+        CHECK_TRUE(ec.is_expected(tps[i]->get()));
+
+    // but an expired session is reused
+    now += 101;
+    CHECK_EQUAL(0, tps[8]->add(ec));
+    CHECK_EQUAL(1, ec.get_expired());
+    CHECK_TRUE(ec.is_expected(tps[8]->get()));
+
+    for ( unsigned i = 4; i < 8; ++i )
+        CHECK_TRUE(ec.is_expected(tps[i]->get()));
+
+    for ( auto* tp : tps )
+        delete tp;
+}
+
+static std::atomic<bool> adding;
+
+static void add_others()
+{
+    ExpectCache ec(1, true);
+    TestPacket tp(100);
+
+    for ( unsigned i = 0; i < 200000; ++i )
+        tp.add(ec, 1 + i % 4);
+
+    adding = false;
+}
+
+// adds don't hide sessions of other keys from lookups on other threads
+TEST(shared_expect, find_while_adding)
+{
+    ExpectCache ec(1, true);
+    std::vector<TestPacket*> tps;
+
+    for ( uint16_t port = 1; port <= 4; ++port )
+    {
+        tps.emplace_back(new TestPacket(port));
+        CHECK_EQUAL(0, tps.back()->add(ec));
+    }
+
+    unsigned misses = 0;
+    adding = true;
+
+    std::thread adder(add_others);
+
+    while ( adding )
+    {
+        for ( auto* tp : tps )
+        {
+            if ( !ec.is_expected(tp->get()) )
+                ++misses;
+        }
+    }
+    adder.join();
+
+    CHECK_EQUAL(0, misses);
+
+    for ( auto* tp : tps )
+        delete tp;
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
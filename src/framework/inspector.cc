@@ -115,3 +115,9 @@ void Inspector::add_ref()
 
 void Inspector::rem_ref()
 { --ref_count[slot]; }
+
+void Inspector::move_ref(unsigned from)
+{
+    ++ref_count[slot];
+    --ref_count[from];
+}
@@ -99,6 +99,9 @@ public:
     void add_ref();
     void rem_ref();
 
+    // move a reference taken on another packet thread to this one
+    void move_ref(unsigned from);
+
     bool is_inactive();
 
     void set_service(SnortProtocolId snort_protocol_id_param)
@@ -136,6 +139,21 @@ public:
 
     const char* get_name();
 
+    // overload control may skip sheddable inspectors; inspectors reused
+    // across a reload are updated while packet threads are using them
+    void set_sheddable(bool b)
+    { sheddable.store(b, std::memory_order_relaxed); }
+
+    bool is_sheddable() const
+    { return sheddable.load(std::memory_order_relaxed); }
+
+    // eval latency histogram, see TailLatency; also set on reused inspectors
+    void set_latency_id(unsigned id)
+    { latency_id.store(id, std::memory_order_relaxed); }
+
+    unsigned get_latency_id() const
+    { return latency_id.load(std::memory_order_relaxed); }
+
 public:
     static unsigned max_slots;
     static THREAD_LOCAL unsigned slot;
@@ -148,6 +166,8 @@ private:
     const InspectApi* api;
     std::atomic_uint* ref_count;
     SnortProtocolId snort_protocol_id;
+    std::atomic<unsigned> latency_id { ~0u };
+    std::atomic<bool> sheddable { false };
 };
 
 template <typename T>
@@ -0,0 +1,180 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// hash_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <vector>
+
+#include "catch/snort_catch.h"
+#include "flow/flow_key.h"
+
+#include "ghash.h"
+#include "xhash.h"
+#include "zhash.h"
+
+using namespace snort;
+
+// the same keys are generated on every run; run snort with -H so the hash
+// functions are also the same and results are comparable
+static std::vector<uint8_t> make_keys(unsigned num, unsigned key_len, unsigned seed)
+{
+    std::vector<uint8_t> keys(num * key_len);
+
+    for ( auto& b : keys )
+    {
+        seed = seed * 1103515245 + 12345;
+        b = seed >> 16;
+    }
+    return keys;
+}
+
+static const unsigned num_keys = 64 * 1024;
+static const unsigned key_len = 16;
+
+TEST_CASE("xhash", "[xhash][.benchmark]")
+{
+    const std::vector<uint8_t> keys = make_keys(num_keys, key_len, 1);
+    const std::vector<uint8_t> misses = make_keys(num_keys, key_len, 2);
+    uint32_t data = 0;
+
+    BENCHMARK("insert and release")
+    {
+        XHash xh(num_keys, key_len, sizeof(data), 0);
+
+        for ( unsigned i = 0; i < num_keys; ++i )
+            xh.insert(&keys[i * key_len], &data);
+
+        for ( unsigned i = 0; i < num_keys; ++i )
+            xh.release_node(&keys[i * key_len]);
+
+        return xh.get_num_nodes();
+    };
+
+    XHash xh(num_keys, key_len, sizeof(data), 0);
+
+    for ( unsigned i = 0; i < num_keys; ++i )
+        xh.insert(&keys[i * key_len], &data);
+
+    BENCHMARK("find hit")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += xh.find_node(&keys[i * key_len]) != nullptr;
+        return found;
+    };
+
+    BENCHMARK("find miss")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += xh.find_node(&misses[i * key_len]) != nullptr;
+        return found;
+    };
+}
+
+// zhash uses flow key operations so keys are flow key sized
+TEST_CASE("zhash", "[zhash][.benchmark]")
+{
+    const unsigned len = sizeof(FlowKey);
+    const std::vector<uint8_t> keys = make_keys(num_keys, len, 1);
+    const std::vector<uint8_t> misses = make_keys(num_keys, len, 2);
+    std::vector<unsigned> data(num_keys);
+
+    ZHash zh(num_keys, len);
+
+    for ( auto& d : data )
+        zh.push(&d);
+
+    BENCHMARK("get and remove")
+    {
+        for ( unsigned i = 0; i < num_keys; ++i )
+            zh.get(&keys[i * len]);
+
+        unsigned removed = 0;
+
+        while ( zh.lru_first() )
+        {
+            zh.push(zh.remove());
+            ++removed;
+        }
+        return removed;
+    };
+
+    for ( unsigned i = 0; i < num_keys; ++i )
+        zh.get(&keys[i * len]);
+
+    BENCHMARK("find hit")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += zh.find_node(&keys[i * len]) != nullptr;
+        return found;
+    };
+
+    BENCHMARK("find miss")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += zh.find_node(&misses[i * len]) != nullptr;
+        return found;
+    };
+}
+
+TEST_CASE("ghash", "[ghash][.benchmark]")
+{
+    const std::vector<uint8_t> keys = make_keys(num_keys, key_len, 1);
+    const std::vector<uint8_t> misses = make_keys(num_keys, key_len, 2);
+    unsigned data = 0;
+
+    BENCHMARK("insert and remove")
+    {
+        GHash gh(num_keys, key_len, true, nullptr);
+
+        for ( unsigned i = 0; i < num_keys; ++i )
+            gh.insert(&keys[i * key_len], &data);
+
+        for ( unsigned i = 0; i < num_keys; ++i )
+            gh.remove(&keys[i * key_len]);
+
+        return gh.get_count();
+    };
+
+    GHash gh(num_keys, key_len, true, nullptr);
+
+    for ( unsigned i = 0; i < num_keys; ++i )
+        gh.insert(&keys[i * key_len], &data);
+
+    BENCHMARK("find hit")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += gh.find(&keys[i * key_len]) != nullptr;
+        return found;
+    };
+
+    BENCHMARK("find miss")
+    {
+        unsigned found = 0;
+        for ( unsigned i = 0; i < num_keys; ++i )
+            found += gh.find(&misses[i * key_len]) != nullptr;
+        return found;
+    };
+}
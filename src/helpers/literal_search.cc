@@ -28,6 +28,7 @@
 #include "main/snort_config.h"
 #include "boyer_moore_search.h"
 #include "hyper_search.h"
+#include "simd_search.h"
 
 namespace snort
 {
@@ -58,12 +59,29 @@ void LiteralSearch::cleanup(LiteralSearch::Handle* h)
 LiteralSearch* LiteralSearch::instantiate(
     LiteralSearch::Handle* h, const uint8_t* pattern, unsigned pattern_len, bool no_case)
 {
+    const SnortConfig* sc = SnortConfig::get_conf();
+
 #ifdef HAVE_HYPERSCAN
-    if ( SnortConfig::get_conf()->hyperscan_literals )
+    if ( sc->hyperscan_literals )
         return new HyperSearch(h, pattern, pattern_len, no_case);
 #else
     UNUSED(h);
 #endif
+
+    switch ( sc->literal_search )
+    {
+    case SIMD:
+        return new SimdSearch(pattern, pattern_len, no_case);
+
+    case AUTO:
+        if ( pattern_len <= SimdSearch::max_auto_len and SimdSearch::is_supported() )
+            return new SimdSearch(pattern, pattern_len, no_case);
+        break;
+
+    default:
+        break;
+    }
+
     if ( no_case )
         return new snort::BoyerMooreSearchNoCase(pattern, pattern_len);
 
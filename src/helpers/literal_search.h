@@ -33,6 +33,9 @@ class SO_PUBLIC LiteralSearch
 public:
     using Handle = void;
 
+    // SnortConfig::literal_search; hyperscan_literals takes precedence
+    enum Method { AUTO, BOYER_MOORE, SIMD };
+
     static Handle* setup();        // call from module ctor
     static void cleanup(Handle*);  // call from module dtor
 
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// literal_search_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <vector>
+
+#include "catch/snort_catch.h"
+
+#include "boyer_moore_search.h"
+#include "simd_search.h"
+
+using namespace snort;
+
+// the pattern is placed at the end of the buffer so every search is a full scan;
+// the filler shares bytes with the pattern so candidates must be verified
+static std::vector<uint8_t> make_buffer(const std::string& pat, unsigned len)
+{
+    std::vector<uint8_t> buf(len);
+    unsigned seed = 1;
+
+    for ( auto& b : buf )
+    {
+        seed = seed * 1103515245 + 12345;
+        b = 'A' + (seed >> 16) % 26;
+    }
+    std::copy(pat.begin(), pat.end(), buf.end() - pat.size());
+    return buf;
+}
+
+static void bench(unsigned pat_len, unsigned buf_len)
+{
+    std::string pat;
+
+    for ( unsigned i = 0; i < pat_len; ++i )
+        pat += 'A' + (i * 7) % 26;
+
+    const std::vector<uint8_t> buf = make_buffer(pat, buf_len);
+    const uint8_t* p = (const uint8_t*)pat.c_str();
+
+    BoyerMooreSearchCase bm(p, pat_len);
+    BoyerMooreSearchNoCase bmn(p, pat_len);
+    SimdSearch ss(p, pat_len);
+    SimdSearch ssn(p, pat_len, true);
+
+    std::string tag = std::to_string(pat_len) + " / " + std::to_string(buf_len);
+
+    BENCHMARK("boyer-moore " + tag)
+    { return bm.search(buf.data(), buf.size()); };
+
+    BENCHMARK("simd " + tag)
+    { return ss.search(buf.data(), buf.size()); };
+
+    BENCHMARK("boyer-moore nocase " + tag)
+    { return bmn.search(buf.data(), buf.size()); };
+
+    BENCHMARK("simd nocase " + tag)
+    { return ssn.search(buf.data(), buf.size()); };
+}
+
+// use the results to tune SimdSearch::max_auto_len
+TEST_CASE("literal search", "[literal_search][.benchmark]")
+{
+    for ( unsigned buf_len : { 64, 512, 1460, 65536 } )
+    {
+        for ( unsigned pat_len : { 1, 2, 4, 8, 16, 32, 64 } )
+            bench(pat_len, buf_len);
+    }
+}
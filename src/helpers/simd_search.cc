@@ -0,0 +1,190 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// simd_search.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "simd_search.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+
+#include "utils/cpu_features.h"
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace snort
+{
+
+// first and last bytes of s already match
+static inline bool verify(const SimdPattern& sp, const uint8_t* s)
+{
+    if ( sp.pattern_len <= 2 )
+        return true;
+
+    if ( !sp.no_case )
+        return !memcmp(s + 1, sp.pattern + 1, sp.pattern_len - 2);
+
+    for ( unsigned i = 1; i < sp.pattern_len - 1; ++i )
+        if ( toupper(s[i]) != sp.pattern[i] )
+            return false;
+
+    return true;
+}
+
+static inline bool is_first(const SimdPattern& sp, uint8_t c)
+{ return c == sp.first[0] or c == sp.first[1]; }
+
+static inline bool is_last(const SimdPattern& sp, uint8_t c)
+{ return c == sp.last[0] or c == sp.last[1]; }
+
+// check positions from start up to the last that fits the pattern
+static int search_tail(const SimdPattern& sp, const uint8_t* buf, unsigned len, unsigned start)
+{
+    if ( len < sp.pattern_len )
+        return -1;
+
+    const unsigned end = len - sp.pattern_len;
+    const unsigned off = sp.pattern_len - 1;
+
+    for ( unsigned i = start; i <= end; ++i )
+    {
+        if ( is_first(sp, buf[i]) and is_last(sp, buf[i + off]) and verify(sp, buf + i) )
+            return i;
+    }
+    return -1;
+}
+
+#ifdef HAVE_X86_SIMD
+SIMD_TARGET("sse2")
+static int search_sse2(const SimdPattern& sp, const uint8_t* buf, unsigned len)
+{
+    const unsigned off = sp.pattern_len - 1;
+
+    const __m128i f0 = _mm_set1_epi8(sp.first[0]);
+    const __m128i f1 = _mm_set1_epi8(sp.first[1]);
+    const __m128i l0 = _mm_set1_epi8(sp.last[0]);
+    const __m128i l1 = _mm_set1_epi8(sp.last[1]);
+
+    unsigned i = 0;
+
+    for ( ; i + off + 16 <= len; i += 16 )
+    {
+        __m128i bf = _mm_loadu_si128((const __m128i*)(buf + i));
+        __m128i bl = _mm_loadu_si128((const __m128i*)(buf + i + off));
+
+        __m128i ef = _mm_or_si128(_mm_cmpeq_epi8(bf, f0), _mm_cmpeq_epi8(bf, f1));
+        __m128i el = _mm_or_si128(_mm_cmpeq_epi8(bl, l0), _mm_cmpeq_epi8(bl, l1));
+
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(ef, el));
+
+        while ( mask )
+        {
+            unsigned bit = __builtin_ctz(mask);
+
+            if ( verify(sp, buf + i + bit) )
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+    return search_tail(sp, buf, len, i);
+}
+
+SIMD_TARGET("avx2")
+static int search_avx2(const SimdPattern& sp, const uint8_t* buf, unsigned len)
+{
+    const unsigned off = sp.pattern_len - 1;
+
+    const __m256i f0 = _mm256_set1_epi8(sp.first[0]);
+    const __m256i f1 = _mm256_set1_epi8(sp.first[1]);
+    const __m256i l0 = _mm256_set1_epi8(sp.last[0]);
+    const __m256i l1 = _mm256_set1_epi8(sp.last[1]);
+
+    unsigned i = 0;
+
+    for ( ; i + off + 32 <= len; i += 32 )
+    {
+        __m256i bf = _mm256_loadu_si256((const __m256i*)(buf + i));
+        __m256i bl = _mm256_loadu_si256((const __m256i*)(buf + i + off));
+
+        __m256i ef = _mm256_or_si256(_mm256_cmpeq_epi8(bf, f0), _mm256_cmpeq_epi8(bf, f1));
+        __m256i el = _mm256_or_si256(_mm256_cmpeq_epi8(bl, l0), _mm256_cmpeq_epi8(bl, l1));
+
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(ef, el));
+
+        while ( mask )
+        {
+            unsigned bit = __builtin_ctz(mask);
+
+            if ( verify(sp, buf + i + bit) )
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+    // finish with sse2 which falls back to scalar for the last few bytes
+    int pos = search_sse2(sp, buf + i, len - i);
+    return pos < 0 ? pos : pos + i;
+}
+#endif
+
+SimdSearch::SimdSearch(const uint8_t* pattern, unsigned pattern_len, bool no_case)
+{
+    assert(pattern_len > 0);
+
+    sp.pattern = pattern;
+    sp.pattern_len = pattern_len;
+    sp.no_case = no_case;
+
+    uint8_t f = pattern[0];
+    uint8_t l = pattern[pattern_len - 1];
+
+    sp.first[0] = f;
+    sp.last[0] = l;
+
+    sp.first[1] = no_case ? tolower(f) : f;
+    sp.last[1] = no_case ? tolower(l) : l;
+
+    sse2 = cpu_has_sse2();
+    avx2 = cpu_has_avx2();
+}
+
+bool SimdSearch::is_supported()
+{ return cpu_has_sse2(); }
+
+int SimdSearch::search(const uint8_t* buffer, unsigned buffer_len) const
+{
+#ifdef HAVE_X86_SIMD
+    // short buffers get nothing from the wider vectors
+    if ( avx2 and buffer_len >= sp.pattern_len + 63 )
+        return search_avx2(sp, buffer, buffer_len);
+
+    if ( sse2 )
+        return search_sse2(sp, buffer, buffer_len);
+#endif
+    return search_tail(sp, buffer, buffer_len, 0);
+}
+
+}
+
@@ -0,0 +1,70 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// simd_search.h
+
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+// vectorized literal content matching (single pattern)
+// candidates are positions where both the first and last bytes of the
+// pattern match; these are found 16 or 32 at a time and then verified.
+// use LiteralSearch::instantiate to get this where it is the better choice.
+
+#include "helpers/literal_search.h"
+#include "main/snort_types.h"
+
+namespace snort
+{
+
+struct SimdPattern
+{
+    const uint8_t* pattern;
+    unsigned pattern_len;
+    bool no_case;
+
+    // [0] is the pattern byte, [1] is the other case if no_case
+    uint8_t first[2];
+    uint8_t last[2];
+};
+
+class SO_PUBLIC SimdSearch : public LiteralSearch
+{
+public:
+    // no_case patterns must be upper case, as with BoyerMooreSearchNoCase
+    SimdSearch(const uint8_t* pattern, unsigned pattern_len, bool no_case = false);
+
+    int search(const uint8_t* buffer, unsigned buffer_len) const;
+
+    int search(void*, const uint8_t* buffer, unsigned buffer_len) const override
+    { return search(buffer, buffer_len); }
+
+    // false if the cpu has no vector unit we use
+    static bool is_supported();
+
+    // longer patterns get larger Boyer-Moore skips and are better left to it
+    static constexpr unsigned max_auto_len = 32;
+
+private:
+    SimdPattern sp;
+    bool sse2;
+    bool avx2;
+};
+
+}
+#endif
+
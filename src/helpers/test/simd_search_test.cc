@@ -0,0 +1,137 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// simd_search_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "../simd_search.h"
+
+#include <algorithm>
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+#include <string>
+
+using namespace std;
+using namespace snort;
+
+enum TestType
+{
+    CASE,
+    NOCASE,
+};
+
+static int simd_find(const string& pat_str, const string& buf_str, TestType type)
+{
+    string pat = pat_str;
+
+    if ( type == NOCASE )
+        transform(pat.begin(), pat.end(), pat.begin(), ::toupper);
+
+    SimdSearch ss((const uint8_t*)pat.c_str(), pat.length(), type == NOCASE);
+    return ss.search((const uint8_t*)buf_str.c_str(), buf_str.length());
+}
+
+TEST_GROUP(simd_search_test_group) {};
+
+TEST(simd_search_test_group, binary)
+{
+    const uint8_t pat[] = { 0xCA, 0xFE, 0xBA, 0xBE };
+
+    const uint8_t buf[] = {
+        0x00, 0x01, 0x02, 0x03,
+        0x72, 0x01, 0x3F, 0x2B,
+        0x1F, 0xCA, 0xFE, 0xBA,
+        0xBE, 0x01, 0x02, 0x03,
+    };
+
+    SimdSearch ss(pat, sizeof(pat));
+    CHECK(ss.search(buf, sizeof(buf)) == 9);
+}
+
+TEST(simd_search_test_group, empty)
+{
+    CHECK(simd_find("abc", "", CASE) == -1);
+}
+
+TEST(simd_search_test_group, start)
+{
+    CHECK(simd_find("abc", "abc", CASE) == 0);
+    CHECK(simd_find("abc", "aBc", NOCASE) == 0);
+}
+
+TEST(simd_search_test_group, found)
+{
+    CHECK(simd_find("d", "abcdefg", CASE) == 3);
+    CHECK(simd_find("nan", "banana", CASE) == 2);
+    CHECK(simd_find("pan", "anpanman", CASE) == 2);
+    CHECK(simd_find("bcd", "abcd", CASE) == 1);
+    CHECK(simd_find("aa", "aaa", CASE) == 0);
+    CHECK(simd_find("that", "which finally halts at tHaT point", NOCASE) == 23);
+}
+
+TEST(simd_search_test_group, not_found)
+{
+    CHECK(simd_find("nnaaman", "anpanmanam", CASE) == -1);
+    CHECK(simd_find("abcd", "abc", CASE) == -1);
+    CHECK(simd_find("abcd", "bcd", CASE) == -1);
+    CHECK(simd_find("baa", "aaaaa", CASE) == -1);
+    CHECK(simd_find("that", "which finally halts at tHaT point", CASE) == -1);
+}
+
+// exercise the 16 and 32 byte blocks and the scalar tail at every offset
+TEST(simd_search_test_group, long_buffers)
+{
+    const string pat = "GET /index";
+
+    for ( unsigned len = pat.length(); len < 200; ++len )
+    {
+        for ( unsigned pos = 0; pos + pat.length() <= len; pos += 7 )
+        {
+            string buf(len, 'G');
+            buf.replace(pos, pat.length(), pat);
+            CHECK(simd_find(pat, buf, CASE) == (int)pos);
+
+            string lower = buf;
+            transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+            CHECK(simd_find(pat, lower, NOCASE) == (int)pos);
+            CHECK(simd_find(pat, lower, CASE) == -1);
+        }
+    }
+}
+
+// candidates with matching first and last bytes but a bad middle
+TEST(simd_search_test_group, false_candidates)
+{
+    string buf;
+
+    for ( unsigned i = 0; i < 20; ++i )
+        buf += "axxxz";
+
+    CHECK(simd_find("ayyyz", buf, CASE) == -1);
+
+    buf += "ayyyz";
+    CHECK(simd_find("ayyyz", buf, CASE) == 100);
+    CHECK(simd_find("AYYYZ", buf, NOCASE) == 100);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
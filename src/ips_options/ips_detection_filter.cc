@@ -26,6 +26,7 @@
 
 #include "detection/treenodes.h"
 #include "filters/detection_filter.h"
+#include "filters/global_counts.h"
 #include "filters/sfthd.h"
 #include "framework/decode_data.h"
 #include "framework/ips_option.h"
@@ -51,12 +52,26 @@ static const Parameter s_params[] =
     { "seconds", Parameter::PT_INT, "1:max32", nullptr,
       "length of interval to count hits" },
 
+    { "global", Parameter::PT_IMPLIED, nullptr, nullptr,
+      "count hits from all packet threads" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
 #define s_help \
     "rule option to require multiple hits before a rule generates an event"
 
+extern THREAD_LOCAL GlobalCountStats detection_filter_stats;
+
+static const PegInfo s_pegs[] =
+{
+    { CountType::SUM, "global_merges", "number of merges of local hits into global tracking" },
+    { CountType::SUM, "global_merge_usecs", "total time spent merging into global tracking" },
+    { CountType::MAX, "global_max_merge_usecs", "maximum time spent on one global merge" },
+    { CountType::SUM, "global_no_memory", "number of times global tracking ran out of memory" },
+    { CountType::END, nullptr, nullptr }
+};
+
 class DetectionFilterModule : public Module
 {
 public:
@@ -64,6 +79,12 @@ public:
     bool set(const char*, Value&, SnortConfig*) override;
     bool begin(const char*, int, SnortConfig*) override;
 
+    const PegInfo* get_pegs() const override
+    { return s_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&detection_filter_stats; }
+
     Usage get_usage() const override
     { return DETECT; }
 
@@ -91,6 +112,9 @@ bool DetectionFilterModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("seconds") )
         thdx.seconds = v.get_uint32();
 
+    else if ( v.is("global") )
+        thdx.global = true;
+
     else
         return false;
 
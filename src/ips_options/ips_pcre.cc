@@ -27,12 +27,20 @@
 
 #include <cassert>
 
+#ifdef HAVE_HYPERSCAN
+#include <hs_compile.h>
+#include <hs_runtime.h>
+#endif
+
 #include "framework/cursor.h"
 #include "framework/ips_option.h"
 #include "framework/module.h"
 #include "framework/parameter.h"
 #include "hash/hash_key_operations.h"
 #include "helpers/scratch_allocator.h"
+#ifdef HAVE_HYPERSCAN
+#include "helpers/hyper_scratch_allocator.h"
+#endif
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "managers/ips_manager.h"
@@ -43,19 +51,23 @@
 using namespace snort;
 
 #ifndef PCRE_STUDY_JIT_COMPILE
-#define PCRE_STUDY_JIT_COMPILE 0
+#define NO_JIT // pcre older than 8.20
 #endif
 
-#define NO_JIT // uncomment to disable JIT for Xcode
+//#define NO_JIT // uncomment to disable JIT for Xcode
 
 #ifdef NO_JIT
-#define PCRE_STUDY_FLAGS 0
 #define pcre_release(x) pcre_free(x)
 #else
-#define PCRE_STUDY_FLAGS PCRE_STUDY_JIT_COMPILE
 #define pcre_release(x) pcre_free_study(x)
 #endif
 
+// jit code runs on its own stack instead of the thread stack so deep
+// patterns don't fail where the interpreter would have succeeded within
+// the recursion limit.  each packet thread gets one.
+#define JIT_STACK_MIN (32 * 1024)
+#define JIT_STACK_MAX (1024 * 1024)
+
 #define SNORT_PCRE_RELATIVE         0x00010 // relative to the end of the last match
 #define SNORT_PCRE_INVERT           0x00020 // invert detect
 #define SNORT_PCRE_ANCHORED         0x00040
@@ -71,6 +83,16 @@ struct PcreData
     bool free_pe;
     int options;        /* sp_pcre specific options (relative & inverse) */
     char* expression;
+#ifdef HAVE_HYPERSCAN
+    hs_database_t* db;  /* prefilter; no match here means no pcre match */
+#endif
+};
+
+// per packet thread state in snort conf
+struct PcreScratch
+{
+    int* ovector;
+    pcre_jit_stack* jit_stack;
 };
 
 // we need to specify the vector length for our pcre_exec call.  we only care
@@ -85,12 +107,105 @@ static int s_ovector_max = -1;
 static unsigned scratch_index;
 static ScratchAllocator* scratcher = nullptr;
 
+#ifdef HAVE_HYPERSCAN
+static HyperScratchAllocator* hs_scratcher = nullptr;
+#endif
+
 static THREAD_LOCAL ProfileStats pcrePerfStats;
 
+struct PcreStats
+{
+    PegCount pcre_rules;
+#ifdef HAVE_HYPERSCAN
+    PegCount pcre_to_hyper;
+    PegCount pcre_prefilter;
+#endif
+    PegCount pcre_native;
+    PegCount pcre_jit;
+    PegCount pcre_negated;
+};
+
+static PcreStats pcre_stats;
+
 //-------------------------------------------------------------------------
 // implementation foo
 //-------------------------------------------------------------------------
 
+static PcreScratch* get_scratch()
+{
+    std::vector<void*>& ss = SnortConfig::get_conf()->state[get_instance_id()];
+    assert(ss[scratch_index]);
+    return (PcreScratch*)ss[scratch_index];
+}
+
+#ifndef NO_JIT
+static pcre_jit_stack* get_jit_stack(void*)
+{ return get_scratch()->jit_stack; }
+#endif
+
+#ifdef HAVE_HYPERSCAN
+// hyperscan in prefilter mode may match where pcre does not but never the
+// reverse, so it only needs to accept the same subject as pcre_exec.  a
+// prefilter is skipped for the flags hyperscan doesn't support (xEG); A is
+// dropped because an unanchored match is a superset.
+static void pcre_prefilter(const char* re, int compile_flags, PcreData* pcre_data)
+{
+    if ( compile_flags & (PCRE_EXTENDED | PCRE_DOLLAR_ENDONLY | PCRE_UNGREEDY) )
+        return;
+
+    if ( hs_valid_platform() != HS_SUCCESS )
+        return;
+
+    unsigned flags = HS_FLAG_PREFILTER | HS_FLAG_SINGLEMATCH;
+
+    if ( compile_flags & PCRE_CASELESS )
+        flags |= HS_FLAG_CASELESS;
+
+    if ( compile_flags & PCRE_DOTALL )
+        flags |= HS_FLAG_DOTALL;
+
+    if ( compile_flags & PCRE_MULTILINE )
+        flags |= HS_FLAG_MULTILINE;
+
+    hs_compile_error_t* err = nullptr;
+
+    // some expressions can't be prefiltered, eg those matching empty
+    if ( hs_compile(re, flags, HS_MODE_BLOCK, nullptr, &pcre_data->db, &err) != HS_SUCCESS )
+    {
+        hs_free_compile_error(err);
+        pcre_data->db = nullptr;
+        return;
+    }
+
+    if ( !hs_scratcher->allocate(pcre_data->db) )
+    {
+        hs_free_database(pcre_data->db);
+        pcre_data->db = nullptr;
+        return;
+    }
+    pcre_stats.pcre_prefilter++;
+}
+
+static int prefilter_match(unsigned, unsigned long long, unsigned long long, unsigned, void*)
+{ return 1; }
+
+static bool prefilter_reject(const PcreData* pcre_data, const uint8_t* buf, unsigned len)
+{
+    if ( !pcre_data->db )
+        return false;
+
+    hs_error_t stat = hs_scan(
+        pcre_data->db, (const char*)buf, len, 0, hs_scratcher->get(), prefilter_match, nullptr);
+
+    // anything but a clean scan without a match must go to pcre
+    if ( stat != HS_SUCCESS )
+        return false;
+
+    pc.pcre_prefilter_rejects++;
+    return true;
+}
+#endif
+
 static void pcre_capture(
     const void* code, const void* extra)
 {
@@ -161,6 +276,7 @@ static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_d
     char delimit = '/';
     int erroffset;
     int compile_flags = 0;
+    int study_flags = 0;
 
     if (data == nullptr)
     {
@@ -268,7 +384,23 @@ static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_d
     }
 
     /* now study it... */
-    pcre_data->pe = pcre_study(pcre_data->re, PCRE_STUDY_FLAGS, &error);
+#ifndef NO_JIT
+    // jit code ignores match_limit_recursion so the interpreter is kept
+    // whenever that limit applies to this expression
+    if ( !SnortConfig::get_pcre_match_limit_recursion() or
+        (pcre_data->options & SNORT_OVERRIDE_MATCH_LIMIT) )
+        study_flags = PCRE_STUDY_JIT_COMPILE;
+#endif
+
+    pcre_data->pe = pcre_study(pcre_data->re, study_flags, &error);
+
+#ifndef NO_JIT
+    if ( pcre_data->pe and (pcre_data->pe->flags & PCRE_EXTRA_EXECUTABLE_JIT) )
+    {
+        pcre_assign_jit_stack(pcre_data->pe, get_jit_stack, nullptr);
+        pcre_stats.pcre_jit++;
+    }
+#endif
 
     if (pcre_data->pe)
     {
@@ -324,6 +456,11 @@ static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_d
     pcre_capture(pcre_data->re, pcre_data->pe);
     pcre_check_anchored(pcre_data);
 
+#ifdef HAVE_HYPERSCAN
+    if ( sc->pcre_prefilter )
+        pcre_prefilter(re, compile_flags, pcre_data);
+#endif
+
     snort_free(free_me);
     return;
 
@@ -352,8 +489,12 @@ static bool pcre_search(
 
     found_offset = -1;
 
-    std::vector<void *> ss = SnortConfig::get_conf()->state[get_instance_id()];
-    assert(ss[scratch_index]);
+#ifdef HAVE_HYPERSCAN
+    if ( prefilter_reject(pcre_data, buf, len) )
+        return (pcre_data->options & SNORT_PCRE_INVERT) != 0;
+#endif
+
+    int* ovector = get_scratch()->ovector;
 
     int result = pcre_exec(
         pcre_data->re,  /* result of pcre_compile() */
@@ -362,7 +503,7 @@ static bool pcre_search(
         len,            /* the length of the subject string */
         start_offset,   /* start at offset 0 in the subject */
         0,              /* options(handled at compile time */
-        (int*)ss[scratch_index], /* vector for substring information */
+        ovector,        /* vector for substring information */
         SnortConfig::get_conf()->pcre_ovector_size); /* number of elements in the vector */
 
     if (result >= 0)
@@ -388,7 +529,7 @@ static bool pcre_search(
          * and a single int for scratch space.
          */
 
-        found_offset = ((int*)ss[scratch_index])[1];
+        found_offset = ovector[1];
     }
     else if (result == PCRE_ERROR_NOMATCH)
     {
@@ -473,6 +614,11 @@ PcreOption::~PcreOption()
     if ( config->re )
         free(config->re);  // external allocation
 
+#ifdef HAVE_HYPERSCAN
+    if ( config->db )
+        hs_free_database(config->db);
+#endif
+
     snort_free(config);
 }
 
@@ -611,29 +757,19 @@ static const Parameter s_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
-struct PcreStats
-{
-    PegCount pcre_rules;
-#ifdef HAVE_HYPERSCAN
-    PegCount pcre_to_hyper;
-#endif
-    PegCount pcre_native;
-    PegCount pcre_negated;
-};
-
 const PegInfo pcre_pegs[] =
 {
     { CountType::SUM, "pcre_rules", "total rules processed with pcre option" },
 #ifdef HAVE_HYPERSCAN
     { CountType::SUM, "pcre_to_hyper", "total pcre rules by hyperscan engine" },
+    { CountType::SUM, "pcre_prefilter", "total pcre rules with a hyperscan prefilter" },
 #endif
     { CountType::SUM, "pcre_native", "total pcre rules compiled by pcre engine" },
+    { CountType::SUM, "pcre_jit", "total pcre rules compiled to native code by the pcre jit" },
     { CountType::SUM, "pcre_negated", "total pcre rules using negation syntax" },
     { CountType::END, nullptr, nullptr }
 };
 
-PcreStats pcre_stats;
-
 #define s_help \
     "rule option for matching payload data with pcre"
 
@@ -645,12 +781,18 @@ public:
         data = nullptr;
         scratcher = new SimpleScratchAllocator(scratch_setup, scratch_cleanup);
         scratch_index = scratcher->get_id();
+#ifdef HAVE_HYPERSCAN
+        hs_scratcher = new HyperScratchAllocator;
+#endif
     }
 
     ~PcreModule() override
     {
         delete data;
         delete scratcher;
+#ifdef HAVE_HYPERSCAN
+        delete hs_scratcher;
+#endif
     }
 
 #ifdef HAVE_HYPERSCAN
@@ -755,8 +897,12 @@ bool PcreModule::scratch_setup(SnortConfig* sc)
 
     for ( unsigned i = 0; i < sc->num_slots; ++i )
     {
-        std::vector<void *>& ss = sc->state[i];
-        ss[scratch_index] = snort_calloc(sc->pcre_ovector_size, sizeof(int));
+        PcreScratch* ps = (PcreScratch*)snort_calloc(sizeof(PcreScratch));
+        ps->ovector = (int*)snort_calloc(sc->pcre_ovector_size, sizeof(int));
+#ifndef NO_JIT
+        ps->jit_stack = pcre_jit_stack_alloc(JIT_STACK_MIN, JIT_STACK_MAX);
+#endif
+        sc->state[i][scratch_index] = ps;
     }
     return true;
 }
@@ -766,7 +912,13 @@ void PcreModule::scratch_cleanup(SnortConfig* sc)
     for ( unsigned i = 0; i < sc->num_slots; ++i )
     {
         std::vector<void *>& ss = sc->state[i];
-        snort_free(ss[scratch_index]);
+        PcreScratch* ps = (PcreScratch*)ss[scratch_index];
+
+        if ( ps->jit_stack )
+            pcre_jit_stack_free(ps->jit_stack);
+
+        snort_free(ps->ovector);
+        snort_free(ps);
         ss[scratch_index] = nullptr;
     }
 }
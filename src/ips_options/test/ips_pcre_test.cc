@@ -0,0 +1,438 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ips_pcre_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pcre.h>
+
+#include "framework/base_api.h"
+#include "framework/counts.h"
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "framework/module.h"
+#include "main/snort_config.h"
+#include "managers/ips_manager.h"
+#include "managers/module_manager.h"
+#include "profiler/profiler_defs.h"
+#include "protocols/packet.h"
+#include "utils/stats.h"
+
+// must appear after snort_config.h to avoid broken c++ map include
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs, spies, etc.
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+
+void mix_str(uint32_t& a, uint32_t&, uint32_t&, const char* s, unsigned)
+{ a += strlen(s); }
+
+SnortConfig s_conf;
+THREAD_LOCAL SnortConfig* snort_conf = &s_conf;
+
+THREAD_LOCAL PacketCount pc;
+
+static std::vector<void *> s_state;
+static std::vector<ScratchAllocator*> s_scratchers;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{
+    state = &s_state;
+    num_slots = 1;
+}
+
+SnortConfig::~SnortConfig() = default;
+
+int SnortConfig::request_scratch(ScratchAllocator* s)
+{
+    s_scratchers.emplace_back(s);
+    s_state.emplace_back(nullptr);
+    return s_state.size() - 1;
+}
+
+void SnortConfig::release_scratch(int id)
+{
+    // hyper scratch requests a second id for the same allocator
+    ScratchAllocator* s = s_scratchers[id];
+
+    for ( auto& p : s_scratchers )
+    {
+        if ( p == s )
+            p = nullptr;
+    }
+}
+
+SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+
+static unsigned s_parse_errors = 0;
+
+void ParseError(const char*, ...)
+{ s_parse_errors++; }
+
+void LogMessage(const char*, ...) { }
+
+unsigned get_instance_id()
+{ return 0; }
+
+// snort_free uses delete[]
+char* snort_strdup(const char* s)
+{
+    char* d = new char[strlen(s) + 1];
+    return strcpy(d, s);
+}
+
+Module* ModuleManager::get_module(const char*)
+{ return nullptr; }
+
+MemoryContext::MemoryContext(MemoryTracker&) { }
+MemoryContext::~MemoryContext() = default;
+
+bool TimeProfilerStats::enabled = false;
+}
+
+extern const BaseApi* ips_pcre;
+
+const IpsApi* IpsManager::get_option_api(const char*)
+{ return nullptr; }
+
+Cursor::Cursor(Packet* p)
+{ set("pkt_data", p->data, p->dsize); }
+
+void show_stats(PegCount*, const PegInfo*, unsigned, const char*) { }
+void show_stats(PegCount*, const PegInfo*, const IndexVec&, const char*, FILE*) { }
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+static const Parameter* get_param(Module* m, const char* s)
+{
+    const Parameter* p = m->get_parameters();
+
+    while ( p and p->name )
+    {
+        if ( !strcmp(p->name, s) )
+            return p;
+        ++p;
+    }
+    return nullptr;
+}
+
+static IpsOption* get_option(Module* mod, const char* pat)
+{
+    mod->begin(ips_pcre->name, 0, snort_conf);
+
+    Value vs(pat);
+    vs.set(get_param(mod, "~re"));
+    mod->set(ips_pcre->name, vs, snort_conf);
+
+    mod->end(ips_pcre->name, 0, snort_conf);
+
+    const IpsApi* api = (const IpsApi*) ips_pcre;
+    IpsOption* opt = api->ctor(mod, nullptr);
+
+    return opt;
+}
+
+static PegCount get_peg(Module* mod, const char* s)
+{
+    const PegInfo* pi = mod->get_pegs();
+
+    for ( unsigned i = 0; pi[i].name; ++i )
+    {
+        if ( !strcmp(pi[i].name, s) )
+            return mod->get_counts()[i];
+    }
+    return 0;
+}
+
+static void reset_pegs(Module* mod)
+{
+    const PegInfo* pi = mod->get_pegs();
+
+    for ( unsigned i = 0; pi[i].name; ++i )
+        mod->get_counts()[i] = 0;
+}
+
+static void scratch_setup()
+{
+    for ( auto* s : s_scratchers )
+    {
+        if ( s )
+            s->setup(snort_conf);
+    }
+}
+
+static void scratch_cleanup()
+{
+    for ( unsigned i = 0; i < s_scratchers.size(); ++i )
+    {
+        if ( s_scratchers[i] and s_state[i] )
+            s_scratchers[i]->cleanup(snort_conf);
+    }
+}
+
+static IpsOption::EvalStatus eval(IpsOption* opt, const char* s)
+{
+    Packet pkt;
+    pkt.data = (const uint8_t*)s;
+    pkt.dsize = strlen(s);
+
+    Cursor c(&pkt);
+    return opt->eval(c, &pkt);
+}
+
+//-------------------------------------------------------------------------
+// base tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(ips_pcre_base)
+{
+    void setup() override
+    { CHECK(ips_pcre); }
+};
+
+TEST(ips_pcre_base, base)
+{
+    CHECK(ips_pcre->type == PT_IPS_OPTION);
+    CHECK(ips_pcre->name);
+    CHECK(ips_pcre->help);
+
+    CHECK(!strcmp(ips_pcre->name, "pcre"));
+
+    CHECK(ips_pcre->mod_ctor);
+    CHECK(ips_pcre->mod_dtor);
+}
+
+TEST(ips_pcre_base, ips_option)
+{
+    const IpsApi* ips_api = (const IpsApi*) ips_pcre;
+
+    CHECK(ips_api->ctor);
+    CHECK(ips_api->dtor);
+}
+
+//-------------------------------------------------------------------------
+// option tests
+//-------------------------------------------------------------------------
+
+TEST_GROUP(ips_pcre_option)
+{
+    Module* mod = nullptr;
+    IpsOption* opt = nullptr;
+
+    void setup() override
+    {
+        s_parse_errors = 0;
+        s_conf.pcre_match_limit_recursion = 1500;
+        s_conf.pcre_override = true;
+        s_conf.pcre_prefilter = false;
+        pc.pcre_recursion_limit = 0;
+        pc.pcre_prefilter_rejects = 0;
+        mod = ips_pcre->mod_ctor();
+        reset_pegs(mod);
+    }
+    void teardown() override
+    {
+        LONGS_EQUAL(0, s_parse_errors);
+        const IpsApi* api = (const IpsApi*) ips_pcre;
+        api->dtor(opt);
+        scratch_cleanup();
+        ips_pcre->mod_dtor(mod);
+    }
+};
+
+TEST(ips_pcre_option, match)
+{
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    Packet pkt;
+    pkt.data = (const uint8_t*) "* foo stew *";
+    pkt.dsize = strlen((const char*) pkt.data);
+
+    Cursor c(&pkt);
+    CHECK(opt->eval(c, &pkt) == IpsOption::MATCH);
+    CHECK(!strcmp((const char*) c.start(), " stew *"));
+    CHECK(opt->retry(c));
+}
+
+TEST(ips_pcre_option, invert)
+{
+    opt = get_option(mod, "!/foo/");
+    scratch_setup();
+
+    CHECK(eval(opt, "* bar stew *") == IpsOption::MATCH);
+    CHECK(eval(opt, "* foo stew *") == IpsOption::NO_MATCH);
+
+    Packet pkt;
+    Cursor c(&pkt);
+    CHECK(!opt->retry(c));
+}
+
+// the jit ignores the recursion limit so the interpreter must be used
+TEST(ips_pcre_option, recursion_limit_interpreted)
+{
+    s_conf.pcre_match_limit_recursion = 8;
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_jit") == 0);
+    CHECK(eval(opt, "* foo stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_recursion_limit == 1);
+}
+
+TEST(ips_pcre_option, recursion_limit_off_jit)
+{
+    s_conf.pcre_match_limit_recursion = 0;
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_jit") == 1);
+    CHECK(eval(opt, "* foo stew *") == IpsOption::MATCH);
+    CHECK(pc.pcre_recursion_limit == 0);
+}
+
+TEST(ips_pcre_option, recursion_limit_override_jit)
+{
+    s_conf.pcre_match_limit_recursion = 8;
+    opt = get_option(mod, "/foo/O");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_jit") == 1);
+    CHECK(eval(opt, "* foo stew *") == IpsOption::MATCH);
+    CHECK(pc.pcre_recursion_limit == 0);
+}
+
+TEST(ips_pcre_option, recursion_limit_no_override)
+{
+    s_conf.pcre_match_limit_recursion = 8;
+    s_conf.pcre_override = false;
+    opt = get_option(mod, "/foo/O");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_jit") == 0);
+    CHECK(eval(opt, "* foo stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_recursion_limit == 1);
+}
+
+//-------------------------------------------------------------------------
+// prefilter tests
+//-------------------------------------------------------------------------
+
+#ifdef HAVE_HYPERSCAN
+TEST(ips_pcre_option, prefilter_off)
+{
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_prefilter") == 0);
+    CHECK(eval(opt, "* bar stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 0);
+}
+
+TEST(ips_pcre_option, prefilter_reject)
+{
+    s_conf.pcre_prefilter = true;
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_prefilter") == 1);
+    CHECK(eval(opt, "* bar stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 1);
+}
+
+TEST(ips_pcre_option, prefilter_pass)
+{
+    s_conf.pcre_prefilter = true;
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(eval(opt, "* foo stew *") == IpsOption::MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 0);
+}
+
+TEST(ips_pcre_option, prefilter_invert)
+{
+    s_conf.pcre_prefilter = true;
+    opt = get_option(mod, "!/foo/");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_prefilter") == 1);
+
+    // a reject still inverts
+    CHECK(eval(opt, "* bar stew *") == IpsOption::MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 1);
+
+    CHECK(eval(opt, "* foo stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 1);
+}
+
+TEST(ips_pcre_option, prefilter_unsupported_flag)
+{
+    s_conf.pcre_prefilter = true;
+    opt = get_option(mod, "/foo/x");
+    scratch_setup();
+
+    CHECK(get_peg(mod, "pcre_prefilter") == 0);
+    CHECK(eval(opt, "* bar stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 0);
+}
+
+// the pcre limits still apply to anything the prefilter passes
+TEST(ips_pcre_option, prefilter_recursion_limit)
+{
+    s_conf.pcre_prefilter = true;
+    s_conf.pcre_match_limit_recursion = 8;
+    opt = get_option(mod, "/foo/");
+    scratch_setup();
+
+    CHECK(eval(opt, "* bar stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 1);
+    CHECK(pc.pcre_recursion_limit == 0);
+
+    CHECK(eval(opt, "* foo stew *") == IpsOption::NO_MATCH);
+    CHECK(pc.pcre_prefilter_rejects == 1);
+    CHECK(pc.pcre_recursion_limit == 1);
+}
+#endif
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    // FIXIT-L cpputest hangs or crashes in the leak detector
+    MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
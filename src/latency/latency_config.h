@@ -21,13 +21,23 @@
 #ifndef LATENCY_CONFIG_H
 #define LATENCY_CONFIG_H
 
+#include "overload_control_config.h"
 #include "packet_latency_config.h"
 #include "rule_latency_config.h"
 
+struct DecompressLatencyConfig
+{
+    hr_duration max_time = CLOCK_ZERO;
+
+    bool enabled() const { return max_time > CLOCK_ZERO; }
+};
+
 struct LatencyConfig
 {
     PacketLatencyConfig packet_latency;
     RuleLatencyConfig rule_latency;
+    DecompressLatencyConfig decompress_latency;
+    OverloadControlConfig overload_control;
 };
 
 #endif
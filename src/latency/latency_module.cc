@@ -78,6 +78,51 @@ static const Parameter s_rule_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter s_decompress_params[] =
+{
+    { "max_time", Parameter::PT_INT, "0:max53", "0",
+        "set cpu budget for inflating one compressed stream (usec, 0 means unlimited)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+static const Parameter s_overload_params[] =
+{
+    { "max_tier", Parameter::PT_INT, "0:3", "0",
+        "highest shedding tier under overload (0 is off, 1 sheds elephant flows, "
+        "2 also skips shed_inspectors, 3 also skips rules below max_priority)" },
+
+    { "check_interval", Parameter::PT_INT, "1:max32", "1000",
+        "time between overload checks (ms)" },
+
+    { "max_backlog", Parameter::PT_INT, "0:max53", "0",
+        "overload when more packets than this are waiting in the daq (0 is ignored)" },
+
+    { "max_latency", Parameter::PT_INT, "0:max53", "0",
+        "overload when the packet latency percentile exceeds this (usec, 0 is ignored)" },
+
+    { "percentile", Parameter::PT_INT, "1:100", "99",
+        "packet latency percentile compared with max_latency" },
+
+    { "recover_percent", Parameter::PT_INT, "1:100", "50",
+        "recover only when below this percent of max_backlog and max_latency" },
+
+    { "recover_checks", Parameter::PT_INT, "1:max32", "5",
+        "number of consecutive calm checks required to drop one tier" },
+
+    { "elephant_bytes", Parameter::PT_INT, "1:max53", "1048576",
+        "stop inspecting flows with more than this many bytes at tier 1 and up" },
+
+    { "shed_inspectors", Parameter::PT_STRING, nullptr, nullptr,
+        "space separated list of network, service, control, or probe inspectors "
+        "to skip at tier 2 and up" },
+
+    { "max_priority", Parameter::PT_INT, "0:max32", "1",
+        "only evaluate rules with this priority or better at tier 3" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter s_params[] =
 {
     { "packet", Parameter::PT_TABLE, s_packet_params, nullptr,
@@ -86,6 +131,12 @@ static const Parameter s_params[] =
     { "rule", Parameter::PT_TABLE, s_rule_params, nullptr,
       "rule latency" },
 
+    { "decompress", Parameter::PT_TABLE, s_decompress_params, nullptr,
+      "decompression latency" },
+
+    { "overload", Parameter::PT_TABLE, s_overload_params, nullptr,
+      "adaptive load shedding" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -109,6 +160,13 @@ static const PegInfo latency_pegs[] =
     { CountType::SUM, "total_rule_evals", "total rule evals monitored" },
     { CountType::SUM, "rule_eval_timeouts", "rule evals that timed out" },
     { CountType::SUM, "rule_tree_enables", "rule tree re-enables" },
+    { CountType::SUM, "decompress_timeouts", "compressed streams abandoned over cpu budget" },
+    { CountType::SUM, "overload_escalations", "overload shedding tier increases" },
+    { CountType::SUM, "overload_recoveries", "overload shedding tier decreases" },
+    { CountType::MAX, "max_overload_tier", "highest overload shedding tier reached" },
+    { CountType::SUM, "flows_shed", "elephant flows no longer inspected due to overload" },
+    { CountType::SUM, "inspectors_shed", "inspector calls skipped due to overload" },
+    { CountType::SUM, "rule_trees_shed", "rule tree evaluations skipped due to overload" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -162,6 +220,61 @@ static inline bool latency_set(Value& v, RuleLatencyConfig& config)
     return true;
 }
 
+static inline bool latency_set(Value& v, DecompressLatencyConfig& config)
+{
+    if ( v.is("max_time") )
+    {
+        long t = clock_ticks(v.get_int64());
+        config.max_time = TO_DURATION(config.max_time, t);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+static inline bool latency_set(Value& v, OverloadControlConfig& config)
+{
+    if ( v.is("max_tier") )
+        config.max_tier = v.get_uint8();
+
+    else if ( v.is("check_interval") )
+    {
+        long t = clock_ticks(v.get_uint64() * 1000);
+        config.check_interval = TO_DURATION(config.check_interval, t);
+    }
+    else if ( v.is("max_backlog") )
+        config.max_backlog = v.get_uint64();
+
+    else if ( v.is("max_latency") )
+    {
+        long t = clock_ticks(v.get_int64());
+        config.max_latency = TO_DURATION(config.max_latency, t);
+    }
+    else if ( v.is("percentile") )
+        config.percentile = v.get_uint8();
+
+    else if ( v.is("recover_percent") )
+        config.recover_percent = v.get_uint8();
+
+    else if ( v.is("recover_checks") )
+        config.recover_checks = v.get_uint32();
+
+    else if ( v.is("elephant_bytes") )
+        config.elephant_bytes = v.get_uint64();
+
+    else if ( v.is("shed_inspectors") )
+        config.shed_inspectors = v.get_string();
+
+    else if ( v.is("max_priority") )
+        config.max_priority = v.get_uint32();
+
+    else
+        return false;
+
+    return true;
+}
+
 LatencyModule::LatencyModule() :
     Module(s_name, s_help, s_params)
 { }
@@ -170,6 +283,8 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
 {
     const char* slp = "latency.packet";
     const char* slr = "latency.rule";
+    const char* sld = "latency.decompress";
+    const char* slo = "latency.overload";
 
     if ( !strncmp(fqn, slp, strlen(slp)) )
         return latency_set(v, sc->latency->packet_latency);
@@ -177,6 +292,12 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, slr, strlen(slr)) )
         return latency_set(v, sc->latency->rule_latency);
 
+    else if ( !strncmp(fqn, sld, strlen(sld)) )
+        return latency_set(v, sc->latency->decompress_latency);
+
+    else if ( !strncmp(fqn, slo, strlen(slo)) )
+        return latency_set(v, sc->latency->overload_control);
+
     return false;
 }
 
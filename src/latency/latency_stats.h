@@ -33,6 +33,13 @@ struct LatencyStats
     PegCount total_rule_evals;
     PegCount rule_eval_timeouts;
     PegCount rule_tree_enables;
+    PegCount decompress_timeouts;
+    PegCount overload_escalations;
+    PegCount overload_recoveries;
+    PegCount max_overload_tier;
+    PegCount flows_shed;
+    PegCount inspectors_shed;
+    PegCount rule_trees_shed;
 };
 
 extern THREAD_LOCAL LatencyStats latency_stats;
@@ -0,0 +1,545 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// overload_control.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "overload_control.h"
+
+#include <daq.h>
+
+#include <sstream>
+
+#include "flow/flow.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "memory/memory_cap.h"
+#include "packet_io/sfdaq_instance.h"
+#include "protocols/packet.h"
+#include "stream/stream.h"
+
+#include "latency_config.h"
+#include "latency_util.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+THREAD_LOCAL unsigned OverloadControl::tier = OverloadControlConfig::NONE;
+THREAD_LOCAL unsigned OverloadControl::max_priority = 0;
+THREAD_LOCAL bool OverloadControl::enabled = false;
+
+namespace overload_control
+{
+// -----------------------------------------------------------------------------
+// helpers
+// -----------------------------------------------------------------------------
+
+// what the controller saw over one check interval
+struct Sample
+{
+    uint64_t backlog;  // packets received by the daq but not yet read
+    uint64_t drops;    // packets dropped by the daq since the last check
+    bool memory;       // memcap over the preemptive threshold
+};
+
+struct Event
+{
+    unsigned from;
+    unsigned to;
+    unsigned percentile;
+    uint64_t latency;
+    Sample sample;
+};
+
+using ConfigWrapper = ReferenceWrapper<OverloadControlConfig>;
+using EventHandler = EventingWrapper<Event>;
+
+static inline std::ostream& operator<<(std::ostream& os, const Event& e)
+{
+    os << "latency: overload tier " << e.from << " -> " << e.to;
+    os << ", backlog " << e.sample.backlog;
+    os << ", drops " << e.sample.drops;
+    os << ", p" << e.percentile << " " << e.latency << " usec";
+    os << ", memcap " << (e.sample.memory ? "over" : "ok");
+
+    return os;
+}
+
+// log2 buckets of usecs; bucket i holds [2^(i-1), 2^i - 1] and 0 is 0
+class Histogram
+{
+public:
+    void add(uint64_t usecs)
+    {
+        unsigned i = usecs ? 64 - __builtin_clzll(usecs) : 0;
+
+        if ( i >= num_buckets )
+            i = num_buckets - 1;
+
+        ++buckets[i];
+        ++total;
+    }
+
+    // upper bound of the bucket holding the percentile
+    uint64_t percentile(unsigned pct) const
+    {
+        if ( !total )
+            return 0;
+
+        uint64_t rank = (total * pct + 99) / 100;
+        uint64_t sum = 0;
+
+        for ( unsigned i = 0; i < num_buckets; ++i )
+        {
+            sum += buckets[i];
+
+            if ( sum >= rank )
+                return (1ULL << i) - 1;
+        }
+        return (1ULL << (num_buckets - 1)) - 1;
+    }
+
+    void reset()
+    {
+        for ( auto& b : buckets )
+            b = 0;
+
+        total = 0;
+    }
+
+private:
+    static constexpr unsigned num_buckets = 40;
+    uint64_t buckets[num_buckets] = { };
+    uint64_t total = 0;
+};
+
+// -----------------------------------------------------------------------------
+// implementation
+// -----------------------------------------------------------------------------
+
+template<typename Clock = SnortClock>
+class Impl
+{
+public:
+    Impl(const ConfigWrapper&, EventHandler&);
+
+    void add(uint64_t usecs)
+    { hist.add(usecs); }
+
+    bool due();
+    unsigned evaluate(const Sample&);
+
+private:
+    bool overloaded(const Sample&, uint64_t latency) const;
+    bool calm(const Sample&, uint64_t latency) const;
+
+    Histogram hist;
+    typename Clock::time_point next_check;
+    bool started = false;
+
+    unsigned tier = OverloadControlConfig::NONE;
+    unsigned calm_checks = 0;
+
+    const ConfigWrapper& config;
+    EventHandler& log_handler;
+};
+
+template<typename Clock>
+inline Impl<Clock>::Impl(const ConfigWrapper& cfg, EventHandler& lh) :
+    config(cfg), log_handler(lh)
+{ }
+
+template<typename Clock>
+inline bool Impl<Clock>::due()
+{
+    auto now = Clock::now();
+
+    if ( !started )
+    {
+        next_check = now + config->check_interval;
+        started = true;
+        return false;
+    }
+
+    if ( now < next_check )
+        return false;
+
+    next_check = now + config->check_interval;
+    return true;
+}
+
+template<typename Clock>
+inline bool Impl<Clock>::overloaded(const Sample& s, uint64_t latency) const
+{
+    if ( s.drops or s.memory )
+        return true;
+
+    if ( config->max_backlog and s.backlog > config->max_backlog )
+        return true;
+
+    if ( config->max_latency > CLOCK_ZERO and
+        latency > (uint64_t)clock_usecs(TO_USECS(config->max_latency)) )
+        return true;
+
+    return false;
+}
+
+// hysteresis: recovery requires a margin below each threshold
+template<typename Clock>
+inline bool Impl<Clock>::calm(const Sample& s, uint64_t latency) const
+{
+    uint64_t pct = config->recover_percent;
+
+    if ( config->max_backlog and s.backlog * 100 > config->max_backlog * pct )
+        return false;
+
+    if ( config->max_latency > CLOCK_ZERO and
+        latency * 100 > (uint64_t)clock_usecs(TO_USECS(config->max_latency)) * pct )
+        return false;
+
+    return true;
+}
+
+template<typename Clock>
+inline unsigned Impl<Clock>::evaluate(const Sample& s)
+{
+    uint64_t latency = hist.percentile(config->percentile);
+    hist.reset();
+
+    unsigned to = tier;
+
+    if ( tier > config->max_tier )
+    {
+        // reload lowered or disabled shedding
+        to = config->max_tier;
+        calm_checks = 0;
+    }
+    else if ( overloaded(s, latency) )
+    {
+        if ( tier < config->max_tier )
+            ++to;
+
+        calm_checks = 0;
+    }
+    else if ( tier and calm(s, latency) )
+    {
+        if ( ++calm_checks >= config->recover_checks )
+        {
+            --to;
+            calm_checks = 0;
+        }
+    }
+    else
+        calm_checks = 0;
+
+    if ( to != tier )
+    {
+        Event e { tier, to, config->percentile, latency, s };
+        log_handler.handle(e);
+        tier = to;
+    }
+    return tier;
+}
+
+// -----------------------------------------------------------------------------
+// static variables
+// -----------------------------------------------------------------------------
+
+static struct SnortConfigWrapper : public ConfigWrapper
+{
+    const OverloadControlConfig* operator->() const override
+    { return &SnortConfig::get_conf()->latency->overload_control; }
+
+} config;
+
+static struct SnortLogHandler : public EventHandler
+{
+    void handle(const Event& e) override
+    {
+        std::ostringstream ss;
+        ss << e;
+        LogMessage("%s\n", ss.str().c_str());
+    }
+} log_handler;
+
+static THREAD_LOCAL Impl<>* impl = nullptr;
+static THREAD_LOCAL uint64_t last_drops = 0;
+
+static inline Impl<>& get_impl()
+{
+    if ( !impl )
+        impl = new Impl<>(config, log_handler);
+
+    return *impl;
+}
+
+} // namespace overload_control
+
+// -----------------------------------------------------------------------------
+// overload control interface
+// -----------------------------------------------------------------------------
+
+void OverloadControl::update(SFDAQInstance* daq)
+{
+    using namespace overload_control;
+
+    enabled = config->enabled();
+
+    // keep checking after a reload disables shedding so the tier comes down
+    if ( !enabled and tier == OverloadControlConfig::NONE )
+        return;
+
+    Impl<>& ctl = get_impl();
+
+    if ( !ctl.due() )
+        return;
+
+    Sample s = { };
+
+    if ( daq )
+    {
+        const DAQ_Stats_t* ds = daq->get_stats();
+        uint64_t read = ds->packets_filtered + ds->packets_received;
+
+        if ( ds->hw_packets_received > read )
+            s.backlog = ds->hw_packets_received - read;
+
+        if ( ds->hw_packets_dropped > last_drops )
+            s.drops = ds->hw_packets_dropped - last_drops;
+
+        last_drops = ds->hw_packets_dropped;
+    }
+    s.memory = memory::MemoryCap::over_threshold();
+
+    unsigned from = tier;
+    tier = ctl.evaluate(s);
+    max_priority = config->max_priority;
+
+    if ( tier > from )
+        ++latency_stats.overload_escalations;
+
+    else if ( tier < from )
+        ++latency_stats.overload_recoveries;
+
+    if ( tier > latency_stats.max_overload_tier )
+        latency_stats.max_overload_tier = tier;
+}
+
+void OverloadControl::add(hr_duration d)
+{ overload_control::get_impl().add(clock_usecs(TO_USECS(d))); }
+
+bool OverloadControl::shed_elephant(Packet* p)
+{
+    Flow* flow = p->flow;
+
+    if ( !flow or !flow->session or p->is_cooked() )
+        return false;
+
+    if ( flow->get_ignore_direction() == SSN_DIR_BOTH )
+        return false;
+
+    uint64_t bytes = flow->flowstats.client_bytes + flow->flowstats.server_bytes;
+
+    if ( bytes < overload_control::config->elephant_bytes )
+        return false;
+
+    Stream::stop_inspection(flow, p, SSN_DIR_BOTH, -1, 0);
+    ++latency_stats.flows_shed;
+    return true;
+}
+
+void OverloadControl::tterm()
+{
+    using overload_control::impl;
+
+    if ( impl )
+    {
+        delete impl;
+        impl = nullptr;
+    }
+    tier = OverloadControlConfig::NONE;
+    enabled = false;
+    overload_control::last_drops = 0;
+}
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+namespace t_overload_control
+{
+
+struct MockConfigWrapper : public overload_control::ConfigWrapper
+{
+    OverloadControlConfig config;
+
+    const OverloadControlConfig* operator->() const override
+    { return &config; }
+};
+
+struct EventHandlerSpy : public overload_control::EventHandler
+{
+    unsigned count = 0;
+    overload_control::Event last = { };
+
+    void handle(const overload_control::Event& e) override
+    { ++count; last = e; }
+};
+
+struct MockClock : public ClockTraits<hr_clock>
+{
+    static hr_time t;
+
+    static void reset()
+    { t = hr_time(0_ticks); }
+
+    static void inc(hr_duration d = 1_ticks)
+    { t += d; }
+
+    static hr_time now()
+    { return t; }
+};
+
+hr_time MockClock::t = hr_time(0_ticks);
+
+} // namespace t_overload_control
+
+TEST_CASE ( "overload histogram", "[latency]" )
+{
+    overload_control::Histogram h;
+    CHECK( h.percentile(99) == 0 );
+
+    for ( unsigned i = 0; i < 99; ++i )
+        h.add(10);
+
+    h.add(1000);
+
+    CHECK( h.percentile(50) == 15 );
+    CHECK( h.percentile(99) == 15 );
+    CHECK( h.percentile(100) == 1023 );
+
+    h.reset();
+    CHECK( h.percentile(100) == 0 );
+}
+
+TEST_CASE ( "overload control impl", "[latency]" )
+{
+    using namespace t_overload_control;
+    using Sample = overload_control::Sample;
+
+    MockConfigWrapper config;
+    EventHandlerSpy log_handler;
+
+    MockClock::reset();
+
+    config.config.check_interval = 10_ticks;
+    config.config.max_backlog = 100;
+    config.config.recover_percent = 50;
+    config.config.recover_checks = 2;
+    config.config.max_tier = OverloadControlConfig::RULES;
+
+    overload_control::Impl<MockClock> impl(config, log_handler);
+
+    SECTION( "interval" )
+    {
+        CHECK_FALSE( impl.due() );
+        MockClock::inc(5_ticks);
+        CHECK_FALSE( impl.due() );
+        MockClock::inc(5_ticks);
+        CHECK( impl.due() );
+        CHECK_FALSE( impl.due() );
+    }
+
+    SECTION( "escalate and recover" )
+    {
+        Sample busy = { 200, 0, false };
+        Sample warm = { 80, 0, false };
+        Sample idle = { 10, 0, false };
+
+        CHECK( impl.evaluate(busy) == 1 );
+        CHECK( impl.evaluate(busy) == 2 );
+        CHECK( impl.evaluate(busy) == 3 );
+        CHECK( impl.evaluate(busy) == 3 );
+        CHECK( log_handler.count == 3 );
+        CHECK( log_handler.last.from == 2 );
+        CHECK( log_handler.last.to == 3 );
+
+        // between thresholds holds the tier
+        CHECK( impl.evaluate(warm) == 3 );
+        CHECK( impl.evaluate(warm) == 3 );
+        CHECK( impl.evaluate(warm) == 3 );
+
+        // recovery takes recover_checks calm intervals per tier
+        CHECK( impl.evaluate(idle) == 3 );
+        CHECK( impl.evaluate(idle) == 2 );
+        CHECK( impl.evaluate(idle) == 2 );
+
+        // calm run is broken by any non-calm interval
+        CHECK( impl.evaluate(warm) == 2 );
+        CHECK( impl.evaluate(idle) == 2 );
+        CHECK( impl.evaluate(idle) == 1 );
+        CHECK( impl.evaluate(idle) == 1 );
+        CHECK( impl.evaluate(idle) == 0 );
+        CHECK( log_handler.count == 6 );
+    }
+
+    SECTION( "drops and memcap" )
+    {
+        CHECK( impl.evaluate({ 0, 1, false }) == 1 );
+        CHECK( impl.evaluate({ 0, 0, true }) == 2 );
+        CHECK( impl.evaluate({ 0, 0, false }) == 2 );
+        CHECK( impl.evaluate({ 0, 0, false }) == 1 );
+    }
+
+    SECTION( "latency" )
+    {
+        config.config.max_backlog = 0;
+        config.config.max_latency = TO_DURATION(config.config.max_latency, clock_ticks(100));
+
+        for ( unsigned i = 0; i < 100; ++i )
+            impl.add(i < 98 ? 10 : 500);
+
+        CHECK( impl.evaluate({ }) == 1 );
+
+        // empty interval is calm
+        CHECK( impl.evaluate({ }) == 1 );
+        CHECK( impl.evaluate({ }) == 0 );
+    }
+
+    SECTION( "max tier" )
+    {
+        config.config.max_tier = OverloadControlConfig::ELEPHANTS;
+
+        CHECK( impl.evaluate({ 200, 0, false }) == 1 );
+        CHECK( impl.evaluate({ 200, 0, false }) == 1 );
+
+        config.config.max_tier = OverloadControlConfig::NONE;
+        CHECK( impl.evaluate({ 200, 0, false }) == 0 );
+        CHECK( log_handler.count == 2 );
+    }
+}
+
+#endif
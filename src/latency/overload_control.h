@@ -0,0 +1,110 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// overload_control.h
+
+#ifndef OVERLOAD_CONTROL_H
+#define OVERLOAD_CONTROL_H
+
+// overload control watches the daq backlog and drops, the packet latency
+// distribution, and memcap pressure once per check interval and moves
+// the packet thread up and down the shedding tiers of
+// OverloadControlConfig.  the shed checks below are called per packet,
+// per inspector, and per rule tree so they only test the current tier
+// before doing anything else.
+
+#include <cstdint>
+
+#include "framework/inspector.h"
+#include "main/thread.h"
+#include "time/clock_defs.h"
+
+#include "latency_stats.h"
+#include "overload_control_config.h"
+
+namespace snort
+{
+class SFDAQInstance;
+struct Packet;
+}
+
+class OverloadControl
+{
+public:
+    // call once per daq batch and when idle
+    static void update(snort::SFDAQInstance*);
+
+    // inspection time of one wire packet
+    static void add(hr_duration);
+
+    // returns true if the packet's flow was shed
+    static bool shed_flow(snort::Packet* p)
+    { return tier >= OverloadControlConfig::ELEPHANTS and shed_elephant(p); }
+
+    static bool shed_inspector(snort::Inspector* ins)
+    {
+        if ( tier < OverloadControlConfig::INSPECTORS or !ins->is_sheddable() )
+            return false;
+
+        ++latency_stats.inspectors_shed;
+        return true;
+    }
+
+    // priority is the best (lowest) priority of the rules in the tree
+    static bool shed_rules(unsigned priority)
+    {
+        if ( tier < OverloadControlConfig::RULES or priority <= max_priority )
+            return false;
+
+        ++latency_stats.rule_trees_shed;
+        return true;
+    }
+
+    static unsigned get_tier()
+    { return tier; }
+
+    static void tterm();
+
+    class Context
+    {
+    public:
+        Context()
+        {
+            if ( enabled )
+                start = SnortClock::now();
+        }
+
+        ~Context()
+        {
+            if ( enabled )
+                OverloadControl::add(SnortClock::now() - start);
+        }
+
+    private:
+        hr_time start;
+    };
+
+private:
+    static bool shed_elephant(snort::Packet*);
+
+    static THREAD_LOCAL unsigned tier;
+    static THREAD_LOCAL unsigned max_priority;
+    static THREAD_LOCAL bool enabled;
+};
+
+#endif
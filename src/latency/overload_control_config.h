@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// overload_control_config.h
+
+#ifndef OVERLOAD_CONTROL_CONFIG_H
+#define OVERLOAD_CONTROL_CONFIG_H
+
+#include <string>
+
+#include "time/clock_defs.h"
+
+struct OverloadControlConfig
+{
+    // shedding tiers are cumulative; each tier also applies the ones below
+    enum Tier
+    {
+        NONE = 0,
+        ELEPHANTS = 1,   // stop inspecting flows over elephant_bytes
+        INSPECTORS = 2,  // skip the inspectors in shed_inspectors
+        RULES = 3,       // skip rule trees without a rule of max_priority or better
+        MAX_TIER = RULES
+    };
+
+    hr_duration check_interval = CLOCK_ZERO;
+    hr_duration max_latency = CLOCK_ZERO;
+    unsigned percentile = 99;
+    uint64_t max_backlog = 0;
+
+    unsigned recover_percent = 50;
+    unsigned recover_checks = 5;
+
+    uint64_t elephant_bytes = 1048576;
+    std::string shed_inspectors;
+    unsigned max_priority = 1;
+
+    unsigned max_tier = NONE;
+
+    bool enabled() const { return max_tier > NONE; }
+};
+
+#endif
@@ -0,0 +1,246 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// text_format_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "catch/snort_catch.h"
+
+#include "log/text_format.h"
+#include "sfip/sf_ip.h"
+
+using namespace snort;
+
+namespace snort
+{
+char* snort_strdup(const char* str)
+{
+    size_t n = strlen(str) + 1;
+    char* p = new char[n];
+    memcpy(p, str, n);
+    return p;
+}
+}
+
+static std::string fmt_uint(uint64_t u)
+{
+    char buf[FMT_UINT_MAX];
+    return std::string(buf, format_uint(buf, u) - buf);
+}
+
+static std::string fmt_hex(uint64_t u)
+{
+    char buf[FMT_HEX_MAX];
+    return std::string(buf, format_hex(buf, u) - buf);
+}
+
+static std::string fmt_ip(const SfIp& ip)
+{
+    char buf[FMT_IP_MAX];
+    return std::string(buf, format_ip(buf, &ip) - buf);
+}
+
+TEST_CASE("format uint", "[text_format]")
+{
+    std::mt19937_64 rng(1);
+    char ref[32];
+
+    for ( uint64_t u : { 0ULL, 9ULL, 10ULL, 99ULL, 100ULL, 4294967295ULL, 4294967296ULL,
+        9999999999999999999ULL, 10000000000000000000ULL, 18446744073709551615ULL } )
+    {
+        snprintf(ref, sizeof(ref), "%" PRIu64, u);
+        CHECK(fmt_uint(u) == ref);
+    }
+
+    for ( unsigned i = 0; i < 10000; ++i )
+    {
+        // spread over all magnitudes
+        uint64_t u = rng() >> (rng() % 64);
+        snprintf(ref, sizeof(ref), "%" PRIu64, u);
+        CHECK(fmt_uint(u) == ref);
+    }
+}
+
+TEST_CASE("format hex", "[text_format]")
+{
+    std::mt19937_64 rng(2);
+    char ref[32];
+
+    for ( unsigned i = 0; i < 10000; ++i )
+    {
+        uint64_t u = i < 256 ? i : rng() >> (rng() % 64);
+        snprintf(ref, sizeof(ref), "%" PRIX64, u);
+        CHECK(fmt_hex(u) == ref);
+    }
+}
+
+TEST_CASE("format mac", "[text_format]")
+{
+    const uint8_t mac[6] = { 0x00, 0x0a, 0xf3, 0x5B, 0x10, 0xff };
+    char buf[FMT_MAC_MAX + 1];
+    *format_mac(buf, mac) = '\0';
+    CHECK(!strcmp(buf, "00:0A:F3:5B:10:FF"));
+}
+
+TEST_CASE("format ip", "[text_format]")
+{
+    SfIp ip;
+    SfIpString ref;
+
+    ip.clear();
+    CHECK(fmt_ip(ip).empty());
+
+    const char* addrs[] =
+    {
+        "0.0.0.0", "1.2.3.4", "10.9.100.255", "255.255.255.255",
+        "::", "::1", "::ffff:1.2.3.4", "::1.2.3.4", "1::", "1:0:0:2::3",
+        "1:0:0:2:0:0:0:3", "fe80::1:2:3:4", "2001:db8::ff00:42:8329",
+        "2001:db8:0:1:1:1:1:1", "1:2:3:4:5:6:7:8", "0:0:1::", "::ffff:0:1.2.3.4",
+    };
+
+    for ( auto s : addrs )
+    {
+        REQUIRE(ip.set(s) == SFIP_SUCCESS);
+        CHECK(fmt_ip(ip) == ip.ntop(ref));
+    }
+
+    // random v6 with many zero words to exercise the run selection
+    std::mt19937 rng(3);
+
+    for ( unsigned i = 0; i < 10000; ++i )
+    {
+        uint16_t w[8];
+
+        for ( auto& x : w )
+            x = (rng() % 3) ? 0 : htons(rng() % 3 ? rng() : rng() % 16);
+
+        if ( i % 7 == 0 )
+            w[5] = 0xffff;
+
+        REQUIRE(ip.set(w, AF_INET6) == SFIP_SUCCESS);
+        CHECK(fmt_ip(ip) == ip.ntop(ref));
+    }
+}
+
+//-------------------------------------------------------------------------
+// benchmark
+// formats the fields of the default alert_csv field list for a tcp over
+// ipv4 event with printf as before and with the formatters
+//-------------------------------------------------------------------------
+
+struct Event
+{
+    uint64_t pkt_num;
+    unsigned pkt_len;
+    SfIp src, dst;
+    unsigned sp, dp;
+    unsigned gid, sid, rev;
+};
+
+static unsigned printf_event(char* buf, const Event& e)
+{
+    SfIpString a1, a2;
+    return snprintf(buf, 256, "%" PRIu64 ", TCP, raw, %u, C2S, %s:%u, %s:%u, %u:%u:%u, allow\n",
+        e.pkt_num, e.pkt_len, e.src.ntop(a1), e.sp, e.dst.ntop(a2), e.dp, e.gid, e.sid, e.rev);
+}
+
+static char* put(char* p, const char* s, unsigned n)
+{
+    memcpy(p, s, n);
+    return p + n;
+}
+
+static unsigned format_event(char* buf, const Event& e)
+{
+    char* p = format_uint(buf, e.pkt_num);
+    p = put(p, ", TCP, raw, ", 12);
+    p = format_uint(p, e.pkt_len);
+    p = put(p, ", C2S, ", 7);
+    p = format_ip(p, &e.src);
+    *p++ = ':';
+    p = format_uint(p, e.sp);
+    p = put(p, ", ", 2);
+    p = format_ip(p, &e.dst);
+    *p++ = ':';
+    p = format_uint(p, e.dp);
+    p = put(p, ", ", 2);
+    p = format_uint(p, e.gid);
+    *p++ = ':';
+    p = format_uint(p, e.sid);
+    *p++ = ':';
+    p = format_uint(p, e.rev);
+    p = put(p, ", allow\n", 8);
+    return p - buf;
+}
+
+template <typename F>
+static double events_per_sec(F f, const Event& e, unsigned n)
+{
+    char buf[256];
+    unsigned total = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for ( unsigned i = 0; i < n; ++i )
+        total += f(buf, e);
+
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+    CHECK(total);
+    return n / secs.count();
+}
+
+TEST_CASE("alert format benchmark", "[.benchmark][text_format]")
+{
+    Event e;
+    e.pkt_num = 123456789;
+    e.pkt_len = 1514;
+    e.src.set("192.168.100.17");
+    e.dst.set("10.1.2.254");
+    e.sp = 49152;
+    e.dp = 443;
+    e.gid = 1;
+    e.sid = 2010935;
+    e.rev = 3;
+
+    char b1[256], b2[256];
+    unsigned n1 = printf_event(b1, e);
+    unsigned n2 = format_event(b2, e);
+    REQUIRE(n1 == n2);
+    REQUIRE(!memcmp(b1, b2, n1));
+
+    const unsigned n = 2000000;
+    printf("printf:     %.0f events/sec\n", events_per_sec(printf_event, e, n));
+    printf("formatters: %.0f events/sec\n", events_per_sec(format_event, e, n));
+
+    BENCHMARK("printf")
+    { return printf_event(b1, e); };
+
+    BENCHMARK("formatters")
+    { return format_event(b2, e); };
+}
@@ -0,0 +1,238 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// text_format.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "text_format.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+#include "sfip/sf_ip.h"
+
+using namespace snort;
+
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint64_t powers_of_10[] =
+{
+    0,  // so that 0 has 1 digit
+    10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+    1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+    1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL,
+    1000000000000000000ULL, 10000000000000000000ULL
+};
+
+static inline unsigned count_digits(uint64_t u)
+{
+    // 1233 / 4096 ~= log10(2); the estimate is exact or one short
+    unsigned bits = 64 - __builtin_clzll(u | 1);
+    unsigned n = (bits * 1233) >> 12;
+    return n + (u >= powers_of_10[n]);
+}
+
+static const char upper_hex[] = "0123456789ABCDEF";
+static const char lower_hex[] = "0123456789abcdef";
+
+namespace snort
+{
+char* format_uint(char* buf, uint64_t u)
+{
+    unsigned n = count_digits(u);
+    char* end = buf + n;
+    char* p = end;
+
+    while ( u >= 100 )
+    {
+        unsigned i = (u % 100) * 2;
+        u /= 100;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+    if ( u >= 10 )
+    {
+        unsigned i = u * 2;
+        *--p = digit_pairs[i + 1];
+        *--p = digit_pairs[i];
+    }
+    else
+        *--p = '0' + u;
+
+    return end;
+}
+
+char* format_hex(char* buf, uint64_t u)
+{
+    unsigned n = (64 - __builtin_clzll(u | 1) + 3) >> 2;
+    char* end = buf + n;
+    char* p = end;
+
+    do
+    {
+        *--p = upper_hex[u & 0xF];
+        u >>= 4;
+    }
+    while ( p > buf );
+
+    return end;
+}
+
+char* format_mac(char* buf, const uint8_t* mac)
+{
+    for ( unsigned i = 0; i < 6; ++i )
+    {
+        *buf++ = upper_hex[mac[i] >> 4];
+        *buf++ = upper_hex[mac[i] & 0xF];
+        *buf++ = ':';
+    }
+    return buf - 1;
+}
+
+static char* format_ip4(char* buf, const uint8_t* p)
+{
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        buf = format_uint(buf, p[i]);
+        *buf++ = '.';
+    }
+    return buf - 1;
+}
+
+static char* format_word(char* buf, unsigned w, const char* hex)
+{
+    // %x
+    if ( w >= 0x1000 )
+        *buf++ = hex[w >> 12];
+    if ( w >= 0x100 )
+        *buf++ = hex[(w >> 8) & 0xF];
+    if ( w >= 0x10 )
+        *buf++ = hex[(w >> 4) & 0xF];
+    *buf++ = hex[w & 0xF];
+    return buf;
+}
+
+#if !defined(REG_TEST) && !defined(CATCH_TEST_BUILD)
+// same as inet_ntop(): the first longest run of 2 or more zero words is
+// replaced with ::, and v4 compatible and mapped addresses end in dotted
+// quad form
+static char* format_ip6(char* buf, const uint8_t* p)
+{
+    unsigned words[8];
+
+    for ( unsigned i = 0; i < 8; ++i )
+        words[i] = (p[2*i] << 8) | p[2*i + 1];
+
+    int best = -1, best_len = 0;
+    int cur = -1, cur_len = 0;
+
+    for ( int i = 0; i < 8; ++i )
+    {
+        if ( !words[i] )
+        {
+            if ( cur < 0 )
+            {
+                cur = i;
+                cur_len = 1;
+            }
+            else
+                ++cur_len;
+        }
+        else if ( cur >= 0 )
+        {
+            if ( cur_len > best_len )
+            {
+                best = cur;
+                best_len = cur_len;
+            }
+            cur = -1;
+        }
+    }
+    if ( cur >= 0 and cur_len > best_len )
+    {
+        best = cur;
+        best_len = cur_len;
+    }
+    if ( best_len < 2 )
+        best = -1;
+
+    for ( int i = 0; i < 8; ++i )
+    {
+        if ( best >= 0 and i >= best and i < best + best_len )
+        {
+            if ( i == best )
+                *buf++ = ':';
+            continue;
+        }
+        if ( i )
+            *buf++ = ':';
+
+        if ( i == 6 and best == 0 and
+            (best_len == 6 or (best_len == 5 and words[5] == 0xffff)) )
+            return format_ip4(buf, p + 12);
+
+        buf = format_word(buf, words[i], lower_hex);
+    }
+    if ( best >= 0 and best + best_len == 8 )
+        *buf++ = ':';
+
+    return buf;
+}
+#else
+// same as snort_inet_ntop() for tests: %04x for each word
+static char* format_ip6(char* buf, const uint8_t* p)
+{
+    for ( unsigned i = 0; i < 8; ++i )
+    {
+        unsigned w = (p[2*i] << 8) | p[2*i + 1];
+        *buf++ = lower_hex[w >> 12];
+        *buf++ = lower_hex[(w >> 8) & 0xF];
+        *buf++ = lower_hex[(w >> 4) & 0xF];
+        *buf++ = lower_hex[w & 0xF];
+        *buf++ = ':';
+    }
+    return buf - 1;
+}
+#endif
+
+char* format_ip(char* buf, const SfIp* ip)
+{
+    if ( ip->get_family() == AF_INET )
+        return format_ip4(buf, (const uint8_t*)ip->get_ip4_ptr());
+
+    if ( ip->get_family() == AF_INET6 )
+        return format_ip6(buf, (const uint8_t*)ip->get_ip6_ptr());
+
+    return buf;
+}
+}
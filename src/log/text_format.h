@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// text_format.h
+
+#ifndef TEXT_FORMAT_H
+#define TEXT_FORMAT_H
+
+// Fixed formatters for the common alert fields.  Each writes exactly the
+// text of the noted printf conversion (or SfIp::ntop) without a
+// terminating null and returns the end of the output.  The buffer must
+// have room for the longest result.  These are used instead of
+// TextLog_Print() on the alert path to avoid the varargs and format
+// parsing cost per field.
+
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+struct SfIp;
+
+#define FMT_UINT_MAX 20   // 18446744073709551615
+#define FMT_HEX_MAX  16   // FFFFFFFFFFFFFFFF
+#define FMT_MAC_MAX  17   // FF:FF:FF:FF:FF:FF
+#define FMT_IP_MAX   46   // INET6_ADDRSTRLEN
+
+// %u, PRIu64
+SO_PUBLIC char* format_uint(char*, uint64_t);
+
+// %X, %lX
+SO_PUBLIC char* format_hex(char*, uint64_t);
+
+// %02X:%02X:%02X:%02X:%02X:%02X
+SO_PUBLIC char* format_mac(char*, const uint8_t*);
+
+// SfIp::ntop(); nothing is written for an unset address
+SO_PUBLIC char* format_ip(char*, const SfIp*);
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include "utils/util.h"
 
 #include "log.h"
+#include "text_format.h"
 
 using namespace snort;
 
@@ -227,15 +228,73 @@ bool TextLog_Write(TextLog* const txt, const char* str, int len)
         TextLog_Flush(txt);
         avail = TextLog_Avail(txt);
     }
-    int n = snprintf(txt->buf+txt->pos, avail, "%.*s", len, str);
 
-    if ( n != len )
+    // like %.*s, the string ends at the first null
+    if ( memchr(str, 0, len) )
         return false;
 
+    if ( len >= avail )
+    {
+        memcpy(txt->buf+txt->pos, str, avail);
+        txt->pos = txt->maxBuf - 1;
+        txt->buf[txt->pos] = '\0';
+        return false;
+    }
+
+    memcpy(txt->buf+txt->pos, str, len);
     txt->pos += len;
+    txt->buf[txt->pos] = '\0';
     return true;
 }
 
+/*-------------------------------------------------------------------
+ * TextLog_Put*: append formatted field to buffer
+ * formats in place without the overhead of TextLog_Print()
+ *-------------------------------------------------------------------
+ */
+static inline char* TextLog_Reserve(TextLog* const txt, int len)
+{
+    if ( TextLog_Avail(txt) <= len )
+    {
+        TextLog_Flush(txt);
+
+        if ( TextLog_Avail(txt) <= len )
+            return nullptr;
+    }
+    return txt->buf + txt->pos;
+}
+
+static inline bool TextLog_Commit(TextLog* const txt, const char* end)
+{
+    txt->pos = end - txt->buf;
+    txt->buf[txt->pos] = '\0';
+    return true;
+}
+
+bool TextLog_PutUInt(TextLog* const txt, uint64_t u)
+{
+    char* p = TextLog_Reserve(txt, FMT_UINT_MAX);
+    return p and TextLog_Commit(txt, format_uint(p, u));
+}
+
+bool TextLog_PutHex(TextLog* const txt, uint64_t u)
+{
+    char* p = TextLog_Reserve(txt, FMT_HEX_MAX);
+    return p and TextLog_Commit(txt, format_hex(p, u));
+}
+
+bool TextLog_PutMac(TextLog* const txt, const uint8_t* mac)
+{
+    char* p = TextLog_Reserve(txt, FMT_MAC_MAX);
+    return p and TextLog_Commit(txt, format_mac(p, mac));
+}
+
+bool TextLog_PutIp(TextLog* const txt, const SfIp* ip)
+{
+    char* p = TextLog_Reserve(txt, FMT_IP_MAX);
+    return p and TextLog_Commit(txt, format_ip(p, ip));
+}
+
 /*-------------------------------------------------------------------
  * TextLog_Printf: append formatted string to buffer
  *-------------------------------------------------------------------
@@ -110,13 +110,13 @@ static void ff_b64_data(const Args& a)
 static void ff_client_bytes(const Args& a)
 {
     if (a.pkt->flow)
-        TextLog_Print(csv_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
+        TextLog_PutUInt(csv_log, a.pkt->flow->flowstats.client_bytes);
 }
 
 static void ff_client_pkts(const Args& a)
 {
     if (a.pkt->flow)
-        TextLog_Print(csv_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
+        TextLog_PutUInt(csv_log, a.pkt->flow->flowstats.client_pkts);
 }
 
 static void ff_dir(const Args& a)
@@ -136,30 +136,27 @@ static void ff_dir(const Args& a)
 static void ff_dst_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-    {
-        SfIpString ip_str;
-        TextLog_Puts(csv_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
-    }
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_dst());
 }
 
 static void ff_dst_ap(const Args& a)
 {
-    SfIpString addr = "";
-    unsigned port = 0;
-
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_dst());
+
+    unsigned port = 0;
 
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.dp;
 
-    TextLog_Print(csv_log, "%s:%u", addr, port);
+    TextLog_Putc(csv_log, ':');
+    TextLog_PutUInt(csv_log, port);
 }
 
 static void ff_dst_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.dp);
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.dp);
 }
 
 static void ff_eth_dst(const Args& a)
@@ -169,9 +166,7 @@ static void ff_eth_dst(const Args& a)
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(csv_log, "%02X:%02X:%02X:%02X:%02X:%02X", eh->ether_dst[0],
-        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
-        eh->ether_dst[4], eh->ether_dst[5]);
+    TextLog_PutMac(csv_log, eh->ether_dst);
 }
 
 static void ff_eth_len(const Args& a)
@@ -179,7 +174,7 @@ static void ff_eth_len(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return;
 
-    TextLog_Print(csv_log, "%u", a.pkt->pkth->pktlen);
+    TextLog_PutUInt(csv_log, a.pkt->pkth->pktlen);
 }
 
 static void ff_eth_src(const Args& a)
@@ -189,9 +184,7 @@ static void ff_eth_src(const Args& a)
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(csv_log, "%02X:%02X:%02X:%02X:%02X:%02X", eh->ether_src[0],
-        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
-        eh->ether_src[4], eh->ether_src[5]);
+    TextLog_PutMac(csv_log, eh->ether_src);
 }
 
 static void ff_eth_type(const Args& a)
@@ -200,42 +193,43 @@ static void ff_eth_type(const Args& a)
         return;
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
-    TextLog_Print(csv_log, "0x%X", ntohs(eh->ether_type));
+    TextLog_Write(csv_log, "0x", 2);
+    TextLog_PutHex(csv_log, ntohs(eh->ether_type));
 }
 
 static void ff_flowstart_time(const Args& a)
 {
     if (a.pkt->flow)
-        TextLog_Print(csv_log, "%u", a.pkt->flow->flowstats.start_time.tv_sec);
+        TextLog_PutUInt(csv_log, (uint32_t)a.pkt->flow->flowstats.start_time.tv_sec);
 }
 
 static void ff_gid(const Args& a)
 {
-    TextLog_Print(csv_log, "%u",  a.event.sig_info->gid);
+    TextLog_PutUInt(csv_log, a.event.sig_info->gid);
 }
 
 static void ff_icmp_code(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.icmph->code);
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.icmph->code);
 }
 
 static void ff_icmp_id(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
-        TextLog_Print(csv_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
+        TextLog_PutUInt(csv_log, ntohs(a.pkt->ptrs.icmph->s_icmp_id));
 }
 
 static void ff_icmp_seq(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
-        TextLog_Print(csv_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
+        TextLog_PutUInt(csv_log, ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
 }
 
 static void ff_icmp_type(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.icmph->type);
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.icmph->type);
 }
 
 static void ff_iface(const Args&)
@@ -246,13 +240,13 @@ static void ff_iface(const Args&)
 static void ff_ip_id(const Args& a)
 {
     if (a.pkt->has_ip())
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.ip_api.id());
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.ip_api.id());
 }
 
 static void ff_ip_len(const Args& a)
 {
     if (a.pkt->has_ip())
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.ip_api.pay_len());
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.ip_api.pay_len());
 }
 
 static void ff_msg(const Args& a)
@@ -273,7 +267,7 @@ static void ff_mpls(const Args& a)
     else
         return;
 
-    TextLog_Print(csv_log, "%u", ntohl(mpls));
+    TextLog_PutUInt(csv_log, ntohl(mpls));
 }
 
 static void ff_pkt_gen(const Args& a)
@@ -284,19 +278,19 @@ static void ff_pkt_gen(const Args& a)
 static void ff_pkt_len(const Args& a)
 {
     if (a.pkt->has_ip())
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.ip_api.dgram_len());
     else
-        TextLog_Print(csv_log, "%u", a.pkt->dsize);
+        TextLog_PutUInt(csv_log, a.pkt->dsize);
 }
 
 static void ff_pkt_num(const Args& a)
 {
-    TextLog_Print(csv_log, STDu64, a.pkt->context->packet_number);
+    TextLog_PutUInt(csv_log, a.pkt->context->packet_number);
 }
 
 static void ff_priority(const Args& a)
 {
-    TextLog_Print(csv_log, "%u", a.event.sig_info->priority);
+    TextLog_PutUInt(csv_log, a.event.sig_info->priority);
 }
 
 static void ff_proto(const Args& a)
@@ -306,30 +300,33 @@ static void ff_proto(const Args& a)
 
 static void ff_rev(const Args& a)
 {
-    TextLog_Print(csv_log, "%u",  a.event.sig_info->rev);
+    TextLog_PutUInt(csv_log, a.event.sig_info->rev);
 }
 
 static void ff_rule(const Args& a)
 {
-    TextLog_Print(csv_log, "%u:%u:%u",
-        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
+    TextLog_PutUInt(csv_log, a.event.sig_info->gid);
+    TextLog_Putc(csv_log, ':');
+    TextLog_PutUInt(csv_log, a.event.sig_info->sid);
+    TextLog_Putc(csv_log, ':');
+    TextLog_PutUInt(csv_log, a.event.sig_info->rev);
 }
 
 static void ff_seconds(const Args& a)
 {
-    TextLog_Print(csv_log, "%u",  a.pkt->pkth->ts.tv_sec);
+    TextLog_PutUInt(csv_log, (uint32_t)a.pkt->pkth->ts.tv_sec);
 }
 
 static void ff_server_bytes(const Args& a)
 {
     if (a.pkt->flow)
-        TextLog_Print(csv_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
+        TextLog_PutUInt(csv_log, a.pkt->flow->flowstats.server_bytes);
 }
 
 static void ff_server_pkts(const Args& a)
 {
     if (a.pkt->flow)
-        TextLog_Print(csv_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
+        TextLog_PutUInt(csv_log, a.pkt->flow->flowstats.server_pkts);
 }
 
 static void ff_service(const Args& a)
@@ -342,58 +339,51 @@ static void ff_service(const Args& a)
 
 static void ff_sid(const Args& a)
 {
-    TextLog_Print(csv_log, "%u",  a.event.sig_info->sid);
+    TextLog_PutUInt(csv_log, a.event.sig_info->sid);
 }
 
 static void ff_src_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-    {
-        SfIpString ip_str;
-        TextLog_Puts(csv_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
-    }
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_src());
 }
 
 static void ff_src_ap(const Args& a)
 {
-    SfIpString addr = "";
-    unsigned port = 0;
-
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_src());
+
+    unsigned port = 0;
 
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.sp;
 
-    TextLog_Print(csv_log, "%s:%u", addr, port);
+    TextLog_Putc(csv_log, ':');
+    TextLog_PutUInt(csv_log, port);
 }
 
 static void ff_src_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.sp);
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.sp);
 }
 
 static void ff_target(const Args& a)
 {
-    SfIpString addr = "";
-
     if ( a.event.sig_info->target == TARGET_SRC )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_src());
 
     else if ( a.event.sig_info->target == TARGET_DST )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
-
-    else
-        return;
-
-    TextLog_Print(csv_log, "%s", addr);
+        TextLog_PutIp(csv_log, a.pkt->ptrs.ip_api.get_dst());
 }
 
 static void ff_tcp_ack(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
-        TextLog_Print(csv_log, "0x%lX", (u_long)ntohl(a.pkt->ptrs.tcph->th_ack));
+    {
+        TextLog_Write(csv_log, "0x", 2);
+        TextLog_PutHex(csv_log, ntohl(a.pkt->ptrs.tcph->th_ack));
+    }
 }
 
 static void ff_tcp_flags(const Args& a)
@@ -402,26 +392,32 @@ static void ff_tcp_flags(const Args& a)
     {
         char tcpFlags[9];
         CreateTCPFlagString(a.pkt->ptrs.tcph, tcpFlags);
-        TextLog_Print(csv_log, "%s", tcpFlags);
+        TextLog_Puts(csv_log, tcpFlags);
     }
 }
 
 static void ff_tcp_len(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
-        TextLog_Print(csv_log, "%u", (a.pkt->ptrs.tcph->off()));
+        TextLog_PutUInt(csv_log, (a.pkt->ptrs.tcph->off()));
 }
 
 static void ff_tcp_seq(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
-        TextLog_Print(csv_log, "0x%lX", (u_long)ntohl(a.pkt->ptrs.tcph->th_seq));
+    {
+        TextLog_Write(csv_log, "0x", 2);
+        TextLog_PutHex(csv_log, ntohl(a.pkt->ptrs.tcph->th_seq));
+    }
 }
 
 static void ff_tcp_win(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
-        TextLog_Print(csv_log, "0x%X", ntohs(a.pkt->ptrs.tcph->th_win));
+    {
+        TextLog_Write(csv_log, "0x", 2);
+        TextLog_PutHex(csv_log, ntohs(a.pkt->ptrs.tcph->th_win));
+    }
 }
 
 static void ff_timestamp(const Args& a)
@@ -432,24 +428,24 @@ static void ff_timestamp(const Args& a)
 static void ff_tos(const Args& a)
 {
     if (a.pkt->has_ip())
-        TextLog_Print(csv_log, "%u", a.pkt->ptrs.ip_api.tos());
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.ip_api.tos());
 }
 
 static void ff_ttl(const Args& a)
 {
     if (a.pkt->has_ip())
-        TextLog_Print(csv_log, "%u",a.pkt->ptrs.ip_api.ttl());
+        TextLog_PutUInt(csv_log, a.pkt->ptrs.ip_api.ttl());
 }
 
 static void ff_udp_len(const Args& a)
 {
     if (a.pkt->ptrs.udph )
-        TextLog_Print(csv_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
+        TextLog_PutUInt(csv_log, ntohs(a.pkt->ptrs.udph->uh_len));
 }
 
 static void ff_vlan(const Args& a)
 {
-    TextLog_Print(csv_log, "%hu", a.pkt->get_flow_vlan_id());
+    TextLog_PutUInt(csv_log, a.pkt->get_flow_vlan_id());
 }
 
 //-------------------------------------------------------------------------
@@ -617,7 +613,7 @@ void CsvLogger::alert(Packet* p, const char* msg, const Event& event)
             first = false;
         else
             // FIXIT-RC need to check csv_log for nullptr
-            TextLog_Puts(csv_log, sep.c_str());
+            TextLog_Write(csv_log, sep.c_str(), sep.size());
 
         f(a);
     }
@@ -68,20 +68,46 @@ struct Args
     Packet* pkt;
     const char* msg;
     const Event& event;
+    const string* label;
     bool comma;
 };
 
-static void print_label(const Args& a, const char* label)
+// labels are built once when configured and include the leading comma
+static void print_label(const Args& a)
 {
-    if ( a.comma )
-        TextLog_Print(json_log, ",");
+    unsigned skip = a.comma ? 0 : 1;
+    TextLog_Write(json_log, a.label->c_str() + skip, a.label->size() - skip);
+}
+
+static void print_quoted_ip(const SfIp* ip)
+{
+    TextLog_Putc(json_log, '"');
+    TextLog_PutIp(json_log, ip);
+    TextLog_Putc(json_log, '"');
+}
 
-    TextLog_Print(json_log, " \"%s\" : ", label);
+static void print_quoted_ap(const SfIp* ip, unsigned port)
+{
+    TextLog_Putc(json_log, '"');
+
+    if ( ip )
+        TextLog_PutIp(json_log, ip);
+
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, port);
+    TextLog_Putc(json_log, '"');
+}
+
+static void print_quoted_mac(const uint8_t* mac)
+{
+    TextLog_Putc(json_log, '"');
+    TextLog_PutMac(json_log, mac);
+    TextLog_Putc(json_log, '"');
 }
 
 static bool ff_action(const Args& a)
 {
-    print_label(a, "action");
+    print_label(a);
     TextLog_Quote(json_log, a.pkt->active->get_action_string());
     return true;
 }
@@ -93,7 +119,7 @@ static bool ff_class(const Args& a)
     if ( a.event.sig_info->class_type and !a.event.sig_info->class_type->text.empty() )
         cls = a.event.sig_info->class_type->text.c_str();
 
-    print_label(a, "class");
+    print_label(a);
     TextLog_Quote(json_log, cls);
     return true;
 }
@@ -110,7 +136,7 @@ static bool ff_b64_data(const Args& a)
     unsigned nin = 0;
     Base64Encoder b64;
 
-    print_label(a, "b64_data");
+    print_label(a);
     TextLog_Putc(json_log, '"');
 
     while ( nin < a.pkt->dsize )
@@ -132,8 +158,8 @@ static bool ff_client_bytes(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "client_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_bytes);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.client_bytes);
         return true;
     }
     return false;
@@ -143,8 +169,8 @@ static bool ff_client_pkts(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "client_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.client_pkts);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.client_pkts);
         return true;
     }
     return false;
@@ -161,7 +187,7 @@ static bool ff_dir(const Args& a)
     else
         dir = "UNK";
 
-    print_label(a, "dir");
+    print_label(a);
     TextLog_Quote(json_log, dir);
     return true;
 }
@@ -170,9 +196,8 @@ static bool ff_dst_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
-        print_label(a, "dst_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_dst()->ntop(ip_str));
+        print_label(a);
+        print_quoted_ip(a.pkt->ptrs.ip_api.get_dst());
         return true;
     }
     return false;
@@ -180,17 +205,17 @@ static bool ff_dst_addr(const Args& a)
 
 static bool ff_dst_ap(const Args& a)
 {
-    SfIpString addr = "";
+    const SfIp* addr = nullptr;
     unsigned port = 0;
 
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_dst();
 
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.dp;
 
-    print_label(a, "dst_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_label(a);
+    print_quoted_ap(addr, port);
     return true;
 }
 
@@ -198,8 +223,8 @@ static bool ff_dst_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
-        print_label(a, "dst_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.dp);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.dp);
         return true;
     }
     return false;
@@ -210,12 +235,10 @@ static bool ff_eth_dst(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_dst");
+    print_label(a);
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_dst[0],
-        eh->ether_dst[1], eh->ether_dst[2], eh->ether_dst[3],
-        eh->ether_dst[4], eh->ether_dst[5]);
+    print_quoted_mac(eh->ether_dst);
 
     return true;
 }
@@ -225,8 +248,8 @@ static bool ff_eth_len(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_len");
-    TextLog_Print(json_log, "%u", a.pkt->pkth->pktlen);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.pkt->pkth->pktlen);
     return true;
 }
 
@@ -235,12 +258,10 @@ static bool ff_eth_src(const Args& a)
     if ( !(a.pkt->proto_bits & PROTO_BIT__ETH) )
         return false;
 
-    print_label(a, "eth_src");
+    print_label(a);
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    TextLog_Print(json_log, "\"%02X:%02X:%02X:%02X:%02X:%02X\"", eh->ether_src[0],
-        eh->ether_src[1], eh->ether_src[2], eh->ether_src[3],
-        eh->ether_src[4], eh->ether_src[5]);
+    print_quoted_mac(eh->ether_src);
     return true;
 }
 
@@ -251,8 +272,10 @@ static bool ff_eth_type(const Args& a)
 
     const eth::EtherHdr* eh = layer::get_eth_layer(a.pkt);
 
-    print_label(a, "eth_type");
-    TextLog_Print(json_log, "\"0x%X\"", ntohs(eh->ether_type));
+    print_label(a);
+    TextLog_Write(json_log, "\"0x", 3);
+    TextLog_PutHex(json_log, ntohs(eh->ether_type));
+    TextLog_Putc(json_log, '"');
     return true;
 }
 
@@ -260,8 +283,8 @@ static bool ff_flowstart_time(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "flowstart_time");
-        TextLog_Print(json_log, "%u", a.pkt->flow->flowstats.start_time.tv_sec);
+        print_label(a);
+        TextLog_PutUInt(json_log, (uint32_t)a.pkt->flow->flowstats.start_time.tv_sec);
         return true;
     }
     return false;
@@ -269,8 +292,8 @@ static bool ff_flowstart_time(const Args& a)
 
 static bool ff_gid(const Args& a)
 {
-    print_label(a, "gid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->gid);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.event.sig_info->gid);
     return true;
 }
 
@@ -278,8 +301,8 @@ static bool ff_icmp_code(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_code");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->code);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.icmph->code);
         return true;
     }
     return false;
@@ -289,8 +312,8 @@ static bool ff_icmp_id(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_id");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_id));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.icmph->s_icmp_id));
         return true;
     }
     return false;
@@ -300,8 +323,8 @@ static bool ff_icmp_seq(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_seq");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.icmph->s_icmp_seq));
         return true;
     }
     return false;
@@ -311,8 +334,8 @@ static bool ff_icmp_type(const Args& a)
 {
     if (a.pkt->ptrs.icmph )
     {
-        print_label(a, "icmp_type");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.icmph->type);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.icmph->type);
         return true;
     }
     return false;
@@ -320,7 +343,7 @@ static bool ff_icmp_type(const Args& a)
 
 static bool ff_iface(const Args& a)
 {
-    print_label(a, "iface");
+    print_label(a);
     TextLog_Quote(json_log, SFDAQ::get_input_spec());
     return true;
 }
@@ -329,8 +352,8 @@ static bool ff_ip_id(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ip_id");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.id());
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.id());
         return true;
     }
     return false;
@@ -340,8 +363,8 @@ static bool ff_ip_len(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ip_len");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.pay_len());
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.pay_len());
         return true;
     }
     return false;
@@ -349,7 +372,7 @@ static bool ff_ip_len(const Args& a)
 
 static bool ff_msg(const Args& a)
 {
-    print_label(a, "msg");
+    print_label(a);
     TextLog_Puts(json_log, a.msg);
     return true;
 }
@@ -367,72 +390,77 @@ static bool ff_mpls(const Args& a)
     else
         return false;
 
-    print_label(a, "mpls");
-    TextLog_Print(json_log, "%u", ntohl(mpls));
+    print_label(a);
+    TextLog_PutUInt(json_log, ntohl(mpls));
     return true;
 }
 
 static bool ff_pkt_gen(const Args& a)
 {
-    print_label(a, "pkt_gen");
+    print_label(a);
     TextLog_Quote(json_log, a.pkt->get_pseudo_type());
     return true;
 }
 
 static bool ff_pkt_len(const Args& a)
 {
-    print_label(a, "pkt_len");
+    print_label(a);
 
     if (a.pkt->has_ip())
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.dgram_len());
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.dgram_len());
     else
-        TextLog_Print(json_log, "%u", a.pkt->dsize);
+        TextLog_PutUInt(json_log, a.pkt->dsize);
 
     return true;
 }
 
 static bool ff_pkt_num(const Args& a)
 {
-    print_label(a, "pkt_num");
-    TextLog_Print(json_log, STDu64, a.pkt->context->packet_number);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.pkt->context->packet_number);
     return true;
 }
 
 static bool ff_priority(const Args& a)
 {
-    print_label(a, "priority");
-    TextLog_Print(json_log, "%u", a.event.sig_info->priority);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.event.sig_info->priority);
     return true;
 }
 
 static bool ff_proto(const Args& a)
 {
-    print_label(a, "proto");
+    print_label(a);
     TextLog_Quote(json_log, a.pkt->get_type());
     return true;
 }
 
 static bool ff_rev(const Args& a)
 {
-    print_label(a, "rev");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->rev);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.event.sig_info->rev);
     return true;
 }
 
 static bool ff_rule(const Args& a)
 {
-    print_label(a, "rule");
+    print_label(a);
 
-    TextLog_Print(json_log, "\"%u:%u:%u\"",
-        a.event.sig_info->gid, a.event.sig_info->sid, a.event.sig_info->rev);
+    TextLog_Putc(json_log, '"');
+    TextLog_PutUInt(json_log, a.event.sig_info->gid);
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, a.event.sig_info->sid);
+    TextLog_Putc(json_log, ':');
+    TextLog_PutUInt(json_log, a.event.sig_info->rev);
+    TextLog_Putc(json_log, '"');
 
     return true;
 }
 
 static bool ff_seconds(const Args& a)
 {
-    print_label(a, "seconds");
-    TextLog_Print(json_log, "%u",  a.pkt->pkth->ts.tv_sec);
+    print_label(a);
+    TextLog_PutUInt(json_log, (uint32_t)a.pkt->pkth->ts.tv_sec);
     return true;
 }
 
@@ -440,8 +468,8 @@ static bool ff_server_bytes(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "server_bytes");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_bytes);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.server_bytes);
         return true;
     }
     return false;
@@ -451,8 +479,8 @@ static bool ff_server_pkts(const Args& a)
 {
     if (a.pkt->flow)
     {
-        print_label(a, "server_pkts");
-        TextLog_Print(json_log, "%" PRIu64, a.pkt->flow->flowstats.server_pkts);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->flow->flowstats.server_pkts);
         return true;
     }
     return false;
@@ -465,15 +493,15 @@ static bool ff_service(const Args& a)
     if ( a.pkt->flow and a.pkt->flow->service )
         svc = a.pkt->flow->service;
 
-    print_label(a, "service");
+    print_label(a);
     TextLog_Quote(json_log, svc);
     return true;
 }
 
 static bool ff_sid(const Args& a)
 {
-    print_label(a, "sid");
-    TextLog_Print(json_log, "%u",  a.event.sig_info->sid);
+    print_label(a);
+    TextLog_PutUInt(json_log, a.event.sig_info->sid);
     return true;
 }
 
@@ -481,9 +509,8 @@ static bool ff_src_addr(const Args& a)
 {
     if ( a.pkt->has_ip() or a.pkt->is_data() )
     {
-        SfIpString ip_str;
-        print_label(a, "src_addr");
-        TextLog_Quote(json_log, a.pkt->ptrs.ip_api.get_src()->ntop(ip_str));
+        print_label(a);
+        print_quoted_ip(a.pkt->ptrs.ip_api.get_src());
         return true;
     }
     return false;
@@ -491,17 +518,17 @@ static bool ff_src_addr(const Args& a)
 
 static bool ff_src_ap(const Args& a)
 {
-    SfIpString addr = "";
+    const SfIp* addr = nullptr;
     unsigned port = 0;
 
     if ( a.pkt->has_ip() or a.pkt->is_data() )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_src();
 
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
         port = a.pkt->ptrs.sp;
 
-    print_label(a, "src_ap");
-    TextLog_Print(json_log, "\"%s:%u\"", addr, port);
+    print_label(a);
+    print_quoted_ap(addr, port);
     return true;
 }
 
@@ -509,8 +536,8 @@ static bool ff_src_port(const Args& a)
 {
     if ( a.pkt->proto_bits & (PROTO_BIT__TCP|PROTO_BIT__UDP) )
     {
-        print_label(a, "src_port");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.sp);
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.sp);
         return true;
     }
     return false;
@@ -518,19 +545,19 @@ static bool ff_src_port(const Args& a)
 
 static bool ff_target(const Args& a)
 {
-    SfIpString addr = "";
+    const SfIp* addr;
 
     if ( a.event.sig_info->target == TARGET_SRC )
-        a.pkt->ptrs.ip_api.get_src()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_src();
 
     else if ( a.event.sig_info->target == TARGET_DST )
-        a.pkt->ptrs.ip_api.get_dst()->ntop(addr);
+        addr = a.pkt->ptrs.ip_api.get_dst();
 
     else
         return false;
 
-    print_label(a, "target");
-    TextLog_Quote(json_log, addr);
+    print_label(a);
+    print_quoted_ip(addr);
     return true;
 }
 
@@ -538,8 +565,8 @@ static bool ff_tcp_ack(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_ack");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_ack));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohl(a.pkt->ptrs.tcph->th_ack));
         return true;
     }
     return false;
@@ -552,7 +579,7 @@ static bool ff_tcp_flags(const Args& a)
         char tcpFlags[9];
         CreateTCPFlagString(a.pkt->ptrs.tcph, tcpFlags);
 
-        print_label(a, "tcp_flags");
+        print_label(a);
         TextLog_Quote(json_log, tcpFlags);
         return true;
     }
@@ -563,8 +590,8 @@ static bool ff_tcp_len(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_len");
-        TextLog_Print(json_log, "%u", (a.pkt->ptrs.tcph->off()));
+        print_label(a);
+        TextLog_PutUInt(json_log, (a.pkt->ptrs.tcph->off()));
         return true;
     }
     return false;
@@ -574,8 +601,8 @@ static bool ff_tcp_seq(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_seq");
-        TextLog_Print(json_log, "%u", ntohl(a.pkt->ptrs.tcph->th_seq));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohl(a.pkt->ptrs.tcph->th_seq));
         return true;
     }
     return false;
@@ -585,8 +612,8 @@ static bool ff_tcp_win(const Args& a)
 {
     if (a.pkt->ptrs.tcph )
     {
-        print_label(a, "tcp_win");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.tcph->th_win));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.tcph->th_win));
         return true;
     }
     return false;
@@ -594,7 +621,7 @@ static bool ff_tcp_win(const Args& a)
 
 static bool ff_timestamp(const Args& a)
 {
-    print_label(a, "timestamp");
+    print_label(a);
     TextLog_Putc(json_log, '"');
     LogTimeStamp(json_log, a.pkt);
     TextLog_Putc(json_log, '"');
@@ -605,8 +632,8 @@ static bool ff_tos(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "tos");
-        TextLog_Print(json_log, "%u", a.pkt->ptrs.ip_api.tos());
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.tos());
         return true;
     }
     return false;
@@ -616,8 +643,8 @@ static bool ff_ttl(const Args& a)
 {
     if (a.pkt->has_ip())
     {
-        print_label(a, "ttl");
-        TextLog_Print(json_log, "%u",a.pkt->ptrs.ip_api.ttl());
+        print_label(a);
+        TextLog_PutUInt(json_log, a.pkt->ptrs.ip_api.ttl());
         return true;
     }
     return false;
@@ -627,8 +654,8 @@ static bool ff_udp_len(const Args& a)
 {
     if (a.pkt->ptrs.udph )
     {
-        print_label(a, "udp_len");
-        TextLog_Print(json_log, "%u", ntohs(a.pkt->ptrs.udph->uh_len));
+        print_label(a);
+        TextLog_PutUInt(json_log, ntohs(a.pkt->ptrs.udph->uh_len));
         return true;
     }
     return false;
@@ -636,8 +663,8 @@ static bool ff_udp_len(const Args& a)
 
 static bool ff_vlan(const Args& a)
 {
-    print_label(a, "vlan");
-    TextLog_Print(json_log, "%hu", a.pkt->get_flow_vlan_id());
+    print_label(a);
+    TextLog_PutUInt(json_log, a.pkt->get_flow_vlan_id());
     return true;
 }
 
@@ -647,6 +674,14 @@ static bool ff_vlan(const Args& a)
 
 typedef bool (*JsonFunc)(const Args&);
 
+struct JsonField
+{
+    JsonFunc func;
+    string label;
+
+    JsonField(JsonFunc f, const string& name) : func(f), label(", \"" + name + "\" : ") { }
+};
+
 static const JsonFunc json_func[] =
 {
     ff_action, ff_class, ff_b64_data, ff_client_bytes, ff_client_pkts, ff_dir,
@@ -706,7 +741,7 @@ public:
     bool file;
     size_t limit;
     string sep;
-    vector<JsonFunc> fields;
+    vector<JsonField> fields;
 };
 
 bool JsonModule::set(const char*, Value& v, SnortConfig*)
@@ -721,7 +756,7 @@ bool JsonModule::set(const char*, Value& v, SnortConfig*)
         fields.clear();
 
         while ( v.get_next_token(tok) )
-            fields.emplace_back(json_func[Parameter::index(json_range, tok.c_str())]);
+            fields.emplace_back(json_func[Parameter::index(json_range, tok.c_str())], tok);
     }
 
     else if ( v.is("limit") )
@@ -749,7 +784,7 @@ bool JsonModule::begin(const char*, int, SnortConfig*)
         v.set_first_token();
 
         while ( v.get_next_token(tok) )
-            fields.emplace_back(json_func[Parameter::index(json_range, tok.c_str())]);
+            fields.emplace_back(json_func[Parameter::index(json_range, tok.c_str())], tok);
     }
     return true;
 }
@@ -771,7 +806,7 @@ public:
 public:
     string file;
     unsigned long limit;
-    vector<JsonFunc> fields;
+    vector<JsonField> fields;
     string sep;
 };
 
@@ -796,16 +831,17 @@ void JsonLogger::close()
 
 void JsonLogger::alert(Packet* p, const char* msg, const Event& event)
 {
-    Args a = { p, msg, event, false };
+    Args a = { p, msg, event, nullptr, false };
     TextLog_Putc(json_log, '{');
 
-    for ( JsonFunc f : fields )
+    for ( const JsonField& f : fields )
     {
-        f(a);
+        a.label = &f.label;
+        f.func(a);
         a.comma = true;
     }
 
-    TextLog_Print(json_log, " }\n");
+    TextLog_Write(json_log, " }\n", 3);
     TextLog_Flush(json_log);
 }
 
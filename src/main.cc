@@ -34,6 +34,7 @@
 #include "lua/lua.h"
 #include "main/analyzer.h"
 #include "main/analyzer_command.h"
+#include "main/bench.h"
 #include "main/request.h"
 #include "main/shell.h"
 #include "main/snort.h"
@@ -984,8 +985,14 @@ static void snort_main()
         pigs_started[idx] = false;
     }
 
+    if ( Bench::enabled() )
+        Bench::setup();
+
     main_loop();
 
+    if ( Bench::enabled() )
+        main_exit_code = Bench::report();
+
     delete pig_poke;
     delete[] pigs;
     pigs = nullptr;
@@ -28,6 +28,7 @@
 
 #include <thread>
 
+#include "decompress/inflate_pool.h"
 #include "detection/context_switcher.h"
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
@@ -38,9 +39,11 @@
 #include "filters/rate_filter.h"
 #include "filters/sfrf.h"
 #include "filters/sfthreshold.h"
+#include "flow/expect_cache.h"
 #include "flow/flow.h"
 #include "flow/ha.h"
 #include "framework/data_bus.h"
+#include "latency/overload_control.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
 #include "log/messages.h"
@@ -58,6 +61,7 @@
 #include "packet_io/sfdaq_module.h"
 #include "packet_tracer/packet_tracer.h"
 #include "profiler/profiler.h"
+#include "profiler/tail_latency.h"
 #include "pub_sub/daq_message_event.h"
 #include "pub_sub/finalize_packet_event.h"
 #include "side_channel/side_channel.h"
@@ -66,6 +70,7 @@
 #include "utils/stats.h"
 
 #include "analyzer_command.h"
+#include "bench.h"
 #include "oops_handler.h"
 #include "snort.h"
 #include "snort_config.h"
@@ -298,6 +303,11 @@ static DAQ_Verdict distill_verdict(Packet* p)
         PacketManager::encode_update(p);
         verdict = DAQ_VERDICT_REPLACE;
     }
+    else if ( p->packet_flags & PKT_CKSUM_UPDATED )
+    {
+        // rewritten in place and already consistent; see encode_rewrite
+        verdict = DAQ_VERDICT_REPLACE;
+    }
     else if ( (p->packet_flags & PKT_IGNORE) ||
         (p->flow && p->flow->get_ignore_direction() == SSN_DIR_BOTH) )
     {
@@ -478,6 +488,10 @@ bool Analyzer::process_rebuilt_packet(Packet* p, const DAQ_PktHdr_t* pkthdr, con
 void Analyzer::post_process_packet(Packet* p)
 {
     post_process_daq_pkt_msg(p);
+
+    // release any shared expected sessions held for this packet
+    ExpectFlow::reset_expect_flows();
+
     // FIXIT-? There is an assumption that this is being called on the active context...
     switcher->stop();
 }
@@ -556,6 +570,7 @@ void Analyzer::idle()
     process_retry_queue();
 
     Stream::timeout_flows(packet_time());
+    OverloadControl::update(daq_instance);
 
     HighAvailabilityManager::process_receive();
 
@@ -603,6 +618,7 @@ void Analyzer::init_unprivileged()
     HighAvailabilityManager::thread_init(); // must be before InspectorManager::thread_init();
     InspectorManager::thread_init(sc);
     PacketTracer::thread_init();
+    TailLatency::tinit();
 
     // in case there are HA messages waiting, process them first
     HighAvailabilityManager::process_receive();
@@ -641,6 +657,7 @@ void Analyzer::term()
     ModuleManager::accumulate(sc);
     InspectorManager::thread_term(sc);
     ActionManager::thread_term(sc);
+    InflatePool::tterm();
 
     IpsManager::clear_options();
     EventManager::close_outputs();
@@ -655,6 +672,7 @@ void Analyzer::term()
 
     PacketLatency::tterm();
     RuleLatency::tterm();
+    OverloadControl::tterm();
 
     Profiler::consolidate_stats();
 
@@ -716,14 +734,25 @@ void Analyzer::operator()(Swapper* ps, uint16_t run_num)
     SFDAQ::set_local_instance(daq_instance);
     set_state(State::INITIALIZED);
 
+    const bool bench = Bench::enabled();
+
     Profiler::start();
 
+    if ( bench )
+        Bench::thread_start();
+
     // Start the main loop
     analyze();
 
+    if ( bench )
+        Bench::thread_stop();
+
     Profiler::stop(pc.analyzed_pkts);
     term();
 
+    if ( bench )
+        Bench::thread_term();
+
     set_state(State::STOPPED);
 }
 
@@ -823,6 +852,10 @@ DAQ_RecvStatus Analyzer::process_messages()
     // This conveniently handles servicing offloads in the no messages received case as well.
     DetectionEngine::onload();
 
+    // batch latency excludes the receive wait
+    bool timed = TailLatency::is_enabled();
+    hr_time start = timed ? SnortClock::now() : hr_time();
+
     unsigned num_recv = 0;
     DAQ_Msg_h msg;
     while ((msg = daq_instance->next_message()) != nullptr)
@@ -845,6 +878,11 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    if ( timed and num_recv )
+        TailLatency::record(TailLatency::DAQ_BATCH, SnortClock::now() - start);
+
+    OverloadControl::update(daq_instance);
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
@@ -0,0 +1,723 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "bench.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "log/messages.h"
+#include "memory/memory_module.h"
+#include "packet_io/sfdaq_module.h"
+#include "packet_io/trough.h"
+#include "profiler/profiler.h"
+#include "time/clock_defs.h"
+#include "utils/stats.h"
+
+#include "snort_config.h"
+#include "thread.h"
+
+#if defined(__i386__) || defined(__x86_64__)
+#include "time/tsc_clock.h"
+#define BENCH_CYCLES
+#endif
+
+using namespace snort;
+
+std::string Bench::output;
+std::string Bench::baseline;
+unsigned Bench::warmup = 1;
+double Bench::tolerance = 5.0;
+bool Bench::loop_given = false;
+
+// modules taking less than this share of the baseline run time are too
+// noisy to compare
+static constexpr double min_module_pct = 1.0;
+
+//-------------------------------------------------------------------------
+// run accounting
+//-------------------------------------------------------------------------
+
+struct RunStats
+{
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    uint64_t cycles;
+    uint64_t max_in_use;
+};
+
+struct RunMark
+{
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+    uint64_t cycles;
+};
+
+static THREAD_LOCAL RunMark mark;
+static THREAD_LOCAL RunStats run;
+
+static std::mutex bench_mutex;
+static RunStats totals;
+static ProfilerStats warmup_stats;
+
+static unsigned passes = 0;
+static unsigned file_count = 0;
+static unsigned warmup_files = 0;
+static unsigned files_done = 0;
+
+static uint64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static uint64_t get_cycles()
+{
+#ifdef BENCH_CYCLES
+    return TscClock::counter();
+#else
+    return 0;
+#endif
+}
+
+void Bench::setup()
+{
+    if ( !SnortConfig::read_mode() )
+        FatalError("--bench requires pcap input\n");
+
+    file_count = Trough::get_queue_size();
+    passes = Trough::get_loop_count();
+
+    if ( !passes )
+    {
+        if ( loop_given )
+            FatalError("--bench can't use --pcap-loop 0, which reads until terminated\n");
+
+        passes = warmup + 3;
+        Trough::set_loop_count(passes);
+    }
+
+    if ( passes <= warmup )
+        FatalError("--bench needs more passes (%u) than warmup passes (%u)\n", passes, warmup);
+
+    warmup_files = warmup * file_count;
+
+    // per-module breakdown comes from the time profiler
+    TimeProfilerStats::set_enabled(true);
+
+    LogMessage("bench: %u pcaps x %u passes, %u warmup\n", file_count, passes, warmup);
+}
+
+void Bench::thread_start()
+{
+    mark.wall_ns = clock_ns(CLOCK_MONOTONIC);
+    mark.cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    mark.cycles = get_cycles();
+}
+
+// must be called before term() accumulates and clears the thread's counts
+void Bench::thread_stop()
+{
+    run.cycles = get_cycles() - mark.cycles;
+    run.cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - mark.cpu_ns;
+    run.wall_ns = clock_ns(CLOCK_MONOTONIC) - mark.wall_ns;
+
+    run.packets = pc.analyzed_pkts;
+    run.bytes = daq_stats.rx_bytes;
+    run.max_in_use = mem_stats.max_in_use;
+}
+
+// must be called after term() so the profiler nodes include this run
+void Bench::thread_term()
+{
+    std::lock_guard<std::mutex> lock(bench_mutex);
+
+    if ( ++files_done <= warmup_files )
+    {
+        if ( files_done == warmup_files )
+            Profiler::get_stats(warmup_stats);
+        return;
+    }
+
+    totals.packets += run.packets;
+    totals.bytes += run.bytes;
+    totals.wall_ns += run.wall_ns;
+    totals.cpu_ns += run.cpu_ns;
+    totals.cycles += run.cycles;
+
+    if ( run.max_in_use > totals.max_in_use )
+        totals.max_in_use = run.max_in_use;
+}
+
+//-------------------------------------------------------------------------
+// results
+//-------------------------------------------------------------------------
+
+// flattened json numbers keyed by dotted path, eg metrics.mpps
+using Metrics = std::map<std::string, double>;
+
+struct ModuleTime
+{
+    std::string name;
+    uint64_t checks;
+    uint64_t usecs;
+};
+
+static void get_module_times(std::vector<ModuleTime>& mods, uint64_t& total_usecs)
+{
+    ProfilerStats stats;
+    Profiler::get_stats(stats);
+
+    std::map<std::string, TimeProfilerStats> warm;
+
+    for ( const auto& ws : warmup_stats )
+        warm[ws.first] = ws.second.time;
+
+    total_usecs = 0;
+
+    for ( const auto& s : stats )
+    {
+        TimeProfilerStats t = s.second.time;
+        const auto w = warm.find(s.first);
+
+        if ( w != warm.end() )
+        {
+            t.elapsed -= w->second.elapsed;
+            t.checks -= w->second.checks;
+        }
+
+        uint64_t usecs = clock_usecs(TO_USECS(t.elapsed));
+
+        if ( s.first == ROOT_NODE )
+            total_usecs = usecs;
+
+        else if ( t.checks )
+            mods.push_back({ s.first, t.checks, usecs });
+    }
+
+    std::sort(mods.begin(), mods.end(),
+        [](const ModuleTime& a, const ModuleTime& b)
+        { return a.usecs > b.usecs or (a.usecs == b.usecs and a.name < b.name); });
+}
+
+static void get_metrics(Metrics& m, std::vector<ModuleTime>& mods)
+{
+    uint64_t total_usecs;
+    get_module_times(mods, total_usecs);
+
+    double pkts = totals.packets ? totals.packets : 1;
+    double secs = totals.wall_ns ? totals.wall_ns / 1e9 : 1;
+
+    m["metrics.packets"] = totals.packets;
+    m["metrics.bytes"] = totals.bytes;
+    m["metrics.seconds"] = totals.wall_ns / 1e9;
+    m["metrics.mpps"] = totals.packets / secs / 1e6;
+    m["metrics.gbps"] = totals.bytes * 8 / secs / 1e9;
+#ifdef BENCH_CYCLES
+    m["metrics.cycles_per_pkt"] = totals.cycles / pkts;
+#endif
+    m["metrics.cpu_usecs_per_pkt"] = totals.cpu_ns / pkts / 1e3;
+    m["metrics.max_in_use"] = totals.max_in_use;
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    m["metrics.max_rss_kb"] = ru.ru_maxrss;
+
+    for ( const auto& mt : mods )
+    {
+        std::string key = "modules." + mt.name;
+        m[key + ".checks"] = mt.checks;
+        m[key + ".usecs"] = mt.usecs;
+        m[key + ".usecs_per_pkt"] = mt.usecs / pkts;
+        m[key + ".pct"] = total_usecs ? 100.0 * mt.usecs / total_usecs : 0.0;
+    }
+}
+
+static std::ostream& operator<<(std::ostream& out, const Metrics::value_type& v)
+{
+    double i;
+
+    if ( std::modf(v.second, &i) == 0.0 )
+        out << uint64_t(i);
+    else
+        out << std::setprecision(6) << std::fixed << v.second;
+
+    return out;
+}
+
+static bool write_json(const std::string& file, const Metrics& m,
+    const std::vector<ModuleTime>& mods)
+{
+    std::ofstream out(file);
+
+    if ( !out )
+        return false;
+
+    out << "{\n";
+    out << "    \"pcaps\": " << file_count << ",\n";
+    out << "    \"passes\": " << passes << ",\n";
+    out << "    \"warmup\": " << Bench::get_warmup() << ",\n";
+    out << "    \"metrics\": {";
+
+    const char* sep = "\n";
+    const std::string prefix = "metrics.";
+
+    for ( auto it = m.lower_bound(prefix); it != m.end(); ++it )
+    {
+        if ( it->first.compare(0, prefix.size(), prefix) )
+            break;
+
+        out << sep << "        \"" << it->first.substr(prefix.size()) << "\": " << *it;
+        sep = ",\n";
+    }
+    out << "\n    },\n";
+    out << "    \"modules\": {";
+    sep = "\n";
+
+    for ( const auto& mt : mods )
+    {
+        std::string key = "modules." + mt.name;
+        out << sep << "        \"" << mt.name << "\": { ";
+        out << "\"checks\": " << mt.checks << ", ";
+        out << "\"usecs\": " << mt.usecs << ", ";
+        out << "\"usecs_per_pkt\": " << *m.find(key + ".usecs_per_pkt") << ", ";
+        out << "\"pct\": " << *m.find(key + ".pct") << " }";
+        sep = ",\n";
+    }
+    out << "\n    }\n";
+    out << "}\n";
+
+    return bool(out);
+}
+
+//-------------------------------------------------------------------------
+// baseline
+//-------------------------------------------------------------------------
+
+// just enough json to read back what write_json() produces plus an optional
+// tolerances object; arrays are not supported
+class JsonReader
+{
+public:
+    JsonReader(const std::string& s) : text(s) { }
+
+    bool parse(Metrics& m)
+    {
+        pos = 0;
+
+        if ( !object("", m) )
+            return false;
+
+        skip();
+        return pos == text.size();
+    }
+
+private:
+    void skip()
+    {
+        while ( pos < text.size() and isspace((unsigned char)text[pos]) )
+            ++pos;
+    }
+
+    bool expect(char c)
+    {
+        skip();
+
+        if ( pos >= text.size() or text[pos] != c )
+            return false;
+
+        ++pos;
+        return true;
+    }
+
+    bool string(std::string& s)
+    {
+        if ( !expect('"') )
+            return false;
+
+        size_t end = text.find('"', pos);
+
+        if ( end == std::string::npos )
+            return false;
+
+        s = text.substr(pos, end - pos);
+        pos = end + 1;
+        return true;
+    }
+
+    bool word(const char* w)
+    {
+        size_t n = strlen(w);
+
+        if ( text.compare(pos, n, w) )
+            return false;
+
+        pos += n;
+        return true;
+    }
+
+    bool value(const std::string& key, Metrics& m)
+    {
+        skip();
+
+        if ( pos >= text.size() )
+            return false;
+
+        if ( text[pos] == '{' )
+            return object(key + ".", m);
+
+        if ( text[pos] == '"' )
+        {
+            std::string s;
+            return string(s);
+        }
+
+        if ( word("true") or word("false") or word("null") )
+            return true;
+
+        const char* start = text.c_str() + pos;
+        char* end;
+        double d = strtod(start, &end);
+
+        if ( end == start )
+            return false;
+
+        m[key] = d;
+        pos += end - start;
+        return true;
+    }
+
+    bool object(const std::string& prefix, Metrics& m)
+    {
+        if ( !expect('{') )
+            return false;
+
+        if ( expect('}') )
+            return true;
+
+        do
+        {
+            std::string key;
+
+            if ( !string(key) or !expect(':') or !value(prefix + key, m) )
+                return false;
+        }
+        while ( expect(',') );
+
+        return expect('}');
+    }
+
+    const std::string& text;
+    size_t pos = 0;
+};
+
+static bool load_baseline(const std::string& file, Metrics& m)
+{
+    std::ifstream in(file);
+
+    if ( !in )
+        return false;
+
+    std::stringstream ss;
+    ss << in.rdbuf();
+
+    const std::string text = ss.str();
+    JsonReader reader(text);
+
+    return reader.parse(m);
+}
+
+static double get_tolerance(const Metrics& base, const std::string& name, const char* group)
+{
+    auto it = base.find("tolerances." + name);
+
+    if ( it == base.end() and group )
+        it = base.find(std::string("tolerances.") + group);
+
+    return it != base.end() ? it->second : Bench::get_tolerance();
+}
+
+static bool regressed(
+    const std::string& name, double cur, double base, double tol, bool higher_is_better)
+{
+    double change = 100.0 * (cur - base) / base;
+    bool bad = higher_is_better ? (change < -tol) : (change > tol);
+
+    LogMessage("bench: %-32s %14.3f %14.3f %+8.2f%%%s\n", name.c_str(), base, cur, change,
+        bad ? "  regressed" : "");
+
+    return bad;
+}
+
+static unsigned compare(const Metrics& cur, const Metrics& base)
+{
+    static const struct
+    {
+        const char* name;
+        bool higher_is_better;
+    }
+    checks[] =
+    {
+        { "mpps", true },
+        { "gbps", true },
+        { "cycles_per_pkt", false },
+        { "cpu_usecs_per_pkt", false },
+        { "max_rss_kb", false },
+    };
+
+    unsigned fails = 0;
+    LogMessage("bench: %-32s %14s %14s %9s\n", "metric", "baseline", "current", "change");
+
+    for ( const auto& c : checks )
+    {
+        const std::string key = std::string("metrics.") + c.name;
+        const auto b = base.find(key);
+        const auto v = cur.find(key);
+
+        if ( b == base.end() or v == cur.end() or b->second <= 0 )
+            continue;
+
+        double tol = get_tolerance(base, c.name, nullptr);
+
+        if ( regressed(c.name, v->second, b->second, tol, c.higher_is_better) )
+            ++fails;
+    }
+
+    const std::string prefix = "modules.";
+    const std::string suffix = ".usecs_per_pkt";
+
+    for ( auto b = base.lower_bound(prefix); b != base.end(); ++b )
+    {
+        const std::string& key = b->first;
+
+        if ( key.compare(0, prefix.size(), prefix) )
+            break;
+
+        if ( key.size() <= prefix.size() + suffix.size() or
+            key.compare(key.size() - suffix.size(), suffix.size(), suffix) )
+            continue;
+
+        const std::string name = key.substr(prefix.size(),
+            key.size() - prefix.size() - suffix.size());
+
+        const auto pct = base.find(prefix + name + ".pct");
+
+        if ( pct == base.end() or pct->second < min_module_pct or b->second <= 0 )
+            continue;
+
+        const auto v = cur.find(key);
+        double tol = get_tolerance(base, name, "modules");
+
+        if ( regressed(name, v != cur.end() ? v->second : 0.0, b->second, tol, false) )
+            ++fails;
+    }
+    return fails;
+}
+
+int Bench::report()
+{
+    Metrics cur;
+    std::vector<ModuleTime> mods;
+    get_metrics(cur, mods);
+
+    LogMessage("bench: %" PRIu64 " packets in %.3f s, %.3f Mpps, %.3f Gbps\n",
+        totals.packets, cur["metrics.seconds"], cur["metrics.mpps"], cur["metrics.gbps"]);
+
+    if ( !write_json(output, cur, mods) )
+    {
+        ErrorMessage("bench: can't write results to %s\n", output.c_str());
+        return 1;
+    }
+
+    if ( baseline.empty() )
+        return 0;
+
+    Metrics base;
+
+    if ( !load_baseline(baseline, base) )
+    {
+        ErrorMessage("bench: can't load baseline from %s\n", baseline.c_str());
+        return 1;
+    }
+
+    if ( unsigned fails = compare(cur, base) )
+    {
+        ErrorMessage("bench: %u metrics regressed beyond tolerance\n", fails);
+        return 1;
+    }
+    return 0;
+}
+
+
+#ifdef UNIT_TEST
+
+#include <unistd.h>
+
+#include <catch/snort_catch.h>
+
+//-------------------------------------------------------------------------
+// baseline tests
+//-------------------------------------------------------------------------
+
+static bool parse(const std::string& text, Metrics& m)
+{
+    JsonReader reader(text);
+    return reader.parse(m);
+}
+
+TEST_CASE("bench json round trip", "[bench]")
+{
+    Metrics m;
+    m["metrics.packets"] = 1000;
+    m["metrics.mpps"] = 1.25;
+    m["metrics.max_rss_kb"] = 20480;
+    m["modules.detection.usecs_per_pkt"] = 2.5;
+    m["modules.detection.pct"] = 60;
+
+    std::vector<ModuleTime> mods = { { "detection", 400, 2500 } };
+
+    char file[] = "/tmp/bench_json_XXXXXX";
+    int fd = mkstemp(file);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    CHECK(write_json(file, m, mods));
+
+    Metrics r;
+    CHECK(load_baseline(file, r));
+    unlink(file);
+
+    CHECK(r["metrics.packets"] == 1000);
+    CHECK(r["metrics.mpps"] == Approx(1.25));
+    CHECK(r["metrics.max_rss_kb"] == 20480);
+    CHECK(r["modules.detection.checks"] == 400);
+    CHECK(r["modules.detection.usecs"] == 2500);
+    CHECK(r["modules.detection.usecs_per_pkt"] == Approx(2.5));
+    CHECK(r["modules.detection.pct"] == 60);
+    CHECK(r.find("warmup") != r.end());
+}
+
+TEST_CASE("bench json reader", "[bench]")
+{
+    Metrics m;
+
+    SECTION("tolerances and ignored values")
+    {
+        CHECK(parse("{ \"name\": \"x\", \"ok\": true, \"none\": null, \"tolerances\": "
+            "{ \"mpps\": 2, \"modules\": 1e1 } }", m));
+        CHECK(m.size() == 2);
+        CHECK(m["tolerances.mpps"] == 2);
+        CHECK(m["tolerances.modules"] == 10);
+    }
+    SECTION("empty object")
+    {
+        CHECK(parse(" {} ", m));
+        CHECK(m.empty());
+    }
+    SECTION("malformed")
+    {
+        CHECK(!parse("", m));
+        CHECK(!parse("{ \"a\": 1", m));
+        CHECK(!parse("{ \"a\" 1 }", m));
+        CHECK(!parse("{ \"a\": 1, }", m));
+        CHECK(!parse("{ \"a\": x }", m));
+        CHECK(!parse("{ \"a\": 1 } }", m));
+        CHECK(!parse("{ \"a\": [ 1 ] }", m));
+    }
+}
+
+TEST_CASE("bench compare", "[bench]")
+{
+    Metrics base;
+    base["metrics.mpps"] = 1.0;
+    base["metrics.cpu_usecs_per_pkt"] = 2.0;
+    base["modules.detection.usecs_per_pkt"] = 1.0;
+    base["modules.detection.pct"] = 50;
+    base["modules.stream.usecs_per_pkt"] = 1.0;
+    base["modules.stream.pct"] = 0.5;
+
+    Metrics cur = base;
+
+    SECTION("no change")
+    {
+        CHECK(compare(cur, base) == 0);
+    }
+    SECTION("within tolerance")
+    {
+        cur["metrics.mpps"] = 0.96;
+        cur["metrics.cpu_usecs_per_pkt"] = 2.09;
+        cur["modules.detection.usecs_per_pkt"] = 1.04;
+        CHECK(compare(cur, base) == 0);
+    }
+    SECTION("direction")
+    {
+        cur["metrics.mpps"] = 0.9;
+        cur["metrics.cpu_usecs_per_pkt"] = 1.0;
+        CHECK(compare(cur, base) == 1);
+
+        cur["metrics.mpps"] = 1.5;
+        cur["metrics.cpu_usecs_per_pkt"] = 2.5;
+        CHECK(compare(cur, base) == 1);
+    }
+    SECTION("modules")
+    {
+        // stream is under the minimum share of run time
+        cur["modules.detection.usecs_per_pkt"] = 1.2;
+        cur["modules.stream.usecs_per_pkt"] = 5.0;
+        CHECK(compare(cur, base) == 1);
+
+        // a module that no longer runs is not a regression
+        cur.erase("modules.detection.usecs_per_pkt");
+        CHECK(compare(cur, base) == 0);
+    }
+    SECTION("tolerances")
+    {
+        cur["metrics.mpps"] = 0.9;
+        cur["modules.detection.usecs_per_pkt"] = 1.2;
+        base["tolerances.mpps"] = 15;
+        base["tolerances.modules"] = 25;
+        CHECK(compare(cur, base) == 0);
+
+        // a module tolerance overrides the modules group
+        base["tolerances.detection"] = 10;
+        CHECK(compare(cur, base) == 1);
+    }
+}
+
+#endif
@@ -0,0 +1,75 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// bench.h
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// Bench replays the configured pcaps several times, discards the warm-up
+// passes, and reports throughput, per-module time, and memory high-water
+// as json.  results may be compared to a prior run to catch regressions.
+
+#include <string>
+
+class Bench
+{
+public:
+    static void set_output(const char* s)
+    { output = s; }
+
+    static void set_baseline(const char* s)
+    { baseline = s; }
+
+    static void set_warmup(unsigned n)
+    { warmup = n; }
+
+    static void set_tolerance(double pct)
+    { tolerance = pct; }
+
+    // --pcap-loop was given, so 0 means until terminated rather than unset
+    static void set_loop_given()
+    { loop_given = true; }
+
+    static unsigned get_warmup()
+    { return warmup; }
+
+    static double get_tolerance()
+    { return tolerance; }
+
+    static bool enabled()
+    { return !output.empty(); }
+
+    // main thread
+    static void setup();
+    static int report();
+
+    // packet thread
+    static void thread_start();
+    static void thread_stop();
+    static void thread_term();
+
+private:
+    static std::string output;
+    static std::string baseline;
+    static unsigned warmup;
+    static double tolerance;
+    static bool loop_given;
+};
+
+#endif
+
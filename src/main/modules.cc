@@ -24,6 +24,7 @@
 
 #include "modules.h"
 
+#include <lua.hpp>
 #include <sys/resource.h>
 
 #include "codecs/codec_module.h"
@@ -52,6 +53,7 @@
 #include "parser/parse_ip.h"
 #include "parser/parser.h"
 #include "profiler/profiler.h"
+#include "profiler/tail_latency.h"
 #include "search_engines/pat_stats.h"
 #include "side_channel/side_channel_module.h"
 #include "sfip/sf_ipvar.h"
@@ -376,6 +378,9 @@ static const Parameter profiler_params[] =
     { "rules", Parameter::PT_TABLE, profiler_rule_params, nullptr,
       "rule time profiling" },
 
+    { "latency", Parameter::PT_BOOL, nullptr, "true",
+      "track latency percentiles of inspectors, detection, and daq batches" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -410,11 +415,43 @@ static bool s_profiler_module_set(T& config, Value& v)
     return true;
 }
 
+static int show_latency(lua_State*)
+{
+    LogMessage("%-24s %12s %10s %10s %10s %10s\n",
+        "latency (usec)", "count", "p50", "p99", "p99.9", "max");
+
+    for ( unsigned id = 0; id < TailLatency::get_num_ids(); ++id )
+    {
+        LatencyHistogram h;
+        TailLatency::merge(id, h);
+        uint64_t count = h.get_count();
+
+        if ( !count )
+            continue;
+
+        auto usecs = [&h](double pct)
+        { return TailLatency::get_nsecs(h.get_percentile(pct)) / 1000.0; };
+
+        LogMessage("%-24s %12" PRIu64 " %10.1f %10.1f %10.1f %10.1f\n",
+            TailLatency::get_name(id), count, usecs(50), usecs(99), usecs(99.9), usecs(100));
+    }
+    return 0;
+}
+
+static const Command profiler_cmds[] =
+{
+    { "latency", show_latency, nullptr, "show latency percentiles for all packet threads" },
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
 class ProfilerModule : public Module
 {
 public:
     ProfilerModule() : Module("profiler", profiler_help, profiler_params) { }
 
+    const Command* get_commands() const override
+    { return profiler_cmds; }
+
     bool set(const char*, Value&, SnortConfig*) override;
     bool end(const char*, int, SnortConfig*) override;
 
@@ -439,6 +476,12 @@ bool ProfilerModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, spr, strlen(spr)) )
         return s_profiler_module_set(sc->profiler->rule, v);
 
+    else if ( v.is("latency") )
+    {
+        sc->profiler->latency = v.get_bool();
+        return true;
+    }
+
     return false;
 }
 
@@ -446,6 +489,7 @@ bool ProfilerModule::end(const char*, int, SnortConfig* sc)
 {
     TimeProfilerStats::set_enabled(sc->profiler->time.show);
     RuleContext::set_enabled(sc->profiler->rule.show);
+    TailLatency::set_enabled(sc->profiler->latency);
     return true;
 }
 
@@ -999,6 +1043,9 @@ static const Parameter network_params[] =
       "all | ip | noip | tcp | notcp | udp | noudp | icmp | noicmp | none", "all",
       "checksums to verify" },
 
+    { "checksum_trust_daq", Parameter::PT_BOOL, nullptr, "true",
+      "skip verifying checksums the DAQ reports as already validated (eg by the NIC)" },
+
     { "decode_drops", Parameter::PT_BOOL, nullptr, "false",
       "enable dropping of packets by the decoder" },
 
@@ -1049,6 +1096,9 @@ bool NetworkModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("checksum_eval") )
         ConfigChecksumMode(v.get_string());
 
+    else if ( v.is("checksum_trust_daq") )
+        p->checksum_trust_daq = v.get_bool();
+
     else if ( v.is("decode_drops") )
         p->decoder_drop = v.get_bool();
 
@@ -1616,6 +1666,9 @@ static const Parameter rate_filter_params[] =
     { "apply_to", Parameter::PT_STRING, nullptr, nullptr,
       "restrict filter to these addresses according to track" },
 
+    { "global", Parameter::PT_BOOL, nullptr, "false",
+      "count hits from all packet threads against the limit" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -1626,6 +1679,10 @@ extern THREAD_LOCAL RateFilterStats rate_filter_stats;
 const PegInfo rate_filter_peg_names[] =
 {
     { CountType::SUM, "no_memory", "number of times rate filter ran out of memory" },
+    { CountType::SUM, "global_merges", "number of merges of local hits into global tracking" },
+    { CountType::SUM, "global_merge_usecs", "total time spent merging into global tracking" },
+    { CountType::MAX, "global_max_merge_usecs", "maximum time spent on one global merge" },
+    { CountType::SUM, "global_no_memory", "number of times global tracking ran out of memory" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -1686,6 +1743,9 @@ bool RateFilterModule::set(const char*, Value& v, SnortConfig*)
     else if ( v.is("apply_to") )
         thdx.applyTo = sfip_var_from_string(v.get_string(), "rate_filter");
 
+    else if ( v.is("global") )
+        thdx.global = v.get_bool();
+
     else if ( v.is("new_action") )
         thdx.newAction = (Actions::Type)(v.get_uint8() + 1);
 
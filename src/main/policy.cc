@@ -52,6 +52,7 @@ NetworkPolicy::NetworkPolicy(PolicyId id)
 
     checksum_eval = CHECKSUM_FLAG__ALL | CHECKSUM_FLAG__DEF;
     checksum_drop = CHECKSUM_FLAG__DEF;
+    checksum_trust_daq = true;
 }
 
 
@@ -99,6 +99,7 @@ public:
     uint32_t checksum_drop;
     uint32_t normal_mask;
 
+    bool checksum_trust_daq;
     bool decoder_drop;
 };
 
@@ -30,6 +30,7 @@
 #include "actions/ips_actions.h"
 #include "codecs/codec_api.h"
 #include "connectors/connectors.h"
+#include "decompress/inflate_pool.h"
 #include "detection/fp_config.h"
 #include "file_api/file_service.h"
 #include "filters/rate_filter.h"
@@ -61,6 +62,7 @@
 #include "parser/cmd_line.h"
 #include "parser/parser.h"
 #include "profiler/profiler.h"
+#include "profiler/tail_latency.h"
 #include "search_engines/search_engines.h"
 #include "service_inspectors/service_inspectors.h"
 #include "side_channel/side_channel.h"
@@ -310,6 +312,7 @@ void Snort::term()
     if ( !Piglet::piglet_mode() )
 #endif
     Trough::cleanup();
+    InflatePool::tterm();
 
     ClosePidFile();
 
@@ -348,6 +351,7 @@ void Snort::term()
     }
 
     CleanupProtoNames();
+    TailLatency::term();
     HighAvailabilityManager::term();
     SideChannelManager::term();
     ModuleManager::term();
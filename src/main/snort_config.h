@@ -246,9 +246,12 @@ public:
     unsigned offload_limit = 99999;  // disabled
     unsigned offload_threads = 0;    // disabled
 
+    uint8_t literal_search = 0;  // LiteralSearch::Method
+
 #ifdef HAVE_HYPERSCAN
     bool hyperscan_literals = false;
     bool pcre_to_regex = false;
+    bool pcre_prefilter = false;
 #endif
 
     bool global_rule_state = false;
@@ -589,6 +592,9 @@ public:
     static bool icmp_checksum_drops()
     { return snort::get_network_policy()->checksum_drop & CHECKSUM_FLAG__ICMP; }
 
+    static bool checksum_trust_daq()
+    { return snort::get_network_policy()->checksum_trust_daq; }
+
     // output stuff
     static bool output_include_year()
     { return get_conf()->output_flags & OUTPUT_FLAG__INCLUDE_YEAR; }
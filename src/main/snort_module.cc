@@ -44,6 +44,7 @@
 #endif
 
 #include "analyzer.h"
+#include "bench.h"
 #include "help.h"
 #include "shell.h"
 #include "snort_config.h"
@@ -300,6 +301,18 @@ static const Parameter s_params[] =
     { "--alert-before-pass", Parameter::PT_IMPLIED, nullptr, nullptr,
       "evaluate alert rules before pass rules; default is pass rules first" },
 
+    { "--bench", Parameter::PT_STRING, nullptr, nullptr,
+      "<file> replay pcaps for a performance benchmark and write json results to file" },
+
+    { "--bench-baseline", Parameter::PT_STRING, nullptr, nullptr,
+      "<file> compare --bench results to a prior run and fail on regression" },
+
+    { "--bench-tolerance", Parameter::PT_REAL, "0:100", "5",
+      "<pct> allowed change from --bench-baseline before a metric is a regression" },
+
+    { "--bench-warmup", Parameter::PT_INT, "0:max32", "1",
+      "<count> number of initial --bench passes to exclude from results" },
+
     { "--bpf", Parameter::PT_STRING, nullptr, nullptr,
       "<filter options> are standard BPF options, as seen in TCPDump" },
 
@@ -537,6 +550,12 @@ static const Parameter s_params[] =
 #ifdef UNIT_TEST
     { "--catch-test", Parameter::PT_STRING, nullptr, nullptr,
       "comma separated list of cat unit test tags or 'all'" },
+
+    { "--catch-reporter", Parameter::PT_ENUM, "console | compact | junit | xml", nullptr,
+      "format of unit test and benchmark results" },
+
+    { "--catch-output", Parameter::PT_STRING, nullptr, nullptr,
+      "write unit test and benchmark results to the given file instead of stdout" },
 #endif
     { "--version", Parameter::PT_IMPLIED, nullptr, nullptr,
       "show version number (same as -V)" },
@@ -771,6 +790,18 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("--alert-before-pass") )
         sc->set_alert_before_pass(true);
 
+    else if ( v.is("--bench") )
+        Bench::set_output(v.get_string());
+
+    else if ( v.is("--bench-baseline") )
+        Bench::set_baseline(v.get_string());
+
+    else if ( v.is("--bench-tolerance") )
+        Bench::set_tolerance(v.get_real());
+
+    else if ( v.is("--bench-warmup") )
+        Bench::set_warmup(v.get_uint32());
+
     else if ( v.is("--bpf") )
         sc->bpf_filter = v.get_string();
 
@@ -949,7 +980,10 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
         Trough::set_filter(v.get_string());
 
     else if ( v.is("--pcap-loop") )
+    {
         Trough::set_loop_count(v.get_uint32());
+        Bench::set_loop_given();
+    }
 
     else if ( v.is("--pcap-no-filter") )
         Trough::set_filter(nullptr);
@@ -1021,6 +1055,12 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
 #ifdef UNIT_TEST
     else if ( v.is("--catch-test") )
         catch_set_filter(v.get_string());
+
+    else if ( v.is("--catch-reporter") )
+        catch_set_reporter(v.get_string());
+
+    else if ( v.is("--catch-output") )
+        catch_set_output(v.get_string());
 #endif
     else if ( v.is("--version") )
         help_version(sc);
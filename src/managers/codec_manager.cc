@@ -191,6 +191,9 @@ void CodecManager::instantiate()
 }
 
 void CodecManager::thread_init(SnortConfig* sc)
+{ thread_init(sc, SFDAQ::get_base_protocol()); }
+
+void CodecManager::thread_init(SnortConfig* sc, int daq_dlt)
 {
     max_layers = sc->num_layers;
 
@@ -198,7 +201,6 @@ void CodecManager::thread_init(SnortConfig* sc)
         if (wrap.api->tinit)
             wrap.api->tinit();
 
-    int daq_dlt = SFDAQ::get_base_protocol();
     for (int i = 0; s_protocols[i] != nullptr; i++)
     {
         Codec* cd = s_protocols[i];
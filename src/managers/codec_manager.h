@@ -82,6 +82,8 @@ public:
     static void release_plugins();
     // initialize the current threads DLT and Packet struct
     static void thread_init(snort::SnortConfig*);
+    // same as above but with the given DLT instead of the DAQ's (no DAQ instance needed)
+    static void thread_init(snort::SnortConfig*, int daq_dlt);
     // destroy thread_local data
     static void thread_term();
     // print all of the codec plugins
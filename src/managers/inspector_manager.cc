@@ -31,11 +31,15 @@
 #include "detection/detection_engine.h"
 #include "flow/flow.h"
 #include "flow/session.h"
+#include "latency/latency_config.h"
+#include "latency/overload_control.h"
 #include "log/messages.h"
 #include "main/snort.h"
 #include "main/snort_config.h"
 #include "main/thread_config.h"
+#include "profiler/tail_latency.h"
 #include "protocols/packet.h"
+#include "search_engines/search_tool.h"
 #include "target_based/snort_protocols.h"
 
 #include "module_manager.h"
@@ -875,6 +879,28 @@ static void instantiate_default_binder(SnortConfig* sc, FrameworkPolicy* fp)
     fp->default_binder = true;
 }
 
+static bool is_sheddable(SnortConfig* sc, PHInstance* p)
+{
+    const string& names = sc->latency->overload_control.shed_inspectors;
+
+    if ( names.empty() )
+        return false;
+
+    switch ( p->pp_class.api.type )
+    {
+    case IT_NETWORK:
+    case IT_SERVICE:
+    case IT_CONTROL:
+    case IT_PROBE:
+        break;
+    default:
+        return false;
+    }
+
+    string list = " " + names + " ";
+    return list.find(" " + p->name + " ") != string::npos;
+}
+
 static bool configure(SnortConfig* sc, FrameworkPolicy* fp, bool cloned)
 {
     bool ok = true;
@@ -883,6 +909,8 @@ static bool configure(SnortConfig* sc, FrameworkPolicy* fp, bool cloned)
 
     for ( auto* p : fp->ilist )
     {
+        p->handler->set_sheddable(is_sheddable(sc, p));
+        p->handler->set_latency_id(TailLatency::get_id(p->name.c_str()));
         ReloadType reload_type = p->get_reload_type();
 
         if ( cloned )
@@ -894,6 +922,7 @@ static bool configure(SnortConfig* sc, FrameworkPolicy* fp, bool cloned)
             else
                 continue;
         }
+        SearchTool::set_owner(p->name.c_str());
         ok = p->handler->configure(sc) && ok;
     }
 
@@ -957,6 +986,9 @@ bool InspectorManager::configure(SnortConfig* sc, bool cloned)
     }
     bool ok = true;
 
+    // search tools prepped by the inspectors are compiled together below
+    SearchTool::start_queue();
+
     for ( unsigned idx = 0; idx < sc->policy_map->inspection_policy_count(); ++idx )
     {
         if ( cloned and idx )
@@ -969,6 +1001,7 @@ bool InspectorManager::configure(SnortConfig* sc, bool cloned)
     }
 
     set_inspection_policy(sc);
+    SearchTool::compile_queue(sc, !Snort::is_reloading());
 
     return ok;
 }
@@ -996,6 +1029,12 @@ void InspectorManager::print_config(SnortConfig* sc)
 // packet handling
 //-------------------------------------------------------------------------
 
+static inline void eval(Inspector* ins, Packet* p)
+{
+    TailLatency::Scope tail_latency(ins->get_latency_id());
+    ins->eval(p);
+}
+
 static inline void execute(
     Packet* p, PHInstance** prep, unsigned num)
 {
@@ -1004,6 +1043,9 @@ static inline void execute(
         if ( p->packet_flags & PKT_PASS_RULE )
             break;
 
+        if ( OverloadControl::shed_inspector((*prep)->handler) )
+            continue;
+
         PHClass& ppc = (*prep)->pp_class;
 
         // FIXIT-P these checks can eventually be optimized
@@ -1017,10 +1059,10 @@ static inline void execute(
         if ( p->type() == PktType::NONE )
         {
             if ( p->proto_bits & ppc.api.proto_bits )
-                (*prep)->handler->eval(p);
+                eval((*prep)->handler, p);
         }
         else if ( BIT((unsigned)p->type()) & ppc.api.proto_bits )
-            (*prep)->handler->eval(p);
+            eval((*prep)->handler, p);
     }
 }
 
@@ -1052,9 +1094,10 @@ void InspectorManager::full_inspection(Packet* p)
     if ( (p->is_cooked() and !p->data) or (!p->is_cooked() and !p->dsize) )
         DetectionEngine::disable_content(p);
 
-    else if ( flow->gadget && flow->gadget->likes(p) )
+    else if ( flow->gadget && !OverloadControl::shed_inspector(flow->gadget) &&
+        flow->gadget->likes(p) )
     {
-        flow->gadget->eval(p);
+        eval(flow->gadget, p);
         p->context->clear_inspectors = true;
     }
 }
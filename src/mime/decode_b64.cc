@@ -24,10 +24,21 @@
 
 #include "decode_b64.h"
 
+#include "utils/cpu_features.h"
 #include "utils/util_unfold.h"
 
 #include "decode_buffer.h"
 
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#ifdef UNIT_TEST
+#include <string>
+#include <vector>
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 void B64Decode::reset_decode_state()
@@ -120,8 +131,133 @@ uint8_t sf_decode64tab[256] =
     100,100,100,100,100,100,100,100,100,100,100,100,100,100,100,100
 };
 
-namespace snort
+//--------------------------------------------------------------------------
+// vectorized block decoders
+//
+// these decode a block of base64 characters only if every character is in
+// the alphabet (no '=', whitespace, or junk) so the result is the same as
+// the table driven loop.  otherwise nothing is stored and the caller falls
+// back to the scalar loop.  validation and translation follow the nibble
+// lookup and range check approach by Wojciech Mula and Alfred Klomp.
+//--------------------------------------------------------------------------
+
+struct B64Block
+{
+    bool (*decode)(const uint8_t* in, uint8_t* out);
+    uint32_t in_len;     // encoded bytes consumed per block
+    uint32_t out_len;    // decoded bytes produced per block
+    uint32_t store_len;  // bytes stored to out per block (>= out_len)
+};
+
+#ifdef HAVE_X86_SIMD
+SIMD_TARGET("ssse3")
+static inline __m128i b64_lookup_ssse3(__m128i str, bool& valid)
+{
+    const __m128i lut_lo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+    __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+
+    // a character is valid iff its low and high nibble classes are disjoint
+    __m128i bad = _mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    valid = !_mm_movemask_epi8(bad);
+
+    __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+    __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+
+    return _mm_add_epi8(str, roll);
+}
+
+SIMD_TARGET("ssse3")
+static bool b64_block_ssse3(const uint8_t* in, uint8_t* out)
+{
+    bool valid;
+    __m128i str = _mm_loadu_si128((const __m128i*)in);
+    __m128i val = b64_lookup_ssse3(str, valid);
+
+    if ( !valid )
+        return false;
+
+    // pack 4 x 6 bits into 3 bytes within each dword then squeeze out the gaps
+    val = _mm_maddubs_epi16(val, _mm_set1_epi32(0x01400140));
+    val = _mm_madd_epi16(val, _mm_set1_epi32(0x00011000));
+    val = _mm_shuffle_epi8(val, _mm_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+    _mm_storeu_si128((__m128i*)out, val);
+    return true;
+}
+
+SIMD_TARGET("avx2")
+static bool b64_block_avx2(const uint8_t* in, uint8_t* out)
 {
+    const __m256i lut_lo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lut_hi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71,
+        0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+
+    __m256i str = _mm256_loadu_si256((const __m256i*)in);
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+    __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+    __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+
+    if ( !_mm256_testz_si256(lo, hi) )
+        return false;
+
+    __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+    __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    __m256i val = _mm256_add_epi8(str, roll);
+
+    val = _mm256_maddubs_epi16(val, _mm256_set1_epi32(0x01400140));
+    val = _mm256_madd_epi16(val, _mm256_set1_epi32(0x00011000));
+    val = _mm256_shuffle_epi8(val, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    val = _mm256_permutevar8x32_epi32(val, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+    _mm256_storeu_si256((__m256i*)out, val);
+    return true;
+}
+#endif
+
+static B64Block get_block_decoder()
+{
+#ifdef HAVE_X86_SIMD
+    if ( cpu_has_avx2() )
+        return { b64_block_avx2, 32, 24, 32 };
+
+    if ( cpu_has_ssse3() )
+        return { b64_block_ssse3, 16, 12, 16 };
+#endif
+    return { nullptr, 0, 0, 0 };
+}
+
+static const B64Block b64_block = get_block_decoder();
+
 /* base64decode assumes the input data terminates with '=' and/or at the end of the input buffer
  * at inbuf_size.  If extra characters exist within inbuf before inbuf_size is reached, it will
  * happily decode what it can and skip over what it can't.  This is consistent with other decoders
@@ -129,10 +265,10 @@ namespace snort
  * data is valid up until the point you care about.  Note base64 data does NOT have to end with
  * '=' and won't if the number of bytes of input data is evenly divisible by 3.
 */
-int sf_base64decode(uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf, uint32_t outbuf_size,
-    uint32_t* bytes_written)
+static int base64decode(const B64Block& blk, const uint8_t* inbuf, uint32_t inbuf_size,
+    uint8_t* outbuf, uint32_t outbuf_size, uint32_t* bytes_written)
 {
-    uint8_t* cursor, * endofinbuf;
+    const uint8_t* cursor, * endofinbuf, * scalar_until;
     uint8_t* outbuf_ptr;
     uint8_t base64data[4], * base64data_ptr; /* temporary holder for current base64 chunk */
     uint8_t tableval_a, tableval_b, tableval_c, tableval_d;
@@ -154,9 +290,31 @@ int sf_base64decode(uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf, uint32
     n = 0;
     *bytes_written = 0;
     cursor = inbuf;
+    scalar_until = inbuf;
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < max_base64_chars))
     {
+        /* Between groups of four, decode whole blocks of clean input at once.  After a block
+           fails, the table loop handles its characters before trying again. */
+        if (blk.decode && (base64data_ptr == base64data) && (cursor >= scalar_until))
+        {
+            while (((uint32_t)(endofinbuf - cursor) >= blk.in_len) &&
+                (max_base64_chars - n >= blk.in_len) &&
+                (outbuf_size - *bytes_written >= blk.store_len) &&
+                blk.decode(cursor, outbuf_ptr))
+            {
+                cursor += blk.in_len;
+                n += blk.in_len;
+                outbuf_ptr += blk.out_len;
+                *bytes_written += blk.out_len;
+            }
+            scalar_until = ((uint32_t)(endofinbuf - cursor) > blk.in_len) ?
+                cursor + blk.in_len : endofinbuf;
+
+            if ((cursor >= endofinbuf) || (n >= max_base64_chars))
+                break;
+        }
+
         if (sf_decode64tab[*cursor] != 100)
         {
             *base64data_ptr++ = *cursor;
@@ -216,5 +374,114 @@ int sf_base64decode(uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf, uint32
     else
         return(0);
 }
+
+namespace snort
+{
+int sf_base64decode(uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf, uint32_t outbuf_size,
+    uint32_t* bytes_written)
+{
+    return base64decode(b64_block, inbuf, inbuf_size, outbuf, outbuf_size, bytes_written);
+}
 } // namespace snort
 
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static const B64Block no_block = { nullptr, 0, 0, 0 };
+
+static std::string make_b64(unsigned len, unsigned seed, bool dirty)
+{
+    static const char* alpha =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static const char* junk = "=\r\n\t -.!\x80\xff";
+    std::string s;
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        seed = seed * 1103515245 + 12345;
+        unsigned r = (seed >> 16) & 0x7fff;
+
+        if ( dirty and !(r % 53) )
+            s += junk[r % 11];
+        else
+            s += alpha[r % 64];
+    }
+    return s;
+}
+
+static void check_same(const std::string& in, uint32_t out_size)
+{
+    uint8_t ref[1024], vec[1024];
+    uint32_t ref_len = 0, vec_len = 0;
+    REQUIRE(out_size <= sizeof(ref));
+
+    int ref_ret = base64decode(no_block, (const uint8_t*)in.data(), in.size(), ref, out_size,
+        &ref_len);
+    int vec_ret = base64decode(b64_block, (const uint8_t*)in.data(), in.size(), vec, out_size,
+        &vec_len);
+
+    CHECK(ref_ret == vec_ret);
+    REQUIRE(ref_len == vec_len);
+    CHECK(!memcmp(ref, vec, ref_len));
+}
+
+TEST_CASE("b64 known answer", "[b64]")
+{
+    uint8_t* in = (uint8_t*)"U25vcnQrKyBkZWNvZGVzIGJhc2U2NCBhdHRhY2htZW50cyBmYXN0ZXI=";
+    const char* exp = "Snort++ decodes base64 attachments faster";
+    uint8_t out[64];
+    uint32_t len = 0;
+
+    CHECK(sf_base64decode(in, strlen((char*)in), out, sizeof(out), &len) == 0);
+    REQUIRE(len == strlen(exp));
+    CHECK(!memcmp(out, exp, len));
+}
+
+TEST_CASE("b64 vector matches table", "[b64]")
+{
+    for ( unsigned len : { 0, 3, 4, 15, 16, 17, 31, 32, 33, 64, 100, 255, 600 } )
+    {
+        for ( unsigned seed = 1; seed < 20; ++seed )
+        {
+            check_same(make_b64(len, seed, false), 1024);
+            check_same(make_b64(len, seed, true), 1024);
+            check_same(make_b64(len, seed, false), len / 2);
+            check_same(make_b64(len, seed, true), 13);
+        }
+    }
+}
+
+TEST_CASE("b64 padding mid block", "[b64]")
+{
+    std::string s = make_b64(40, 7, false);
+    s[9] = '=';
+    check_same(s, 1024);
+    s[9] = 'A';
+    s[1] = '=';
+    check_same(s, 1024);
+}
+
+TEST_CASE("b64 decode", "[b64][.benchmark]")
+{
+    const std::string in = make_b64(64 * 1024, 3, false);
+    std::vector<uint8_t> out(in.size());
+    uint32_t len;
+
+    BENCHMARK("table")
+    {
+        return base64decode(no_block, (const uint8_t*)in.data(), in.size(), out.data(),
+            out.size(), &len);
+    };
+
+    BENCHMARK("dispatched")
+    {
+        return base64decode(b64_block, (const uint8_t*)in.data(), in.size(), out.data(),
+            out.size(), &len);
+    };
+}
+
+#endif
@@ -26,13 +26,73 @@
 
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 
+#include "utils/cpu_features.h"
 #include "utils/util_unfold.h"
 
 #include "decode_buffer.h"
 
+#ifdef HAVE_X86_SIMD
+#include <emmintrin.h>
+#endif
+
+#ifdef UNIT_TEST
+#include <string>
+#include <vector>
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
+// returns the length of the leading run of literal characters, ie those the
+// decoder copies as is: printable except '=' plus tab, CR, and LF.  only full
+// 16 byte blocks are scanned; the caller handles the remainder.
+typedef uint32_t (*SpanFunc)(const char*, uint32_t);
+
+#ifdef HAVE_X86_SIMD
+SIMD_TARGET("sse2")
+static uint32_t qp_literal_span_sse2(const char* buf, uint32_t len)
+{
+    const __m128i lo = _mm_set1_epi8(0x1f);
+    const __m128i hi = _mm_set1_epi8(0x7f);
+    const __m128i eq = _mm_set1_epi8('=');
+    const __m128i ht = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    uint32_t n = 0;
+
+    while ( len - n >= 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(buf + n));
+
+        // signed compares also reject 0x80 - 0xff
+        __m128i print = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, ht),
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+        __m128i lit = _mm_or_si128(_mm_andnot_si128(_mm_cmpeq_epi8(v, eq), print), space);
+        unsigned mask = _mm_movemask_epi8(lit) ^ 0xffff;
+
+        if ( mask )
+            return n + __builtin_ctz(mask);
+
+        n += 16;
+    }
+    return n;
+}
+#endif
+
+static SpanFunc get_literal_span()
+{
+#ifdef HAVE_X86_SIMD
+    if ( cpu_has_sse2() )
+        return qp_literal_span_sse2;
+#endif
+    return nullptr;
+}
+
+static const SpanFunc qp_literal_span = get_literal_span();
+
 void QPDecode::reset_decode_state()
 {
     reset_decoded_bytes();
@@ -99,8 +159,8 @@ QPDecode::~QPDecode()
         delete buffer;
 }
 
-int sf_qpdecode(const char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* bytes_read,
-    uint32_t* bytes_copied)
+static int qpdecode(SpanFunc literal_span, const char* src, uint32_t slen, char* dst,
+    uint32_t dlen, uint32_t* bytes_read, uint32_t* bytes_copied)
 {
     if (!src || !slen || !dst || !dlen || !bytes_read || !bytes_copied )
         return -1;
@@ -110,6 +170,23 @@ int sf_qpdecode(const char* src, uint32_t slen, char* dst, uint32_t dlen, uint32
 
     while ( (*bytes_read < slen) && (*bytes_copied < dlen))
     {
+        // copy text between soft line breaks and escapes in bulk
+        if ( literal_span )
+        {
+            uint32_t src_avail = slen - *bytes_read;
+            uint32_t dst_avail = dlen - *bytes_copied;
+            uint32_t run = literal_span(src + *bytes_read,
+                (src_avail < dst_avail) ? src_avail : dst_avail);
+
+            if ( run )
+            {
+                memcpy(dst + *bytes_copied, src + *bytes_read, run);
+                *bytes_read += run;
+                *bytes_copied += run;
+                continue;
+            }
+        }
+
         char ch = src[*bytes_read];
         *bytes_read += 1;
 
@@ -173,3 +250,98 @@ int sf_qpdecode(const char* src, uint32_t slen, char* dst, uint32_t dlen, uint32
     return 0;
 }
 
+int sf_qpdecode(const char* src, uint32_t slen, char* dst, uint32_t dlen, uint32_t* bytes_read,
+    uint32_t* bytes_copied)
+{
+    return qpdecode(qp_literal_span, src, slen, dst, dlen, bytes_read, bytes_copied);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static std::string make_qp(unsigned len, unsigned seed)
+{
+    static const char* text[] =
+    {
+        "The quick brown fox ", "jumps over ", "=3D", "=\r\n", "=\n", "caf=C3=A9 ",
+        "\t", "\r\n", "=ZZ", "\x01", "\xe9", "=", "=4", "lazy dogs. "
+    };
+    std::string s;
+
+    while ( s.size() < len )
+    {
+        seed = seed * 1103515245 + 12345;
+        s += text[(seed >> 16) % (sizeof(text) / sizeof(*text))];
+    }
+    s.resize(len);
+    return s;
+}
+
+static void check_same(const std::string& in, uint32_t out_size)
+{
+    std::vector<char> ref(out_size + 1), vec(out_size + 1);
+    uint32_t ref_read = 0, ref_len = 0, vec_read = 0, vec_len = 0;
+
+    int ref_ret = qpdecode(nullptr, in.data(), in.size(), ref.data(), out_size,
+        &ref_read, &ref_len);
+    int vec_ret = qpdecode(qp_literal_span, in.data(), in.size(), vec.data(), out_size,
+        &vec_read, &vec_len);
+
+    CHECK(ref_ret == vec_ret);
+    CHECK(ref_read == vec_read);
+    REQUIRE(ref_len == vec_len);
+    CHECK(!memcmp(ref.data(), vec.data(), ref_len));
+}
+
+TEST_CASE("qp known answer", "[qp]")
+{
+    const char* in = "caf=C3=A9 au lait =\r\nsoft break=3Dnone";
+    const char* exp = "caf\xc3\xa9 au lait soft break=none";
+    char out[64];
+    uint32_t read = 0, len = 0;
+
+    CHECK(sf_qpdecode(in, strlen(in), out, sizeof(out), &read, &len) == 0);
+    CHECK(read == strlen(in));
+    REQUIRE(len == strlen(exp));
+    CHECK(!memcmp(out, exp, len));
+}
+
+TEST_CASE("qp vector matches scalar", "[qp]")
+{
+    for ( unsigned len : { 1, 15, 16, 17, 47, 64, 200, 1000 } )
+    {
+        for ( unsigned seed = 1; seed < 30; ++seed )
+        {
+            std::string s = make_qp(len, seed);
+            check_same(s, 2048);
+            check_same(s, len / 3 + 1);
+        }
+    }
+}
+
+TEST_CASE("qp decode", "[qp][.benchmark]")
+{
+    std::string in;
+
+    while ( in.size() < 64 * 1024 )
+        in += "Dear customer, your invoice for caf=C3=A9 supplies is attached. Please =\r\n";
+
+    std::vector<char> out(in.size());
+    uint32_t read, len;
+
+    BENCHMARK("scalar")
+    {
+        return qpdecode(nullptr, in.data(), in.size(), out.data(), out.size(), &read, &len);
+    };
+
+    BENCHMARK("dispatched")
+    {
+        return qpdecode(qp_literal_span, in.data(), in.size(), out.data(), out.size(),
+            &read, &len);
+    };
+}
+
+#endif
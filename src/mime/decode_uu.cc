@@ -31,6 +31,12 @@
 
 #include "decode_buffer.h"
 
+#ifdef UNIT_TEST
+#include <string>
+#include <vector>
+#include "catch/snort_catch.h"
+#endif
+
 using namespace snort;
 
 #define UU_DECODE_CHAR(c) (((c) - 0x20) & 0x3f)
@@ -249,3 +255,47 @@ int sf_uudecode(uint8_t* src, uint32_t slen, uint8_t* dst, uint32_t dlen, uint32
     return 0;
 }
 
+
+#ifdef UNIT_TEST
+
+static std::string make_uu(unsigned lines)
+{
+    std::string s = "begin 644 attachment.bin\n";
+    unsigned v = 1;
+
+    for ( unsigned i = 0; i < lines; ++i )
+    {
+        s += 'M';  // 45 bytes per line
+
+        for ( unsigned j = 0; j < 15; ++j )
+        {
+            v = v * 1103515245 + 12345;
+            uint32_t w = v >> 8;
+
+            for ( int k = 18; k >= 0; k -= 6 )
+                s += (char)(0x20 + ((w >> k) & 0x3f));
+        }
+        s += '\n';
+    }
+    return s + "`\nend\n";
+}
+
+TEST_CASE("uu decode", "[uu][.benchmark]")
+{
+    const unsigned lines = 1500;
+    std::string in = make_uu(lines);
+    std::vector<uint8_t> out(in.size());
+    uint32_t read, len;
+
+    BENCHMARK("scalar")
+    {
+        bool begin = false, end = false;
+        sf_uudecode((uint8_t*)&in[0], in.size(), out.data(), out.size(), &read, &len,
+            &begin, &end);
+        return len;
+    };
+
+    CHECK(len == lines * 45);
+}
+
+#endif
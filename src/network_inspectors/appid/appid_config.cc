@@ -27,6 +27,7 @@
 
 #include <glob.h>
 #include <climits>
+#include <cstring>
 
 #include "app_forecast.h"
 #include "app_info_table.h"
@@ -38,6 +39,7 @@
 #include "main/snort_config.h"
 #include "log/messages.h"
 #include "lua_detector_module.h"
+#include "service_state.h"
 #include "utils/util.h"
 #include "service_plugins/service_ssl.h"
 #include "detector_plugins/detector_dns.h"
@@ -79,6 +81,7 @@ void AppIdContext::pterm()
     assert(odp_ctxt);
     odp_ctxt->get_app_info_mgr().cleanup_appid_info_table();
     delete odp_ctxt;
+    AppIdServiceState::term_shared();
 }
 
 bool AppIdContext::init_appid(SnortConfig* sc)
@@ -87,6 +90,16 @@ bool AppIdContext::init_appid(SnortConfig* sc)
     if (!odp_ctxt)
         odp_ctxt = new OdpContext(config, sc);
 
+    // the http matchers are part of ODP so their method is fixed until restart
+    else if ( strcmp(HttpMatchEngine::get_method(config.http_search_method.c_str()),
+        odp_ctxt->get_http_matchers().get_search_method()) )
+    {
+        ReloadError("Changing appid.http_search_method requires a restart.\n");
+    }
+
+    // like ODP, the shared service cache is kept on reload_config()
+    AppIdServiceState::init_shared(config.shared_memcap);
+
     // FIXIT-M: RELOAD - Get rid of "once" flag
     // Handle the if condition in AppIdContext::init_appid
     static bool once = false;
@@ -118,7 +131,8 @@ void AppIdContext::show()
         LogMessage("    3rd Party Dir: %s\n", config.tp_appid_path.c_str());
 }
 
-OdpContext::OdpContext(AppIdConfig& config, SnortConfig* sc)
+OdpContext::OdpContext(AppIdConfig& config, SnortConfig* sc) :
+    http_matchers(config.http_search_method.c_str())
 {
     app_info_mgr.init_appid_info_table(config, sc, *this);
     client_pattern_detector = new PatternClientDetector(&client_disco_mgr);
@@ -71,6 +71,9 @@ public:
     bool tp_appid_config_dump = false;
     uint32_t instance_id = 0;
     size_t memcap = 0;
+    size_t shared_memcap = 0;
+    uint32_t lua_budget = 0;
+    std::string http_search_method = "ac_full";
     bool debug = false;
     bool dump_ports = false;
     bool log_all_sessions = false;
@@ -44,6 +44,7 @@
 #include "client_plugins/client_discovery.h"
 #include "detector_plugins/detector_pattern.h"
 #include "detector_plugins/detector_sip.h"
+#include "detector_plugins/http_match_engine.h"
 #include "host_port_app_cache.h"
 #include "lua_detector_module.h"
 #include "service_plugins/service_discovery.h"
@@ -140,6 +141,9 @@ void AppIdInspector::show(SnortConfig*)
     LogMessage("    appStats Rollover time: %lu secs\n",
         config->app_stats_rollover_time);
     LogMessage("    memcap:                 %zu bytes\n", config->memcap);
+    LogMessage("    shared memcap:          %zu bytes\n", config->shared_memcap);
+    LogMessage("    lua budget:             %u usecs\n", config->lua_budget);
+    LogMessage("    http search method:     %s\n", config->http_search_method.c_str());
     LogMessage("\n");
 }
 
@@ -230,6 +234,7 @@ static void appid_inspector_tterm()
 {
     TPLibHandler::tfini();
     AppIdPegCounts::cleanup_pegs();
+    HttpMatchEngine::tterm();
 }
 
 static Inspector* appid_inspector_ctor(Module* m)
@@ -64,8 +64,15 @@ static const Parameter s_params[] =
 #endif
     { "memcap", Parameter::PT_INT, "1024:maxSZ", "1048576",
       "max size of the service cache before we start pruning the cache" },
+    { "shared_memcap", Parameter::PT_INT, "0:maxSZ", "0",
+      "size of the service cache shared by all packet threads or 0 to disable" },
+    { "lua_budget", Parameter::PT_INT, "0:max32", "0",
+      "max microseconds for a lua detector validation; detectors over it 8 times are disabled "
+      "or 0 for no limit" },
+    { "http_search_method", Parameter::PT_SELECT, "ac_full | hyperscan", "ac_full",
+      "search method for http user agent, via, content type, and chp patterns" },
     { "log_stats", Parameter::PT_BOOL, nullptr, "false",
-      "enable logging of appid statistics" },
+      "enable logging of appid statistics and lua detector costs" },
     { "app_stats_period", Parameter::PT_INT, "1:max32", "300",
       "time period for collecting and logging appid statistics" },
     { "app_stats_rollover_size", Parameter::PT_INT, "0:max32", "20971520",
@@ -253,6 +260,11 @@ static const PegInfo appid_pegs[] =
     { CountType::SUM, "service_cache_prunes", "number of times the service cache was pruned" },
     { CountType::SUM, "service_cache_adds", "number of times an entry was added to the service cache" },
     { CountType::SUM, "service_cache_removes", "number of times an item was removed from the service cache" },
+    { CountType::SUM, "service_cache_shared_hits", "number of services learned from another packet thread" },
+    { CountType::SUM, "service_cache_shared_adds", "number of services shared with other packet threads" },
+    { CountType::SUM, "service_brute_force_skips", "number of brute force detectors skipped by prefilter" },
+    { CountType::SUM, "lua_detector_overruns", "number of lua detector validations over budget" },
+    { CountType::SUM, "lua_detectors_disabled", "number of lua detectors disabled for going over budget" },
     { CountType::END, nullptr, nullptr },
 };
 
@@ -289,6 +301,12 @@ bool AppIdModule::set(const char* fqn, Value& v, SnortConfig* c)
 #endif
     if ( v.is("memcap") )
         config->memcap = v.get_size();
+    else if ( v.is("shared_memcap") )
+        config->shared_memcap = v.get_size();
+    else if ( v.is("lua_budget") )
+        config->lua_budget = v.get_uint32();
+    else if ( v.is("http_search_method") )
+        config->http_search_method = v.get_string();
     else if ( v.is("log_stats") )
         config->stats_logging_enabled = v.get_bool();
     else if ( v.is("app_stats_period") )
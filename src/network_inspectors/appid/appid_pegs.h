@@ -33,6 +33,11 @@ struct AppIdStats
     PegCount service_cache_prunes;
     PegCount service_cache_adds;
     PegCount service_cache_removes;
+    PegCount service_cache_shared_hits;
+    PegCount service_cache_shared_adds;
+    PegCount service_brute_force_skips;
+    PegCount lua_detector_overruns;
+    PegCount lua_detectors_disabled;
 };
 
 #endif
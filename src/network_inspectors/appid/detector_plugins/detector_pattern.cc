@@ -151,11 +151,32 @@ struct PServiceMatch
     Pattern* data;
 };
 
+struct PServiceMatchList
+{
+    PServiceMatch* matches;
+
+    /**port bound patterns only match on these ports; -1 matches any port */
+    int port;
+};
+
 static PServiceMatch* free_servicematch_list;
 
+static bool has_port(const PatternService* ps, int port)
+{
+    if (!ps->port || port < 0)
+        return true;
+
+    for (const PortNode* pn = ps->port; pn; pn = pn->next)
+        if (pn->port == port)
+            return true;
+
+    return false;
+}
+
 static int pattern_match(void* id, void*, int match_end_pos, void* data, void*)
 {
-    PServiceMatch** matches = (PServiceMatch**)data;
+    PServiceMatchList* list = (PServiceMatchList*)data;
+    PServiceMatch** matches = &list->matches;
     Pattern* pd = (Pattern*)id;
     PServiceMatch* psm;
     PServiceMatch* sm;
@@ -164,6 +185,10 @@ static int pattern_match(void* id, void*, int match_end_pos, void* data, void*)
     if (pd->offset >= 0 && pd->offset != (match_end_pos - (int)pd->length))
         return 0;
 
+    //  Ignore patterns bound to other ports.
+    if (!has_port(pd->ps, list->port))
+        return 0;
+
     /*find if previously this PS was matched. */
     for (psm = *matches; psm; psm = psm->next)
         if (psm->data->ps == pd->ps)
@@ -205,15 +230,18 @@ static int pattern_match(void* id, void*, int match_end_pos, void* data, void*)
     return 0;
 }
 
-static int csd_pattern_tree_search(const uint8_t* data, uint16_t size, SearchTool* patternTree)
+static int csd_pattern_tree_search(const uint8_t* data, uint16_t size, SearchTool* patternTree,
+    int port = -1)
 {
-    PServiceMatch* matches = nullptr;
+    PServiceMatchList list = { nullptr, port };
 
     if ( !size )
         return 0;
 
     if (patternTree)
-        patternTree->find_all((const char*)data, size, &pattern_match, false, (void*)&matches);
+        patternTree->find_all((const char*)data, size, &pattern_match, false, (void*)&list);
+
+    PServiceMatch* matches = list.matches;
 
     if (matches == nullptr)
         return 0;
@@ -275,47 +303,24 @@ static int csd_pattern_tree_search(const uint8_t* data, uint16_t size, SearchToo
     return ps->id;
 }
 
-// Creates unique subset of services registered on ports, and then creates pattern trees.
+// Adds each port bound pattern once to the protocol's matcher; the patterns
+// with no ports are added by register_service_patterns().
 void PatternServiceDetector::create_service_pattern_trees()
 {
     for (PatternService* ps = service_port_pattern; ps; ps = ps->next)
-        for (PortNode* port = ps->port; port; port = port->next)
-            for (Pattern* pattern = ps->pattern; pattern; pattern = pattern->next)
-                if (ps->proto == IpProtocol::TCP)
-                    register_pattern(&tcp_port_pattern_tree[port->port],
-                        pattern);
-                else
-                    register_pattern(&udp_port_pattern_tree[port->port],
-                        pattern);
-
-    for (unsigned i = 0; i < 65536; i++)
     {
-        if (tcp_port_pattern_tree[i])
-        {
-            for (PatternService* ps = service_port_pattern; ps; ps = ps->next)
-            {
-                if (ps->port || (ps->proto != IpProtocol::TCP))
-                    continue;
-
-                for (Pattern* pattern = ps->pattern; pattern; pattern = pattern->next)
-                    register_pattern(&tcp_port_pattern_tree[i], pattern);
-            }
-
-            tcp_port_pattern_tree[i]->prep();
-        }
+        if (!ps->port)
+            continue;
 
-        if (udp_port_pattern_tree[i])
+        for (Pattern* pattern = ps->pattern; pattern; pattern = pattern->next)
         {
-            for (PatternService* ps = service_port_pattern; ps; ps = ps->next)
-            {
-                if (ps->port || (ps->proto != IpProtocol::UDP))
-                    continue;
-
-                for (Pattern* pattern = ps->pattern; pattern; pattern = pattern->next)
-                    register_pattern(&udp_port_pattern_tree[i], pattern);
-            }
+            if (!pattern->data || !pattern->length)
+                continue;
 
-            udp_port_pattern_tree[i]->prep();
+            if (ps->proto == IpProtocol::TCP)
+                register_pattern(&tcp_pattern_matcher, pattern);
+            else
+                register_pattern(&udp_pattern_matcher, pattern);
         }
     }
 }
@@ -433,14 +438,6 @@ PatternServiceDetector::~PatternServiceDetector()
         delete tcp_pattern_matcher;
         delete udp_pattern_matcher;
 
-        for (unsigned i = 0; i < 65536; i++)
-        {
-            if (tcp_port_pattern_tree[i])
-                delete tcp_port_pattern_tree[i];
-            if (udp_port_pattern_tree[i])
-                delete udp_port_pattern_tree[i];
-        }
-
         PatternService* ps;
         while (service_port_pattern)
         {
@@ -462,8 +459,6 @@ PatternServiceDetector::~PatternServiceDetector()
 
 int PatternServiceDetector::validate(AppIdDiscoveryArgs& args)
 {
-    SearchTool* patternTree = nullptr;
-
     if (!args.data )
         return APPID_ENULL;
     if (!args.size || (args.dir != APP_ID_FROM_RESPONDER) )
@@ -472,20 +467,10 @@ int PatternServiceDetector::validate(AppIdDiscoveryArgs& args)
         return APPID_INPROCESS;
     }
 
-    if (args.asd.protocol == IpProtocol::UDP)
-    {
-        patternTree = udp_port_pattern_tree[args.pkt->ptrs.sp];
-        if (!patternTree)
-            patternTree = udp_pattern_matcher;
-    }
-    else
-    {
-        patternTree = tcp_port_pattern_tree[args.pkt->ptrs.sp];
-        if (!patternTree)
-            patternTree = tcp_pattern_matcher;
-    }
-
-    uint32_t id = csd_pattern_tree_search(args.data, args.size, patternTree);
+    SearchTool* patternTree = (args.asd.protocol == IpProtocol::UDP) ?
+        udp_pattern_matcher : tcp_pattern_matcher;
+    uint32_t id = csd_pattern_tree_search(args.data, args.size, patternTree,
+        args.pkt->ptrs.sp);
     if (!id)
     {
         fail_service(args.asd, args.pkt, args.dir);
@@ -113,10 +113,11 @@ private:
 
     PortPatternNode* lua_injected_patterns = nullptr;
     PatternService* service_port_pattern = nullptr;
+
+    // one matcher per protocol holds the patterns for all ports; matches
+    // are filtered by the ports of the pattern's PatternService
     snort::SearchTool* tcp_pattern_matcher = nullptr;
     snort::SearchTool* udp_pattern_matcher = nullptr;
-    snort::SearchTool* tcp_port_pattern_tree[65536] = { nullptr };
-    snort::SearchTool* udp_port_pattern_tree[65536] = { nullptr };
 };
 
 #endif
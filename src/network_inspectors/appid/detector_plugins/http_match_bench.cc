@@ -0,0 +1,145 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_match_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#include "main/snort_config.h"
+#include "managers/mpse_manager.h"
+
+#include "http_match_engine.h"
+
+using namespace snort;
+
+// the same user agents are generated on every run so results are comparable
+static unsigned next_rand(unsigned& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static const char* const products[] =
+{
+    "Mozilla/", "AppleWebKit/", "Chrome/", "Safari/", "Firefox/", "Edge/", "OPR/",
+    "Gecko/", "MSIE ", "Trident/", "Version/", "Mobile/", "curl/", "Wget/", "Dalvik/",
+    "okhttp/", "Java/", "python-requests/", "Outlook-iOS/", "Dropbox/",
+};
+
+static std::vector<std::string> make_patterns(unsigned num, unsigned seed)
+{
+    static const char* alpha = "abcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::vector<std::string> pats;
+
+    for ( auto p : products )
+        pats.emplace_back(p);
+
+    while ( pats.size() < num )
+    {
+        std::string s;
+        unsigned len = 4 + next_rand(seed) % 9;
+
+        for ( unsigned j = 0; j < len; ++j )
+            s += alpha[next_rand(seed) % 38];
+
+        pats.emplace_back(s + "/");
+    }
+    return pats;
+}
+
+static std::vector<std::string> make_agents(
+    unsigned num, const std::vector<std::string>& pats, unsigned seed)
+{
+    std::vector<std::string> agents;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        std::string s = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) ";
+        unsigned tokens = 1 + next_rand(seed) % 4;
+
+        for ( unsigned j = 0; j < tokens; ++j )
+        {
+            s += pats[next_rand(seed) % pats.size()];
+            s += std::to_string(next_rand(seed) % 100) + ".0 ";
+        }
+        agents.emplace_back(s);
+    }
+    return agents;
+}
+
+static int count_match(void*, void*, int, void* context, void*)
+{
+    ++*(unsigned*)context;
+    return 0;
+}
+
+static void refresh_scratch()
+{
+    SnortConfig* sc = SnortConfig::get_conf();
+
+    for ( auto* s : sc->scratchers )
+        s->cleanup(sc);
+
+    sc->scratchers.clear();
+    sc->post_setup();
+}
+
+// one user agent search per transaction; ac_full passes its matches straight
+// through and the other methods pay for the replay in ac_full order
+TEST_CASE("http match engine", "[appid][.benchmark]")
+{
+    const std::vector<std::string> pats = make_patterns(2000, 3);
+    const std::vector<std::string> agents = make_agents(1000, pats, 5);
+    std::vector<unsigned> users(pats.size());
+
+    for ( const char* method : { "ac_full", "ac_bnfa", "ac_std", "hyperscan" } )
+    {
+        if ( !MpseManager::get_search_api(method) )
+            continue;
+
+        HttpMatchEngine hme(method);
+
+        for ( unsigned i = 0; i < pats.size(); ++i )
+            hme.add(pats[i].c_str(), pats[i].size(), &users[i], true);
+
+        hme.prep();
+
+        // redo the scratch setup as a reload would so hyperscan has scratch
+        // sized for this database
+        if ( !strcmp(method, "hyperscan") )
+            refresh_scratch();
+
+        BENCHMARK(std::string("user agents ") + method)
+        {
+            unsigned hits = 0;
+
+            for ( auto& a : agents )
+                hme.find_all(a.c_str(), a.size(), count_match, false, &hits);
+
+            return hits;
+        };
+    }
+    HttpMatchEngine::tterm();
+}
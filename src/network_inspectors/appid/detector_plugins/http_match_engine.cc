@@ -0,0 +1,269 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_match_engine.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "http_match_engine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "log/messages.h"
+#include "main/thread.h"
+#include "managers/mpse_manager.h"
+
+using namespace snort;
+
+static const char* const default_method = "ac_full";
+
+// reused by every search on the thread so searches don't allocate; the
+// match callbacks record results and must not search another engine
+struct HitBuffers
+{
+    std::vector<HttpMatchEngine::Hit> hits;
+    std::vector<unsigned> chain;
+};
+
+static THREAD_LOCAL HitBuffers* s_buffers = nullptr;
+
+void HttpMatchEngine::tterm()
+{
+    delete s_buffers;
+    s_buffers = nullptr;
+}
+
+const char* HttpMatchEngine::get_method(const char* method)
+{
+    if ( !method or !strcmp(method, default_method) )
+        return default_method;
+
+    if ( MpseManager::get_search_api(method) )
+        return method;
+
+    WarningMessage("appid: http search method %s is not available, using %s\n",
+        method, default_method);
+
+    return default_method;
+}
+
+HttpMatchEngine::HttpMatchEngine(const char* method) :
+    tool(method, true), canonical(strcmp(method, default_method) != 0)
+{
+    if ( canonical )
+        nodes.push_back({ 0, 0, 0, 0 });
+}
+
+unsigned HttpMatchEngine::get_next(unsigned node, uint8_t byte) const
+{
+    auto it = next.find(((uint64_t)node << 8) | byte);
+    return it == next.end() ? 0 : it->second;
+}
+
+// case is folded like ac_full does; case sensitive patterns are checked
+// by the search method and don't change the order
+unsigned HttpMatchEngine::add_node(const char* pattern, unsigned len)
+{
+    unsigned node = 0;
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        uint8_t byte = toupper((uint8_t)pattern[i]);
+        unsigned child = get_next(node, byte);
+
+        if ( !child )
+        {
+            child = nodes.size();
+            nodes.push_back({ node, 0, nodes[node].depth + 1, byte });
+            next[((uint64_t)node << 8) | byte] = child;
+        }
+        node = child;
+    }
+    if ( len > max_depth )
+        max_depth = len;
+
+    return node;
+}
+
+void HttpMatchEngine::add(const char* pattern, unsigned len, void* user, bool no_case)
+{
+    if ( !canonical )
+    {
+        tool.add(pattern, len, user, no_case);
+        return;
+    }
+    unsigned seq = entries.size();
+    entries.push_back({ user, seq, add_node(pattern, len) });
+    tool.add(pattern, len, &entries.back(), no_case);
+}
+
+// fail states are set shallowest first as with any aho-corasick build
+void HttpMatchEngine::build_fail()
+{
+    std::vector<unsigned> order;
+
+    for ( unsigned i = 1; i < nodes.size(); ++i )
+        order.push_back(i);
+
+    std::stable_sort(order.begin(), order.end(), [this](unsigned a, unsigned b)
+        { return nodes[a].depth < nodes[b].depth; });
+
+    for ( auto n : order )
+    {
+        Node& node = nodes[n];
+
+        if ( !node.parent )
+            continue;
+
+        unsigned f = nodes[node.parent].fail;
+        unsigned child;
+
+        while ( !(child = get_next(f, node.byte)) and f )
+            f = nodes[f].fail;
+
+        node.fail = child;
+    }
+}
+
+void HttpMatchEngine::prep()
+{
+    if ( canonical )
+        build_fail();
+
+    tool.prep();
+}
+
+// rank is the position of the hit in the ac_full match list for its end
+// offset relative to the other hits of that offset.  the hits are sorted
+// by end offset so the trie is walked once up to the last one.
+void HttpMatchEngine::rank_hits(
+    const char* s, Hit* hits, unsigned n, std::vector<unsigned>& chain)
+{
+    unsigned state = 0;
+    unsigned pos = 0;
+    unsigned i = 0;
+
+    while ( i < n )
+    {
+        int end = hits[i].index;
+        unsigned j = i;
+
+        while ( j < n and hits[j].index == end )
+            ++j;
+
+        // the state only depends on the last max_depth bytes so a longer
+        // gap since the previous offset is skipped
+        if ( (unsigned)end - pos > max_depth )
+        {
+            state = 0;
+            pos = end - max_depth;
+        }
+
+        for ( ; pos < (unsigned)end; ++pos )
+        {
+            uint8_t byte = toupper((uint8_t)s[pos]);
+            unsigned child;
+
+            while ( !(child = get_next(state, byte)) and state )
+                state = nodes[state].fail;
+
+            state = child;
+        }
+
+        chain.clear();
+
+        for ( unsigned c = state; c; c = nodes[c].fail )
+            chain.push_back(c);
+
+        const unsigned m = chain.size();
+
+        for ( ; i < j; ++i )
+        {
+            unsigned c = std::find(chain.begin(), chain.end(), hits[i].entry->node) -
+                chain.begin();
+
+            // odd chain positions come first, then even ones from the far end;
+            // the low bit marks the odd positions whose duplicates are reversed
+            if ( c == m )
+                hits[i].rank = m << 1;
+            else if ( c & 1 )
+                hits[i].rank = ((c / 2) << 1) | 1;
+            else
+                hits[i].rank = (m / 2 + (m - 1 - c) / 2) << 1;
+        }
+    }
+}
+
+static int collect_hit(void* id, void* tree, int index, void* context, void* neg)
+{
+    auto hits = (std::vector<HttpMatchEngine::Hit>*)context;
+    hits->push_back({ (HttpMatchEngine::Entry*)id, tree, neg, index, 0 });
+    return 0;
+}
+
+int HttpMatchEngine::find_all(
+    const char* s, unsigned len, MpseMatch match, bool confine, void* context)
+{
+    if ( !canonical )
+        return tool.find_all(s, len, match, confine, context);
+
+    if ( !s_buffers )
+        s_buffers = new HitBuffers;
+
+    std::vector<Hit>& hits = s_buffers->hits;
+    hits.clear();
+
+    tool.find_all(s, len, collect_hit, confine, &hits);
+
+    if ( hits.empty() )
+        return 0;
+
+    std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b)
+        { return a.index < b.index; });
+
+    rank_hits(s, hits.data(), hits.size(), s_buffers->chain);
+
+    std::sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b)
+        {
+            if ( a.index != b.index )
+                return a.index < b.index;
+
+            if ( a.rank != b.rank )
+                return a.rank < b.rank;
+
+            if ( a.rank & 1 )
+                return a.entry->seq > b.entry->seq;
+
+            return a.entry->seq < b.entry->seq;
+        });
+
+    int found = 0;
+
+    for ( auto& h : hits )
+    {
+        ++found;
+
+        if ( match(h.entry->user, h.tree, h.index, context, h.neg) > 0 )
+            break;
+    }
+    return found;
+}
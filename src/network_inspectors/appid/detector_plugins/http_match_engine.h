@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_match_engine.h
+
+#ifndef HTTP_MATCH_ENGINE_H
+#define HTTP_MATCH_ENGINE_H
+
+// HttpMatchEngine wraps the SearchTool used for one class of http patterns
+// so that the search method can be selected by configuration.  ac_full
+// reports matches that end at the same offset in the order of its match
+// lists and the http consumers depend on that order (the first SINGLE user
+// agent match wins, the last content type match wins).  Other methods such
+// as hyperscan report same offset matches in their own order so their
+// matches are collected and replayed in the ac_full order.
+//
+// ac_full builds the match list of a state by prepending the list of its
+// fail state, one entry at a time, to the state's own patterns.  So for the
+// fail chain c0 (the longest suffix that is a trie node), c1 = fail(c0), ...
+// the list is own(c1), own(c3), ... each reversed, then ..., own(c2), own(c0)
+// each in insertion order.  For "abcd", "cd", and "d" that is cd, d, abcd.
+// The engine keeps its own trie of the (case folded) patterns to find the
+// chain for each end offset with matches.
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include "framework/mpse.h"
+#include "search_engines/search_tool.h"
+
+class HttpMatchEngine
+{
+public:
+    HttpMatchEngine(const char* method);
+
+    void add(const char* pattern, unsigned len, void* user, bool no_case);
+
+    void add(const uint8_t* pattern, unsigned len, void* user, bool no_case)
+    { add((const char*)pattern, len, user, no_case); }
+
+    void prep();
+
+    int find_all(const char* s, unsigned len, MpseMatch, bool confine, void* context);
+
+    bool is_canonical() const
+    { return canonical; }
+
+    // returns method if it is available or ac_full otherwise
+    static const char* get_method(const char* method);
+
+    // frees the packet thread's search buffers
+    static void tterm();
+
+    struct Entry
+    {
+        void* user;
+        unsigned seq;
+        unsigned node;
+    };
+
+    struct Hit
+    {
+        const Entry* entry;
+        void* tree;
+        void* neg;
+        int index;
+        unsigned rank;
+    };
+
+private:
+    struct Node
+    {
+        unsigned parent;
+        unsigned fail;
+        unsigned depth;
+        uint8_t byte;
+    };
+
+    unsigned add_node(const char* pattern, unsigned len);
+    unsigned get_next(unsigned node, uint8_t byte) const;
+    void build_fail();
+    void rank_hits(const char*, Hit*, unsigned, std::vector<unsigned>& chain);
+
+    snort::SearchTool tool;
+    std::deque<Entry> entries;
+
+    std::vector<Node> nodes;
+    std::unordered_map<uint64_t, unsigned> next;
+    unsigned max_depth = 0;
+
+    bool canonical;
+};
+
+#endif
+
@@ -669,7 +669,7 @@ int HttpPatternMatchers::process_host_patterns(DetectorHTTPPatterns& patterns)
 int HttpPatternMatchers::process_chp_list(CHPListElement* chplist)
 {
     for (size_t i = 0; i < NUM_HTTP_FIELDS; i++)
-        chp_matchers[i] = new SearchTool("ac_full", true);
+        chp_matchers[i] = new HttpMatchEngine(search_method.c_str());
 
     for (CHPListElement* chpe = chplist; chpe; chpe = chpe->next)
         chp_matchers[chpe->chp_action.ptype]->add(chpe->chp_action.pattern,
@@ -709,10 +709,10 @@ static FieldPattern http_field_patterns[] =
       HTTP_FIELD_PREFIX_USER_AGENT_SIZE },
 };
 
-static SearchTool* process_http_field_patterns(FieldPattern* patternList,
-    size_t patternListCount)
+static HttpMatchEngine* process_http_field_patterns(FieldPattern* patternList,
+    size_t patternListCount, const char* method)
 {
-    SearchTool* patternMatcher = new SearchTool("ac_full", true);
+    HttpMatchEngine* patternMatcher = new HttpMatchEngine(method);
 
     for (size_t i=0; i < patternListCount; i++)
         patternMatcher->add( (const char*)patternList[i].data, patternList[i].length,
@@ -722,7 +722,7 @@ static SearchTool* process_http_field_patterns(FieldPattern* patternList,
     return patternMatcher;
 }
 
-static void process_patterns(SearchTool& matcher, DetectorHTTPPatterns& patterns, bool
+static void process_patterns(HttpMatchEngine& matcher, DetectorHTTPPatterns& patterns, bool
     last = true)
 {
     for (auto& pat: patterns)
@@ -735,7 +735,6 @@ static void process_patterns(SearchTool& matcher, DetectorHTTPPatterns& patterns
 int HttpPatternMatchers::finalize_patterns()
 {
     process_patterns(via_matcher, static_via_http_detector_patterns);
-    process_patterns(url_matcher, url_patterns);
     process_patterns(client_agent_matcher, static_client_agent_patterns, false);
     process_patterns(client_agent_matcher, client_agent_patterns);
 
@@ -746,7 +745,8 @@ int HttpPatternMatchers::finalize_patterns()
     process_patterns(content_type_matcher, content_type_patterns);
 
     uint32_t numPatterns = sizeof(http_field_patterns) / sizeof(*http_field_patterns);
-    field_matcher = process_http_field_patterns(http_field_patterns, numPatterns);
+    field_matcher = process_http_field_patterns(http_field_patterns, numPatterns,
+        search_method.c_str());
 
     process_chp_list(chpList);
 
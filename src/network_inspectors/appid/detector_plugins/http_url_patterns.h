@@ -23,6 +23,7 @@
 #define HTTP_URL_PATTERNS_H
 
 #include <list>
+#include <string>
 #include <vector>
 
 #include "flow/flow.h"
@@ -34,6 +35,7 @@
 #include "appid_utils/sf_mlmp.h"
 #include "appid_utils/sf_multi_mpse.h"
 #include "application_ids.h"
+#include "http_match_engine.h"
 
 namespace snort
 {
@@ -282,9 +284,10 @@ public:
 class HttpPatternMatchers
 {
 public:
-    HttpPatternMatchers()
-        : url_matcher("ac_full", true), client_agent_matcher("ac_full", true), via_matcher("ac_full", true),
-          content_type_matcher("ac_full", true)
+    HttpPatternMatchers(const char* method = nullptr)
+        : search_method(HttpMatchEngine::get_method(method)),
+          client_agent_matcher(search_method.c_str()), via_matcher(search_method.c_str()),
+          content_type_matcher(search_method.c_str())
     { }
     ~HttpPatternMatchers();
 
@@ -296,6 +299,9 @@ public:
     void insert_url_pattern(DetectorAppUrlPattern*);
     void insert_rtmp_url_pattern(DetectorAppUrlPattern*);
     void insert_app_url_pattern(DetectorAppUrlPattern*);
+
+    const char* get_search_method() const
+    { return search_method.c_str(); }
     int process_chp_list(CHPListElement*);
     int process_host_patterns(DetectorHTTPPatterns&);
     int process_mlmp_patterns();
@@ -324,12 +330,13 @@ private:
     std::vector<HostUrlDetectorPattern*> host_url_patterns;
     CHPListElement* chpList = nullptr;
 
-    snort::SearchTool url_matcher;
-    snort::SearchTool client_agent_matcher;
-    snort::SearchTool via_matcher;
-    snort::SearchTool content_type_matcher;
-    snort::SearchTool* field_matcher = nullptr;
-    snort::SearchTool* chp_matchers[NUM_HTTP_FIELDS] = { nullptr };
+    // owned since the config that named it doesn't outlive reloads
+    std::string search_method;
+    HttpMatchEngine client_agent_matcher;
+    HttpMatchEngine via_matcher;
+    HttpMatchEngine content_type_matcher;
+    HttpMatchEngine* field_matcher = nullptr;
+    HttpMatchEngine* chp_matchers[NUM_HTTP_FIELDS] = { nullptr };
     tMlmpTree* host_url_matcher = nullptr;
     tMlmpTree* rtmp_host_url_matcher = nullptr;
 
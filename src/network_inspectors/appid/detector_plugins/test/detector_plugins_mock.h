@@ -83,6 +83,16 @@ char* snort_strdup(const char* str)
 }
 }
 
+// Stubs for http_match_engine.cc
+HttpMatchEngine::HttpMatchEngine(const char* method) : tool(method, true), canonical(false) { }
+const char* HttpMatchEngine::get_method(const char*) { return "ac_full"; }
+void HttpMatchEngine::add(const char* pattern, unsigned len, void* user, bool no_case)
+{ tool.add(pattern, len, user, no_case); }
+void HttpMatchEngine::prep() { tool.prep(); }
+int HttpMatchEngine::find_all(const char* s, unsigned len, MpseMatch match, bool confine,
+    void* context)
+{ return tool.find_all(s, len, match, confine, context); }
+
 void show_stats(PegCount*, const PegInfo*, unsigned, const char*) { }
 void show_stats(PegCount*, const PegInfo*, const IndexVec&, const char*, FILE*) { }
 
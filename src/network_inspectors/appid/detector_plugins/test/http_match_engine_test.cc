@@ -0,0 +1,355 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_match_engine_test.cc
+// unit test for http_match_engine
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/detector_plugins/http_match_engine.cc"
+
+#include <string>
+#include <vector>
+
+#include "search_engines/acsmx2.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// ac_full is the real acsmx2 full matcher.  the fake hyperscan reports all
+// matches that end at the same offset in reverse insertion order, which is
+// the worst case for the replay.
+struct FakePattern
+{
+    std::string pat;
+    void* user;
+    bool no_case;
+};
+
+static std::vector<FakePattern> added;
+static ACSM_STRUCT2* acsm = nullptr;
+static bool is_ac_full = false;
+static int dummy_api;
+
+static bool same(const FakePattern& fp, const char* s)
+{
+    for ( unsigned i = 0; i < fp.pat.size(); ++i )
+    {
+        char a = fp.pat[i];
+        char b = s[i];
+
+        if ( fp.no_case ? toupper(a) != toupper(b) : a != b )
+            return false;
+    }
+    return true;
+}
+
+namespace snort
+{
+SearchTool::SearchTool(const char* method, bool)
+{
+    is_ac_full = !strcmp(method, "ac_full");
+
+    if ( is_ac_full )
+    {
+        acsm = acsmNew2(nullptr, ACF_FULL);
+        acsm->enable_dfa();
+    }
+}
+
+SearchTool::~SearchTool()
+{
+    if ( acsm )
+        acsmFree2(acsm);
+    acsm = nullptr;
+}
+
+void SearchTool::add(const char* pat, unsigned len, void* user, bool no_case)
+{
+    added.push_back({ std::string(pat, len), user, no_case });
+
+    if ( acsm )
+        acsmAddPattern2(acsm, (const uint8_t*)pat, len, no_case, false, user);
+}
+
+void SearchTool::prep()
+{
+    if ( acsm )
+        acsmCompile2(nullptr, acsm);
+}
+
+int SearchTool::find_all(const char* s, unsigned len, MpseMatch match, bool, void* context)
+{
+    if ( acsm )
+    {
+        int state = 0;
+        return acsm_search_dfa_full_all(
+            acsm, (const uint8_t*)s, len, match, context, &state);
+    }
+    int n = 0;
+
+    for ( unsigned end = 1; end <= len; ++end )
+    {
+        for ( auto it = added.rbegin(); it != added.rend(); ++it )
+        {
+            unsigned plen = it->pat.size();
+
+            if ( plen > end or !same(*it, s + end - plen) )
+                continue;
+
+            ++n;
+
+            if ( match(it->user, nullptr, end, context, nullptr) > 0 )
+                return n;
+        }
+    }
+    return n;
+}
+
+void WarningMessage(const char*,...) { }
+void LogMessage(const char*,...) { }
+void LogValue(const char*, const char*, FILE*) { }
+void LogCount(const char*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+}
+
+const MpseApi* MpseManager::get_search_api(const char* type)
+{ return strcmp(type, "hyperscan") ? nullptr : (const MpseApi*)&dummy_api; }
+
+typedef std::vector<std::pair<int, int>> Seen;
+
+static int record(void* user, void*, int index, void* context, void*)
+{
+    Seen& seen = *(Seen*)context;
+    seen.emplace_back(*(int*)user, index);
+    return 0;
+}
+
+static int record_first(void* user, void*, int index, void* context, void*)
+{
+    record(user, nullptr, index, context, nullptr);
+    return 1;
+}
+
+static int users[64];
+
+struct TestPattern
+{
+    const char* pat;
+    bool no_case;
+};
+
+static Seen search(const char* method, const std::vector<TestPattern>& pats, const char* text)
+{
+    added.clear();
+    Seen seen;
+    {
+        HttpMatchEngine hme(method);
+
+        for ( unsigned i = 0; i < pats.size(); ++i )
+            hme.add(pats[i].pat, strlen(pats[i].pat), &users[i], pats[i].no_case);
+
+        hme.prep();
+        hme.find_all(text, strlen(text), record, false, &seen);
+    }
+    return seen;
+}
+
+// the hyperscan replay must match what ac_full reports
+static void check_parity(const std::vector<TestPattern>& pats, const char* text)
+{
+    Seen expected = search("ac_full", pats, text);
+    Seen actual = search("hyperscan", pats, text);
+
+    CHECK_EQUAL(expected.size(), actual.size());
+
+    for ( unsigned i = 0; i < expected.size(); ++i )
+    {
+        CHECK_EQUAL(expected[i].first, actual[i].first);
+        CHECK_EQUAL(expected[i].second, actual[i].second);
+    }
+}
+
+TEST_GROUP(http_match_engine_tests)
+{
+    void setup() override
+    {
+        acsmx2_init_xlatcase();
+        added.clear();
+
+        for ( unsigned i = 0; i < 64; ++i )
+            users[i] = i;
+    }
+
+    void teardown() override
+    {
+        HttpMatchEngine::tterm();
+    }
+};
+
+TEST(http_match_engine_tests, get_method)
+{
+    STRCMP_EQUAL("ac_full", HttpMatchEngine::get_method(nullptr));
+    STRCMP_EQUAL("ac_full", HttpMatchEngine::get_method("ac_full"));
+    STRCMP_EQUAL("hyperscan", HttpMatchEngine::get_method("hyperscan"));
+    STRCMP_EQUAL("ac_full", HttpMatchEngine::get_method("bogus"));
+}
+
+TEST(http_match_engine_tests, ac_full_order_is_kept)
+{
+    HttpMatchEngine hme("ac_full");
+    CHECK_FALSE(hme.is_canonical());
+
+    hme.add("abc", 3, &users[0], false);
+    hme.prep();
+
+    // ac_full results are passed straight through to the caller
+    POINTERS_EQUAL(&users[0], added.back().user);
+}
+
+TEST(http_match_engine_tests, suffix_order)
+{
+    // ac_full puts the fail state matches first
+    Seen seen = search("ac_full", { { "abcd", false }, { "cd", false }, { "d", false } }, "abcd");
+    CHECK_EQUAL(3, seen.size());
+    CHECK_EQUAL(1, seen[0].first);
+    CHECK_EQUAL(2, seen[1].first);
+    CHECK_EQUAL(0, seen[2].first);
+
+    check_parity({ { "abcd", false }, { "cd", false }, { "d", false } }, "abcd");
+}
+
+TEST(http_match_engine_tests, canonical_order)
+{
+    HttpMatchEngine hme("hyperscan");
+    CHECK_TRUE(hme.is_canonical());
+
+    std::vector<TestPattern> pats =
+        { { "abcd", false }, { "cd", false }, { "cd", false }, { "ab", false } };
+
+    // duplicates of an odd fail chain position are reversed
+    Seen seen = search("hyperscan", pats, "abcd");
+    CHECK_EQUAL(4, seen.size());
+    CHECK_EQUAL(3, seen[0].first);
+    CHECK_EQUAL(2, seen[0].second);
+    CHECK_EQUAL(2, seen[1].first);
+    CHECK_EQUAL(1, seen[2].first);
+    CHECK_EQUAL(0, seen[3].first);
+
+    check_parity(pats, "abcd");
+}
+
+TEST(http_match_engine_tests, long_chain)
+{
+    // "bcde" is a trie node but not a pattern so it is in the chain
+    check_parity(
+        { { "abcde", true }, { "bcdex", true }, { "cde", true }, { "de", true }, { "e", true },
+          { "de", true }, { "cde", true } }, "xxabcdexx");
+
+    check_parity(
+        { { "aaaa", true }, { "aa", true }, { "a", true }, { "aaa", true }, { "aa", true } },
+        "aaaaaa");
+}
+
+TEST(http_match_engine_tests, sparse_hits)
+{
+    // gaps longer than the deepest pattern restart the trie walk
+    check_parity(
+        { { "abc", true }, { "bc", true }, { "c", true }, { "cab", true } },
+        "abcxxxxxxxxabcabxxxxcxxxxxxxxxxbc");
+}
+
+TEST(http_match_engine_tests, case_sensitive)
+{
+    check_parity(
+        { { "Agent", false }, { "agent", true }, { "GENT", false }, { "ent", true },
+          { "nt", false } }, "User-Agent: AGENT agent");
+}
+
+TEST(http_match_engine_tests, random_parity)
+{
+    unsigned seed = 1;
+    auto rnd = [&seed]()
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) & 0x7fff;
+    };
+
+    std::vector<std::string> strs;
+
+    for ( unsigned t = 0; t < 200; ++t )
+    {
+        strs.clear();
+        std::vector<TestPattern> pats;
+        unsigned n = 1 + rnd() % 24;
+
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            std::string s;
+            unsigned len = 1 + rnd() % 5;
+
+            for ( unsigned j = 0; j < len; ++j )
+                s += "abAB"[rnd() % 4];
+
+            strs.emplace_back(s);
+        }
+        for ( unsigned i = 0; i < n; ++i )
+            pats.push_back({ strs[i].c_str(), (rnd() % 4) != 0 });
+
+        std::string text;
+
+        for ( unsigned j = 0; j < 32; ++j )
+            text += "abAB"[rnd() % 4];
+
+        check_parity(pats, text.c_str());
+    }
+}
+
+TEST(http_match_engine_tests, canonical_stop)
+{
+    HttpMatchEngine hme("hyperscan");
+
+    hme.add("abcd", 4, &users[0], false);
+    hme.add("cd", 2, &users[1], false);
+    hme.prep();
+
+    // the whole buffer is searched but only the first match is replayed
+    Seen seen;
+    CHECK_EQUAL(1, hme.find_all("abcd", 4, record_first, false, &seen));
+    CHECK_EQUAL(1, seen.size());
+    CHECK_EQUAL(1, seen[0].first);
+}
+
+TEST(http_match_engine_tests, canonical_no_match)
+{
+    HttpMatchEngine hme("hyperscan");
+    hme.add("abcd", 4, &users[0], false);
+    hme.prep();
+
+    Seen seen;
+    CHECK_EQUAL(0, hme.find_all("xyz", 3, record, false, &seen));
+    CHECK_EQUAL(0, seen.size());
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
@@ -24,6 +24,7 @@
 #endif
 
 #include "lua_detector_api.h"
+#include <cinttypes>
 #include <lua.hpp>
 #include <pcre.h>
 #include <unordered_map>
@@ -2674,6 +2675,33 @@ int register_detector(lua_State* L)
     return 1;                         /* return methods on the stack */
 }
 
+// a detector over its budget this many times is disabled on the thread
+static const unsigned max_lua_overruns = 8;
+
+bool LuaStateDescriptor::resolve_validate(lua_State* L)
+{
+    const char* validateFn = package_info.validateFunctionName.c_str();
+
+    if ( validateFn[0] != '\0' )
+    {
+        // get the table for this chunk (env) and the function we want to call
+        lua_getfield(L, LUA_REGISTRYINDEX, package_info.name.c_str());
+        lua_getfield(L, -1, validateFn);
+
+        if ( lua_isfunction(L, -1) )
+        {
+            validate_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+            lua_pop(L, 1);
+            return true;
+        }
+        ErrorMessage("lua detector %s: no validate function %s\n",
+            package_info.name.c_str(), validateFn);
+        lua_pop(L, 2);
+    }
+    has_validate = false;
+    return false;
+}
+
 int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
 {
     auto my_lua_state = lua_detector_mgr? lua_detector_mgr->L : nullptr;
@@ -2683,22 +2711,14 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
         return APPID_ENULL;
     }
 
-    // get the table for this chunk (env)
-    lua_getfield(my_lua_state, LUA_REGISTRYINDEX, package_info.name.c_str());
-    ldp.data = args.data;
-    ldp.size = args.size;
-    ldp.dir = args.dir;
-    ldp.asd = &args.asd;
-    ldp.change_bits = &args.change_bits;
-    ldp.pkt = args.pkt;
-    const char* validateFn = package_info.validateFunctionName.c_str();
+    // pattern only detectors and those with a missing function never reach lua
+    if ( !has_validate or (!validate_ref and !resolve_validate(my_lua_state)) )
+        return package_info.validateFunctionName.empty() ? APPID_NOMATCH : APPID_ENULL;
 
-    if ( (!validateFn) || (validateFn[0] == '\0'))
-    {
-        ldp.pkt = nullptr;
+    if ( disabled )
         return APPID_NOMATCH;
-    }
-    else if ( !lua_checkstack(my_lua_state, 1) )
+
+    if ( !lua_checkstack(my_lua_state, 1) )
     {
         static bool logged_stack_error = false;
         if (!logged_stack_error)
@@ -2707,13 +2727,43 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
             ErrorMessage("lua detector %s: LUA stack can not grow, %s\n",
                 package_info.name.c_str(), lua_tostring(my_lua_state, -1));
         }
-        ldp.pkt = nullptr;
         return APPID_ENOMEM;
     }
 
-    lua_getfield(my_lua_state, -1, validateFn); // get the function we want to call
+    ldp.data = args.data;
+    ldp.size = args.size;
+    ldp.dir = args.dir;
+    ldp.asd = &args.asd;
+    ldp.change_bits = &args.change_bits;
+    ldp.pkt = args.pkt;
+
+    lua_rawgeti(my_lua_state, LUA_REGISTRYINDEX, validate_ref);
+
+    hr_time start = SnortClock::now();
+    int status = lua_pcall(my_lua_state, 0, 1, 0);
+    hr_duration elapsed = SnortClock::now() - start;
+
+    cost.calls++;
+    cost.time += elapsed;
+
+    unsigned budget = args.asd.ctxt.config.lua_budget;
 
-    if ( lua_pcall(my_lua_state, 0, 1, 0) )
+    if ( budget and (unsigned long)clock_usecs(TO_USECS(elapsed)) > budget )
+    {
+        cost.overruns++;
+        appid_stats.lua_detector_overruns++;
+
+        if ( cost.overruns >= max_lua_overruns )
+        {
+            disabled = true;
+            appid_stats.lua_detectors_disabled++;
+            WarningMessage("appid: lua detector %s disabled on instance %u after %" PRIu64
+                " validations over %u usecs\n", package_info.name.c_str(), get_instance_id(),
+                cost.overruns, budget);
+        }
+    }
+
+    if ( status )
     {
         // Runtime Lua errors are suppressed in production code since detectors are written for
         // efficiency and with defensive minimum checks. Errors are dealt as exceptions
@@ -2742,6 +2792,19 @@ int LuaStateDescriptor::lua_validate(AppIdDiscoveryArgs& args)
     return rc;
 }
 
+static bool has_lua_function(lua_State* L, const std::string& detector_name,
+    const std::string& fn_name)
+{
+    if ( fn_name.empty() )
+        return false;
+
+    lua_getfield(L, LUA_REGISTRYINDEX, detector_name.c_str());
+    lua_getfield(L, -1, fn_name.c_str());
+    bool found = lua_isfunction(L, -1);
+    lua_pop(L, 2);
+    return found;
+}
+
 static inline void init_lsd(LuaStateDescriptor* lsd, const std::string& detector_name,
     lua_State* L)
 {
@@ -2756,8 +2819,10 @@ static inline void init_lsd(LuaStateDescriptor* lsd, const std::string& detector
 }
 
 LuaServiceDetector::LuaServiceDetector(AppIdDiscovery* sdm, const std::string& detector_name,
-    const std::string& logging_name, bool is_custom, unsigned min_match, IpProtocol protocol)
+    const std::string& logging_name, bool is_custom, unsigned min_match, IpProtocol protocol,
+    bool brute_force)
 {
+    prefilter.brute_force = brute_force;
     handler = sdm;
     name = detector_name;
     log_name = logging_name;
@@ -2776,8 +2841,11 @@ LuaServiceObject::LuaServiceObject(AppIdDiscovery* sdm, const std::string& detec
 
     if (init(L))
     {
+        // a detector that only registers patterns fails every session it is tried on,
+        // so it is left out of brute force
         sd = new LuaServiceDetector(sdm, detector_name,
-            log_name, is_custom, lsd.package_info.minimum_matches, protocol);
+            log_name, is_custom, lsd.package_info.minimum_matches, protocol,
+            has_lua_function(L, detector_name, lsd.package_info.validateFunctionName));
     }
     else
     {
@@ -2818,13 +2886,13 @@ LuaServiceObject::LuaServiceObject(AppIdDiscovery* sdm, const std::string& detec
 
 int LuaServiceDetector::validate(AppIdDiscoveryArgs& args)
 {
-    //FIXIT-M: RELOAD - use lua references to get user data object from stack
-    auto my_lua_state = lua_detector_mgr? lua_detector_mgr->L : nullptr;
-    lua_settop(my_lua_state,0);
-    std::string name = this->name + "_";
-    lua_getglobal(my_lua_state, name.c_str());
-    auto& ud = *UserData<LuaServiceObject>::check(my_lua_state, DETECTOR, 1);
-    return ud->lsd.lua_validate(args);
+    LuaObject* lo = lua_detector_mgr ? lua_detector_mgr->get_lua_object(this) : nullptr;
+
+    if ( !lo )
+        return APPID_ENULL;
+
+    lua_settop(lua_detector_mgr->L, 0);
+    return lo->lsd.lua_validate(args);
 }
 
 LuaClientDetector::LuaClientDetector(AppIdDiscovery* cdm, const std::string& detector_name,
@@ -2896,11 +2964,11 @@ LuaStateDescriptor* LuaObject::validate_lua_state(bool packet_context)
 
 int LuaClientDetector::validate(AppIdDiscoveryArgs& args)
 {
-    //FIXIT-M: RELOAD - use lua references to get user data object from stack
-    auto my_lua_state = lua_detector_mgr? lua_detector_mgr->L : nullptr;
-    std::string name = this->name + "_";
-    lua_settop(my_lua_state,0); //set stack index to 0
-    lua_getglobal(my_lua_state, name.c_str());
-    auto& ud = *UserData<LuaClientObject>::check(my_lua_state, DETECTOR, 1);
-    return ud->lsd.lua_validate(args);
+    LuaObject* lo = lua_detector_mgr ? lua_detector_mgr->get_lua_object(this) : nullptr;
+
+    if ( !lo )
+        return APPID_ENULL;
+
+    lua_settop(lua_detector_mgr->L, 0); //set stack index to 0
+    return lo->lsd.lua_validate(args);
 }
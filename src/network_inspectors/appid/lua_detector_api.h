@@ -32,6 +32,7 @@
 #include "service_plugins/service_detector.h"
 
 #include "main/snort_debug.h"
+#include "time/clock_defs.h"
 
 extern Trace TRACE_NAME(appid_module);
 
@@ -76,6 +77,14 @@ struct LuaDetectorParameters
     const snort::Packet* pkt = nullptr;
 };
 
+// cost of a detector's validate function on one packet thread
+struct LuaDetectorCost
+{
+    uint64_t calls = 0;
+    uint64_t overruns = 0;
+    hr_duration time = 0_ticks;
+};
+
 class LuaStateDescriptor
 {
 public:
@@ -85,14 +94,26 @@ public:
     //int detector_user_data_ref = 0;    // key into LUA_REGISTRYINDEX
     DetectorPackageInfo package_info;
     AppId service_id = APP_ID_UNKNOWN;
+    LuaDetectorCost cost;
     int lua_validate(AppIdDiscoveryArgs&);
+
+    bool is_disabled() const
+    { return disabled; }
+
+private:
+    bool resolve_validate(lua_State*);
+
+    int validate_ref = 0;       // key into LUA_REGISTRYINDEX, resolved on first use
+    bool has_validate = true;   // false for detectors that only register patterns
+    bool disabled = false;      // over budget too often on this thread
 };
 
 class LuaServiceDetector : public ServiceDetector
 {
 public:
     LuaServiceDetector(AppIdDiscovery* sdm, const std::string& detector_name,
-        const std::string& log_name, bool is_custom, unsigned min_match, IpProtocol protocol);
+        const std::string& log_name, bool is_custom, unsigned min_match, IpProtocol protocol,
+        bool brute_force = true);
     int validate(AppIdDiscoveryArgs&) override;
 };
 
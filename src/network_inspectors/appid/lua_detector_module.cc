@@ -28,8 +28,11 @@
 #include <glob.h>
 #include <libgen.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cinttypes>
 #include <fstream>
+#include <vector>
 
 #include "appid_config.h"
 #include "lua_detector_util.h"
@@ -221,6 +224,9 @@ void LuaDetectorManager::terminate()
     if (!lua_detector_mgr)
         return;
 
+    if (lua_detector_mgr->ctxt.config.stats_logging_enabled)
+        lua_detector_mgr->log_lua_costs();
+
     delete lua_detector_mgr;
     lua_detector_mgr = nullptr;
 }
@@ -513,6 +519,10 @@ void LuaDetectorManager::activate_lua_detectors()
 
         lua_getfield(L, LUA_REGISTRYINDEX, lsd->package_info.name.c_str());
         set_lua_tracker_size(L, lua_tracker_size);
+
+        // saves a lua global lookup by name on every validate
+        if ( AppIdDetector* ad = (*lo)->get_detector() )
+            detector_objects[ad] = *lo;
         ++lo;
     }
 }
@@ -524,3 +534,33 @@ void LuaDetectorManager::list_lua_detectors()
         (allocated_objects.size() - num_odp_detectors), lua_gc(L, LUA_GCCOUNT, 0));
 }
 
+void LuaDetectorManager::log_lua_costs()
+{
+    std::vector<LuaObject*> costly;
+
+    for ( auto& lua_object : allocated_objects )
+        if ( lua_object->lsd.cost.calls )
+            costly.emplace_back(lua_object);
+
+    if ( costly.empty() )
+        return;
+
+    std::sort(costly.begin(), costly.end(), [](const LuaObject* a, const LuaObject* b)
+        { return a->lsd.cost.time > b->lsd.cost.time; });
+
+    const unsigned max_logged = 10;
+
+    if ( costly.size() > max_logged )
+        costly.resize(max_logged);
+
+    LogMessage("AppId Lua-Detector Costs: instance %u\n", get_instance_id());
+
+    for ( auto& lua_object : costly )
+    {
+        const LuaStateDescriptor& lsd = lua_object->lsd;
+        LogMessage("    %s: calls %" PRIu64 ", usecs %ld, overruns %" PRIu64 "%s\n",
+            lsd.package_info.name.c_str(), lsd.cost.calls,
+            clock_usecs(TO_USECS(lsd.cost.time)), lsd.cost.overruns,
+            lsd.is_disabled() ? " (disabled)" : "");
+    }
+}
@@ -26,6 +26,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 #include <lua.hpp>
 #include <lua/lua.h>
@@ -58,10 +59,18 @@ public:
     bool insert_cb_detector(AppId app_id, LuaObject* ud);
     LuaObject* get_cb_detector(AppId app_id);
 
+    // this thread's lua object for a detector
+    LuaObject* get_lua_object(const AppIdDetector* ad)
+    {
+        auto it = detector_objects.find(ad);
+        return it == detector_objects.end() ? nullptr : it->second;
+    }
+
 private:
     void initialize_lua_detectors();
     void activate_lua_detectors();
     void list_lua_detectors();
+    void log_lua_costs();
     void load_detector(char* detectorName, bool isCustom);
     void load_lua_detectors(const char* path, bool isCustom);
     LuaObject* create_lua_detector(const char* detector_name, bool is_custom,
@@ -71,6 +80,7 @@ private:
     std::list<LuaObject*> allocated_objects;
     size_t num_odp_detectors = 0;
     std::map<AppId, LuaObject*> cb_detectors;
+    std::unordered_map<const AppIdDetector*, LuaObject*> detector_objects;
 };
 
 extern THREAD_LOCAL LuaDetectorManager* lua_detector_mgr;
@@ -98,6 +98,8 @@ BgpServiceDetector::BgpServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { sizeof(ServiceBGPHeader) };
+
     tcp_patterns =
     {
         { (uint8_t*)BGP_PATTERN, sizeof(BGP_PATTERN), 0, 0, 0 },
@@ -24,6 +24,7 @@
 
 #include "appid_detector.h"
 #include "service_discovery.h"
+#include "service_prefilter.h"
 
 #define APPID_EARLY_SESSION_FLAG_FW_RULE    1
 
@@ -60,6 +61,13 @@ public:
 
     void initialize_expected_session(const AppIdSession&, AppIdSession&, uint64_t flags, AppidSessionDirection dir);
 
+    const ServicePrefilter& get_prefilter() const
+    { return prefilter; }
+
+protected:
+    // conditions the first responder payload must meet for validate() to succeed
+    ServicePrefilter prefilter;
+
 private:
     int update_service_data(AppIdSession&, const snort::Packet*, AppidSessionDirection dir, AppId,
         const char* vendor, const char* version, AppidChangeBits& change_bits);
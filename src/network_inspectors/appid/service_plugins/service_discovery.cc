@@ -145,12 +145,28 @@ void ServiceDiscovery::initialize()
     }
 }
 
+static void compile_brute_force(AppIdDetectors& detectors, ServicePrefilterTable& table)
+{
+    for ( auto& kv : detectors )
+    {
+        ServiceDetector* sd = static_cast<ServiceDetector*>(kv.second);
+
+        if ( sd->get_prefilter().brute_force )
+            table.add(sd, sd->get_prefilter());
+    }
+    table.finalize();
+}
+
 void ServiceDiscovery::finalize_service_patterns()
 {
     if (tcp_patterns)
         tcp_patterns->prep();
     if (udp_patterns)
         udp_patterns->prep();
+
+    // lua detectors are registered by now too
+    compile_brute_force(tcp_detectors, tcp_brute_force);
+    compile_brute_force(udp_detectors, udp_brute_force);
 }
 
 int ServiceDiscovery::add_service_port(AppIdDetector* detector, const ServiceDetectorPort& pp)
@@ -433,8 +449,11 @@ int ServiceDiscovery::identify_service(AppIdSession& asd, Packet* p,
             else if ( sds_state == ServiceState::SEARCHING_BRUTE_FORCE and
                       asd.service_candidates.empty() )
             {
+                // only the first responder payload can rule out detectors
+                bool banner = dir == APP_ID_FROM_RESPONDER;
                 asd.service_detector = sds->select_detector_by_brute_force(proto,
-                    asd.ctxt.get_odp_ctxt().get_service_disco_mgr());
+                    asd.ctxt.get_odp_ctxt().get_service_disco_mgr(),
+                    banner ? p->data : nullptr, banner ? p->dsize : 0);
                 got_brute_force = true;
             }
         }
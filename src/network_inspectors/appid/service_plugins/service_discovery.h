@@ -32,6 +32,7 @@
 #include "utils/sflsq.h"
 
 #include "appid_types.h"
+#include "service_prefilter.h"
 
 class AppIdSession;
 class ServiceDetector;
@@ -84,6 +85,9 @@ public:
     int incompatible_data(AppIdSession&, const snort::Packet*, AppidSessionDirection dir, ServiceDetector*);
     static int add_ftp_service_state(AppIdSession&);
 
+    const ServicePrefilterTable& get_brute_force_table(IpProtocol proto) const
+    { return proto == IpProtocol::TCP ? tcp_brute_force : udp_brute_force; }
+
 private:
     void get_next_service(const snort::Packet*, const AppidSessionDirection dir, AppIdSession&);
     void get_port_based_services(IpProtocol, uint16_t port, AppIdSession&);
@@ -93,6 +97,8 @@ private:
     std::unordered_map<uint16_t, std::vector<ServiceDetector*> > tcp_services;
     std::unordered_map<uint16_t, std::vector<ServiceDetector*> > udp_services;
     std::unordered_map<uint16_t, std::vector<ServiceDetector*> > udp_reversed_services;
+    ServicePrefilterTable tcp_brute_force;
+    ServicePrefilterTable udp_brute_force;
 };
 
 #endif
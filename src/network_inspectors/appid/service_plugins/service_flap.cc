@@ -76,6 +76,10 @@ struct FLAPHeader
 
 static uint8_t FLAP_PATTERN[] = { 0x2A, 0x01 };
 
+// signon frame with a 4 byte payload, any sequence number
+static const uint8_t flap_ack[] = { 0x2A, 0x01, 0, 0, 0x00, 0x04, 0x00, 0x00 };
+static const uint8_t flap_ack_mask[] = { 0xFF, 0xFF, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF };
+
 FlapServiceDetector::FlapServiceDetector(ServiceDiscovery* sd)
 {
     handler = sd;
@@ -83,6 +87,8 @@ FlapServiceDetector::FlapServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { sizeof(FLAPHeader) + 4, flap_ack, sizeof(flap_ack), flap_ack_mask };
+
     tcp_patterns =
     {
         { FLAP_PATTERN, sizeof(FLAP_PATTERN), 0, 0, 0 },
@@ -45,6 +45,10 @@ struct ServiceMYSQLHdr
 
 #pragma pack()
 
+// a greeting is packet 0 of protocol version 10
+static const uint8_t mysql_greeting[] = { 0, 0, 0, 0, 0x0A };
+static const uint8_t mysql_greeting_mask[] = { 0, 0, 0, 0xFF, 0xFF };
+
 MySqlServiceDetector::MySqlServiceDetector(ServiceDiscovery* sd)
 {
     handler = sd;
@@ -52,6 +56,9 @@ MySqlServiceDetector::MySqlServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { sizeof(ServiceMYSQLHdr), mysql_greeting, sizeof(mysql_greeting),
+        mysql_greeting_mask };
+
     appid_registry =
     {
         { APP_ID_MYSQL, APPINFO_FLAG_SERVICE_ADDITIONAL }
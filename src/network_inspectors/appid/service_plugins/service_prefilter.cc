@@ -0,0 +1,59 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// service_prefilter.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "service_prefilter.h"
+
+#include <cassert>
+
+ServicePrefilter::ServicePrefilter(uint16_t min, const uint8_t* magic, unsigned len,
+    const uint8_t* mask_bytes) : min_size(min)
+{
+    assert(len <= sizeof(value));
+    uint8_t v[sizeof(value)] = { };
+    uint8_t m[sizeof(mask)] = { };
+
+    for ( unsigned i = 0; i < len; ++i )
+    {
+        m[i] = mask_bytes ? mask_bytes[i] : 0xff;
+        v[i] = magic[i] & m[i];
+    }
+    memcpy(&value, v, sizeof(value));
+    memcpy(&mask, m, sizeof(mask));
+}
+
+void ServicePrefilterTable::add(ServiceDetector* sd, const ServicePrefilter& pf)
+{
+    detectors.emplace_back(sd);
+    values.emplace_back(pf.value);
+    masks.emplace_back(pf.mask);
+    min_sizes.emplace_back(pf.min_size);
+}
+
+void ServicePrefilterTable::finalize()
+{
+    hits.reset(new std::atomic<uint32_t>[detectors.size()]);
+
+    for ( unsigned i = 0; i < detectors.size(); ++i )
+        hits[i] = 0;
+}
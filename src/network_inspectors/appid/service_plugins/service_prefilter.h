@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// service_prefilter.h
+
+#ifndef SERVICE_PREFILTER_H
+#define SERVICE_PREFILTER_H
+
+// Brute force tries the TCP or UDP service detectors one per session until one
+// of them validates the server.  Most C detectors reject the first responder
+// payload on its length and leading bytes alone, so they can declare those
+// necessary conditions as a ServicePrefilter.  ServicePrefilterTable compiles
+// them into packed arrays so brute force can skip the detectors that would
+// fail the payload at hand, and counts brute force successes so the detectors
+// that find the most services are tried first.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+class ServiceDetector;
+
+struct ServicePrefilter
+{
+    ServicePrefilter() = default;
+
+    // mask defaults to all of the len magic bytes; len is at most 8
+    ServicePrefilter(uint16_t min_size, const uint8_t* magic = nullptr, unsigned len = 0,
+        const uint8_t* mask = nullptr);
+
+    // the leading bytes of a payload in the same layout as value and mask
+    static uint64_t load(const uint8_t* data, uint16_t size)
+    {
+        uint64_t word = 0;
+        memcpy(&word, data, size < sizeof(word) ? size : sizeof(word));
+        return word;
+    }
+
+    uint16_t min_size = 0;
+    uint64_t value = 0;
+    uint64_t mask = 0;
+    bool brute_force = true;    // false for detectors that can't validate anything
+};
+
+class ServicePrefilterTable
+{
+public:
+    void add(ServiceDetector*, const ServicePrefilter&);
+    void finalize();
+
+    unsigned get_count() const
+    { return detectors.size(); }
+
+    ServiceDetector* get_detector(unsigned i) const
+    { return detectors[i]; }
+
+    bool plausible(unsigned i, uint64_t word, uint16_t size) const
+    { return size >= min_sizes[i] and (word & masks[i]) == values[i]; }
+
+    void hit(unsigned i) const
+    { hits[i].fetch_add(1, std::memory_order_relaxed); }
+
+    uint32_t get_hits(unsigned i) const
+    { return hits ? hits[i].load(std::memory_order_relaxed) : 0; }
+
+    // detector indices with the most brute force successes first; ties keep
+    // the registration (name) order
+    void get_order(std::vector<uint16_t>& order) const
+    {
+        order.resize(detectors.size());
+
+        for ( unsigned i = 0; i < order.size(); ++i )
+            order[i] = i;
+
+        std::stable_sort(order.begin(), order.end(),
+            [this](uint16_t a, uint16_t b) { return get_hits(a) > get_hits(b); });
+    }
+
+private:
+    std::vector<ServiceDetector*> detectors;
+    std::vector<uint64_t> values;
+    std::vector<uint64_t> masks;
+    std::vector<uint16_t> min_sizes;
+    std::unique_ptr<std::atomic<uint32_t>[]> hits;
+};
+
+#endif
@@ -37,6 +37,8 @@ RfbServiceDetector::RfbServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { RFB_BANNER_SIZE, (const uint8_t*)RFB_BANNER, sizeof(RFB_BANNER) - 1 };
+
     tcp_patterns =
     {
         { (const uint8_t*)RFB_BANNER, sizeof(RFB_BANNER) - 1, 0, 0, 0 },
@@ -49,6 +49,8 @@ RsyncServiceDetector::RsyncServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { sizeof(RSYNC_BANNER) - 1, (const uint8_t*)RSYNC_BANNER, 8 };
+
     tcp_patterns =
     {
         { (const uint8_t*)RSYNC_BANNER, sizeof(RSYNC_BANNER)-1, 0, 0, 0 }
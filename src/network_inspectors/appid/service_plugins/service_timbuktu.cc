@@ -64,6 +64,8 @@ TimbuktuServiceDetector::TimbuktuServiceDetector(ServiceDiscovery* sd)
     proto = IpProtocol::TCP;
     detectorType = DETECTOR_TYPE_DECODER;
 
+    prefilter = { 1, (const uint8_t*)TIMBUKTU_BANNER, 1 };
+
     tcp_patterns =
     {
         { (const uint8_t*)TIMBUKTU_BANNER, sizeof(TIMBUKTU_BANNER) - 1, 0, 0, 0 }
@@ -74,6 +74,10 @@ bool Module::set(const char*, Value&, SnortConfig*){ return false;}
 void Module::reset_stats() {}
 }
 
+// Stubs for http_match_engine.cc
+HttpMatchEngine::HttpMatchEngine(const char* method) : tool(method, true), canonical(false) { }
+const char* HttpMatchEngine::get_method(const char*) { return "ac_full"; }
+
 SslPatternMatchers::~SslPatternMatchers() { }
 SipPatternMatchers::~SipPatternMatchers() { }
 HttpPatternMatchers::~HttpPatternMatchers() { }
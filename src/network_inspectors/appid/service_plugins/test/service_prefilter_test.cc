@@ -0,0 +1,107 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// service_prefilter_test.cc
+// unit test for the brute force prefilter table
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "network_inspectors/appid/service_plugins/service_prefilter.cc"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// the table only stores and returns detector pointers
+static ServiceDetector* const rfb = (ServiceDetector*)0x10;
+static ServiceDetector* const mysql = (ServiceDetector*)0x20;
+static ServiceDetector* const lua = (ServiceDetector*)0x30;
+
+static bool plausible(const ServicePrefilterTable& table, unsigned i, const char* s, uint16_t n)
+{
+    const uint8_t* data = (const uint8_t*)s;
+    return table.plausible(i, ServicePrefilter::load(data, n), n);
+}
+
+TEST_GROUP(service_prefilter_tests)
+{
+    ServicePrefilterTable table;
+
+    void setup() override
+    {
+        static const uint8_t greeting[] = { 0, 0, 0, 0, 0x0A };
+        static const uint8_t mask[] = { 0, 0, 0, 0xFF, 0xFF };
+
+        table.add(rfb, { 12, (const uint8_t*)"RFB ", 4 });
+        table.add(mysql, { 5, greeting, sizeof(greeting), mask });
+        table.add(lua, { });
+        table.finalize();
+    }
+};
+
+TEST(service_prefilter_tests, leading_bytes)
+{
+    CHECK_EQUAL(3u, table.get_count());
+    CHECK(table.get_detector(0) == rfb);
+
+    CHECK_TRUE(plausible(table, 0, "RFB 003.008\n", 12));
+    CHECK_FALSE(plausible(table, 0, "SSH-2.0-Open", 12));
+    CHECK_FALSE(plausible(table, 0, "RFB ", 4));
+}
+
+TEST(service_prefilter_tests, masked_bytes)
+{
+    CHECK_TRUE(plausible(table, 1, "J\0\0\0\x0A" "5.7.3", 10));
+    CHECK_TRUE(plausible(table, 1, "\xff\xff\xff\0\x0A", 5));
+    CHECK_FALSE(plausible(table, 1, "J\0\0\1\x0A" "5.7.3", 10));
+    CHECK_FALSE(plausible(table, 1, "J\0\0\0\x09" "5.7.3", 10));
+    CHECK_FALSE(plausible(table, 1, "J\0\0\0", 4));
+}
+
+TEST(service_prefilter_tests, no_prefilter)
+{
+    CHECK_TRUE(plausible(table, 2, "x", 1));
+    CHECK_TRUE(plausible(table, 2, "RFB 003.008\n", 12));
+}
+
+TEST(service_prefilter_tests, order_by_hits)
+{
+    std::vector<uint16_t> order;
+    table.get_order(order);
+    CHECK_EQUAL(3u, order.size());
+    CHECK_EQUAL(0, order[0]);
+    CHECK_EQUAL(1, order[1]);
+    CHECK_EQUAL(2, order[2]);
+
+    table.hit(2);
+    table.hit(2);
+    table.hit(1);
+    CHECK_EQUAL(2u, table.get_hits(2));
+
+    table.get_order(order);
+    CHECK_EQUAL(2, order[0]);
+    CHECK_EQUAL(1, order[1]);
+    CHECK_EQUAL(0, order[2]);
+}
+
+int main(int argc, char** argv)
+{
+    int return_value = CommandLineTestRunner::RunAllTests(argc, argv);
+    return return_value;
+}
@@ -29,6 +29,7 @@
 #include <map>
 
 #include "log/messages.h"
+#include "main/thread.h"
 #include "sfip/sf_ip.h"
 #include "time/packet_time.h"
 #include "utils/util.h"
@@ -39,6 +40,7 @@
 using namespace snort;
 
 static THREAD_LOCAL MapList* service_state_cache = nullptr;
+static SharedServiceState* shared_service_state = nullptr;
 
 const size_t MapList::sz = sizeof(ServiceDiscoveryState) +
     sizeof(Map_t::value_type) + sizeof(Queue_t::value_type);
@@ -57,14 +59,41 @@ ServiceDiscoveryState::~ServiceDiscoveryState()
     delete udp_brute_force_mgr;
 }
 
+ServiceDetector* AppIdDetectorList::next(const uint8_t* data, uint16_t size)
+{
+    // detectors go in process on empty payloads, so those can't rule any out
+    bool filter = data and size;
+    uint64_t word = filter ? ServicePrefilter::load(data, size) : 0;
+
+    while ( pos < order.size() )
+    {
+        const uint16_t* i = &order[pos++];
+
+        if ( !filter or table.plausible(*i, word, size) )
+        {
+            last = i;
+            return table.get_detector(*i);
+        }
+        appid_stats.service_brute_force_skips++;
+    }
+    last = nullptr;
+    return nullptr;
+}
+
+void AppIdDetectorList::hit(const ServiceDetector* sd)
+{
+    if ( last and table.get_detector(*last) == sd )
+        table.hit(*last);
+}
+
 ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtocol proto,
-    ServiceDiscovery& sd)
+    ServiceDiscovery& sd, const uint8_t* data, uint16_t size)
 {
     if (proto == IpProtocol::TCP)
     {
         if ( !tcp_brute_force_mgr )
             tcp_brute_force_mgr = new AppIdDetectorList(IpProtocol::TCP, sd);
-        service = tcp_brute_force_mgr->next();
+        service = tcp_brute_force_mgr->next(data, size);
         if (appidDebug->is_active())
             LogMessage("AppIdDbg %s Brute-force state %s\n", appidDebug->get_debug_session(),
                 service? "" : "failed - no more TCP detectors");
@@ -73,7 +102,7 @@ ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtoco
     {
         if ( !udp_brute_force_mgr )
             udp_brute_force_mgr = new AppIdDetectorList(IpProtocol::UDP, sd);
-        service = udp_brute_force_mgr->next();
+        service = udp_brute_force_mgr->next(data, size);
         if (appidDebug->is_active())
             LogMessage("AppIdDbg %s Brute-force state %s\n", appidDebug->get_debug_session(),
                 service? "" : "failed - no more UDP detectors");
@@ -89,6 +118,20 @@ ServiceDetector* ServiceDiscoveryState::select_detector_by_brute_force(IpProtoco
 
 void ServiceDiscoveryState::set_service_id_valid(ServiceDetector* sd)
 {
+    if ( shared_key and (state != ServiceState::VALID or service != sd) )
+    {
+        shared_service_state->add(shared_key, sd, packet_time());
+        appid_stats.service_cache_shared_adds++;
+    }
+
+    if ( state == ServiceState::SEARCHING_BRUTE_FORCE )
+    {
+        if ( tcp_brute_force_mgr )
+            tcp_brute_force_mgr->hit(sd);
+        if ( udp_brute_force_mgr )
+            udp_brute_force_mgr->hit(sd);
+    }
+
     service = sd;
     reset_time = 0;
     if ( state != ServiceState::VALID )
@@ -118,6 +161,7 @@ void ServiceDiscoveryState::set_service_id_valid(ServiceDetector* sd)
 void ServiceDiscoveryState::set_service_id_failed(AppIdSession& asd, const SfIp* client_ip,
     unsigned invalid_delta)
 {
+    bool was_valid = ( state == ServiceState::VALID );
     invalid_client_count += invalid_delta;
 
     /* If we had a valid detector, check for too many fails.  If so, start
@@ -177,6 +221,10 @@ void ServiceDiscoveryState::set_service_id_failed(AppIdSession& asd, const SfIp*
         else
             state = FAILED;
     }
+
+    // don't let other threads adopt a service we gave up on
+    if ( shared_key and was_valid and state != ServiceState::VALID )
+        shared_service_state->remove(shared_key);
 }
 
 void ServiceDiscoveryState::update_service_incompatiable(const SfIp* ip)
@@ -214,7 +262,26 @@ void AppIdServiceState::clean()
 ServiceDiscoveryState* AppIdServiceState::add(const SfIp* ip, IpProtocol proto, uint16_t port,
     bool decrypted, bool do_touch)
 {
-    return service_state_cache->add( AppIdServiceStateKey(ip, proto, port, decrypted), do_touch );
+    AppIdServiceStateKey ssk(ip, proto, port, decrypted);
+    bool added = false;
+    ServiceDiscoveryState* ss = service_state_cache->add(ssk, do_touch, &added);
+
+    if ( added and shared_service_state )
+    {
+        uint64_t key = SharedServiceState::hash(ssk);
+        bool other_thread = false;
+
+        // adopt before setting the key so we don't publish it again
+        if ( ServiceDetector* sd = shared_service_state->find(key, packet_time(), other_thread) )
+        {
+            ss->set_service_id_valid(sd);
+
+            if ( other_thread )
+                appid_stats.service_cache_shared_hits++;
+        }
+        ss->set_shared_key(key);
+    }
+    return ss;
 }
 
 ServiceDiscoveryState* AppIdServiceState::get(const SfIp* ip, IpProtocol proto, uint16_t port,
@@ -228,6 +295,9 @@ void AppIdServiceState::remove(const SfIp* ip, IpProtocol proto, uint16_t port,
     AppIdServiceStateKey ssk(ip, proto, port, decrypted);
     Map_t::iterator it = service_state_cache->find(ssk);
 
+    if ( shared_service_state )
+        shared_service_state->remove(SharedServiceState::hash(ssk));
+
     if ( !service_state_cache->remove(it) )
     {
         char ipstr[INET6_ADDRSTRLEN];
@@ -261,3 +331,142 @@ bool AppIdServiceState::prune(size_t max_memory, size_t num_items)
         return service_state_cache->prune(max_memory, num_items);
     return true;
 }
+
+void AppIdServiceState::init_shared(size_t memcap)
+{
+    if ( memcap and !shared_service_state )
+        shared_service_state = new SharedServiceState(memcap);
+}
+
+void AppIdServiceState::term_shared()
+{
+    delete shared_service_state;
+    shared_service_state = nullptr;
+}
+
+//-------------------------------------------------------------------------
+// shared service state
+//-------------------------------------------------------------------------
+
+SharedServiceState::SharedServiceState(size_t memcap)
+{
+    size_t n = max_probes;
+
+    while ( 2 * n * sizeof(SharedServiceSlot) <= memcap )
+        n *= 2;
+
+    mask = n - 1;
+    slots = new SharedServiceSlot[n];
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+        slots[i].key.store(0, std::memory_order_relaxed);
+        slots[i].service.store(nullptr, std::memory_order_relaxed);
+        slots[i].touched.store(0, std::memory_order_relaxed);
+        slots[i].owner.store(0, std::memory_order_relaxed);
+    }
+}
+
+SharedServiceState::~SharedServiceState()
+{
+    delete[] slots;
+}
+
+uint64_t SharedServiceState::hash(const AppIdServiceStateKey& k)
+{
+    // FNV-1a with a final mix; the key has no uninitialized padding
+    const uint8_t* p = (const uint8_t*)&k;
+    uint64_t h = 0xcbf29ce484222325ull;
+
+    for ( size_t i = 0; i < sizeof(k); ++i )
+        h = (h ^ p[i]) * 0x100000001b3ull;
+
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+
+    return h ? h : 1;
+}
+
+ServiceDetector* SharedServiceState::find(uint64_t key, uint32_t now, bool& other_thread)
+{
+    for ( unsigned i = 0; i < max_probes; ++i )
+    {
+        SharedServiceSlot& s = slots[(key + i) & mask];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+
+        if ( !k )
+            return nullptr;
+
+        if ( k != key )
+            continue;
+
+        ServiceDetector* sd = s.service.load(std::memory_order_acquire);
+
+        if ( sd )
+        {
+            // avoid dirtying the line on every hit
+            if ( s.touched.load(std::memory_order_relaxed) != now )
+                s.touched.store(now, std::memory_order_relaxed);
+
+            other_thread = s.owner.load(std::memory_order_relaxed) != get_instance_id() + 1;
+        }
+        return sd;
+    }
+    return nullptr;
+}
+
+void SharedServiceState::add(uint64_t key, ServiceDetector* sd, uint32_t now)
+{
+    SharedServiceSlot* lru = nullptr;
+
+    for ( unsigned i = 0; i < max_probes; ++i )
+    {
+        SharedServiceSlot& s = slots[(key + i) & mask];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+
+        if ( !k and s.key.compare_exchange_strong(k, key) )
+            k = key;
+
+        if ( k == key )
+        {
+            s.owner.store(get_instance_id() + 1, std::memory_order_relaxed);
+            s.touched.store(now, std::memory_order_relaxed);
+            s.service.store(sd, std::memory_order_release);
+            return;
+        }
+        if ( !lru or s.touched.load(std::memory_order_relaxed) <
+            lru->touched.load(std::memory_order_relaxed) )
+            lru = &s;
+    }
+
+    // approximate lru: replace the stalest slot in the probe sequence
+    uint64_t k = lru->key.load(std::memory_order_relaxed);
+    lru->service.store(nullptr, std::memory_order_release);
+
+    if ( lru->key.compare_exchange_strong(k, key) )
+    {
+        lru->owner.store(get_instance_id() + 1, std::memory_order_relaxed);
+        lru->touched.store(now, std::memory_order_relaxed);
+        lru->service.store(sd, std::memory_order_release);
+    }
+}
+
+void SharedServiceState::remove(uint64_t key)
+{
+    // the key stays so that probe sequences aren't broken
+    for ( unsigned i = 0; i < max_probes; ++i )
+    {
+        SharedServiceSlot& s = slots[(key + i) & mask];
+        uint64_t k = s.key.load(std::memory_order_acquire);
+
+        if ( !k )
+            return;
+
+        if ( k == key )
+        {
+            s.service.store(nullptr, std::memory_order_release);
+            return;
+        }
+    }
+}
@@ -22,8 +22,10 @@
 #ifndef SERVICE_STATE_H
 #define SERVICE_STATE_H
 
+#include <atomic>
 #include <list>
 #include <map>
+#include <vector>
 
 #include "protocols/protocol_ids.h"
 #include "sfip/sf_ip.h"
@@ -53,31 +55,29 @@ class AppIdDetectorList
 {
 public:
     AppIdDetectorList(IpProtocol proto, ServiceDiscovery& sd)
+        : table(sd.get_brute_force_table(proto))
     {
-        if (proto == IpProtocol::TCP)
-            detectors = sd.get_tcp_detectors();
-        else
-            detectors = sd.get_udp_detectors();
-        dit = detectors->begin();
+        table.get_order(order);
     }
 
-    ServiceDetector* next()
-    {
-        ServiceDetector* detector = nullptr;
+    // data is the first responder payload of the session, if any; detectors
+    // whose prefilter rules it out are passed over
+    ServiceDetector* next(const uint8_t* data = nullptr, uint16_t size = 0);
 
-        if ( dit != detectors->end())
-            detector = (ServiceDetector*)(dit++)->second;
-        return detector;
-    }
+    // credit the last detector returned if it is the one that validated
+    void hit(const ServiceDetector*);
 
     void reset()
     {
-        dit = detectors->begin();
+        pos = 0;
+        last = nullptr;
     }
 
 private:
-    AppIdDetectors* detectors;
-    AppIdDetectorsIterator dit;
+    const ServicePrefilterTable& table;
+    std::vector<uint16_t> order;
+    unsigned pos = 0;
+    const uint16_t* last = nullptr;
 };
 
 class ServiceDiscoveryState
@@ -85,7 +85,8 @@ class ServiceDiscoveryState
 public:
     ServiceDiscoveryState();
     ~ServiceDiscoveryState();
-    ServiceDetector* select_detector_by_brute_force(IpProtocol proto, ServiceDiscovery& sd);
+    ServiceDetector* select_detector_by_brute_force(IpProtocol proto, ServiceDiscovery& sd,
+        const uint8_t* data = nullptr, uint16_t size = 0);
     void set_service_id_valid(ServiceDetector* sd);
     void set_service_id_failed(AppIdSession& asd, const snort::SfIp* client_ip,
         unsigned invalid_delta = 0);
@@ -121,9 +122,16 @@ public:
         reset_time = resetTime;
     }
 
+    // key in the shared service state table, 0 if not shared
+    void set_shared_key(uint64_t key)
+    {
+        shared_key = key;
+    }
+
     Queue_t::iterator qptr; // Our place in service_state_queue
 
 private:
+    uint64_t shared_key = 0;
     ServiceState state;
     ServiceDetector* service = nullptr;
     AppIdDetectorList* tcp_brute_force_mgr = nullptr;
@@ -153,6 +161,10 @@ public:
     static void remove(const snort::SfIp*, IpProtocol, uint16_t port, bool decrypted);
     static void check_reset(AppIdSession& asd, const snort::SfIp* ip, uint16_t port);
     static bool prune(size_t max_memory = 0, size_t num_items = -1u);
+
+    // main thread; the shared table lives until pterm and can't be resized
+    static void init_shared(size_t memcap);
+    static void term_shared();
 };
 
 
@@ -193,6 +205,44 @@ private:
 };
 PADDING_GUARD_END
 
+// Valid services shared by all packet threads.  Each thread still keeps its
+// own ServiceDiscoveryState map but a thread that learns a service publishes
+// it here so the other threads can start new states as valid instead of
+// relearning it by port, pattern, or brute force.  The open addressing table
+// of fixed size slots is sized by the memcap; slots are claimed with compare
+// and swap and the least recently touched slot in the probe sequence is
+// replaced when all are taken.  Keys are 64 bit hashes and slot updates are
+// not atomic as a whole so a hit is only a hint that the detector validates.
+struct SharedServiceSlot
+{
+    std::atomic<uint64_t> key;                 // 0 if free
+    std::atomic<ServiceDetector*> service;     // null if retracted
+    std::atomic<uint32_t> touched;             // packet time of last use
+    std::atomic<uint32_t> owner;               // packet thread instance + 1
+};
+
+class SharedServiceState
+{
+public:
+    SharedServiceState(size_t memcap);
+    ~SharedServiceState();
+
+    // other_thread is set if another packet thread published the service
+    ServiceDetector* find(uint64_t key, uint32_t now, bool& other_thread);
+    void add(uint64_t key, ServiceDetector*, uint32_t now);
+    void remove(uint64_t key);
+
+    size_t get_count() const
+    { return mask + 1; }
+
+    static uint64_t hash(const AppIdServiceStateKey&);
+
+    static constexpr unsigned max_probes = 8;
+
+private:
+    SharedServiceSlot* slots;
+    size_t mask;
+};
 
 extern THREAD_LOCAL AppIdStats appid_stats;
 
@@ -208,7 +258,8 @@ public:
             delete kv.second;
     }
 
-    ServiceDiscoveryState* add(const AppIdServiceStateKey& k, bool do_touch = false)
+    ServiceDiscoveryState* add(const AppIdServiceStateKey& k, bool do_touch = false,
+        bool* added = nullptr)
     {
         ServiceDiscoveryState* ss = nullptr;
 
@@ -225,6 +276,9 @@ public:
             ss->qptr = --q.end(); // remember our place in the queue
             appid_stats.service_cache_adds++;
 
+            if ( added )
+                *added = true;
+
             if ( mem_used > memcap )
                 remove( q.front() );
         }
@@ -103,6 +103,10 @@ void IpApi::set(const SfIp& sip, const SfIp& dip)
 
 } // namespace snort
 
+// Stubs for http_match_engine.cc
+HttpMatchEngine::HttpMatchEngine(const char* method) : tool(method, true), canonical(false) {}
+const char* HttpMatchEngine::get_method(const char*) { return "ac_full"; }
+
 // Stubs for publish
 static bool databus_publish_called = false;
 static char test_log[256];
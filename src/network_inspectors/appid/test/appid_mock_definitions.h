@@ -54,6 +54,10 @@ SearchTool::SearchTool(char const*, bool) { }
 SearchTool::~SearchTool() { }
 }
 
+// Stubs for http_match_engine.cc
+HttpMatchEngine::HttpMatchEngine(const char* method) : tool(method, true), canonical(false) { }
+const char* HttpMatchEngine::get_method(const char*) { return "ac_full"; }
+
 AppIdDiscovery::AppIdDiscovery() { }
 AppIdDiscovery::~AppIdDiscovery() { }
 void ClientDiscovery::initialize() { }
@@ -52,6 +52,8 @@ char* snort_strdup(const char* str)
     return p;
 }
 time_t packet_time() { return std::time(0); }
+unsigned instance_id = 0;
+unsigned get_instance_id() { return instance_id; }
 }
 
 // Stubs for AppInfoManager
@@ -234,6 +236,56 @@ TEST(service_state_tests, service_cache)
     CHECK_TRUE( ss->qptr == ServiceCache.newest() );
 }
 
+TEST(service_state_tests, shared_service_cache)
+{
+    SharedServiceState shared(64 * sizeof(SharedServiceSlot));
+    CHECK_TRUE(shared.get_count() == 64);
+
+    SfIp ip4;
+    ip4.set("1.2.3.4");
+    uint64_t key = SharedServiceState::hash(AppIdServiceStateKey(&ip4, IpProtocol::TCP, 80, 0));
+    uint64_t other = SharedServiceState::hash(AppIdServiceStateKey(&ip4, IpProtocol::TCP, 81, 0));
+    CHECK_TRUE(key != other);
+
+    ServiceDetector* sd = (ServiceDetector*)&ip4;
+    bool other_thread = false;
+    CHECK_TRUE(shared.find(key, 1, other_thread) == nullptr);
+
+    instance_id = 1;
+    shared.add(key, sd, 1);
+    CHECK_TRUE(shared.find(key, 2, other_thread) == sd);
+    CHECK_FALSE(other_thread);
+
+    instance_id = 0;
+    CHECK_TRUE(shared.find(key, 3, other_thread) == sd);
+    CHECK_TRUE(other_thread);
+    CHECK_TRUE(shared.find(other, 3, other_thread) == nullptr);
+
+    shared.remove(key);
+    CHECK_TRUE(shared.find(key, 4, other_thread) == nullptr);
+}
+
+TEST(service_state_tests, shared_service_cache_lru)
+{
+    SharedServiceState shared(0);
+    unsigned n = shared.get_count();
+    CHECK_TRUE(n == SharedServiceState::max_probes);
+
+    ServiceDetector* sd = (ServiceDetector*)&shared;
+    bool other_thread;
+
+    // every key collides in the minimum table; the stalest is replaced
+    for ( unsigned i = 1; i <= n; ++i )
+        shared.add(i * n, sd, i);
+
+    CHECK_TRUE(shared.find(n, 100, other_thread) == sd);
+    shared.add((n + 1) * n, sd, 101);
+
+    CHECK_TRUE(shared.find(n, 102, other_thread) == sd);
+    CHECK_TRUE(shared.find(2 * n, 102, other_thread) == nullptr);
+    CHECK_TRUE(shared.find((n + 1) * n, 102, other_thread) == sd);
+}
+
 int main(int argc, char** argv)
 {
     int rc = CommandLineTestRunner::RunAllTests(argc, argv);
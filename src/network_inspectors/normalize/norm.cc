@@ -104,6 +104,9 @@ static const uint8_t MAX_EOL_PAD[TCP_OPTLENMAX] =
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+// big enough for ip4 and tcp headers with options
+#define MAX_NORM_HDR 60
+
 // go from inner to outer
 int Norm_Packet(NormalizerConfig* c, Packet* p)
 {
@@ -112,19 +115,39 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 
     while ( lyr > 0 )
     {
-        ProtocolId proto_id = p->layers[--lyr].prot_id;
-        NormalFunc n = c->normalizers[PacketManager::proto_idx(proto_id)];
+        const Layer& l = p->layers[--lyr];
+        NormalFunc n = c->normalizers[PacketManager::proto_idx(l.prot_id)];
+
+        if ( !n )
+            continue;
+
+        // normalizations only touch the layer header, so keep a copy for
+        // an incremental checksum update
+        uint8_t old[MAX_NORM_HDR];
+        const bool copied = (l.length <= sizeof(old));
+
+        if ( copied )
+            memcpy(old, l.start, l.length);
 
-        if ( n )
-            changes = n(c, p, lyr, changes);
+        int prev = changes;
+        changes = n(c, p, lyr, changes);
+
+        if ( changes > prev )
+        {
+            if ( copied )
+                PacketManager::encode_rewrite(p, l.start, old, l.length);
+            else
+                p->packet_flags |= PKT_MODIFIED;
+        }
     }
 
     if ( changes > 0 )
     {
-        p->packet_flags |= PKT_MODIFIED;
+        if ( p->packet_flags & PKT_RESIZED )
+            p->packet_flags |= PKT_MODIFIED;
         return 1;
     }
-    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED) )
+    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED|PKT_CKSUM_UPDATED) )
     {
         return 1;
     }
@@ -137,9 +160,10 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 // avoided to ensure that we don't get tripped up by nested protocols.
 // TCP options count and length are a notable exception.
 //
-// also note that checksums are not calculated here.  they are only
-// calculated once after all normalizations are done (here, stream)
-// and any replacements are made.
+// also note that checksums are not calculated here.  they are updated
+// incrementally by encode_rewrite when possible, otherwise calculated
+// once after all normalizations are done (here, stream) and any
+// replacements are made.
 //-----------------------------------------------------------------------
 
 #if 0
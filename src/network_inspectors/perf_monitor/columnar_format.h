@@ -0,0 +1,420 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar_format.h
+
+#ifndef COLUMNAR_FORMAT_H
+#define COLUMNAR_FORMAT_H
+
+// The columnar perf_monitor file format.  This is shared by the formatter
+// and by tools/columnar/pcolstreamer so it may only depend on the STL.
+//
+// file:   "SPCF", u32 schema size, schema, records, optional index
+// schema: one "<type> <section>.<field>\n" line per column where type is
+//         pc (peg count), s (string), or ipc (indexed peg counts)
+// record: u64 timestamp, u32 body size, body
+// body:   u8 flags, then one value per column in schema order:
+//         pc  - zigzag varint delta from the prior record
+//         s   - varint length and bytes
+//         ipc - varint size, varint number of changed entries, then the
+//               varint index gap and zigzag varint delta of each
+// index:  u64 timestamp and u64 file offset of each key record,
+//         u32 number of entries, "SPCI"
+//
+// Fixed size integers are big endian.  Key records are delta encoded from
+// zero so decoding can start at any key record; the index written when the
+// file is closed or rotated locates them without scanning.  Files that were
+// not closed cleanly have no index and are decoded from the start.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace columnar
+{
+static const char file_magic[] = "SPCF";
+static const char index_magic[] = "SPCI";
+
+constexpr uint8_t KEY_RECORD = 0x01;
+constexpr unsigned key_interval = 64;
+constexpr unsigned record_header_size = 12;
+constexpr unsigned index_entry_size = 16;
+constexpr unsigned index_trailer_size = 8;
+constexpr uint64_t max_indexed = 1 << 24;
+
+enum ColumnType : uint8_t
+{
+    CT_PEG,
+    CT_STRING,
+    CT_INDEXED
+};
+
+inline const char* get_type_name(ColumnType t)
+{
+    switch ( t )
+    {
+    case CT_PEG: return "pc";
+    case CT_STRING: return "s";
+    case CT_INDEXED: return "ipc";
+    }
+    return "";
+}
+
+//-------------------------------------------------------------------------
+// encoding
+//-------------------------------------------------------------------------
+
+inline uint64_t zigzag(uint64_t delta)
+{ return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63); }
+
+inline uint64_t unzigzag(uint64_t v)
+{ return (v >> 1) ^ (~(v & 1) + 1); }
+
+inline void put_varint(std::string& out, uint64_t v)
+{
+    while ( v >= 0x80 )
+    {
+        out += (char)(v | 0x80);
+        v >>= 7;
+    }
+    out += (char)v;
+}
+
+inline void put_u32(std::string& out, uint32_t v)
+{
+    for ( int shift = 24; shift >= 0; shift -= 8 )
+        out += (char)(v >> shift);
+}
+
+inline void put_u64(std::string& out, uint64_t v)
+{
+    for ( int shift = 56; shift >= 0; shift -= 8 )
+        out += (char)(v >> shift);
+}
+
+//-------------------------------------------------------------------------
+// decoding
+//-------------------------------------------------------------------------
+
+class Cursor
+{
+public:
+    Cursor(const uint8_t* p, size_t len) : pos(p), end(p + len) { }
+
+    bool get_varint(uint64_t& v)
+    {
+        v = 0;
+
+        for ( unsigned shift = 0; shift < 64 and pos < end; shift += 7 )
+        {
+            uint8_t b = *pos++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+
+            if ( !(b & 0x80) )
+                return true;
+        }
+        return false;
+    }
+
+    bool get_u32(uint32_t& v)
+    {
+        uint64_t u;
+
+        if ( !get_fixed(u, 4) )
+            return false;
+
+        v = (uint32_t)u;
+        return true;
+    }
+
+    bool get_u64(uint64_t& v)
+    { return get_fixed(v, 8); }
+
+    bool get_bytes(const uint8_t*& p, size_t n)
+    {
+        if ( (size_t)(end - pos) < n )
+            return false;
+
+        p = pos;
+        pos += n;
+        return true;
+    }
+
+    const uint8_t* get_pos() const
+    { return pos; }
+
+    size_t remaining() const
+    { return end - pos; }
+
+private:
+    bool get_fixed(uint64_t& v, unsigned n)
+    {
+        if ( (size_t)(end - pos) < n )
+            return false;
+
+        v = 0;
+
+        while ( n-- )
+            v = (v << 8) | *pos++;
+
+        return true;
+    }
+
+    const uint8_t* pos;
+    const uint8_t* end;
+};
+
+struct Column
+{
+    ColumnType type;
+    std::string name;
+
+    // current value
+    uint64_t peg = 0;
+    std::string str;
+    std::vector<uint64_t> vec;
+};
+
+// Decodes a file held in memory, typically mapped with mmap.  The buffer
+// must remain valid while the reader is in use.
+class Reader
+{
+public:
+    bool open(const uint8_t* buf, size_t len)
+    {
+        base = buf;
+        size = len;
+        columns.clear();
+        index.clear();
+
+        Cursor c(buf, len);
+        const uint8_t* magic;
+        uint32_t schema_size;
+        const uint8_t* schema;
+
+        if ( !c.get_bytes(magic, 4) or memcmp(magic, file_magic, 4) or
+            !c.get_u32(schema_size) or !c.get_bytes(schema, schema_size) or
+            !parse_schema((const char*)schema, schema_size) )
+            return false;
+
+        data = c.get_pos() - base;
+        limit = size;
+        load_index();
+        rewind();
+        return true;
+    }
+
+    const std::vector<Column>& get_columns() const
+    { return columns; }
+
+    bool has_index() const
+    { return !index.empty(); }
+
+    void rewind()
+    { next_record = data; }
+
+    // position at the last key record at or before the given time so
+    // that decoding is as short as possible
+    void seek(uint64_t timestamp)
+    {
+        rewind();
+
+        for ( const auto& e : index )
+        {
+            if ( e.timestamp > timestamp )
+                break;
+
+            next_record = e.offset;
+        }
+    }
+
+    // false at the end of the data or if the record is corrupt
+    bool next(uint64_t& timestamp)
+    {
+        Cursor c(base + next_record, limit - next_record);
+        uint32_t body_size;
+        const uint8_t* body;
+
+        if ( !c.get_u64(timestamp) or !c.get_u32(body_size) or
+            !c.get_bytes(body, body_size) )
+            return false;
+
+        next_record = c.get_pos() - base;
+        return decode(body, body_size);
+    }
+
+private:
+    struct IndexEntry
+    {
+        uint64_t timestamp;
+        uint64_t offset;
+    };
+
+    bool parse_schema(const char* s, size_t len)
+    {
+        std::string schema(s, len);
+        size_t start = 0;
+
+        while ( start < schema.size() )
+        {
+            size_t eol = schema.find('\n', start);
+            size_t sp = schema.find(' ', start);
+
+            if ( eol == std::string::npos or sp == std::string::npos or sp > eol )
+                return false;
+
+            std::string type = schema.substr(start, sp - start);
+            Column col;
+
+            if ( type == "pc" )
+                col.type = CT_PEG;
+            else if ( type == "s" )
+                col.type = CT_STRING;
+            else if ( type == "ipc" )
+                col.type = CT_INDEXED;
+            else
+                return false;
+
+            col.name = schema.substr(sp + 1, eol - sp - 1);
+            columns.emplace_back(col);
+            start = eol + 1;
+        }
+        return true;
+    }
+
+    void load_index()
+    {
+        if ( size < data + index_trailer_size )
+            return;
+
+        Cursor t(base + size - index_trailer_size, index_trailer_size);
+        uint32_t num;
+        const uint8_t* magic;
+
+        if ( !t.get_u32(num) or !t.get_bytes(magic, 4) or memcmp(magic, index_magic, 4) )
+            return;
+
+        uint64_t len = (uint64_t)num * index_entry_size + index_trailer_size;
+
+        if ( !num or size - data < len )
+            return;
+
+        size_t start = size - len;
+        Cursor c(base + start, len - index_trailer_size);
+        std::vector<IndexEntry> entries(num);
+
+        for ( auto& e : entries )
+        {
+            c.get_u64(e.timestamp);
+            c.get_u64(e.offset);
+
+            if ( e.offset < data or e.offset >= start )
+                return;
+        }
+        if ( entries[0].offset != data )
+            return;
+
+        index.swap(entries);
+        limit = start;
+    }
+
+    bool decode(const uint8_t* body, size_t len)
+    {
+        Cursor c(body, len);
+        const uint8_t* flags;
+
+        if ( !c.get_bytes(flags, 1) )
+            return false;
+
+        if ( *flags & KEY_RECORD )
+        {
+            for ( auto& col : columns )
+            {
+                col.peg = 0;
+                col.vec.assign(col.vec.size(), 0);
+            }
+        }
+
+        for ( auto& col : columns )
+        {
+            uint64_t v;
+
+            switch ( col.type )
+            {
+            case CT_PEG:
+                if ( !c.get_varint(v) )
+                    return false;
+
+                col.peg += unzigzag(v);
+                break;
+
+            case CT_STRING:
+            {
+                const uint8_t* p;
+
+                if ( !c.get_varint(v) or !c.get_bytes(p, v) )
+                    return false;
+
+                col.str.assign((const char*)p, v);
+                break;
+            }
+            case CT_INDEXED:
+            {
+                uint64_t n;
+
+                if ( !c.get_varint(v) or !c.get_varint(n) or v > max_indexed )
+                    return false;
+
+                col.vec.resize(v);
+                uint64_t idx = 0;
+
+                for ( uint64_t i = 0; i < n; ++i )
+                {
+                    uint64_t gap, delta;
+
+                    if ( !c.get_varint(gap) or !c.get_varint(delta) )
+                        return false;
+
+                    idx += gap;
+
+                    if ( idx >= col.vec.size() )
+                        return false;
+
+                    col.vec[idx++] += unzigzag(delta);
+                }
+                break;
+            }
+            }
+        }
+        return true;
+    }
+
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    size_t data = 0;
+    size_t limit = 0;
+    size_t next_record = 0;
+
+    std::vector<Column> columns;
+    std::vector<IndexEntry> index;
+};
+}
+
+#endif
+
@@ -0,0 +1,64 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar_formatter.h
+
+#ifndef COLUMNAR_FORMATTER_H
+#define COLUMNAR_FORMATTER_H
+
+// writes each peg once per file in the schema and then only varint deltas
+// per record.  see columnar_format.h for the layout.
+
+#include "perf_formatter.h"
+
+class ColumnarFormatter : public PerfFormatter
+{
+public:
+    using PerfFormatter::PerfFormatter;
+
+    const char* get_extension() override
+    { return ".pcol"; }
+
+    bool allow_append() override
+    { return false; }
+
+    void finalize_fields() override;
+    void init_output(FILE*) override;
+    void write(FILE*, time_t) override;
+    void finalize_output(FILE*) override;
+
+private:
+    struct IndexEntry
+    {
+        uint64_t timestamp;
+        uint64_t offset;
+    };
+
+    std::string schema;
+    std::string record;
+    std::string changes;
+
+    std::vector<PegCount> last_pegs;
+    std::vector<std::vector<PegCount>> last_vecs;
+    std::vector<IndexEntry> index;
+
+    unsigned num_records = 0;
+};
+
+#endif
+
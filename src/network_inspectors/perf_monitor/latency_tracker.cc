@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// latency_tracker.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "latency_tracker.h"
+
+#include "profiler/tail_latency.h"
+
+#define TRACKER_NAME PERF_NAME "_latency"
+
+using namespace snort;
+
+LatencyTracker::LatencyTracker(PerfConfig* perf) : PerfTracker(perf, TRACKER_NAME)
+{
+    unsigned num = TailLatency::get_num_ids();
+
+    // field pointers must remain valid
+    stats.resize(num);
+    last.reset(new LatencyHistogram[num]);
+    interval.reset(new LatencyHistogram);
+
+    for ( unsigned id = 0; id < num; ++id )
+    {
+        Stats& s = stats[id];
+        formatter->register_section(TailLatency::get_name(id));
+        formatter->register_field("count", &s.count);
+        formatter->register_field("p50_ns", &s.p50);
+        formatter->register_field("p99_ns", &s.p99);
+        formatter->register_field("p999_ns", &s.p999);
+        formatter->register_field("max_ns", &s.max);
+    }
+    formatter->finalize_fields();
+}
+
+LatencyTracker::~LatencyTracker() = default;
+
+void LatencyTracker::reset()
+{
+    for ( unsigned id = 0; id < stats.size(); ++id )
+    {
+        if ( const LatencyHistogram* h = TailLatency::find(id) )
+            last[id].set(*h);
+    }
+}
+
+void LatencyTracker::process(bool)
+{
+    for ( unsigned id = 0; id < stats.size(); ++id )
+    {
+        const LatencyHistogram* h = TailLatency::find(id);
+        Stats& s = stats[id];
+
+        if ( !h )
+        {
+            s = { };
+            continue;
+        }
+        interval->set(*h);
+        interval->sub(last[id]);
+        last[id].set(*h);
+
+        s.count = interval->get_count();
+        s.p50 = TailLatency::get_nsecs(interval->get_percentile(50));
+        s.p99 = TailLatency::get_nsecs(interval->get_percentile(99));
+        s.p999 = TailLatency::get_nsecs(interval->get_percentile(99.9));
+        s.max = TailLatency::get_nsecs(interval->get_percentile(100));
+    }
+    write();
+}
+
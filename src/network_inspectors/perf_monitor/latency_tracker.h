@@ -1,5 +1,5 @@
 //--------------------------------------------------------------------------
-// Copyright (C) 2019-2020 Cisco and/or its affiliates. All rights reserved.
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
 //
 // This program is free software; you can redistribute it and/or modify it
 // under the terms of the GNU General Public License Version 2 as published
@@ -15,43 +15,49 @@
 // with this program; if not, write to the Free Software Foundation, Inc.,
 // 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 //--------------------------------------------------------------------------
-// http2_huffman_state_machine.h author Maya Dagon <mdagon@cisco.com>
 
-#ifndef HTTP2_HUFFMAN_STATE_MACHINE_H
-#define HTTP2_HUFFMAN_STATE_MACHINE_H
+// latency_tracker.h
 
-#include "main/snort_types.h"
+#ifndef LATENCY_TRACKER_H
+#define LATENCY_TRACKER_H
 
-enum HuffmanState
+// reports interval percentiles of the TailLatency histograms kept by this
+// packet thread.  the set of histograms is fixed when the tracker is
+// created so inspectors added by a later reload are not reported.
+
+#include <memory>
+#include <vector>
+
+#include "perf_tracker.h"
+
+namespace snort
 {
-    HUFFMAN_LOOKUP_1 = 0,
-    HUFFMAN_LOOKUP_2 = 1,
-    HUFFMAN_LOOKUP_3 = 2,
-    HUFFMAN_LOOKUP_4 = 3,
-    HUFFMAN_LOOKUP_5 = 4,
-    HUFFMAN_LOOKUP_6 = 5,
-    HUFFMAN_LOOKUP_7 = 6,
-    HUFFMAN_LOOKUP_8 = 7,
-    HUFFMAN_LOOKUP_9 = 8,
-    HUFFMAN_LOOKUP_10 = 9,
-    HUFFMAN_LOOKUP_11 = 10,
-    HUFFMAN_LOOKUP_12 = 11,
-    HUFFMAN_LOOKUP_13 = 12,
-    HUFFMAN_LOOKUP_14 = 13,
-    HUFFMAN_LOOKUP_15 = 14,
-    HUFFMAN_LOOKUP_MAX = HUFFMAN_LOOKUP_15,
-    HUFFMAN_MATCH = HUFFMAN_LOOKUP_MAX + 1,
-    HUFFMAN_FAILURE = HUFFMAN_MATCH + 1
-};
+class LatencyHistogram;
+}
 
-struct HuffmanEntry
+class LatencyTracker : public PerfTracker
 {
-    uint8_t len;
-    char symbol;
-    HuffmanState state;
-};
+public:
+    LatencyTracker(PerfConfig*);
+    ~LatencyTracker() override;
+
+    void reset() override;
+    void process(bool) override;
 
-extern const HuffmanEntry huffman_decode[][UINT8_MAX+1];
+private:
+    struct Stats
+    {
+        PegCount count;
+        PegCount p50;
+        PegCount p99;
+        PegCount p999;
+        PegCount max;
+    };
+
+    std::vector<Stats> stats;
+    std::unique_ptr<snort::LatencyHistogram[]> last;
+    std::unique_ptr<snort::LatencyHistogram> interval;
+};
 
 #endif
 
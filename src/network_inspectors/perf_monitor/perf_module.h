@@ -39,6 +39,7 @@
 #define PERF_BASE_MAX   0x00000010
 #define PERF_FLOWIP     0x00000020
 #define PERF_SUMMARY    0x00000040
+#define PERF_LATENCY    0x00000080
 
 #define ROLLOVER_THRESH     512
 #define MAX_PERF_FILE_SIZE  UINT64_MAX
@@ -49,6 +50,7 @@ enum class PerfFormat
     CSV,
     TEXT,
     JSON,
+    COLUMNAR,
     FBS,
     MOCK
 };
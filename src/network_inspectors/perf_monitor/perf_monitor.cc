@@ -40,6 +40,7 @@
 #include "cpu_tracker.h"
 #include "flow_ip_tracker.h"
 #include "flow_tracker.h"
+#include "latency_tracker.h"
 #include "perf_module.h"
 
 
@@ -172,6 +173,8 @@ void PerfMonitor::show(SnortConfig*)
     }
     LogMessage("  CPU Stats:    %s\n",
         (config->perf_flags & PERF_CPU) ? "ACTIVE" : "INACTIVE");
+    LogMessage("  Latency Stats:    %s\n",
+        (config->perf_flags & PERF_LATENCY) ? "ACTIVE" : "INACTIVE");
     switch ( config->output )
     {
         case PerfOutput::TO_CONSOLE:
@@ -192,6 +195,9 @@ void PerfMonitor::show(SnortConfig*)
         case PerfFormat::JSON:
             LogMessage("    Output Format:  json\n");
             break;
+        case PerfFormat::COLUMNAR:
+            LogMessage("    Output Format:  columnar\n");
+            break;
 #ifdef HAVE_FLATBUFFERS
         case PerfFormat::FBS:
             LogMessage("    Output Format:  flatbuffers\n");
@@ -248,6 +254,9 @@ void PerfMonitor::tinit()
     if (config->perf_flags & PERF_CPU )
         trackers->emplace_back(new CPUTracker(config));
 
+    if (config->perf_flags & PERF_LATENCY )
+        trackers->emplace_back(new LatencyTracker(config));
+
     for (unsigned i = 0; i < trackers->size(); i++)
     {
         if (!(*trackers)[i]->open(true))
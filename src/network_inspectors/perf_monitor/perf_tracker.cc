@@ -37,6 +37,7 @@
 #include "fbs_formatter.h"
 #endif
 
+#include "columnar_formatter.h"
 #include "csv_formatter.h"
 #include "json_formatter.h"
 #include "text_formatter.h"
@@ -60,6 +61,9 @@ static inline bool check_file_size(FILE* fh, uint64_t max_file_size)
     return false;
 }
 
+static bool rotate_file(const char* old_file, FILE* old_fh,
+    uint32_t max_file_size, bool append);
+
 PerfTracker::PerfTracker(PerfConfig* config, const char* tracker_name)
 {
     max_file_size = config->max_file_size;
@@ -69,6 +73,7 @@ PerfTracker::PerfTracker(PerfConfig* config, const char* tracker_name)
         case PerfFormat::CSV: formatter = new CSVFormatter(tracker_name); break;
         case PerfFormat::TEXT: formatter = new TextFormatter(tracker_name); break;
         case PerfFormat::JSON: formatter = new JSONFormatter(tracker_name); break;
+        case PerfFormat::COLUMNAR: formatter = new ColumnarFormatter(tracker_name); break;
 #ifdef HAVE_FLATBUFFERS
         case PerfFormat::FBS: formatter = new FbsFormatter(tracker_name); break;
 #endif
@@ -148,8 +153,14 @@ bool PerfTracker::open(bool append)
         }
 
         // FIXIT-L refactor rotation so it doesn't require an open file handle
+        // the existing file was finalized when it was closed
         if (existed && append && !formatter->allow_append())
-            return rotate();
+        {
+            if (!rotate_file(fname.c_str(), fh, max_file_size, false))
+                return false;
+
+            return open(false);
+        }
     }
     else
         fh = stdout;
@@ -162,7 +173,7 @@ bool PerfTracker::open(bool append)
 // FIXIT-M combine with fileRotate
 // FIXIT-M refactor file naming foo to use std::string
 static bool rotate_file(const char* old_file, FILE* old_fh,
-    uint32_t max_file_size)
+    uint32_t max_file_size, bool append)
 {
     time_t ts;
     char rotate_file[PATH_MAX];
@@ -202,6 +213,27 @@ static bool rotate_file(const char* old_file, FILE* old_fh,
                 old_file, rotate_file, get_error(errno));
         }
     }
+    // Binary formats can't be concatenated so use the next free index
+    else if (!append)
+    {
+        char rotate_file_with_index[PATH_MAX];
+        int rotate_index = 0;
+
+        do
+        {
+            rotate_index++;
+            SnortSnprintf(rotate_file_with_index, PATH_MAX, "%s.%02d",
+                rotate_file, rotate_index);
+        }
+        while (stat(rotate_file_with_index, &fstats) == 0);
+
+        if (rename(old_file, rotate_file_with_index) != 0)
+        {
+            ErrorMessage("Perfmonitor: Could not rename performance stats "
+                "file from \"%s\" to \"%s\": %s.\n",
+                old_file, rotate_file_with_index, get_error(errno));
+        }
+    }
     else  // Otherwise, if it does exist, append data from current stats file to it
     {
         char read_buf[4096];
@@ -342,7 +374,9 @@ bool PerfTracker::rotate()
 {
     if (fh && fh != stdout)
     {
-        if (!rotate_file(fname.c_str(), fh, max_file_size))
+        formatter->finalize_output(fh);
+
+        if (!rotate_file(fname.c_str(), fh, max_file_size, formatter->allow_append()))
             return false;
 
         return open(false);
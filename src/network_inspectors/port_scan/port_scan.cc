@@ -26,11 +26,13 @@
 
 #include "detection/detection_engine.h"
 #include "log/messages.h"
+#include "main/snort_config.h"
 #include "managers/inspector_manager.h"
 #include "profiler/profiler.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
+#include "ps_global.h"
 #include "ps_inspect.h"
 #include "ps_module.h"
 
@@ -363,7 +365,14 @@ static void PrintPortscanConf(PortscanConfig* config)
 
     LogMessage("%s\n", buf);
     LogMessage("    Memcap (in bytes): %zu\n", config->memcap);
-    LogMessage("    Number of Nodes:   %zu\n", config->memcap / ps_node_size());
+
+    if ( config->global )
+    {
+        LogMessage("    Global:            %s\n", "yes");
+        LogMessage("    Number of Nodes:   %zu\n", config->memcap / PsGlobal::sketch_size());
+    }
+    else
+        LogMessage("    Number of Nodes:   %zu\n", config->memcap / ps_node_size());
 
     if ( config->logfile )
         LogMessage("    Logfile:           %s\n", "yes");
@@ -409,17 +418,40 @@ static void PrintPortscanConf(PortscanConfig* config)
 PortScan::PortScan(PortScanModule* mod)
 {
     config = mod->get_data();
+
+    if ( config->global )
+    {
+        global = new PsGlobal(config->memcap);
+
+        // nothing to evaluate when just checking the config
+        if ( !SnortConfig::test_mode() )
+            evaluator = new std::thread(&PortScan::ps_global_run, this);
+    }
 }
 
 PortScan::~PortScan()
 {
+    if ( evaluator )
+    {
+        {
+            std::lock_guard<std::mutex> lock(eval_mutex);
+            eval_stop = true;
+        }
+        eval_cond.notify_one();
+        evaluator->join();
+        delete evaluator;
+    }
+
+    delete global;
+
     if ( config )
         delete config;
 }
 
 void PortScan::tinit()
 {
-    ps_init_hash(config->memcap);
+    if ( !global )
+        ps_init_hash(config->memcap);
 }
 
 void PortScan::tterm()
@@ -427,6 +459,97 @@ void PortScan::tterm()
     ps_cleanup();
 }
 
+//-------------------------------------------------------------------------
+// global mode
+//-------------------------------------------------------------------------
+
+// apply the configured thresholds to each active sketch and flag those
+// that should alert; packet threads raise the flagged alerts
+void PortScan::ps_global_eval()
+{
+    PsSketch* sketches = global->get_sketches();
+    time_t now = global->get_time();
+
+    for ( size_t i = 0; i < global->get_count(); ++i )
+    {
+        PsSketch& sk = sketches[i];
+
+        if ( !sk.key.load(std::memory_order_acquire) )
+            continue;
+
+        uint8_t alerts = sk.alerts.load(std::memory_order_relaxed);
+
+        if ( alerts and !(config->alert_all and alerts == PS_ALERT_GENERATED) )
+            continue;
+
+        PS_PROTO proto;
+        global->get_proto(&sk, proto);
+
+        if ( proto.window < now )
+            continue;
+
+        PS_PROTO* scanner = sk.is_scanner ? &proto : nullptr;
+        PS_PROTO* scanned = sk.is_scanner ? nullptr : &proto;
+
+        switch ( sk.protocol )
+        {
+        case PS_PROTO_TCP:
+            ps_alert_tcp(scanner, scanned);
+            break;
+
+        case PS_PROTO_UDP:
+            ps_alert_udp(scanner, scanned);
+            break;
+
+        case PS_PROTO_ICMP:
+            ps_alert_icmp(scanner, scanned);
+            break;
+
+        case PS_PROTO_IP:
+            ps_alert_ip(scanner, scanned);
+            break;
+        }
+
+        if ( proto.alerts )
+            sk.alerts.compare_exchange_strong(alerts, proto.alerts);
+    }
+}
+
+void PortScan::ps_global_run()
+{
+    std::unique_lock<std::mutex> lock(eval_mutex);
+
+    while ( !eval_stop )
+    {
+        eval_cond.wait_for(lock, std::chrono::seconds(1));
+
+        if ( !eval_stop )
+            ps_global_eval();
+    }
+}
+
+// claim a pending alert from the sketch and copy it to the scratch tracker
+void PortScan::ps_global_alert(PS_TRACKER* tracker, const SfIp* peer)
+{
+    if ( !tracker )
+        return;
+
+    PsSketch* sk = tracker->proto.sketch;
+    uint8_t alerts = sk->alerts.load(std::memory_order_relaxed);
+
+    if ( !alerts or alerts == PS_ALERT_GENERATED or
+        !sk->alerts.compare_exchange_strong(alerts, PS_ALERT_GENERATED) )
+        return;
+
+    global->get_proto(sk, tracker->proto);
+    tracker->proto.sketch = sk;
+    tracker->proto.alerts = alerts;
+
+    // only the packet's peer is known; sketches don't keep address ranges
+    tracker->proto.low_ip = *peer;
+    tracker->proto.high_ip = *peer;
+}
+
 void PortScan::show(SnortConfig*)
 {
     PrintPortscanConf(config);
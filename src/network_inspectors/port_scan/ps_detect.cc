@@ -44,6 +44,7 @@
 #include "utils/cpp_macros.h"
 #include "utils/stats.h"
 
+#include "ps_global.h"
 #include "ps_inspect.h"
 #include "ps_pegs.h"
 
@@ -313,6 +314,26 @@ static PS_TRACKER* ps_tracker_get(PS_HASH_KEY* key)
     return ht;
 }
 
+/*
+**  In global mode the tracker is a scratch copy that just refers to the
+**  shared sketch; updates go to the sketch and only the alert is copied
+**  back when one is raised.
+*/
+static PS_TRACKER* ps_global_get(
+    PsGlobal* global, PS_HASH_KEY* key, PS_TRACKER& tracker, bool scanner)
+{
+    PsSketch* sketch = global->get(key, sizeof(*key), key->protocol, scanner, packet_time());
+
+    if ( !sketch )
+        return nullptr;
+
+    memset(&tracker, 0, sizeof(tracker));
+    tracker.protocol = key->protocol;
+    tracker.proto.sketch = sketch;
+
+    return &tracker;
+}
+
 bool PortScan::ps_tracker_lookup(
     PS_PKT* ps_pkt, PS_TRACKER** scanner, PS_TRACKER** scanned)
 {
@@ -338,7 +359,8 @@ bool PortScan::ps_tracker_lookup(
         else
             key.scanned = *p->ptrs.ip_api.get_dst();
 
-        *scanned = ps_tracker_get(&key);
+        *scanned = global ? ps_global_get(global, &key, ps_pkt->shared[0], false) :
+            ps_tracker_get(&key);
     }
 
     //  Let's lookup the host that is scanning.
@@ -351,7 +373,8 @@ bool PortScan::ps_tracker_lookup(
         else
             key.scanner = *p->ptrs.ip_api.get_src();
 
-        *scanner = ps_tracker_get(&key);
+        *scanner = global ? ps_global_get(global, &key, ps_pkt->shared[1], true) :
+            ps_tracker_get(&key);
     }
 
     return *scanner or *scanned;
@@ -447,6 +470,12 @@ int PortScan::ps_proto_update(PS_PROTO* proto, int ps_cnt, int pri_cnt,
     if (!proto)
         return 0;
 
+    if ( proto->sketch )
+    {
+        global->update(proto->sketch, ps_cnt, pri_cnt, window, ip, port, pkt_time);
+        return 0;
+    }
+
     /*
     **  If the ps_cnt is negative, that means we are just taking off
     **  for valid connection, and we don't want to do anything else,
@@ -1138,6 +1167,21 @@ void PortScan::ps_alert_icmp(PS_PROTO* scanner, PS_PROTO* scanned)
 bool PortScan::ps_tracker_alert(
     PS_PKT* ps_pkt, PS_TRACKER* scanner, PS_TRACKER* scanned)
 {
+    if ( global )
+    {
+        // alerts are determined by the evaluator thread
+        const Packet* p = ps_pkt->pkt;
+        const SfIp* src = p->ptrs.ip_api.get_src();
+        const SfIp* dst = p->ptrs.ip_api.get_dst();
+
+        if ( ps_pkt->reverse_pkt )
+            std::swap(src, dst);
+
+        ps_global_alert(scanner, dst);
+        ps_global_alert(scanned, src);
+        return true;
+    }
+
     PS_PROTO* scanner_proto = nullptr;
     PS_PROTO* scanned_proto = nullptr;
 
@@ -31,6 +31,7 @@ namespace snort
 {
 struct Packet;
 }
+struct PsSketch;
 
 #define PS_OPEN_PORTS 8
 
@@ -86,6 +87,7 @@ struct PortscanConfig
 
     bool alert_all;
     bool logfile;
+    bool global;
 
     unsigned tcp_window;
     unsigned udp_window;
@@ -138,6 +140,9 @@ struct PS_PROTO
     unsigned char alerts;
 
     time_t window;
+
+    // set when this is a copy of a shared tracker (port_scan.global)
+    PsSketch* sketch;
 };
 
 struct PS_TRACKER
@@ -157,6 +162,9 @@ struct PS_PKT
     int proto;
     int reverse_pkt;
 
+    // scratch trackers used with port_scan.global
+    PS_TRACKER shared[2];
+
     PS_PKT(snort::Packet*);
 };
 
@@ -0,0 +1,414 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ps_global.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ps_global.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "main/thread.h"
+#include "sfip/sf_ip.h"
+
+#include "ps_detect.h"
+#include "ps_pegs.h"
+
+#ifdef UNIT_TEST
+#include <thread>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+extern THREAD_LOCAL PsPegStats spstats;
+
+// number of slots to check before giving up on a key
+#define PS_PROBES 8
+
+// sketches not updated for this many seconds may be reused
+#define PS_IDLE 60
+
+static uint64_t hash_bytes(const void* pv, size_t len)
+{
+    // fnv-1a
+    const uint8_t* p = (const uint8_t*)pv;
+    uint64_t h = 0xcbf29ce484222325;
+
+    for ( size_t i = 0; i < len; ++i )
+    {
+        h ^= p[i];
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+static uint64_t mix(uint64_t h)
+{
+    // splitmix64 finalizer; spreads fnv output across all bits for hll
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111eb;
+    h ^= h >> 31;
+    return h;
+}
+
+PsGlobal::PsGlobal(size_t memcap)
+{
+    num_sketches = memcap / sizeof(PsSketch);
+
+    if ( num_sketches < PS_PROBES )
+        num_sketches = PS_PROBES;
+
+    sketches = new PsSketch[num_sketches]();
+    latest = 0;
+}
+
+PsGlobal::~PsGlobal()
+{ delete[] sketches; }
+
+void PsGlobal::reset(PsSketch* s, time_t now)
+{
+    const auto r = std::memory_order_relaxed;
+
+    s->touched.store(now, r);
+    s->window.store(0, r);
+    s->connection_count.store(0, r);
+    s->priority_count.store(0, r);
+    s->low_p.store(0, r);
+    s->high_p.store(0, r);
+    s->alerts.store(0, r);
+
+    for ( unsigned i = 0; i < PS_HLL_REGS; ++i )
+    {
+        s->ip_regs[i].store(0, r);
+        s->port_regs[i].store(0, r);
+    }
+}
+
+PsSketch* PsGlobal::get(const void* pv, size_t len, int protocol, bool scanner, time_t now)
+{
+    uint64_t key = hash_bytes(pv, len);
+
+    if ( !key )
+        key = 1;
+
+    if ( now > latest.load(std::memory_order_relaxed) )
+        latest.store(now, std::memory_order_relaxed);
+
+    size_t idx = key % num_sketches;
+    PsSketch* idle = nullptr;
+
+    for ( unsigned i = 0; i < PS_PROBES; ++i )
+    {
+        PsSketch* s = sketches + (idx + i) % num_sketches;
+        uint64_t k = s->key.load(std::memory_order_acquire);
+
+        if ( k == key )
+            return s;
+
+        if ( !k )
+        {
+            if ( s->key.compare_exchange_strong(k, key) )
+            {
+                reset(s, now);
+                s->protocol.store(protocol, std::memory_order_relaxed);
+                s->is_scanner.store(scanner, std::memory_order_relaxed);
+                ++spstats.sketches;
+                return s;
+            }
+            if ( k == key )
+                return s;
+        }
+        else if ( !idle and now - s->touched.load(std::memory_order_relaxed) > PS_IDLE )
+            idle = s;
+    }
+
+    if ( idle )
+    {
+        uint64_t k = idle->key.load(std::memory_order_acquire);
+
+        if ( k != key and idle->key.compare_exchange_strong(k, key) )
+        {
+            reset(idle, now);
+            idle->protocol.store(protocol, std::memory_order_relaxed);
+            idle->is_scanner.store(scanner, std::memory_order_relaxed);
+            ++spstats.sketches;
+            return idle;
+        }
+    }
+    ++spstats.sketch_full;
+    return nullptr;
+}
+
+void PsGlobal::add(std::atomic<uint8_t>* regs, uint64_t h)
+{
+    std::atomic<uint8_t>& reg = regs[h >> (64 - PS_HLL_BITS)];
+
+    // position of the first 1 bit in the remaining bits; the low sentinel
+    // bit bounds the rank
+    uint64_t w = (h << PS_HLL_BITS) | (1 << (PS_HLL_BITS - 1));
+    uint8_t rank = __builtin_clzll(w) + 1;
+    uint8_t cur = reg.load(std::memory_order_relaxed);
+
+    while ( rank > cur and !reg.compare_exchange_weak(cur, rank, std::memory_order_relaxed) );
+}
+
+unsigned PsGlobal::estimate(const std::atomic<uint8_t>* regs)
+{
+    const double m = PS_HLL_REGS;
+    const double alpha = 0.709;  // for m = 64
+
+    double sum = 0;
+    unsigned zeros = 0;
+
+    for ( unsigned i = 0; i < PS_HLL_REGS; ++i )
+    {
+        uint8_t r = regs[i].load(std::memory_order_relaxed);
+        sum += std::ldexp(1.0, -r);
+
+        if ( !r )
+            ++zeros;
+    }
+    double e = alpha * m * m / sum;
+
+    // small range correction (linear counting)
+    if ( e <= 2.5 * m and zeros )
+        e = m * std::log(m / zeros);
+
+    return (unsigned)(e + 0.5);
+}
+
+void PsGlobal::update(PsSketch* s, int ps_cnt, int pri_cnt, unsigned interval,
+    const SfIp* ip, unsigned short port, time_t now)
+{
+    const auto r = std::memory_order_relaxed;
+    s->touched.store(latest.load(r), r);
+
+    if ( ps_cnt < 0 )
+    {
+        int32_t c = s->connection_count.load(r);
+        int32_t n;
+
+        do
+            n = (c + ps_cnt < 0) ? 0 : c + ps_cnt;
+        while ( !s->connection_count.compare_exchange_weak(c, n, r) );
+
+        return;
+    }
+
+    if ( pri_cnt )
+    {
+        s->priority_count.fetch_add(pri_cnt, r);
+        return;
+    }
+
+    time_t w = s->window.load(r);
+
+    if ( now > w and s->window.compare_exchange_strong(w, now + interval) )
+    {
+        // start a new window; concurrent updates may land on either side
+        s->connection_count.store(0, r);
+        s->priority_count.store(0, r);
+        s->low_p.store(0, r);
+        s->high_p.store(0, r);
+        s->alerts.store(0, r);
+
+        for ( unsigned i = 0; i < PS_HLL_REGS; ++i )
+        {
+            s->ip_regs[i].store(0, r);
+            s->port_regs[i].store(0, r);
+        }
+    }
+
+    s->connection_count.fetch_add(ps_cnt, r);
+
+    if ( ip->is_set() )
+        add(s->ip_regs, mix(hash_bytes(ip->get_ip6_ptr(), 16)));
+
+    if ( port )
+    {
+        add(s->port_regs, mix(port));
+
+        uint16_t p = s->low_p.load(r);
+
+        while ( (!p or p > port) and !s->low_p.compare_exchange_weak(p, port, r) );
+
+        p = s->high_p.load(r);
+
+        while ( p < port and !s->high_p.compare_exchange_weak(p, port, r) );
+    }
+}
+
+void PsGlobal::get_proto(const PsSketch* s, PS_PROTO& proto) const
+{
+    const auto r = std::memory_order_relaxed;
+    memset(&proto, 0, sizeof(proto));
+
+    proto.connection_count = s->connection_count.load(r);
+    proto.priority_count = s->priority_count.load(r);
+    proto.u_ip_count = estimate(s->ip_regs);
+    proto.u_port_count = estimate(s->port_regs);
+    proto.low_p = s->low_p.load(r);
+    proto.high_p = s->high_p.load(r);
+    proto.window = s->window.load(r);
+}
+
+//--------------------------------------------------------------------------
+// unit tests
+//--------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("ps hll estimate", "[ps_global]")
+{
+    std::atomic<uint8_t> regs[PS_HLL_REGS] { };
+
+    CHECK(PsGlobal::estimate(regs) == 0);
+
+    for ( unsigned n : { 1u, 10u, 100u, 1000u, 10000u } )
+    {
+        for ( auto& r : regs )
+            r = 0;
+
+        // duplicates must not change the estimate
+        for ( unsigned k = 0; k < 3; ++k )
+            for ( unsigned i = 0; i < n; ++i )
+                PsGlobal::add(regs, mix(i + 1));
+
+        double e = PsGlobal::estimate(regs);
+        CHECK(e >= 0.6 * n);
+        CHECK(e <= 1.4 * n);
+    }
+}
+
+TEST_CASE("ps sketch claim", "[ps_global]")
+{
+    PsGlobal ps(0);
+    CHECK(ps.get_count() == PS_PROBES);
+
+    int k1 = 1, k2 = 2;
+    PsSketch* s1 = ps.get(&k1, sizeof(k1), PS_PROTO_TCP, true, 100);
+    PsSketch* s2 = ps.get(&k2, sizeof(k2), PS_PROTO_UDP, false, 100);
+
+    REQUIRE(s1);
+    REQUIRE(s2);
+    CHECK(s1 != s2);
+    CHECK(ps.get(&k1, sizeof(k1), PS_PROTO_TCP, true, 101) == s1);
+    CHECK(s1->protocol == PS_PROTO_TCP);
+    CHECK(s2->is_scanner == 0);
+
+    // fill the table; further keys fail until sketches go idle
+    int k = 3;
+    for ( ; k < 3 + PS_PROBES - 2; ++k )
+        CHECK(ps.get(&k, sizeof(k), PS_PROTO_TCP, true, 101));
+
+    CHECK(!ps.get(&k, sizeof(k), PS_PROTO_TCP, true, 101));
+    CHECK(ps.get(&k, sizeof(k), PS_PROTO_TCP, true, 101 + PS_IDLE + 1));
+}
+
+TEST_CASE("ps sketch update", "[ps_global]")
+{
+    PsGlobal ps(1024 * 1024);
+    SfIp ip, cleared;
+    cleared.clear();
+
+    int key = 1;
+    PsSketch* s = ps.get(&key, sizeof(key), PS_PROTO_TCP, false, 100);
+    REQUIRE(s);
+
+    for ( unsigned i = 0; i < 50; ++i )
+    {
+        std::string str = "10.1.1." + std::to_string(i + 1);
+        ip.set(str.c_str());
+        ps.update(s, 1, 0, 60, &ip, 1000 + (i % 10), 100);
+    }
+    ps.update(s, 0, 1, 60, &cleared, 0, 0);
+    ps.update(s, -1, 0, 60, &cleared, 0, 0);
+
+    PS_PROTO proto;
+    ps.get_proto(s, proto);
+
+    CHECK(proto.connection_count == 49);
+    CHECK(proto.priority_count == 1);
+    CHECK(proto.u_ip_count >= 35);
+    CHECK(proto.u_ip_count <= 65);
+    CHECK(proto.u_port_count >= 7);
+    CHECK(proto.u_port_count <= 13);
+    CHECK(proto.low_p == 1000);
+    CHECK(proto.high_p == 1009);
+    CHECK(proto.window == 160);
+
+    // a new window starts fresh
+    ps.update(s, 1, 0, 60, &ip, 80, 161);
+    ps.get_proto(s, proto);
+
+    CHECK(proto.connection_count == 1);
+    CHECK(proto.priority_count == 0);
+    CHECK(proto.u_ip_count == 1);
+    CHECK(proto.u_port_count == 1);
+}
+
+TEST_CASE("ps sketch threads", "[ps_global]")
+{
+    const unsigned num_threads = 4;
+    const unsigned hosts = 4000;
+
+    PsGlobal ps(1024 * 1024);
+    int key = 1;
+    PsSketch* s = ps.get(&key, sizeof(key), PS_PROTO_TCP, true, 100);
+    REQUIRE(s);
+
+    // a sweep split across threads is counted as a whole
+    std::vector<std::thread> threads;
+
+    for ( unsigned t = 0; t < num_threads; ++t )
+    {
+        threads.emplace_back([&ps, s, t]()
+        {
+            SfIp ip;
+
+            for ( unsigned i = t; i < hosts; i += num_threads )
+            {
+                std::string str = "10.2." + std::to_string(i / 250) + "." +
+                    std::to_string(i % 250 + 1);
+                ip.set(str.c_str());
+                ps.update(s, 1, 0, 60, &ip, 22, 100);
+            }
+        });
+    }
+    for ( auto& t : threads )
+        t.join();
+
+    PS_PROTO proto;
+    ps.get_proto(s, proto);
+
+    CHECK(proto.connection_count == (int)hosts);
+    CHECK(proto.u_ip_count >= 0.6 * hosts);
+    CHECK(proto.u_ip_count <= 1.4 * hosts);
+    CHECK(proto.u_port_count == 1);
+}
+
+#endif
@@ -0,0 +1,104 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ps_global.h
+
+#ifndef PS_GLOBAL_H
+#define PS_GLOBAL_H
+
+// Trackers shared by all packet threads when port_scan.global is set.
+// Each tracked host is a fixed size sketch in a single table sized by the
+// memcap so memory does not grow with the number of packet threads.
+// Counters are updated with relaxed atomics and the numbers of distinct
+// peer addresses and ports are estimated with small HyperLogLog register
+// sets.  A background thread estimates the distinct counts, applies the
+// alert thresholds, and flags the sketch; the next packet thread to see
+// that host raises the alert.
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+
+namespace snort
+{
+struct SfIp;
+}
+
+struct PS_PROTO;
+
+#define PS_HLL_BITS 6
+#define PS_HLL_REGS (1 << PS_HLL_BITS)
+
+struct PsSketch
+{
+    std::atomic<uint64_t> key;           // 0 if free
+    std::atomic<time_t> touched;         // time of last update
+    std::atomic<time_t> window;
+    std::atomic<int32_t> connection_count;
+    std::atomic<int32_t> priority_count;
+    std::atomic<uint16_t> low_p;
+    std::atomic<uint16_t> high_p;
+    std::atomic<uint8_t> protocol;       // PS_PROTO_*
+    std::atomic<uint8_t> is_scanner;
+    std::atomic<uint8_t> alerts;         // PS_ALERT_* set by evaluation
+    std::atomic<uint8_t> ip_regs[PS_HLL_REGS];
+    std::atomic<uint8_t> port_regs[PS_HLL_REGS];
+};
+
+class PsGlobal
+{
+public:
+    PsGlobal(size_t memcap);
+    ~PsGlobal();
+
+    // find or claim the sketch for the given key; null if the table is full
+    PsSketch* get(const void* key, size_t len, int protocol, bool scanner, time_t now);
+
+    // same semantics as PortScan::ps_proto_update()
+    void update(PsSketch*, int ps_cnt, int pri_cnt, unsigned interval,
+        const snort::SfIp* ip, unsigned short port, time_t now);
+
+    // snapshot the sketch with estimated distinct counts
+    void get_proto(const PsSketch*, PS_PROTO&) const;
+
+    PsSketch* get_sketches() const
+    { return sketches; }
+
+    size_t get_count() const
+    { return num_sketches; }
+
+    // latest packet time seen by any thread
+    time_t get_time() const
+    { return latest.load(std::memory_order_relaxed); }
+
+    static unsigned estimate(const std::atomic<uint8_t>* regs);
+    static void add(std::atomic<uint8_t>* regs, uint64_t hash);
+
+    static size_t sketch_size()
+    { return sizeof(PsSketch); }
+
+private:
+    void reset(PsSketch*, time_t now);
+
+private:
+    PsSketch* sketches;
+    size_t num_sketches;
+    std::atomic<time_t> latest;
+};
+
+#endif
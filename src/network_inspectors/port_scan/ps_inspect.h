@@ -25,6 +25,10 @@
 // alerting methods are defined in port_scan.cc and the detection methods
 // are in ps_detect.cc.
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "framework/inspector.h"
 #include "ps_detect.h"
 
@@ -35,6 +39,7 @@ struct SfIp;
 struct PS_PROTO;
 struct PS_TRACKER;
 struct PS_PKT;
+class PsGlobal;
 
 class PortScan : public snort::Inspector
 {
@@ -77,8 +82,19 @@ private:
     void ps_alert_udp(PS_PROTO* scanner, PS_PROTO* scanned);
     void ps_alert_icmp(PS_PROTO* scanner, PS_PROTO* scanned);
 
+    void ps_global_alert(PS_TRACKER*, const snort::SfIp* peer);
+    void ps_global_eval();
+    void ps_global_run();
+
 private:
     PortscanConfig* config;
+
+    // shared trackers and the thread that evaluates them
+    PsGlobal* global = nullptr;
+    std::thread* evaluator = nullptr;
+    std::mutex eval_mutex;
+    std::condition_variable eval_cond;
+    bool eval_stop = false;
 };
 
 #endif
@@ -84,6 +84,9 @@ static const Parameter ps_params[] =
     { "include_midstream", Parameter::PT_BOOL, nullptr, "false",
       "list of CIDRs with optional ports" },
 
+    { "global", Parameter::PT_BOOL, nullptr, "false",
+      "track hosts in one memcap sized table shared by all packet threads" },
+
     { "tcp_ports", Parameter::PT_TABLE, scan_params, nullptr,
       "TCP port scan configuration (one-to-one)" },
 
@@ -259,6 +262,9 @@ bool PortScanModule::set(const char* fqn, Value& v, SnortConfig*)
     else if ( v.is("include_midstream") )
         config->include_midstream = v.get_bool();
 
+    else if ( v.is("global") )
+        config->global = v.get_bool();
+
     else if ( v.is("watch_ip") )
     {
         IPSET*& ips = config->watch_ip;
@@ -331,7 +337,9 @@ bool PortScanModule::end(const char* fqn, int, SnortConfig* sc)
     if ( strcmp(fqn, "port_scan") == 0 )
     {
         ps_rrt.memcap = config->memcap;
-        if ( Snort::is_reloading() )
+
+        // shared trackers are replaced along with the inspector
+        if ( Snort::is_reloading() and !config->global )
             sc->register_reload_resource_tuner(ps_rrt);
     }
     return true;
@@ -30,6 +30,8 @@ static const PegInfo ps_module_pegs[] =
     { CountType::SUM, "trackers", "number of trackers allocated by port scan" },
     { CountType::SUM, "alloc_prunes", "number of trackers pruned on allocation of new tracking" },
     { CountType::SUM, "reload_prunes", "number of trackers pruned on reload due to reduced memcap" },
+    { CountType::SUM, "sketches", "number of shared trackers claimed in global mode" },
+    { CountType::SUM, "sketch_full", "number of lookups failed due to a full shared table" },
     { CountType::END, nullptr, nullptr },
 };
 
@@ -39,6 +41,8 @@ struct PsPegStats
     PegCount trackers;
     PegCount alloc_prunes;
     PegCount reload_prunes;
+    PegCount sketches;
+    PegCount sketch_full;
 };
 
 #endif
@@ -95,6 +95,9 @@ void Profiler::consolidate_stats()
     MemoryProfiler::consolidate_fallthrough_stats();
 }
 
+void Profiler::get_stats(ProfilerStats& ps)
+{ s_profiler_nodes.get_stats(ps); }
+
 void Profiler::reset_stats()
 {
     s_profiler_nodes.reset_nodes();
@@ -21,6 +21,10 @@
 #ifndef PROFILER_H
 #define PROFILER_H
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "main/thread.h"
 #include "profiler_defs.h"
 
@@ -29,6 +33,8 @@ namespace snort
 class Module;
 }
 
+using ProfilerStats = std::vector<std::pair<std::string, snort::ProfileStats>>;
+
 class Profiler
 {
 public:
@@ -40,6 +46,10 @@ public:
 
     static void consolidate_stats();
 
+    // copy of the consolidated stats of each node; safe to call from the
+    // main thread while packet threads are consolidating
+    static void get_stats(ProfilerStats&);
+
     static void reset_stats();
     static void show_stats();
 };
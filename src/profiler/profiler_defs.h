@@ -38,6 +38,7 @@ struct ProfilerConfig
     TimeProfilerConfig time;
     RuleProfilerConfig rule;
     MemoryProfilerConfig memory;
+    bool latency = true;
 };
 
 struct SO_PUBLIC ProfileStats
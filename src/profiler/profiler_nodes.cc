@@ -37,6 +37,9 @@
 
 using namespace snort;
 
+// guards consolidated node stats against concurrent packet thread updates
+static std::mutex stats_mutex;
+
 // -----------------------------------------------------------------------------
 // types
 // -----------------------------------------------------------------------------
@@ -127,13 +130,21 @@ void ProfilerNodeMap::register_node(const std::string &n, const char* pn, Module
 
 void ProfilerNodeMap::accumulate_nodes()
 {
-    static std::mutex stats_mutex;
     std::lock_guard<std::mutex> lock(stats_mutex);
 
     for ( auto it = nodes.begin(); it != nodes.end(); ++it )
         it->second.accumulate();
 }
 
+void ProfilerNodeMap::get_stats(std::vector<std::pair<std::string, ProfileStats>>& ps) const
+{
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ps.clear();
+
+    for ( const auto& it : nodes )
+        ps.emplace_back(it.first, it.second.get_stats());
+}
+
 void ProfilerNodeMap::accumulate_flex()
 {
     auto it = nodes.find(FLEX_NODE);
@@ -24,6 +24,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "profiler_defs.h"
@@ -92,6 +93,7 @@ public:
     void register_node(const std::string&, const char*, snort::Module*);
 
     void accumulate_nodes();
+    void get_stats(std::vector<std::pair<std::string, snort::ProfileStats>>&) const;
     void accumulate_flex();
     void reset_nodes();
 
@@ -0,0 +1,386 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// tail_latency.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "tail_latency.h"
+
+#include <cassert>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// histogram
+//-------------------------------------------------------------------------
+
+void LatencyHistogram::add(const LatencyHistogram& rhs)
+{
+    for ( unsigned i = 0; i < num_buckets; ++i )
+        buckets[i].fetch_add(rhs.buckets[i].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+}
+
+void LatencyHistogram::sub(const LatencyHistogram& rhs)
+{
+    for ( unsigned i = 0; i < num_buckets; ++i )
+        buckets[i].fetch_sub(rhs.buckets[i].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+}
+
+void LatencyHistogram::set(const LatencyHistogram& rhs)
+{
+    for ( unsigned i = 0; i < num_buckets; ++i )
+        buckets[i].store(rhs.buckets[i].load(std::memory_order_relaxed),
+            std::memory_order_relaxed);
+}
+
+void LatencyHistogram::clear()
+{
+    for ( auto& b : buckets )
+        b.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::get_count() const
+{
+    uint64_t n = 0;
+
+    for ( const auto& b : buckets )
+        n += b.load(std::memory_order_relaxed);
+
+    return n;
+}
+
+uint64_t LatencyHistogram::get_percentile(double pct) const
+{
+    uint64_t total = get_count();
+
+    if ( !total )
+        return 0;
+
+    // rank of the target sample, 1 based
+    uint64_t rank = (uint64_t)(pct * total / 100.0 + 0.5);
+
+    if ( rank < 1 )
+        rank = 1;
+
+    else if ( rank > total )
+        rank = total;
+
+    uint64_t n = 0;
+
+    for ( unsigned i = 0; i < num_buckets; ++i )
+    {
+        n += buckets[i].load(std::memory_order_relaxed);
+
+        if ( n >= rank )
+            return get_upper(i);
+    }
+    return get_upper(num_buckets - 1);
+}
+
+uint64_t LatencyHistogram::get_upper(unsigned idx)
+{
+    if ( idx < sub_count )
+        return idx;
+
+    unsigned shift = (idx >> sub_bits) - 1;
+    uint64_t sub = (idx & (sub_count - 1)) + sub_count;
+
+    return ((sub + 1) << shift) - 1;
+}
+
+//-------------------------------------------------------------------------
+// registry
+//-------------------------------------------------------------------------
+
+// names and thread tables are only touched by the main thread and at
+// thread start so the lock is never taken while processing packets.
+// thread tables outlive their threads so that final stats can be merged.
+static std::mutex s_lock;
+static std::vector<std::string> s_names { "daq_batch", "packet", "mpse", "rule_eval" };
+static std::vector<std::atomic<LatencyHistogram*>*> s_threads;
+
+// bumped by term() so a thread's tables are known to be gone
+static unsigned s_generation = 0;
+static THREAD_LOCAL unsigned t_generation = 0;
+
+bool TailLatency::enabled = true;
+THREAD_LOCAL std::atomic<LatencyHistogram*>* TailLatency::hists = nullptr;
+
+unsigned TailLatency::get_id(const char* name)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    for ( unsigned i = 0; i < s_names.size(); ++i )
+    {
+        if ( s_names[i] == name )
+            return i;
+    }
+    if ( s_names.size() >= MAX_IDS )
+        return MAX_IDS;
+
+    s_names.emplace_back(name);
+    return s_names.size() - 1;
+}
+
+const char* TailLatency::get_name(unsigned id)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    return id < s_names.size() ? s_names[id].c_str() : nullptr;
+}
+
+unsigned TailLatency::get_num_ids()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+    return s_names.size();
+}
+
+void TailLatency::tinit()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    // already registered since the last term()
+    if ( hists and t_generation == s_generation )
+        return;
+
+    hists = new std::atomic<LatencyHistogram*>[MAX_IDS];
+
+    for ( unsigned i = 0; i < MAX_IDS; ++i )
+        hists[i].store(nullptr, std::memory_order_relaxed);
+
+    s_threads.emplace_back(hists);
+    t_generation = s_generation;
+}
+
+LatencyHistogram& TailLatency::get(unsigned id)
+{
+    assert(hists and id < MAX_IDS);
+    LatencyHistogram* h = hists[id].load(std::memory_order_relaxed);
+
+    if ( !h )
+    {
+        h = new LatencyHistogram;
+        hists[id].store(h, std::memory_order_release);
+    }
+    return *h;
+}
+
+const LatencyHistogram* TailLatency::find(unsigned id)
+{
+    if ( !hists or id >= MAX_IDS )
+        return nullptr;
+
+    return hists[id].load(std::memory_order_relaxed);
+}
+
+void TailLatency::merge(unsigned id, LatencyHistogram& sum)
+{
+    if ( id >= MAX_IDS )
+        return;
+
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    for ( auto* t : s_threads )
+    {
+        if ( const LatencyHistogram* h = t[id].load(std::memory_order_acquire) )
+            sum.add(*h);
+    }
+}
+
+void TailLatency::term()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    for ( auto* t : s_threads )
+    {
+        for ( unsigned i = 0; i < MAX_IDS; ++i )
+            delete t[i].load(std::memory_order_relaxed);
+
+        delete[] t;
+    }
+    s_threads.clear();
+    ++s_generation;
+
+    // packet threads are gone by now; other threads must tinit again
+    hists = nullptr;
+}
+
+uint64_t TailLatency::get_nsecs(uint64_t ticks)
+{
+#ifdef USE_TSC_CLOCK
+    return ticks * 1000 / clock_scale();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(hr_duration(ticks)).count();
+#endif
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("latency histogram buckets", "[tail_latency]")
+{
+    using H = LatencyHistogram;
+
+    SECTION("small values are exact")
+    {
+        for ( unsigned v = 0; v < H::sub_count; ++v )
+        {
+            CHECK(H::index(v) == v);
+            CHECK(H::get_upper(v) == v);
+        }
+    }
+
+    SECTION("buckets are contiguous")
+    {
+        for ( unsigned i = 1; i < H::num_buckets; ++i )
+            CHECK(H::index(H::get_upper(i - 1) + 1) == i);
+
+        CHECK(H::index(H::get_upper(H::num_buckets - 1)) == H::num_buckets - 1);
+    }
+
+    SECTION("relative error is bounded")
+    {
+        for ( uint64_t v = 1; v < (1ull << H::max_bits); v = v * 3 + 1 )
+        {
+            uint64_t u = H::get_upper(H::index(v));
+            CHECK(u >= v);
+            CHECK((u - v) * H::sub_count <= v);
+        }
+    }
+
+    SECTION("large values are clamped")
+    {
+        CHECK(H::index(~0ull) == H::num_buckets - 1);
+    }
+}
+
+TEST_CASE("latency histogram percentiles", "[tail_latency]")
+{
+    LatencyHistogram h;
+    CHECK(h.get_percentile(50) == 0);
+
+    for ( unsigned v = 1; v <= 1000; ++v )
+        h.record(v);
+
+    CHECK(h.get_count() == 1000);
+
+    uint64_t p50 = h.get_percentile(50);
+    CHECK(p50 >= 500);
+    CHECK(p50 <= 500 + 500 / LatencyHistogram::sub_count);
+
+    uint64_t p99 = h.get_percentile(99);
+    CHECK(p99 >= 990);
+    CHECK(p99 <= 990 + 990 / LatencyHistogram::sub_count);
+
+    CHECK(h.get_percentile(100) >= 1000);
+
+    LatencyHistogram s;
+    s.set(h);
+    s.add(h);
+    CHECK(s.get_count() == 2000);
+    CHECK(s.get_percentile(50) == p50);
+
+    s.sub(h);
+    CHECK(s.get_count() == 1000);
+}
+
+TEST_CASE("tail latency registry", "[tail_latency]")
+{
+    CHECK(TailLatency::get_id("packet") == TailLatency::PACKET);
+
+    unsigned id = TailLatency::get_id("tail_latency_test");
+    CHECK(id >= TailLatency::RULE_EVAL);
+    CHECK(TailLatency::get_id("tail_latency_test") == id);
+    CHECK(std::string(TailLatency::get_name(id)) == "tail_latency_test");
+
+    CHECK(!TailLatency::find(id));
+    TailLatency::record(id, hr_duration(10));  // ignored before tinit
+
+    TailLatency::tinit();
+    TailLatency::record(id, hr_duration(10));
+    TailLatency::record(id, hr_duration(20));
+
+    const LatencyHistogram* h = TailLatency::find(id);
+    REQUIRE(h);
+    CHECK(h->get_count() == 2);
+
+    LatencyHistogram sum;
+    TailLatency::merge(id, sum);
+    CHECK(sum.get_count() == 2);
+    CHECK(sum.get_percentile(100) == 20);
+
+    TailLatency::term();
+    CHECK(!TailLatency::find(id));
+    TailLatency::record(id, hr_duration(10));  // ignored after term
+
+    // a new registration starts empty
+    TailLatency::tinit();
+    TailLatency::record(id, hr_duration(30));
+
+    h = TailLatency::find(id);
+    REQUIRE(h);
+    CHECK(h->get_count() == 1);
+
+    sum.clear();
+    TailLatency::merge(id, sum);
+    CHECK(sum.get_count() == 1);
+
+    TailLatency::term();
+}
+
+TEST_CASE("tail latency overhead", "[.benchmark][tail_latency]")
+{
+    const unsigned n = 10000000;
+    LatencyHistogram h;
+    TailLatency::tinit();
+    hr_time start = SnortClock::now();
+
+    for ( unsigned i = 0; i < n; ++i )
+        h.record(i & 0xFFFFF);
+
+    hr_duration rec = SnortClock::now() - start;
+    start = SnortClock::now();
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        TailLatency::Scope s(TailLatency::PACKET);
+    }
+    hr_duration scope = SnortClock::now() - start;
+
+    WARN("record: " << TailLatency::get_nsecs(TO_TICKS(rec)) * 1000 / n << " ps/op");
+    WARN("scope: " << TailLatency::get_nsecs(TO_TICKS(scope)) * 1000 / n << " ps/op");
+    CHECK(h.get_count() == n);
+    TailLatency::term();
+}
+
+#endif
+
@@ -0,0 +1,159 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// tail_latency.h
+
+#ifndef TAIL_LATENCY_H
+#define TAIL_LATENCY_H
+
+// always-on latency distributions for percentile (p50 / p99 / p99.9)
+// reporting.  the profiler only yields totals and averages which hide the
+// tail; these histograms are cheap enough to leave enabled in production.
+
+#include <atomic>
+#include <cstdint>
+
+#include "main/snort_types.h"
+#include "main/thread.h"
+#include "time/clock_defs.h"
+
+namespace snort
+{
+// log-linear (HDR style) buckets: values below sub_count are exact and
+// each power of 2 above that is split into sub_count linear buckets so the
+// relative error is bounded by 1 / sub_count.  each histogram has a single
+// writer (its packet thread); the counters are atomic only so that the main
+// thread can read them at any time without locking.
+class SO_PUBLIC LatencyHistogram
+{
+public:
+    static constexpr unsigned sub_bits = 4;
+    static constexpr unsigned sub_count = 1 << sub_bits;
+    static constexpr unsigned max_bits = 40;
+    static constexpr unsigned num_buckets = (max_bits - sub_bits + 1) * sub_count;
+
+    LatencyHistogram()
+    { clear(); }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    // packet thread only
+    void record(uint64_t ticks)
+    {
+        std::atomic<uint64_t>& b = buckets[index(ticks)];
+        b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // these may be used by any thread
+    void add(const LatencyHistogram&);
+    void sub(const LatencyHistogram&);
+    void set(const LatencyHistogram&);
+    void clear();
+
+    uint64_t get_count() const;
+
+    // upper bound of the bucket holding the given percentile (0 to 100)
+    // in ticks; 0 if empty
+    uint64_t get_percentile(double pct) const;
+
+    static unsigned index(uint64_t ticks)
+    {
+        if ( ticks < sub_count )
+            return (unsigned)ticks;
+
+        if ( ticks >> max_bits )
+            ticks = (1ull << max_bits) - 1;
+
+        unsigned shift = 63 - __builtin_clzll(ticks) - sub_bits;
+        return ((shift + 1) << sub_bits) + (unsigned)(ticks >> shift) - sub_count;
+    }
+
+    // largest value that maps to the given bucket
+    static uint64_t get_upper(unsigned idx);
+
+private:
+    std::atomic<uint64_t> buckets[num_buckets];
+};
+
+class SO_PUBLIC TailLatency
+{
+public:
+    // fixed ids; inspector instances are assigned the following ids
+    enum : unsigned { DAQ_BATCH, PACKET, MPSE, RULE_EVAL, MAX_IDS = 256 };
+
+    // main thread only
+    // returns MAX_IDS when full
+    static unsigned get_id(const char* name);
+    static const char* get_name(unsigned id);
+    static unsigned get_num_ids();
+
+    // combine all packet threads
+    static void merge(unsigned id, LatencyHistogram&);
+    static void term();
+
+    // packet thread only
+    static void tinit();
+
+    static void record(unsigned id, hr_duration d)
+    {
+        if ( hists and id < MAX_IDS )
+            get(id).record(TO_TICKS(d));
+    }
+
+    // histogram for this thread, null if nothing recorded yet
+    static const LatencyHistogram* find(unsigned id);
+
+    static void set_enabled(bool b)
+    { enabled = b; }
+
+    static bool is_enabled()
+    { return enabled; }
+
+    static uint64_t get_nsecs(uint64_t ticks);
+
+    class Scope
+    {
+    public:
+        Scope(unsigned id) : id(id)
+        {
+            if ( (on = enabled) )
+                start = SnortClock::now();
+        }
+
+        ~Scope()
+        {
+            if ( on )
+                record(id, SnortClock::now() - start);
+        }
+
+    private:
+        hr_time start;
+        unsigned id;
+        bool on;
+    };
+
+private:
+    static LatencyHistogram& get(unsigned id);
+
+    static bool enabled;
+    static THREAD_LOCAL std::atomic<LatencyHistogram*>* hists;
+};
+}
+#endif
+
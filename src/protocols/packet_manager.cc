@@ -38,6 +38,19 @@
 #include "eth.h"
 #include "icmp4.h"
 #include "icmp6.h"
+#include "ipv4.h"
+#include "tcp.h"
+#include "udp.h"
+
+#ifdef UNIT_TEST
+#include <daq_dlt.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/snort_catch.h"
+#endif
 
 using namespace snort;
 
@@ -838,6 +851,125 @@ void PacketManager::encode_update(Packet* p)
     }
 }
 
+// outer layers are link layer only if there is just one ip layer, so no
+// other checksum covers the rewritten bytes.  the same goes for icmp
+// errors, which embed the headers of the offending packet.
+static bool single_ip_layer(const Packet* p)
+{
+    if ( p->proto_bits & PROTO_BIT__ICMP_EMBED )
+        return false;
+
+    unsigned num_ip = 0;
+
+    for ( unsigned i = 0; i < p->num_layers; ++i )
+    {
+        switch ( p->layers[i].prot_id )
+        {
+        case ProtocolId::ETHERTYPE_IPV4:
+        case ProtocolId::ETHERTYPE_IPV6:
+        case ProtocolId::IPIP:
+        case ProtocolId::IPV6:
+            ++num_ip;
+            break;
+        default:
+            break;
+        }
+    }
+    return num_ip == 1;
+}
+
+static bool update_cksum(Packet* p, const uint8_t* start, const uint8_t* old, unsigned len)
+{
+    if ( p->packet_flags & (PKT_PSEUDO | PKT_REBUILT_FRAG | PKT_RESIZED) )
+        return false;
+
+    if ( !single_ip_layer(p) )
+        return false;
+
+    int i = p->num_layers - 1;
+
+    while ( i >= 0 and start < p->layers[i].start )
+        --i;
+
+    if ( i < 0 )
+        return false;
+
+    const Layer& lyr = p->layers[i];
+    uint8_t* hdr = const_cast<uint8_t*>(lyr.start);
+    const bool in_hdr = (start + len <= lyr.start + lyr.length);
+    const bool odd = (start - lyr.start) & 1;
+
+    const uint16_t* before = reinterpret_cast<const uint16_t*>(old);
+    const uint16_t* after = reinterpret_cast<const uint16_t*>(start);
+
+    switch ( lyr.prot_id )
+    {
+    case ProtocolId::ETHERTYPE_IPV4:
+    case ProtocolId::IPIP:
+    {
+        if ( !in_hdr )
+            return false;
+
+        ip::IP4Hdr* h = reinterpret_cast<ip::IP4Hdr*>(hdr);
+        h->ip_csum = checksum::cksum_update(h->ip_csum, before, after, len, odd);
+        break;
+    }
+    case ProtocolId::ETHERTYPE_IPV6:
+    case ProtocolId::IPV6:
+    case ProtocolId::HOPOPTS:
+    case ProtocolId::DSTOPTS:
+        // no checksum and not part of the transport pseudoheader
+        if ( !in_hdr )
+            return false;
+        break;
+
+    case ProtocolId::TCP:
+    {
+        tcp::TCPHdr* h = reinterpret_cast<tcp::TCPHdr*>(hdr);
+        h->th_sum = checksum::cksum_update(h->th_sum, before, after, len, odd);
+        break;
+    }
+    case ProtocolId::UDP:
+    {
+        udp::UDPHdr* h = reinterpret_cast<udp::UDPHdr*>(hdr);
+
+        // zero means no checksum over ip4 and a computed zero is sent as ones
+        if ( h->uh_chk or !p->ptrs.ip_api.is_ip4() )
+        {
+            h->uh_chk = checksum::cksum_update(h->uh_chk, before, after, len, odd);
+
+            if ( !h->uh_chk )
+                h->uh_chk = 0xffff;
+        }
+        break;
+    }
+    case ProtocolId::ICMPV4:
+    {
+        ICMPHdr* h = reinterpret_cast<ICMPHdr*>(hdr);
+        h->csum = checksum::cksum_update(h->csum, before, after, len, odd);
+        break;
+    }
+    case ProtocolId::ICMPV6:
+    {
+        icmp::Icmp6Hdr* h = reinterpret_cast<icmp::Icmp6Hdr*>(hdr);
+        h->csum = checksum::cksum_update(h->csum, before, after, len, odd);
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
+
+void PacketManager::encode_rewrite(
+    Packet* p, const uint8_t* start, const uint8_t* old, unsigned len)
+{
+    if ( update_cksum(p, start, old, len) )
+        p->packet_flags |= PKT_CKSUM_UPDATED;
+    else
+        p->packet_flags |= PKT_MODIFIED;
+}
+
 //-------------------------------------------------------------------------
 // codec support and statistics
 //-------------------------------------------------------------------------
@@ -921,3 +1053,295 @@ void PacketManager::log_protocols(TextLog* const text_log,
         }
     }
 }
+
+#ifdef UNIT_TEST
+
+static void put16(uint8_t* p, uint16_t v)
+{ p[0] = v >> 8; p[1] = v & 0xff; }
+
+static void put_cksum(uint8_t* p, uint16_t c)
+{ memcpy(p, &c, sizeof(c)); }
+
+static std::vector<uint8_t> make_frame(unsigned payload, bool ip6)
+{
+    const unsigned eth_len = 14, ip_len = ip6 ? 40 : 20, l4_len = ip6 ? 8 : 20;
+    std::vector<uint8_t> f(eth_len + ip_len + l4_len + payload, 0);
+
+    uint8_t* eth = f.data();
+    eth[0] = 0x02;
+    eth[6] = 0x02;
+    eth[11] = 1;
+    put16(eth + 12, ip6 ? 0x86DD : 0x0800);
+
+    uint8_t* ip = eth + eth_len;
+    uint8_t* l4 = ip + ip_len;
+    uint16_t l4_total = l4_len + payload;
+
+    for ( unsigned i = 0; i < payload; ++i )
+        l4[l4_len + i] = 'a' + i % 26;
+
+    if ( ip6 )
+    {
+        ip[0] = 0x60;
+        put16(ip + 4, l4_total);
+        ip[6] = (uint8_t)IpProtocol::UDP;
+        ip[7] = 64;
+        ip[8] = 0x20; ip[9] = 0x01; ip[23] = 1;
+        ip[24] = 0x20; ip[25] = 0x01; ip[39] = 2;
+
+        put16(l4, 40000);
+        put16(l4 + 2, 53);
+        put16(l4 + 4, l4_total);
+
+        checksum::Pseudoheader6 ph;
+        memcpy(ph.hdr.sip, ip + 8, 16);
+        memcpy(ph.hdr.dip, ip + 24, 16);
+        ph.hdr.zero = 0;
+        ph.hdr.protocol = IpProtocol::UDP;
+        ph.hdr.len = htons(l4_total);
+        put_cksum(l4 + 6, checksum::udp_cksum((const uint16_t*)l4, l4_total, ph));
+    }
+    else
+    {
+        ip[0] = 0x45;
+        put16(ip + 2, ip_len + l4_total);
+        put16(ip + 6, 0x4000);
+        ip[8] = 64;
+        ip[9] = (uint8_t)IpProtocol::TCP;
+        ip[12] = 10; ip[15] = 1;
+        ip[16] = 10; ip[19] = 2;
+        put_cksum(ip + 10, checksum::ip_cksum((const uint16_t*)ip, ip_len));
+
+        put16(l4, 40000);
+        put16(l4 + 2, 80);
+        l4[7] = 1;
+        l4[11] = 1;
+        l4[12] = 0x50;
+        l4[13] = TH_ACK | TH_PUSH;
+        put16(l4 + 14, 65535);
+
+        checksum::Pseudoheader ph;
+        memcpy(&ph.hdr.sip, ip + 12, 4);
+        memcpy(&ph.hdr.dip, ip + 16, 4);
+        ph.hdr.zero = 0;
+        ph.hdr.protocol = IpProtocol::TCP;
+        ph.hdr.len = htons(l4_total);
+        put_cksum(l4 + 16, checksum::tcp_cksum((const uint16_t*)l4, l4_total, ph));
+    }
+    return f;
+}
+
+// codecs expect the DAQ message a packet came from
+static void set_msg(Packet& p, DAQ_Msg_t& msg, DAQ_PktHdr_t& hdr, const std::vector<uint8_t>& f)
+{
+    hdr = { };
+    hdr.pktlen = f.size();
+
+    msg = { };
+    msg.type = DAQ_MSG_TYPE_PACKET;
+    msg.hdr = &hdr;
+    msg.hdr_len = sizeof(hdr);
+    msg.data = const_cast<uint8_t*>(f.data());
+    msg.data_len = f.size();
+
+    p.daq_msg = &msg;
+}
+
+TEST_CASE("packet manager decode", "[packet_manager][.benchmark]")
+{
+    CodecManager::thread_init(SnortConfig::get_conf(), DLT_EN10MB);
+    {
+        Packet p(false);
+        DAQ_PktHdr_t hdr;
+        DAQ_Msg_t msg;
+
+        for ( bool ip6 : { false, true } )
+        {
+            for ( unsigned payload : { 0, 1400 } )
+            {
+                const std::vector<uint8_t> f = make_frame(payload, ip6);
+                const std::string name = ip6 ? "eth ip6 udp " : "eth ip4 tcp ";
+                set_msg(p, msg, hdr, f);
+
+                PacketManager::decode(&p, &hdr, f.data(), f.size());
+                CHECK((p.proto_bits & (ip6 ? PROTO_BIT__UDP : PROTO_BIT__TCP)));
+                CHECK(p.dsize == payload);
+
+                BENCHMARK(name + std::to_string(payload))
+                {
+                    PacketManager::decode(&p, &hdr, f.data(), f.size());
+                    return p.dsize;
+                };
+            }
+        }
+    }
+    CodecManager::thread_term();
+}
+
+static bool valid_tcp4(const uint8_t* ip, unsigned l4_total)
+{
+    checksum::Pseudoheader ph;
+    memcpy(&ph.hdr.sip, ip + 12, 4);
+    memcpy(&ph.hdr.dip, ip + 16, 4);
+    ph.hdr.zero = 0;
+    ph.hdr.protocol = IpProtocol::TCP;
+    ph.hdr.len = htons(l4_total);
+    return checksum::tcp_cksum((const uint16_t*)(ip + 20), l4_total, ph) == 0;
+}
+
+static bool valid_udp6(const uint8_t* ip, unsigned l4_total)
+{
+    checksum::Pseudoheader6 ph;
+    memcpy(ph.hdr.sip, ip + 8, 16);
+    memcpy(ph.hdr.dip, ip + 24, 16);
+    ph.hdr.zero = 0;
+    ph.hdr.protocol = IpProtocol::UDP;
+    ph.hdr.len = htons(l4_total);
+    return checksum::udp_cksum((const uint16_t*)(ip + 40), l4_total, ph) == 0;
+}
+
+static void rewrite(Packet* p, uint8_t* start, const char* s)
+{
+    unsigned len = strlen(s);
+    std::vector<uint8_t> old(start, start + len);
+    memcpy(start, s, len);
+    PacketManager::encode_rewrite(p, start, old.data(), len);
+}
+
+TEST_CASE("encode rewrite", "[packet_manager]")
+{
+    CodecManager::thread_init(SnortConfig::get_conf(), DLT_EN10MB);
+    {
+        Packet p(false);
+        DAQ_PktHdr_t hdr = { };
+
+        std::vector<uint8_t> f = make_frame(101, false);
+        uint8_t* ip = f.data() + 14;
+        hdr.pktlen = f.size();
+
+        PacketManager::decode(&p, &hdr, f.data(), f.size());
+        REQUIRE(p.dsize == 101);
+        CHECK(valid_tcp4(ip, 20 + 101));
+
+        SECTION("odd payload offset")
+        {
+            rewrite(&p, const_cast<uint8_t*>(p.data) + 3, "snort");
+            CHECK((p.packet_flags & PKT_CKSUM_UPDATED));
+            CHECK(!(p.packet_flags & PKT_MODIFIED));
+            CHECK(valid_tcp4(ip, 20 + 101));
+        }
+        SECTION("odd length payload tail")
+        {
+            rewrite(&p, const_cast<uint8_t*>(p.data) + 96, "snort");
+            CHECK(valid_tcp4(ip, 20 + 101));
+        }
+        SECTION("ip and tcp headers")
+        {
+            const char ttl[] = { 5, 0 };
+            rewrite(&p, ip + 8, ttl);
+            CHECK(checksum::ip_cksum((const uint16_t*)ip, 20) == 0);
+
+            const char flags[] = { TH_ACK, 0 };
+            rewrite(&p, ip + 20 + 13, flags);
+            CHECK(valid_tcp4(ip, 20 + 101));
+            CHECK(!(p.packet_flags & PKT_MODIFIED));
+        }
+        SECTION("cooked")
+        {
+            p.packet_flags |= PKT_PSEUDO;
+            rewrite(&p, const_cast<uint8_t*>(p.data), "snort");
+            CHECK((p.packet_flags & PKT_MODIFIED));
+            CHECK(!(p.packet_flags & PKT_CKSUM_UPDATED));
+        }
+
+        f = make_frame(64, true);
+        ip = f.data() + 14;
+        hdr.pktlen = f.size();
+
+        PacketManager::decode(&p, &hdr, f.data(), f.size());
+        REQUIRE(p.dsize == 64);
+
+        rewrite(&p, const_cast<uint8_t*>(p.data) + 7, "rewritten");
+        CHECK((p.packet_flags & PKT_CKSUM_UPDATED));
+        CHECK(valid_udp6(ip, 8 + 64));
+    }
+    CodecManager::thread_term();
+}
+
+TEST_CASE("checksum", "[checksum][.benchmark]")
+{
+    std::vector<uint8_t> buf(9001);
+
+    for ( unsigned i = 0; i < buf.size(); ++i )
+        buf[i] = i * 7;
+
+    // + 1 for an unaligned buffer
+    for ( unsigned len : { 20, 64, 576, 1460, 9000 } )
+    {
+        const uint16_t* data = (const uint16_t*)(buf.data() + 1);
+        const std::string tag = " " + std::to_string(len);
+
+        BENCHMARK("scalar" + tag)
+        { return checksum::detail::cksum_add_scalar(data, len, 0); };
+
+#ifdef HAVE_X86_SIMD
+        if ( len >= 16 and cpu_has_sse2() )
+        {
+            BENCHMARK("sse2" + tag)
+            {
+                const uint16_t* d = data;
+                std::size_t n = len;
+                uint32_t sum = checksum::detail::add_sse2(d, n);
+                return checksum::detail::cksum_add_scalar(d, n, sum);
+            };
+        }
+        if ( len >= 32 and cpu_has_avx2() )
+        {
+            BENCHMARK("avx2" + tag)
+            {
+                const uint16_t* d = data;
+                std::size_t n = len;
+                uint32_t sum = checksum::detail::add_avx2(d, n);
+                return checksum::detail::cksum_add_scalar(d, n, sum);
+            };
+        }
+#endif
+        BENCHMARK("dispatch" + tag)
+        { return checksum::cksum_add(data, len); };
+    }
+}
+
+TEST_CASE("encode update vs rewrite", "[packet_manager][.benchmark]")
+{
+    CodecManager::thread_init(SnortConfig::get_conf(), DLT_EN10MB);
+    {
+        Packet p(false);
+        DAQ_PktHdr_t hdr = { };
+
+        std::vector<uint8_t> f = make_frame(1400, false);
+        hdr.pktlen = f.size();
+
+        PacketManager::decode(&p, &hdr, f.data(), f.size());
+        uint8_t* start = const_cast<uint8_t*>(p.data) + 100;
+
+        BENCHMARK("update 1400")
+        {
+            memcpy(start, "snort", 5);
+            p.packet_flags |= PKT_MODIFIED;
+            PacketManager::encode_update(&p);
+            return p.pktlen;
+        };
+
+        BENCHMARK("rewrite 1400")
+        {
+            uint8_t old[5];
+            memcpy(old, start, sizeof(old));
+            memcpy(start, "snort", 5);
+            PacketManager::encode_rewrite(&p, start, old, sizeof(old));
+            return p.packet_flags;
+        };
+    }
+    CodecManager::thread_term();
+}
+
+#endif
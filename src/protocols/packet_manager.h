@@ -68,6 +68,13 @@ public:
     // after Snort has changed any data in this packet
     static void encode_update(Packet*);
 
+    // call this instead of setting PKT_MODIFIED after overwriting len bytes
+    // at start, anywhere in the headers or payload, without changing the
+    // packet size.  old is a copy of the original bytes.  the covering
+    // checksum is updated incrementally if that is all it takes, otherwise
+    // the packet is marked for encode_update.
+    static void encode_rewrite(Packet*, const uint8_t* start, const uint8_t* old, unsigned len);
+
     //--------------------------------------------------------------------
     // FIXIT-L encode_format() should be replaced with a function that
     // does format and update in one step for packets cooked for internal
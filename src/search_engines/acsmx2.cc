@@ -117,8 +117,10 @@
 
 #include "acsmx2.h"
 
+#include <atomic>
 #include <cassert>
 #include <list>
+#include <mutex>
 
 #include "log/messages.h"
 #include "utils/stats.h"
@@ -128,31 +130,33 @@ using namespace snort;
 
 #define printf LogMessage
 
-static int acsm2_total_memory = 0;
-static int acsm2_pattern_memory = 0;
-static int acsm2_matchlist_memory = 0;
-static int acsm2_transtable_memory = 0;
-static int acsm2_dfa_memory = 0;
-static int acsm2_dfa1_memory = 0;
-static int acsm2_dfa2_memory = 0;
-static int acsm2_dfa4_memory = 0;
-static int acsm2_failstate_memory = 0;
+static std::atomic<int> acsm2_total_memory { 0 };
+static std::atomic<int> acsm2_pattern_memory { 0 };
+static std::atomic<int> acsm2_matchlist_memory { 0 };
+static std::atomic<int> acsm2_transtable_memory { 0 };
+static std::atomic<int> acsm2_dfa_memory { 0 };
+static std::atomic<int> acsm2_dfa1_memory { 0 };
+static std::atomic<int> acsm2_dfa2_memory { 0 };
+static std::atomic<int> acsm2_dfa4_memory { 0 };
+static std::atomic<int> acsm2_failstate_memory { 0 };
 
 struct acsm_summary_t
 {
-    unsigned num_states;
-    unsigned num_transitions;
-    unsigned num_instances;
-    unsigned num_patterns;
-    unsigned num_characters;
-    unsigned num_match_states;
-    unsigned num_1byte_instances;
-    unsigned num_2byte_instances;
-    unsigned num_4byte_instances;
+    // instances may be compiled in parallel
+    std::atomic<unsigned> num_states;
+    std::atomic<unsigned> num_transitions;
+    std::atomic<unsigned> num_instances;
+    std::atomic<unsigned> num_patterns;
+    std::atomic<unsigned> num_characters;
+    std::atomic<unsigned> num_match_states;
+    std::atomic<unsigned> num_1byte_instances;
+    std::atomic<unsigned> num_2byte_instances;
+    std::atomic<unsigned> num_4byte_instances;
     ACSM_STRUCT2 acsm;
 };
 
 static acsm_summary_t summary;
+static std::mutex summary_mutex;
 
 void acsm_init_summary()
 {
@@ -1346,7 +1350,10 @@ static inline int _acsmCompile2(ACSM_STRUCT2* acsm)
     summary.num_transitions += acsm->acsmNumTrans;
     summary.num_instances++;
 
-    memcpy(&summary.acsm, acsm, sizeof(ACSM_STRUCT2));
+    {
+        std::lock_guard<std::mutex> lock(summary_mutex);
+        memcpy(&summary.acsm, acsm, sizeof(ACSM_STRUCT2));
+    }
 
     return 0;
 }
@@ -22,14 +22,23 @@
 #include "config.h"
 #endif
 
+#include <fcntl.h>
 #include <hs_compile.h>
 #include <hs_runtime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
+#include <map>
+#include <mutex>
 
 #include "framework/module.h"
 #include "framework/mpse.h"
+#include "hash/hashes.h"
 #include "helpers/scratch_allocator.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
@@ -99,6 +108,205 @@ void Pattern::escape(const uint8_t* s, unsigned n, bool literal)
 
 typedef std::vector<Pattern> PatternVector;
 
+//-------------------------------------------------------------------------
+// shared databases
+//-------------------------------------------------------------------------
+
+// a compiled database is immutable and scanned with per-thread scratch so
+// instances with identical pattern sets can share one.  on reload this
+// means only groups whose patterns changed are compiled; the rest reuse
+// the running config's databases without a second copy in memory.  the
+// generation is bumped when a config is done so a database found from an
+// earlier config counts as reused rather than as a duplicate.
+
+struct SharedDatabase
+{
+    hs_database_t* db;
+    unsigned refs;
+    unsigned gen;
+};
+
+static std::map<std::string, SharedDatabase> s_shared;
+static std::mutex s_shared_mutex;
+static unsigned s_generation = 0;
+
+static hs_database_t* db_acquire(const std::string& key, bool& reused)
+{
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    auto it = s_shared.find(key);
+
+    if ( it == s_shared.end() )
+        return nullptr;
+
+    reused = it->second.gen != s_generation;
+    it->second.gen = s_generation;
+    ++it->second.refs;
+    return it->second.db;
+}
+
+// returns the database to use, which is not the given one if another
+// thread added the same set first
+static hs_database_t* db_share(const std::string& key, hs_database_t* db)
+{
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    auto it = s_shared.find(key);
+
+    if ( it != s_shared.end() )
+    {
+        hs_free_database(db);
+        ++it->second.refs;
+        return it->second.db;
+    }
+    s_shared[key] = { db, 1, s_generation };
+    return db;
+}
+
+static void db_release(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    auto it = s_shared.find(key);
+    assert(it != s_shared.end() and it->second.refs);
+
+    if ( --it->second.refs )
+        return;
+
+    hs_free_database(it->second.db);
+    s_shared.erase(it);
+}
+
+//-------------------------------------------------------------------------
+// database cache
+//-------------------------------------------------------------------------
+
+// compiling large pattern sets dominates startup and reload time.  if a
+// cache directory is configured, compiled databases are serialized there
+// keyed by a digest of the hyperscan version and the pattern set, and
+// subsequent compiles of the same set are replaced by an mmap and
+// deserialize.  any mismatch or error just falls back to compiling.  the
+// directory only applies to the config being built so it is cleared when
+// that config is done.
+
+static std::string s_cache_dir;
+
+// called once all databases of a config are compiled
+static void db_config_done()
+{
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    ++s_generation;
+    s_cache_dir.clear();
+}
+
+struct CacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t mode;
+    uint8_t digest[SHA256_HASH_SIZE];
+    uint64_t size;
+};
+
+static const char cache_magic[8] = { 'S', 'N', 'O', 'R', 'T', 'H', 'S', '\0' };
+static const uint32_t cache_version = 1;
+
+static void get_db_digest(
+    const std::vector<const char*>& pats, const std::vector<unsigned>& flags, uint8_t* digest)
+{
+    std::string key = hs_version();
+    key += '\0';
+
+    for ( unsigned i = 0; i < pats.size(); ++i )
+    {
+        key += pats[i];
+        key += '\0';
+        key.append((const char*)&flags[i], sizeof(flags[i]));
+    }
+    sha256((const unsigned char*)key.data(), key.size(), digest);
+}
+
+static std::string get_cache_path(const uint8_t* digest)
+{
+    std::string path = s_cache_dir + "/";
+
+    for ( unsigned i = 0; i < SHA256_HASH_SIZE; ++i )
+    {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", digest[i]);
+        path += hex;
+    }
+    return path + ".hsdb";
+}
+
+static hs_database_t* cache_load(const std::string& path, const uint8_t* digest)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if ( fd < 0 )
+        return nullptr;
+
+    struct stat st;
+    void* map = MAP_FAILED;
+
+    if ( !fstat(fd, &st) and (size_t)st.st_size > sizeof(CacheHeader) )
+        map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if ( map == MAP_FAILED )
+        return nullptr;
+
+    const CacheHeader* hdr = (const CacheHeader*)map;
+    hs_database_t* db = nullptr;
+
+    if ( !memcmp(hdr->magic, cache_magic, sizeof(cache_magic)) and
+        hdr->version == cache_version and hdr->mode == HS_MODE_BLOCK and
+        !memcmp(hdr->digest, digest, SHA256_HASH_SIZE) and
+        hdr->size == st.st_size - sizeof(CacheHeader) )
+    {
+        const char* bytes = (const char*)map + sizeof(CacheHeader);
+
+        if ( hs_deserialize_database(bytes, hdr->size, &db) != HS_SUCCESS )
+            db = nullptr;
+    }
+    munmap(map, st.st_size);
+    return db;
+}
+
+static bool cache_store(const std::string& path, const uint8_t* digest, const hs_database_t* db)
+{
+    char* bytes = nullptr;
+    size_t size = 0;
+
+    if ( hs_serialize_database(db, &bytes, &size) != HS_SUCCESS )
+        return false;
+
+    CacheHeader hdr;
+    memcpy(hdr.magic, cache_magic, sizeof(hdr.magic));
+    hdr.version = cache_version;
+    hdr.mode = HS_MODE_BLOCK;
+    memcpy(hdr.digest, digest, sizeof(hdr.digest));
+    hdr.size = size;
+
+    // write a private file and rename so concurrent compiles and other
+    // processes never see a partial database
+    std::string tmp = path + "." + std::to_string(getpid()) + "." +
+        std::to_string(get_instance_id()) + ".tmp";
+
+    FILE* fh = fopen(tmp.c_str(), "wb");
+    bool ok = false;
+
+    if ( fh )
+    {
+        ok = fwrite(&hdr, sizeof(hdr), 1, fh) == 1 and fwrite(bytes, size, 1, fh) == 1;
+        ok = !fclose(fh) and ok;
+        ok = ok and !rename(tmp.c_str(), path.c_str());
+
+        if ( !ok )
+            unlink(tmp.c_str());
+    }
+    free(bytes);
+    return ok;
+}
+
 // we need to update scratch in each compiler thread as each pattern is processed
 // and then select the largest to clone to packet thread specific after all rules
 // are loaded.  s_scratch is a prototype that is large enough for all uses.
@@ -137,7 +345,7 @@ public:
     ~HyperscanMpse() override
     {
         if ( hs_db )
-            hs_free_database(hs_db);
+            db_release(db_key);
 
         if ( agent )
             user_dtor();
@@ -174,14 +382,25 @@ private:
     PatternVector pvector;
 
     hs_database_t* hs_db = nullptr;
+    std::string db_key;
 
 public:
     static uint64_t instances;
     static uint64_t patterns;
+
+    // updated by the compile threads
+    static std::atomic<uint64_t> shared;
+    static std::atomic<uint64_t> reused;
+    static std::atomic<uint64_t> cache_loads;
+    static std::atomic<uint64_t> cache_stores;
 };
 
 uint64_t HyperscanMpse::instances = 0;
 uint64_t HyperscanMpse::patterns = 0;
+std::atomic<uint64_t> HyperscanMpse::shared { 0 };
+std::atomic<uint64_t> HyperscanMpse::reused { 0 };
+std::atomic<uint64_t> HyperscanMpse::cache_loads { 0 };
+std::atomic<uint64_t> HyperscanMpse::cache_stores { 0 };
 
 // other mpse have direct access to their fsm match states and populate
 // user list and tree with each pattern that leads to the same match state.
@@ -244,14 +463,54 @@ int HyperscanMpse::prep_patterns(SnortConfig* sc)
         ids.emplace_back(id++);
     }
 
-    if ( hs_compile_multi(&pats[0], &flags[0], &ids[0], pvector.size(), HS_MODE_BLOCK,
-            nullptr, &hs_db, &errptr) or !hs_db )
+    uint8_t digest[SHA256_HASH_SIZE];
+    get_db_digest(pats, flags, digest);
+    db_key.assign((const char*)digest, sizeof(digest));
+
+    bool reuse = false;
+
+    if ( (hs_db = db_acquire(db_key, reuse)) )
     {
-        ParseError("can't compile hyperscan pattern database: %s (%d) - '%s'",
-            errptr->message, errptr->expression,
-            errptr->expression >= 0 ? pats[errptr->expression] : "");
-        hs_free_compile_error(errptr);
-        return -2;
+        if ( reuse )
+            ++reused;
+        else
+            ++shared;
+    }
+    else
+    {
+        std::string cache_path;
+
+        if ( !s_cache_dir.empty() )
+        {
+            cache_path = get_cache_path(digest);
+
+            if ( (hs_db = cache_load(cache_path, digest)) )
+                ++cache_loads;
+        }
+
+        if ( !hs_db )
+        {
+            if ( hs_compile_multi(&pats[0], &flags[0], &ids[0], pvector.size(), HS_MODE_BLOCK,
+                    nullptr, &hs_db, &errptr) or !hs_db )
+            {
+                ParseError("can't compile hyperscan pattern database: %s (%d) - '%s'",
+                    errptr->message, errptr->expression,
+                    errptr->expression >= 0 ? pats[errptr->expression] : "");
+                hs_free_compile_error(errptr);
+                hs_db = nullptr;
+                return -2;
+            }
+
+            if ( !cache_path.empty() )
+            {
+                if ( cache_store(cache_path, digest, hs_db) )
+                    ++cache_stores;
+                else
+                    WarningMessage("hyperscan: can't write database cache %s\n",
+                        cache_path.c_str());
+            }
+        }
+        hs_db = db_share(db_key, hs_db);
     }
 
     if ( hs_error_t err = hs_alloc_scratch(hs_db, &s_scratch[get_instance_id()]) )
@@ -299,15 +558,25 @@ int HyperscanMpse::_search(
     return scan.nfound;
 }
 
+// databases can outlive the config that prepped them, eg appid keeps its
+// http matchers across reload_config, so the scratch must fit those too
+static void db_fit_scratch(hs_scratch_t*& ss)
+{
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+
+    for ( const auto& it : s_shared )
+    {
+        if ( it.second.gen != s_generation )
+            hs_alloc_scratch(it.second.db, &ss);
+    }
+}
+
 static bool scratch_setup(SnortConfig* sc)
 {
     // find the largest scratch and clone for all slots
     hs_scratch_t* max = nullptr;
 
-    if ( !s_scratch.size() )
-        return false;
-
-    for ( unsigned i = 0; i < sc->num_slots; ++i )
+    for ( unsigned i = 0; i < s_scratch.size(); ++i )
     {
         if ( !s_scratch[i] )
             continue;
@@ -333,6 +602,9 @@ static bool scratch_setup(SnortConfig* sc)
         }
         s_scratch[i] = nullptr;
     }
+    db_fit_scratch(max);
+    db_config_done();
+
     if ( !max )
         return false;
 
@@ -355,10 +627,18 @@ static void scratch_cleanup(SnortConfig* sc)
     }
 }
 
+static const Parameter hs_params[] =
+{
+    { "cache_dir", Parameter::PT_STRING, nullptr, nullptr,
+      "directory for compiled pattern databases reused across restarts and reloads" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 class HyperscanModule : public Module
 {
 public:
-    HyperscanModule() : Module(s_name, s_help)
+    HyperscanModule() : Module(s_name, s_help, hs_params)
     {
         scratcher = new SimpleScratchAllocator(scratch_setup, scratch_cleanup);
         scratch_index = scratcher->get_id();
@@ -366,6 +646,25 @@ public:
 
     ~HyperscanModule() override
     { delete scratcher; }
+
+    bool begin(const char*, int, SnortConfig*) override
+    {
+        s_cache_dir.clear();
+        return true;
+    }
+
+    bool set(const char*, Value& v, SnortConfig*) override
+    {
+        if ( v.is("cache_dir") )
+            s_cache_dir = v.get_string();
+        else
+            return false;
+
+        return true;
+    }
+
+    Usage get_usage() const override
+    { return GLOBAL; }
 };
 
 //-------------------------------------------------------------------------
@@ -399,12 +698,20 @@ static void hs_init()
 {
     HyperscanMpse::instances = 0;
     HyperscanMpse::patterns = 0;
+    HyperscanMpse::shared = 0;
+    HyperscanMpse::reused = 0;
+    HyperscanMpse::cache_loads = 0;
+    HyperscanMpse::cache_stores = 0;
 }
 
 static void hs_print()
 {
     LogCount("instances", HyperscanMpse::instances);
     LogCount("patterns", HyperscanMpse::patterns);
+    LogCount("shared databases", HyperscanMpse::shared);
+    LogCount("reused databases", HyperscanMpse::reused);
+    LogCount("cache loads", HyperscanMpse::cache_loads);
+    LogCount("cache stores", HyperscanMpse::cache_stores);
 }
 
 static const MpseApi hs_api =
@@ -24,6 +24,23 @@
 
 #include "managers/plugin_manager.h"
 
+#ifdef UNIT_TEST
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+
+#include "catch/snort_catch.h"
+#include "framework/mpse.h"
+#include "main/snort_config.h"
+#include "managers/mpse_manager.h"
+#endif
+
 using namespace snort;
 
 extern const BaseApi* se_ac_bnfa[];
@@ -49,3 +66,160 @@ void load_search_engines()
 #endif
 }
 
+
+#ifdef UNIT_TEST
+
+// the same patterns and text are generated on every run so results are comparable
+static unsigned next_rand(unsigned& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static std::vector<std::string> make_patterns(unsigned num, unsigned seed)
+{
+    static const char* alpha = "abcdefghijklmnopqrstuvwxyz0123456789/.-_=";
+    std::vector<std::string> pats;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        std::string s;
+        unsigned len = 4 + next_rand(seed) % 13;
+
+        for ( unsigned j = 0; j < len; ++j )
+            s += alpha[next_rand(seed) % 41];
+
+        pats.emplace_back(s);
+    }
+    return pats;
+}
+
+static std::string make_text(unsigned len, const std::vector<std::string>& pats, unsigned seed)
+{
+    std::string s;
+
+    while ( s.size() < len )
+    {
+        unsigned r = next_rand(seed);
+
+        if ( !(r % 509) )
+            s += pats[next_rand(seed) % pats.size()];
+        else
+            s += (char)(r & 0xff);
+    }
+    s.resize(len);
+    return s;
+}
+
+// SNORT_BENCH_CORPUS names a file of recorded payloads, eg extracted from a pcap
+static std::string load_corpus()
+{
+    const char* file = getenv("SNORT_BENCH_CORPUS");
+
+    if ( !file )
+        return "";
+
+    std::ifstream in(file, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+static int count_match(void*, void*, int, void* context, void*)
+{
+    ++*(unsigned*)context;
+    return 0;
+}
+
+// the engines allocate with calloc, new, and their own libraries, none of which go through the
+// memory profiler, so the build is measured by the heap in use on this thread's (main) arena
+static bool heap_in_use(size_t& bytes)
+{
+#ifdef HAVE_MALLINFO2
+    bytes = mallinfo2().uordblks;
+    return true;
+#else
+    bytes = 0;
+    return false;
+#endif
+}
+
+static Mpse* build_mpse(const MpseApi* api, const std::vector<std::string>& pats)
+{
+    Mpse* mpse = MpseManager::get_search_engine(SnortConfig::get_conf(), api, nullptr);
+    Mpse::PatternDescriptor desc(true, false, true);
+
+    for ( unsigned i = 0; i < pats.size(); ++i )
+    {
+        mpse->add_pattern(nullptr, (const uint8_t*)pats[i].c_str(), pats[i].size(), desc,
+            (void*)(long)(i + 1));
+    }
+    mpse->prep_patterns(nullptr);
+    return mpse;
+}
+
+TEST_CASE("search engines", "[search_engines][.benchmark]")
+{
+    const std::vector<std::string> pats = make_patterns(2000, 7);
+    const std::string text = make_text(64 * 1024, pats, 11);
+    const std::string corpus = load_corpus();
+
+    if ( corpus.empty() )
+        WARN("SNORT_BENCH_CORPUS not set, skipping recorded corpus");
+
+    for ( const char* method :
+        { "ac_bnfa", "ac_full", "ac_sparse", "ac_banded", "ac_sparse_bands", "ac_std",
+          "hyperscan" } )
+    {
+        const MpseApi* api = MpseManager::get_search_api(method);
+
+        if ( !api )
+            continue;
+
+        const std::string name = method;
+
+        BENCHMARK("build " + name)
+        {
+            Mpse* mpse = build_mpse(api, pats);
+            int n = mpse->get_pattern_count();
+            MpseManager::delete_search_engine(mpse);
+            return n;
+        };
+
+        size_t before, after;
+        bool have_heap = heap_in_use(before);
+        Mpse* mpse = build_mpse(api, pats);
+        heap_in_use(after);
+
+        if ( have_heap )
+            WARN(name << " memory: " << (after > before ? after - before : 0) << " bytes");
+        else
+            WARN(name << " memory: heap size not available");
+
+        // hyperscan scratch is only allocated for packet threads
+        if ( name != "hyperscan" )
+        {
+            BENCHMARK("search synthetic " + name)
+            {
+                unsigned hits = 0;
+                int state = 0;
+                mpse->search((const uint8_t*)text.data(), text.size(), count_match, &hits,
+                    &state);
+                return hits;
+            };
+
+            if ( !corpus.empty() )
+            {
+                BENCHMARK("search corpus " + name)
+                {
+                    unsigned hits = 0;
+                    int state = 0;
+                    mpse->search((const uint8_t*)corpus.data(), corpus.size(), count_match,
+                        &hits, &state);
+                    return hits;
+                };
+            }
+        }
+        MpseManager::delete_search_engine(mpse);
+    }
+}
+
+#endif
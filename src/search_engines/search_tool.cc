@@ -21,16 +21,164 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
 
 #include "detection/fp_config.h"
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
+#include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
+#include "utils/stats.h"
 #include "search_tool.h"
 
 namespace snort
 {
+//--------------------------------------------------------------------------
+// deferred compilation
+//--------------------------------------------------------------------------
+
+struct QueuedTool
+{
+    SearchTool* tool;
+    std::string owner;
+};
+
+struct OwnerStats
+{
+    unsigned tools = 0;
+    double secs = 0;
+};
+
+// tools are only queued by the main thread while configuring
+static THREAD_LOCAL bool s_queuing = false;
+static std::string s_owner;
+static std::list<QueuedTool> s_queue;
+static std::map<std::string, OwnerStats> s_owners;
+static std::mutex s_mutex;
+
+static bool get_tool(QueuedTool& qt)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    if ( s_queue.empty() )
+        return false;
+
+    qt = s_queue.front();
+    s_queue.pop_front();
+
+    return true;
+}
+
+static void add_time(const std::string& owner, double secs)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    OwnerStats& os = s_owners[owner];
+    os.tools++;
+    os.secs += secs;
+}
+
+static double get_secs(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    return d.count();
+}
+
+void SearchTool::start_queue()
+{
+    s_queuing = true;
+}
+
+void SearchTool::set_owner(const char* s)
+{
+    s_owner = s ? s : "";
+}
+
+void SearchTool::compile_tools(unsigned id)
+{
+    set_instance_id(id);
+    QueuedTool qt;
+
+    while ( get_tool(qt) )
+    {
+        auto start = std::chrono::steady_clock::now();
+        qt.tool->queued = false;
+        qt.tool->compile();
+        add_time(qt.owner, get_secs(start));
+    }
+}
+
+void SearchTool::compile_queue(SnortConfig* sc, bool parallel)
+{
+    s_queuing = false;
+    s_owner.clear();
+
+    if ( s_queue.empty() )
+        return;
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned tools = s_queue.size();
+    std::list<QueuedTool> pending;
+
+    // engines that can't be built concurrently are done first on this thread
+    if ( parallel )
+    {
+        for ( auto it = s_queue.begin(); it != s_queue.end(); )
+        {
+            auto next = std::next(it);
+
+            if ( it->tool->parallel_compiles() )
+                pending.splice(pending.end(), s_queue, it);
+
+            it = next;
+        }
+    }
+    compile_tools(get_instance_id());
+
+    s_queue.swap(pending);
+    unsigned max = std::min((unsigned)s_queue.size(), sc->num_slots);
+
+    if ( max == 1 )
+        compile_tools(get_instance_id());
+
+    else if ( max > 1 )
+    {
+        std::list<std::thread*> workers;
+
+        for ( unsigned i = 0; i < max; ++i )
+            workers.push_back(new std::thread(compile_tools, i));
+
+        for ( auto* w : workers )
+        {
+            w->join();
+            delete w;
+        }
+    }
+
+    LogLabel("search tools");
+    LogCount("tools", tools);
+    LogCount("compile threads", max);
+
+    for ( const auto& os : s_owners )
+    {
+        const char* owner = os.first.empty() ? "other" : os.first.c_str();
+        LogMessage("%25.25s: %.3f sec (%u)\n", owner, os.second.secs, os.second.tools);
+    }
+    LogMessage("%25.25s: %.3f sec\n", "elapsed", get_secs(start));
+    s_owners.clear();
+}
+
+//--------------------------------------------------------------------------
+// search tool
+//--------------------------------------------------------------------------
+
 SearchTool::SearchTool(const char* method, bool dfa)
 {
     mpsegrp = new MpseGroup;
@@ -61,10 +209,14 @@ SearchTool::SearchTool(const char* method, bool dfa)
     }
 
     max_len = 0;
+    queued = false;
 }
 
 SearchTool::~SearchTool()
 {
+    if ( queued )
+        s_queue.remove_if([this](const QueuedTool& qt) { return qt.tool == this; });
+
     delete mpsegrp;
 }
 
@@ -97,6 +249,31 @@ void SearchTool::add(const uint8_t* pat, unsigned len, void* id, bool no_case)
 }
 
 void SearchTool::prep()
+{
+    if ( s_queuing )
+    {
+        if ( !queued )
+        {
+            s_queue.push_back({ this, s_owner });
+            queued = true;
+        }
+        return;
+    }
+    compile();
+}
+
+bool SearchTool::parallel_compiles()
+{
+    if ( mpsegrp->normal_mpse and !(mpsegrp->normal_mpse->get_api()->flags & MPSE_MTBLD) )
+        return false;
+
+    if ( mpsegrp->offload_mpse and !(mpsegrp->offload_mpse->get_api()->flags & MPSE_MTBLD) )
+        return false;
+
+    return true;
+}
+
+void SearchTool::compile()
 {
     if ( mpsegrp->normal_mpse )
         mpsegrp->normal_mpse->prep_patterns(nullptr);
@@ -36,8 +36,15 @@ public:
     void add(const uint8_t* pattern, unsigned len, int s_id, bool no_case = true);
     void add(const uint8_t* pattern, unsigned len, void* s_context, bool no_case = true);
 
+    // while queuing, prep() defers compilation to compile_queue() which
+    // builds all pending tools together, in parallel when their search
+    // engines support it; the owner labels the startup summary
     void prep();
 
+    static void start_queue();
+    static void set_owner(const char*);
+    static void compile_queue(SnortConfig*, bool parallel);
+
     // set state to zero on first call
     int find(const char* s, unsigned s_len, MpseMatch, int& state,
         bool confine = false, void* user_data = nullptr);
@@ -49,8 +56,14 @@ public:
         bool confine = false, void* user_data = nullptr);
 
 private:
+    void compile();
+    bool parallel_compiles();
+
+    static void compile_tools(unsigned id);
+
     class MpseGroup* mpsegrp;
     unsigned max_len;
+    bool queued;
 };
 } // namespace snort
 #endif
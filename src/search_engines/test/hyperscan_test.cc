@@ -22,12 +22,23 @@
 #include "config.h"
 #endif
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
 
 #include "framework/base_api.h"
 #include "framework/counts.h"
 #include "framework/mpse.h"
+#include "framework/module.h"
 #include "framework/mpse_batch.h"
+#include "framework/value.h"
 #include "main/snort_config.h"
 #include "utils/stats.h"
 
@@ -125,8 +136,22 @@ static unsigned parse_errors = 0;
 void ParseError(const char*, ...)
 { parse_errors++; }
 
-void LogCount(char const*, uint64_t, FILE*)
-{ }
+static std::map<std::string, uint64_t> s_counts;
+
+void LogCount(char const* name, uint64_t n, FILE*)
+{ s_counts[name] = n; }
+
+static unsigned warnings = 0;
+void WarningMessage(const char*, ...)
+{ warnings++; }
+
+// distinct pattern sets must get distinct digests or they will share a database
+void sha256(const unsigned char* data, size_t size, unsigned char* digest)
+{
+    size_t h = std::hash<std::string>()(std::string((const char*)data, size));
+    memset(digest, 0, 32);
+    memcpy(digest, &h, sizeof(h));
+}
 
 unsigned get_instance_id()
 { return 0; }
@@ -426,6 +451,300 @@ TEST(mpse_hs_multi, single)
     CHECK(hits == 1);
 }
 
+TEST(mpse_hs_multi, shared)
+{
+    Mpse::PatternDescriptor desc;
+
+    CHECK(hs1->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+    CHECK(hs2->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+
+    CHECK(hs1->prep_patterns(snort_conf) == 0);
+    CHECK(hs2->prep_patterns(snort_conf) == 0);
+
+    do_cleanup = scratcher->setup(snort_conf);
+
+    // the shared database must outlive the first instance
+    mpse_api->dtor(hs1);
+    hs1 = mpse_api->ctor(snort_conf, nullptr, &s_agent);
+    CHECK(hs1);
+
+    int state = 0;
+    CHECK(hs2->search((const uint8_t*)"fubar", 5, match, nullptr, &state) == 1);
+    CHECK(hits == 1);
+}
+
+// a database kept from an earlier config, eg appid's http matchers on
+// reload_config, still needs scratch in the new config
+TEST(mpse_hs_multi, kept)
+{
+    Mpse::PatternDescriptor desc;
+
+    CHECK(hs1->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+    CHECK(hs1->prep_patterns(snort_conf) == 0);
+
+    CHECK(scratcher->setup(snort_conf));
+    scratcher->cleanup(snort_conf);
+
+    // nothing is prepped for the next config
+    do_cleanup = scratcher->setup(snort_conf);
+    CHECK(do_cleanup);
+
+    int state = 0;
+    CHECK(hs1->search((const uint8_t*)"fubar", 5, match, nullptr, &state) == 1);
+    CHECK(hits == 1);
+}
+
+static uint64_t get_count(const char* name)
+{
+    s_counts.clear();
+    ((const MpseApi*)se_hyperscan)->print();
+    return s_counts[name];
+}
+
+TEST(mpse_hs_multi, reused)
+{
+    Mpse::PatternDescriptor desc;
+    mpse_api->init();
+
+    CHECK(hs1->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+    CHECK(hs2->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+
+    CHECK(hs1->prep_patterns(snort_conf) == 0);
+    CHECK(hs2->prep_patterns(snort_conf) == 0);
+
+    CHECK(get_count("shared databases") == 1);
+    CHECK(get_count("reused databases") == 0);
+
+    // the config is done so the next instance is built for a reload
+    do_cleanup = scratcher->setup(snort_conf);
+
+    Mpse* hs3 = mpse_api->ctor(snort_conf, nullptr, &s_agent);
+    Mpse* hs4 = mpse_api->ctor(snort_conf, nullptr, &s_agent);
+
+    CHECK(hs3->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+    CHECK(hs4->add_pattern(nullptr, (const uint8_t*)"uba", 3, desc, s_user) == 0);
+
+    CHECK(hs3->prep_patterns(snort_conf) == 0);
+    CHECK(get_count("shared databases") == 1);
+    CHECK(get_count("reused databases") == 1);
+
+    // a second copy in the new config is a duplicate
+    CHECK(hs4->prep_patterns(snort_conf) == 0);
+    CHECK(get_count("shared databases") == 2);
+    CHECK(get_count("reused databases") == 1);
+
+    mpse_api->dtor(hs3);
+    mpse_api->dtor(hs4);
+}
+
+//-------------------------------------------------------------------------
+// database cache tests
+//-------------------------------------------------------------------------
+
+static std::vector<std::string> list_dir(const std::string& dir, const char* suffix)
+{
+    std::vector<std::string> files;
+    DIR* d = opendir(dir.c_str());
+
+    if ( !d )
+        return files;
+
+    while ( dirent* de = readdir(d) )
+    {
+        std::string f = de->d_name;
+        size_t n = strlen(suffix);
+
+        if ( f[0] != '.' and f.size() > n and !f.compare(f.size() - n, n, suffix) )
+            files.emplace_back(dir + "/" + f);
+    }
+    closedir(d);
+    return files;
+}
+
+static ino_t get_inode(const std::string& file)
+{
+    struct stat st;
+    return stat(file.c_str(), &st) ? 0 : st.st_ino;
+}
+
+TEST_GROUP(mpse_hs_cache)
+{
+    Module* mod = nullptr;
+    bool do_cleanup = false;
+    const MpseApi* mpse_api = (const MpseApi*)se_hyperscan;
+    std::string dir;
+
+    void setup() override
+    {
+        // FIXIT-L cpputest hangs or crashes in the leak detector
+        MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
+        CHECK(se_hyperscan);
+
+        char tmp[] = "/tmp/hs_cache_XXXXXX";
+        CHECK(mkdtemp(tmp));
+        dir = tmp;
+
+        mod = mpse_api->base.mod_ctor();
+        set_cache_dir(dir.c_str());
+        mpse_api->init();
+
+        parse_errors = 0;
+        warnings = 0;
+        hits = 0;
+    }
+    void teardown() override
+    {
+        for ( const auto& f : list_dir(dir, "") )
+            unlink(f.c_str());
+
+        rmdir(dir.c_str());
+
+        if ( do_cleanup )
+            scratcher->cleanup(snort_conf);
+
+        mpse_api->base.mod_dtor(mod);
+        MemoryLeakWarningPlugin::turnOnNewDeleteOverloads();
+    }
+    void set_cache_dir(const char* s)
+    {
+        Value v(s);
+        v.set(mod->get_parameters());
+        CHECK(mod->begin("hyperscan", 0, snort_conf));
+        CHECK(mod->set("hyperscan.cache_dir", v, snort_conf));
+    }
+    Mpse* build(const char* pat)
+    {
+        Mpse::PatternDescriptor desc;
+        Mpse* hs = mpse_api->ctor(snort_conf, nullptr, &s_agent);
+        CHECK(hs->add_pattern(nullptr, (const uint8_t*)pat, strlen(pat), desc, s_user) == 0);
+        CHECK(hs->prep_patterns(snort_conf) == 0);
+        return hs;
+    }
+    unsigned search(Mpse* hs, const char* s)
+    {
+        int state = 0;
+        return hs->search((const uint8_t*)s, strlen(s), match, nullptr, &state);
+    }
+};
+
+TEST(mpse_hs_cache, store_and_load)
+{
+    Mpse* hs = build("uba");
+    CHECK(get_count("cache stores") == 1);
+    CHECK(get_count("cache loads") == 0);
+
+    std::vector<std::string> files = list_dir(dir, ".hsdb");
+    CHECK(files.size() == 1);
+    CHECK(list_dir(dir, ".tmp").empty());
+
+    // once the running database is released the next build loads the file
+    mpse_api->dtor(hs);
+    hs = build("uba");
+    CHECK(get_count("cache stores") == 1);
+    CHECK(get_count("cache loads") == 1);
+
+    do_cleanup = scratcher->setup(snort_conf);
+    CHECK(search(hs, "fubar") == 1);
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_cache, bad_header)
+{
+    mpse_api->dtor(build("uba"));
+    std::vector<std::string> files = list_dir(dir, ".hsdb");
+    CHECK(files.size() == 1);
+
+    int fd = open(files[0].c_str(), O_WRONLY);
+    CHECK(fd >= 0);
+    CHECK(write(fd, "X", 1) == 1);
+    close(fd);
+
+    ino_t ino = get_inode(files[0]);
+
+    // a bad magic is compiled and the file is replaced by a rename
+    Mpse* hs = build("uba");
+    CHECK(get_count("cache loads") == 0);
+    CHECK(get_count("cache stores") == 2);
+    CHECK(get_inode(files[0]) != ino);
+    CHECK(list_dir(dir, ".tmp").empty());
+
+    char magic[8];
+    fd = open(files[0].c_str(), O_RDONLY);
+    CHECK(read(fd, magic, sizeof(magic)) == sizeof(magic));
+    close(fd);
+    CHECK(!memcmp(magic, "SNORTHS", 8));
+
+    do_cleanup = scratcher->setup(snort_conf);
+    CHECK(search(hs, "fubar") == 1);
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_cache, truncated)
+{
+    mpse_api->dtor(build("uba"));
+    std::vector<std::string> files = list_dir(dir, ".hsdb");
+    CHECK(files.size() == 1);
+
+    struct stat st;
+    CHECK(!stat(files[0].c_str(), &st));
+    CHECK(!truncate(files[0].c_str(), st.st_size - 1));
+
+    Mpse* hs = build("uba");
+    CHECK(get_count("cache loads") == 0);
+    CHECK(get_count("cache stores") == 2);
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_cache, digest_mismatch)
+{
+    mpse_api->dtor(build("uba"));
+    mpse_api->dtor(build("tuba"));
+
+    std::vector<std::string> files = list_dir(dir, ".hsdb");
+    CHECK(files.size() == 2);
+
+    // put one set's database under the other set's name
+    CHECK(!unlink(files[1].c_str()));
+    CHECK(!link(files[0].c_str(), files[1].c_str()));
+
+    Mpse* uba = build("uba");
+    Mpse* tuba = build("tuba");
+
+    // one loads its own file, the other rejects the copy and compiles
+    CHECK(get_count("cache loads") == 1);
+    CHECK(get_count("cache stores") == 3);
+
+    do_cleanup = scratcher->setup(snort_conf);
+    CHECK(search(uba, "fubar") == 1);
+    CHECK(search(tuba, "fubar") == 0);
+    CHECK(search(tuba, "tuba") == 1);
+
+    mpse_api->dtor(uba);
+    mpse_api->dtor(tuba);
+}
+
+TEST(mpse_hs_cache, write_error)
+{
+    set_cache_dir((dir + "/missing").c_str());
+
+    Mpse* hs = build("uba");
+    CHECK(get_count("cache stores") == 0);
+    CHECK(warnings == 1);
+    CHECK(parse_errors == 0);
+    mpse_api->dtor(hs);
+}
+
+TEST(mpse_hs_cache, config_done)
+{
+    // a reloaded config without cache_dir doesn't use the last one
+    do_cleanup = scratcher->setup(snort_conf);
+
+    Mpse* hs = build("uba");
+    CHECK(get_count("cache stores") == 0);
+    CHECK(list_dir(dir, ".hsdb").empty());
+    mpse_api->dtor(hs);
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
@@ -45,6 +45,8 @@ using namespace snort;
 // base stuff
 //-------------------------------------------------------------------------
 
+void set_instance_id(unsigned) { }
+
 namespace snort
 {
 SnortConfig s_conf;
@@ -71,6 +73,7 @@ SnortConfig* SnortConfig::get_parser_conf()
 unsigned get_instance_id()
 { return 0; }
 
+void LogLabel(const char*, FILE*) { }
 void LogValue(const char*, const char*, FILE*) { }
 void LogMessage(const char*, ...) { }
 [[noreturn]] void FatalError(const char*,...) { exit(1); }
@@ -418,6 +421,104 @@ TEST(search_tool_full, search_all)
     CHECK(s_found == 5);
 }
 
+//-------------------------------------------------------------------------
+// deferred compile tests
+//-------------------------------------------------------------------------
+
+static SearchTool* make_tool(const char* method)
+{
+    SearchTool* st = new SearchTool(method, true);
+    st->add("the", 3, 1);
+    st->add("tuba", 4, 77);
+    st->add("uba", 3, 78);
+    st->add("away", 4, 2112);
+    st->add("nothere", 7, 1000);
+    st->prep();
+    return st;
+}
+
+static void check_tool(SearchTool* st)
+{
+    const char* datastr = "the tuba ran away with the tuna";
+    const ExpectedMatch xm[] =
+    {
+        { 1, 3 },
+        { 78, 8 },
+        { 2112, 17 },
+        { 1, 26 },
+        { 0, 0 }
+    };
+
+    s_expect = xm;
+    s_found = 0;
+
+    int result = st->find(datastr, strlen(datastr), Test_SearchStrFound);
+
+    CHECK(result == 4);
+    CHECK(s_found == 4);
+}
+
+TEST_GROUP(search_tool_queue)
+{
+    void teardown() override
+    {
+        s_conf.num_slots = 1;
+    }
+};
+
+TEST(search_tool_queue, deferred)
+{
+    SearchTool::start_queue();
+    SearchTool::set_owner("test");
+
+    SearchTool* full = make_tool("ac_full");
+    SearchTool* bnfa = make_tool("ac_bnfa");
+    SearchTool* gone = make_tool("ac_full");
+
+    CHECK(full->queued);
+    CHECK(bnfa->queued);
+    delete gone;
+
+    SearchTool::compile_queue(&s_conf, false);
+
+    CHECK(!full->queued);
+    CHECK(!bnfa->queued);
+
+    check_tool(full);
+    check_tool(bnfa);
+
+    delete full;
+    delete bnfa;
+}
+
+TEST(search_tool_queue, parallel)
+{
+    std::vector<SearchTool*> tools;
+    s_conf.num_slots = 4;
+
+    SearchTool::start_queue();
+
+    for ( unsigned i = 0; i < 16; ++i )
+        tools.emplace_back(make_tool(i % 4 ? "ac_full" : "ac_bnfa"));
+
+    SearchTool::compile_queue(&s_conf, true);
+
+    for ( auto* st : tools )
+    {
+        CHECK(!st->queued);
+        check_tool(st);
+        delete st;
+    }
+}
+
+TEST(search_tool_queue, immediate)
+{
+    SearchTool* st = make_tool("ac_full");
+    CHECK(!st->queued);
+    check_tool(st);
+    delete st;
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
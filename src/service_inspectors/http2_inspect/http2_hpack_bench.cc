@@ -0,0 +1,179 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http2_hpack_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch/snort_catch.h"
+
+#include "http2_hpack_dynamic_table.h"
+#include "http2_hpack_string_decode.h"
+#include "http2_hpack_table.h"
+#include "http2_huffman_table.h"
+
+static const uint8_t HUFFMAN_FLAG = 0x80;
+
+// Build an HPACK Huffman string literal, length prefix included
+static std::vector<uint8_t> huffman_encode(const std::string& s)
+{
+    std::vector<uint8_t> code;
+    uint64_t bits = 0;
+    unsigned num_bits = 0;
+
+    for (const char c : s)
+    {
+        const uint8_t symbol = c;
+        bits = (bits << huffman_table.get_code_len(symbol)) | huffman_table.get_code(symbol);
+        num_bits += huffman_table.get_code_len(symbol);
+
+        while (num_bits >= 8)
+        {
+            num_bits -= 8;
+            code.push_back(bits >> num_bits);
+        }
+    }
+    if (num_bits)
+        code.push_back((bits << (8 - num_bits)) | ((1 << (8 - num_bits)) - 1));
+
+    std::vector<uint8_t> literal;
+    uint32_t len = code.size();
+
+    if (len < 0x7F)
+        literal.push_back(HUFFMAN_FLAG | len);
+    else
+    {
+        literal.push_back(HUFFMAN_FLAG | 0x7F);
+        for (len -= 0x7F; len >= 0x80; len >>= 7)
+            literal.push_back(0x80 | (len & 0x7F));
+        literal.push_back(len);
+    }
+    literal.insert(literal.end(), code.begin(), code.end());
+    return literal;
+}
+
+static bool huffman_decode(const Http2HpackStringDecode& decode, const std::vector<uint8_t>& in,
+    std::vector<uint8_t>& out, uint32_t& bytes_written)
+{
+    Http2EventGen events;
+    Http2Infractions infractions;
+    uint32_t bytes_consumed;
+
+    return decode.translate(in.data(), in.size(), bytes_consumed, out.data(), out.size(),
+        bytes_written, &events, &infractions);
+}
+
+TEST_CASE("hpack huffman round trip", "[http2_hpack]")
+{
+    std::string s;
+
+    // every symbol, each followed by every length of short code
+    for (unsigned c = 0; c < 256; c++)
+    {
+        s += (char)c;
+        s += "0 %:aA{";
+    }
+
+    const std::vector<uint8_t> in = huffman_encode(s);
+    std::vector<uint8_t> out(in.size() * 8 / 5);
+    uint32_t bytes_written;
+
+    CHECK(huffman_decode(Http2HpackStringDecode(), in, out, bytes_written));
+    CHECK(bytes_written == s.size());
+    CHECK(!memcmp(out.data(), s.data(), s.size()));
+}
+
+TEST_CASE("hpack dynamic table arena", "[http2_hpack]")
+{
+    HpackDynamicTable table;
+    std::string value;
+
+    // entries of every size up to the table size churn the ring without growing it past the bound
+    for (unsigned i = 0; i < 2000; i++)
+    {
+        value.assign((i * 37) % 4000, 'a' + i % 26);
+        const Field name(4, (const uint8_t*)"name");
+        const Field val(value.size(), (const uint8_t*)value.data());
+
+        CHECK(table.add_entry(name, val));
+        CHECK(table.get_arena_size() <= 2 * table.get_max_size());
+
+        const HpackTableEntry* entry = table.get_entry(HpackIndexTable::STATIC_MAX_INDEX + 1);
+        REQUIRE(entry);
+        CHECK(entry->value.length() == (int32_t)value.size());
+        CHECK(!memcmp(entry->value.start(), value.data(), value.size()));
+    }
+
+    // a lower table size shrinks the arena and keeps the entries that still fit
+    const std::string last(100, 'z');
+    const Field name(4, (const uint8_t*)"last");
+    const Field val(last.size(), (const uint8_t*)last.data());
+    CHECK(table.add_entry(name, val));
+    table.update_size(256);
+    CHECK(table.get_arena_size() == 1024);
+
+    const HpackTableEntry* entry = table.get_entry(HpackIndexTable::STATIC_MAX_INDEX + 1);
+    REQUIRE(entry);
+    CHECK(!memcmp(entry->name.start(), "last", 4));
+    CHECK(entry->value.start()[99] == 'z');
+
+    table.update_size(0);
+    CHECK(!table.get_entry(HpackIndexTable::STATIC_MAX_INDEX + 1));
+}
+
+TEST_CASE("hpack huffman decode", "[http2_hpack][.benchmark]")
+{
+    const char* const headers[] =
+    {
+        "www.example.com",
+        "/api/v2/items?id=1234567&session=0f3a9c2b7d814e6a",
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) "
+            "Chrome/86.0.4240.75 Safari/537.36",
+        "text/html,application/xhtml+xml,application/xml;q=0.9,image/webp,*/*;q=0.8",
+        "gzip, deflate, br",
+        "en-US,en;q=0.9",
+        "_ga=GA1.2.1234567890.1602612345; _gid=GA1.2.987654321.1602612345",
+        "Tue, 13 Oct 2020 18:05:11 GMT",
+    };
+
+    std::vector<std::vector<uint8_t>> block;
+
+    for (auto h : headers)
+        block.emplace_back(huffman_encode(h));
+
+    const Http2HpackStringDecode decode;
+    std::vector<uint8_t> out(1024);
+
+    BENCHMARK("header block")
+    {
+        uint32_t total = 0;
+
+        for (auto& in : block)
+        {
+            uint32_t bytes_written;
+            huffman_decode(decode, in, out, bytes_written);
+            total += bytes_written;
+        }
+        return total;
+    };
+}
@@ -26,15 +26,120 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <new>
+
 #include "http2_hpack_table.h"
 
 using namespace Http2Enums;
 
 HpackDynamicTable::~HpackDynamicTable()
 {
-    for (unsigned i = 0; i < ARRAY_CAPACITY; i++)
-        delete circular_array[i];
-    delete[] circular_array;
+    for (uint32_t i = 0; i < num_entries; i++)
+        circular_array[array_index(i)].~HpackTableEntry();
+    operator delete(circular_array);
+    delete[] arena;
+}
+
+// Double the circular array, moving the entries to its front in table order
+void HpackDynamicTable::expand_array()
+{
+    const uint32_t new_capacity = array_capacity ? 2 * array_capacity : INITIAL_ARRAY_CAPACITY;
+    HpackTableEntry* new_array =
+        static_cast<HpackTableEntry*>(operator new(new_capacity * sizeof(HpackTableEntry)));
+
+    for (uint32_t i = 0; i < num_entries; i++)
+    {
+        HpackTableEntry& entry = circular_array[array_index(i)];
+        new (&new_array[i]) HpackTableEntry(entry.name.length(), entry.name.start(),
+            entry.value.length(), entry.value.start());
+        entry.~HpackTableEntry();
+    }
+
+    operator delete(circular_array);
+    circular_array = new_array;
+    array_capacity = new_capacity;
+    start = 0;
+}
+
+// The name and value bytes of the table are less than max_size. With twice that, the free space
+// either side of a wrapped ring is always large enough for a new entry.
+uint32_t HpackDynamicTable::max_arena_size() const
+{
+    const uint64_t min_size = INITIAL_ARENA_SIZE;
+    return std::max(min_size, std::min(2 * (uint64_t)max_size, (uint64_t)UINT32_MAX));
+}
+
+// Copy the entries into a new arena with at least min_free bytes after them, oldest first.
+// Returns the old arena to be freed by the caller.
+uint8_t* HpackDynamicTable::resize_arena(uint32_t min_free)
+{
+    const uint64_t min_size = INITIAL_ARENA_SIZE;
+    const uint64_t needed = (uint64_t)arena_used() + min_free;
+    const uint32_t new_arena_size = std::max(needed,
+        std::min(std::max(min_size, 2 * needed), (uint64_t)max_arena_size()));
+    uint8_t* new_arena = new uint8_t[new_arena_size];
+    uint32_t head = 0;
+
+    for (uint32_t i = num_entries; i > 0; i--)
+    {
+        HpackTableEntry& entry = circular_array[array_index(i - 1)];
+        const uint32_t name_len = entry.name.length();
+        const uint32_t value_len = entry.value.length();
+        uint8_t* const name = new_arena + head;
+
+        memcpy(name, entry.name.start(), name_len);
+        memcpy(name + name_len, entry.value.start(), value_len);
+        head += name_len + value_len;
+
+        entry.~HpackTableEntry();
+        new (&entry) HpackTableEntry(name_len, name, value_len, name + name_len);
+    }
+
+    uint8_t* const old_arena = arena;
+    arena = new_arena;
+    arena_size = new_arena_size;
+    arena_head = head;
+    return old_arena;
+}
+
+// Returns len contiguous bytes at the head of the arena, wrapping to the front if the end is
+// too short and growing the arena if neither fits. A replaced arena is returned in old_arena.
+uint8_t* HpackDynamicTable::arena_alloc(uint32_t len, uint8_t*& old_arena)
+{
+    bool fits;
+
+    if (arena_used() == 0)
+    {
+        arena_head = 0;
+        fits = arena && arena_size >= len;
+    }
+    else
+    {
+        const HpackTableEntry& oldest = circular_array[array_index(num_entries - 1)];
+        const uint32_t tail = oldest.name.start() - arena;
+
+        if (arena_head <= tail)
+            // wrapped, the head is full when it reaches the tail
+            fits = tail - arena_head >= len;
+
+        else if (arena_size - arena_head >= len)
+            fits = true;
+
+        else if (tail >= len)
+        {
+            arena_head = 0;
+            fits = true;
+        }
+        else
+            fits = false;
+    }
+
+    old_arena = fits ? nullptr : resize_arena(len);
+
+    uint8_t* const ptr = arena + arena_head;
+    arena_head += len;
+    return ptr;
 }
 
 bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
@@ -43,7 +148,9 @@ bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
     if (num_entries >= ARRAY_CAPACITY)
         return false;
 
-    const uint32_t new_entry_size = name.length() + value.length() + RFC_ENTRY_OVERHEAD;
+    const uint32_t name_len = name.length();
+    const uint32_t value_len = value.length();
+    const uint32_t new_entry_size = name_len + value_len + RFC_ENTRY_OVERHEAD;
 
     // As per the RFC, attempting to add an entry that is larger than the max size of the table is
     // not an error, it causes the table to be cleared
@@ -53,16 +160,24 @@ bool HpackDynamicTable::add_entry(const Field& name, const Field& value)
         return true;
     }
 
-    // Create new entry. This is done before pruning because the entry referenced by the new name
-    // may be pruned.
-    HpackTableEntry *new_entry = new HpackTableEntry(name, value);
-
     // If add entry would exceed max table size, evict old entries
     prune_to_size(max_size - new_entry_size);
 
+    if (num_entries == array_capacity)
+        expand_array();
+
+    // The new name may reference an entry that was just pruned. Its bytes are still in the old
+    // arena if that was replaced or in the arena where they may overlap the new entry.
+    uint8_t* old_arena;
+    uint8_t* const new_name = arena_alloc(name_len + value_len, old_arena);
+    memmove(new_name, name.start(), name_len);
+    memmove(new_name + name_len, value.start(), value_len);
+    delete[] old_arena;
+
     // Add new entry to the front of the table (newest entry = lowest index)
-    start = (start + ARRAY_CAPACITY - 1) % ARRAY_CAPACITY;
-    circular_array[start] = new_entry;
+    start = (start + array_capacity - 1) % array_capacity;
+    new (&circular_array[start]) HpackTableEntry(name_len, new_name, value_len,
+        new_name + name_len);
 
     num_entries++;
     if (num_entries > Http2Module::get_peg_counts(PEG_MAX_ENTRIES))
@@ -79,8 +194,7 @@ const HpackTableEntry* HpackDynamicTable::get_entry(uint32_t virtual_index) cons
     if (dyn_index + 1 > num_entries)
         return nullptr;
 
-    const uint32_t arr_index = (start + dyn_index) % ARRAY_CAPACITY;
-    return circular_array[arr_index];
+    return &circular_array[array_index(dyn_index)];
 }
 
 /* This is called when adding a new entry and when receiving a dynamic table size update.
@@ -93,13 +207,28 @@ void HpackDynamicTable::prune_to_size(uint32_t new_max_size)
 {
     while (rfc_table_size > new_max_size)
     {
-        const uint32_t last_index = (start + num_entries - 1 + ARRAY_CAPACITY) % ARRAY_CAPACITY;
+        HpackTableEntry& last = circular_array[array_index(num_entries - 1)];
         num_entries--;
-        rfc_table_size -= circular_array[last_index]->name.length() +
-            circular_array[last_index]->value.length() + RFC_ENTRY_OVERHEAD;
-        delete circular_array[last_index];
-        circular_array[last_index] = nullptr;
+        rfc_table_size -= last.name.length() + last.value.length() + RFC_ENTRY_OVERHEAD;
+        last.~HpackTableEntry();
+    }
+}
+
+// Release the space a lower max table size no longer needs
+void HpackDynamicTable::shrink_arena()
+{
+    if (arena_size <= max_arena_size())
+        return;
+
+    if (arena_used() == 0)
+    {
+        delete[] arena;
+        arena = nullptr;
+        arena_size = 0;
+        arena_head = 0;
     }
+    else
+        delete[] resize_arena(0);
 }
 
 void HpackDynamicTable::update_size(uint32_t new_size)
@@ -109,4 +238,5 @@ void HpackDynamicTable::update_size(uint32_t new_size)
         prune_to_size(new_size);
     }
     max_size = new_size;
+    shrink_arena();
 }
@@ -30,27 +30,48 @@ struct HpackTableEntry;
 class HpackDynamicTable
 {
 public:
-    // FIXIT-P This array can be optimized to start smaller and grow on demand 
-    HpackDynamicTable() : circular_array(new HpackTableEntry*[ARRAY_CAPACITY]()) { }
+    HpackDynamicTable() = default;
     ~HpackDynamicTable();
     const HpackTableEntry* get_entry(uint32_t index) const;
     bool add_entry(const Field& name, const Field& value);
     void update_size(uint32_t new_size);
     uint32_t get_max_size() { return max_size; }
+    uint32_t get_arena_size() const { return arena_size; }
 
 private:
     void expand_array();
+    uint8_t* resize_arena(uint32_t min_free);
+    uint32_t max_arena_size() const;
+    void shrink_arena();
+    uint8_t* arena_alloc(uint32_t len, uint8_t*& old_arena);
+    uint32_t array_index(uint32_t dyn_index) const
+    { return (start + dyn_index) % array_capacity; }
+    uint32_t arena_used() const
+    { return rfc_table_size - num_entries * RFC_ENTRY_OVERHEAD; }
 
     const static uint32_t RFC_ENTRY_OVERHEAD = 32;
 
     const static uint32_t DEFAULT_MAX_SIZE = 4096;
+    const static uint32_t INITIAL_ARRAY_CAPACITY = 16;
     const static uint32_t ARRAY_CAPACITY = 512;
+    const static uint32_t INITIAL_ARENA_SIZE = 1024;
     uint32_t max_size = DEFAULT_MAX_SIZE;
 
+    // Entries are constructed in place in a circular array that doubles up to ARRAY_CAPACITY.
+    // Their names and values are copied into a ring buffer, the arena, instead of being
+    // allocated per entry. Pruned entries free arena space from the tail. The arena grows,
+    // compacting the entries, when a new entry fits neither at the head nor at the front. It
+    // never exceeds twice the max table size, where any entry fits at the head or the front, and
+    // is shrunk to that bound when a table size update lowers it.
     uint32_t start = 0;
     uint32_t num_entries = 0;
     uint32_t rfc_table_size = 0;
-    HpackTableEntry** circular_array;
+    uint32_t array_capacity = 0;
+    HpackTableEntry* circular_array = nullptr;
+
+    uint8_t* arena = nullptr;
+    uint32_t arena_size = 0;
+    uint32_t arena_head = 0;
 
     void prune_to_size(uint32_t new_max_size);
 };
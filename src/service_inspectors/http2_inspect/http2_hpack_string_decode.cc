@@ -24,7 +24,7 @@
 #include "http2_hpack_string_decode.h"
 
 #include "http2_enum.h"
-#include "http2_huffman_state_machine.h"
+#include "http2_huffman_table.h"
 
 #include <math.h>
 
@@ -32,10 +32,6 @@ using namespace Http2Enums;
 
 static const uint8_t HUFFMAN_FLAG = 0x80;
 
-// Minimum bit length for each lookup table
-static const uint8_t min_decode_len[HUFFMAN_LOOKUP_MAX + 1] =
-    {5, 2, 2, 3, 5, 1, 1, 2, 2, 2, 2, 3, 3, 3, 4};
-
 bool Http2HpackStringDecode::translate(const uint8_t* in_buff, const uint32_t in_len,
     uint32_t& bytes_consumed, uint8_t* out_buff, const uint32_t out_len, uint32_t& bytes_written,
     Http2EventGen* events, Http2Infractions* infractions) const
@@ -92,64 +88,10 @@ bool Http2HpackStringDecode::get_string(const uint8_t* in_buff, const uint32_t e
     return true;
 }
 
-// return is tail/padding
-bool Http2HpackStringDecode::get_next_byte(const uint8_t* in_buff, const uint32_t last_byte,
-    uint32_t& bytes_consumed, uint8_t& cur_bit, uint8_t match_len, uint8_t& byte,
-    bool& another_search) const
-{
-    another_search = true;
-    cur_bit += match_len;
-
-    if (cur_bit >= 8) // done with current bit
-    {
-        bytes_consumed++;
-        cur_bit -= 8;
-    }
-
-    bool tail = false;
-    uint8_t msb, lsb = 0xff;
-    if (bytes_consumed == last_byte)
-    {
-        // bytes consumed must be bigger than 1 - int length is at least 1
-        msb = in_buff[bytes_consumed-1];
-        another_search = false;
-        tail = true;
-    }
-    else if ((bytes_consumed + 1) == last_byte)
-    {
-        if (cur_bit != 0)
-        {
-            msb = in_buff[bytes_consumed++];
-            tail = true;
-        }
-        else
-        {
-            byte = in_buff[bytes_consumed];
-            return false;
-        }
-    }
-    else
-    {
-        msb = in_buff[bytes_consumed];
-        lsb = in_buff[bytes_consumed+1];
-    }
-
-    const uint16_t tmp = (uint16_t)(msb << 8) | lsb;
-    byte = (tmp & (0xff00 >> cur_bit)) >> (8 - cur_bit);
-    return tail;
-}
-
 bool Http2HpackStringDecode::get_huffman_string(const uint8_t* in_buff, const uint32_t encoded_len,
     uint32_t& bytes_consumed, uint8_t* out_buff, const uint32_t out_len, uint32_t& bytes_written,
     Http2EventGen* events, Http2Infractions* infractions) const
 {
-    const uint32_t last_encoded_byte = bytes_consumed + encoded_len;
-    uint8_t byte;
-    uint8_t cur_bit = 0;
-    HuffmanEntry result = { 0, 0, HUFFMAN_LOOKUP_1 };
-    bool another_search = false;
-    HuffmanState state = HUFFMAN_LOOKUP_1;
-
     // Check length
     const uint32_t max_length = floor(encoded_len * 8.0/5.0);
     if (max_length > out_len)
@@ -159,87 +101,81 @@ bool Http2HpackStringDecode::get_huffman_string(const uint8_t* in_buff, const ui
         return false;
     }
 
-    while (!get_next_byte(in_buff, last_encoded_byte, bytes_consumed, cur_bit, result.len, byte,
-        another_search))
-    {
-        result = huffman_decode[state][byte];
-
-        switch (result.state) {
-
-        case HUFFMAN_MATCH:
-            out_buff[bytes_written++] = result.symbol;
-            state = HUFFMAN_LOOKUP_1;
-            break;
-
-        case HUFFMAN_LOOKUP_2:
-        case HUFFMAN_LOOKUP_3:
-        case HUFFMAN_LOOKUP_4:
-        case HUFFMAN_LOOKUP_5:
-        case HUFFMAN_LOOKUP_6:
-        case HUFFMAN_LOOKUP_7:
-        case HUFFMAN_LOOKUP_8:
-        case HUFFMAN_LOOKUP_9:
-        case HUFFMAN_LOOKUP_10:
-        case HUFFMAN_LOOKUP_11:
-        case HUFFMAN_LOOKUP_12:
-        case HUFFMAN_LOOKUP_13:
-        case HUFFMAN_LOOKUP_14:
-        case HUFFMAN_LOOKUP_15:
-            state = result.state;
-            break;
+    const uint32_t first_encoded_byte = bytes_consumed;
+    const uint8_t* in = in_buff + first_encoded_byte;
+    const uint8_t* const end = in + encoded_len;
 
-        case HUFFMAN_FAILURE:
-            *infractions += INF_HUFFMAN_DECODED_EOS;
-            events->create_event(EVENT_STRING_DECODE_FAILURE);
-            return false;
-            break;
+    // Unread input is kept left justified in bits, refilled a byte at a time
+    uint64_t bits = 0;
+    unsigned avail = 0;
+    uint32_t decoded_bits = 0;
 
-        default:
-            break;
+    while (true)
+    {
+        while (avail <= 56 && in < end)
+        {
+            bits |= (uint64_t)*in++ << (56 - avail);
+            avail += 8;
         }
-    }
 
-    // Tail needs 1 last lookup in case the leftover is big enough for a match.
-    // Make sure match length <= available length
-    uint8_t leftover_len = 8 - cur_bit;
-    uint8_t old_result_len = result.len;
-    HuffmanState old_result_state = result.state;
+        const Http2HuffmanTable::Entry& e =
+            huffman_table.lookup(bits >> (64 - Http2HuffmanTable::LOOKUP_BITS));
+        uint8_t len;
 
-    if (another_search && (leftover_len >= min_decode_len[state]))
-    {
-        result = huffman_decode[state][byte];
-        if ((result.state == HUFFMAN_MATCH) && (result.len <= leftover_len))
+        if (e.len && e.len <= avail)
         {
-            out_buff[bytes_written++] = result.symbol;
-            byte = (byte << result.len) | (((uint16_t)1 << result.len) - 1);
+            out_buff[bytes_written++] = e.symbol[0];
+            if (e.len > e.first_len)
+                out_buff[bytes_written++] = e.symbol[1];
+            len = e.len;
         }
-        else
+        else if (e.first_len && e.first_len <= avail)
         {
-            // Use leftover bits for padding check if previous lookup was a match
-            if (old_result_state == HUFFMAN_MATCH)
-                result.len = leftover_len;
-            else
-                result.len = old_result_len;
+            out_buff[bytes_written++] = e.symbol[0];
+            len = e.first_len;
         }
-    }
-
-    // Padding check
-    if (result.len < 8)
-    {
-        if (byte != 0xff)
+        else if (!e.first_len)
         {
-            *infractions += INF_HUFFMAN_BAD_PADDING;
-            events->create_event(EVENT_STRING_DECODE_FAILURE);
-            return false;
+            const uint16_t symbol = huffman_table.decode_long(bits >> 32, len);
+
+            if (len > avail)
+                break;
+
+            if (symbol == Http2HuffmanTable::EOS)
+            {
+                // Report where a byte at a time decode would have found it
+                bytes_consumed = first_encoded_byte + (decoded_bits + 24) / 8;
+                *infractions += INF_HUFFMAN_DECODED_EOS;
+                events->create_event(EVENT_STRING_DECODE_FAILURE);
+                return false;
+            }
+            out_buff[bytes_written++] = symbol;
         }
+        else
+            break;
+
+        bits <<= len;
+        avail -= len;
+        decoded_bits += len;
     }
-    else if (result.state != HUFFMAN_MATCH)
+
+    bytes_consumed = first_encoded_byte + encoded_len;
+
+    // The leftover must be padding: the most significant bits of EOS, which are all ones,
+    // and shorter than a byte
+    if (avail >= 8)
     {
         *infractions += INF_HUFFMAN_INCOMPLETE_CODE_PADDING;
         events->create_event(EVENT_STRING_DECODE_FAILURE);
         return false;
     }
 
+    if (avail && (bits >> (64 - avail)) != (1u << avail) - 1)
+    {
+        *infractions += INF_HUFFMAN_BAD_PADDING;
+        events->create_event(EVENT_STRING_DECODE_FAILURE);
+        return false;
+    }
+
     return true;
 }
-
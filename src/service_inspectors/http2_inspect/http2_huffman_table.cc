@@ -0,0 +1,138 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http2_huffman_table.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "http2_huffman_table.h"
+
+#include <cassert>
+
+const Http2HuffmanTable huffman_table;
+
+// code length of each symbol including EOS
+const uint8_t Http2HuffmanTable::code_len[EOS + 1] =
+{
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+     6, 10, 10, 12, 13,  6,  8, 11, 10, 10,  8, 11,  8,  6,  6,  6,
+     5,  5,  5,  6,  6,  6,  6,  6,  6,  6,  7,  8, 15,  6, 12, 10,
+    13,  6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,
+     7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  8, 13, 19, 13, 14,  6,
+    15,  5,  6,  5,  6,  5,  6,  6,  6,  5,  7,  7,  6,  6,  6,  5,
+     6,  7,  6,  5,  5,  6,  7,  7,  7,  7,  7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30
+};
+
+Http2HuffmanTable::Http2HuffmanTable() : first(), count(), offset()
+{
+    for ( unsigned s = 0; s <= EOS; s++ )
+        count[code_len[s]]++;
+
+    // canonical codes are assigned in order of length then symbol
+    uint32_t next = 0;
+    uint16_t sum = 0;
+
+    for ( unsigned len = 1; len <= MAX_CODE_LEN; len++ )
+    {
+        first[len] = next;
+        offset[len] = sum;
+        next = (next + count[len]) << 1;
+        sum += count[len];
+    }
+
+    uint16_t pos[MAX_CODE_LEN + 1];
+
+    for ( unsigned len = 1; len <= MAX_CODE_LEN; len++ )
+        pos[len] = offset[len];
+
+    for ( unsigned s = 0; s <= EOS; s++ )
+    {
+        const uint8_t len = code_len[s];
+        code[s] = first[len] + pos[len] - offset[len];
+        sorted[pos[len]++] = s;
+    }
+
+    // the code is complete; EOS is the last code, all ones
+    assert(code[EOS] == (1u << MAX_CODE_LEN) - 1);
+
+    for ( uint32_t i = 0; i < (1u << LOOKUP_BITS); i++ )
+    {
+        Entry& e = table[i];
+        e = { { 0, 0 }, 0, 0 };
+
+        uint32_t bits = i << (32 - LOOKUP_BITS);
+        unsigned avail = LOOKUP_BITS;
+        uint16_t symbol;
+        uint8_t len;
+
+        if ( !decode(bits, avail, symbol, len) )
+            continue;
+
+        e.symbol[0] = symbol;
+        e.first_len = e.len = len;
+        bits <<= len;
+        avail -= len;
+
+        if ( decode(bits, avail, symbol, len) )
+        {
+            e.symbol[1] = symbol;
+            e.len += len;
+        }
+    }
+}
+
+// bits are left justified
+bool Http2HuffmanTable::decode(uint32_t bits, unsigned avail, uint16_t& symbol, uint8_t& len) const
+{
+    for ( len = 1; len <= avail; len++ )
+    {
+        const uint32_t c = bits >> (32 - len);
+
+        if ( c - first[len] < count[len] )
+        {
+            symbol = sorted[offset[len] + c - first[len]];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint16_t Http2HuffmanTable::decode_long(uint32_t bits, uint8_t& len) const
+{
+    uint16_t symbol;
+
+    if ( !decode(bits, MAX_CODE_LEN, symbol, len) )
+    {
+        symbol = EOS;
+        len = MAX_CODE_LEN;
+    }
+    return symbol;
+}
+
@@ -0,0 +1,77 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http2_huffman_table.h
+
+#ifndef HTTP2_HUFFMAN_TABLE_H
+#define HTTP2_HUFFMAN_TABLE_H
+
+// Decode tables for the HPACK Huffman code (RFC 7541 Appendix B). The code is canonical so it is
+// built from the code lengths alone. Codes of up to LOOKUP_BITS are decoded by a single table
+// lookup that yields one or two symbols. Longer codes are rare in header text and are decoded by
+// comparing against the first code of each length.
+
+#include "main/snort_types.h"
+
+class Http2HuffmanTable
+{
+public:
+    static const unsigned LOOKUP_BITS = 12;
+    static const unsigned MAX_CODE_LEN = 30;
+    static const uint16_t EOS = 256;
+
+    struct Entry
+    {
+        uint8_t symbol[2];
+        uint8_t first_len;  // bits in the first code or 0 if it is longer than LOOKUP_BITS
+        uint8_t len;        // bits in all the codes
+    };
+
+    Http2HuffmanTable();
+
+    // bits are the next LOOKUP_BITS of input
+    const Entry& lookup(uint32_t bits) const
+    { return table[bits]; }
+
+    // bits are the next 32 bits of input; returns the symbol and sets len to its code length
+    uint16_t decode_long(uint32_t bits, uint8_t& len) const;
+
+    uint32_t get_code(uint16_t symbol) const
+    { return code[symbol]; }
+
+    uint8_t get_code_len(uint16_t symbol) const
+    { return code_len[symbol]; }
+
+private:
+    bool decode(uint32_t bits, unsigned avail, uint16_t& symbol, uint8_t& len) const;
+
+    Entry table[1 << LOOKUP_BITS];
+
+    uint32_t code[EOS + 1];
+    uint32_t first[MAX_CODE_LEN + 1];
+    uint16_t count[MAX_CODE_LEN + 1];
+    uint16_t offset[MAX_CODE_LEN + 1];
+    uint16_t sorted[EOS + 1];
+
+    static const uint8_t code_len[EOS + 1];
+};
+
+extern const Http2HuffmanTable huffman_table;
+
+#endif
+
@@ -23,7 +23,7 @@
 #endif
 
 #include "../http2_enum.h"
-#include "../http2_huffman_state_machine.h"
+#include "../http2_huffman_table.h"
 #include "../http2_hpack_string_decode.h"
 #include "../../http_inspect/http_common.h"
 #include "../../http_inspect/http_enum.h"
@@ -597,6 +597,21 @@ TEST(http2_hpack_string_decode_success, huffman_decoding_tail_lookup_unsucessful
     CHECK(bytes_written == 2);
 }
 
+TEST(http2_hpack_string_decode_success, huffman_decoding_long_code_at_end)
+{
+    // '0' (5 bits), 0x00 (13 bits), and ' ' (6 bits) end on the last bit; decodes to 30 00 20
+    uint8_t buf[4] = { 0x83, 0x07, 0xFE, 0x14 };
+    // decode
+    uint32_t bytes_processed = 0, bytes_written = 0;
+    uint8_t res[4];
+    bool success = decode->translate(buf, 4, bytes_processed, res, 4, bytes_written, &events, &inf);
+    // check results
+    CHECK(success == true);
+    CHECK(bytes_processed == 4);
+    CHECK(bytes_written == 3);
+    CHECK(memcmp(res, "0\0 ", 3) == 0);
+}
+
 //
 // The following tests should trigger infractions/events
 //
@@ -878,6 +893,47 @@ TEST(http2_hpack_string_decode_infractions, huffman_decoded_eos)
     CHECK(local_events.get_raw() == (1<<(EVENT_STRING_DECODE_FAILURE-1)));
 }
 
+TEST(http2_hpack_string_decode_infractions, huffman_bad_padding_after_long_string)
+{
+    // prepare decode object
+    Http2EventGen local_events;
+    Http2Infractions local_inf;
+    Http2HpackStringDecode local_decode;
+    // prepare buf to decode - ". gruI*" with padding 110
+    uint8_t buf[7] = { 0x86, 0x5D, 0x49, 0xAC, 0xB7, 0x27, 0xCE };
+    // decode
+    uint32_t bytes_processed = 0, bytes_written = 0;
+    uint8_t res[9];
+    bool success = local_decode.translate(buf, 7, bytes_processed, res, 9, bytes_written, &local_events, &local_inf);
+    // check results
+    CHECK(success == false);
+    CHECK(bytes_processed == 7);
+    CHECK(bytes_written == 7);
+    CHECK(local_inf.get_raw() == (1<<INF_HUFFMAN_BAD_PADDING));
+    CHECK(local_events.get_raw() == (1<<(EVENT_STRING_DECODE_FAILURE-1)));
+    CHECK(memcmp(res, ". gruI*", 7) == 0);
+}
+
+TEST(http2_hpack_string_decode_infractions, huffman_decoded_eos_after_symbols)
+{
+    // prepare decode object
+    Http2EventGen local_events;
+    Http2Infractions local_inf;
+    Http2HpackStringDecode local_decode;
+    // prepare buf to decode - 9 symbols then EOS
+    uint8_t buf[12] = { 0x8B, 0xE2, 0xFF, 0xAE, 0x02, 0xD5, 0x4A, 0x35, 0xFF, 0xFF, 0xFF, 0xFF };
+    // decode
+    uint32_t bytes_processed = 0, bytes_written = 0;
+    uint8_t res[20];
+    bool success = local_decode.translate(buf, 12, bytes_processed, res, 20, bytes_written, &local_events, &local_inf);
+    // check results
+    CHECK(success == false);
+    CHECK(bytes_processed == 11);
+    CHECK(bytes_written == 9);
+    CHECK(local_inf.get_raw() == (1<<INF_HUFFMAN_DECODED_EOS));
+    CHECK(local_events.get_raw() == (1<<(EVENT_STRING_DECODE_FAILURE-1)));
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
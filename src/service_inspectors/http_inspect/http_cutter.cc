@@ -22,6 +22,8 @@
 #endif
 
 #include "http_cutter.h"
+
+#include "decompress/inflate_pool.h"
 #include "http_enum.h"
 
 using namespace HttpEnums;
@@ -256,29 +258,19 @@ HttpBodyCutter::HttpBodyCutter(bool detained_inspection_, CompressId compression
 {
     if (detained_inspection && ((compression == CMP_GZIP) || (compression == CMP_DEFLATE)))
     {
-        compress_stream = new z_stream;
-        compress_stream->zalloc = Z_NULL;
-        compress_stream->zfree = Z_NULL;
-        compress_stream->next_in = Z_NULL;
-        compress_stream->avail_in = 0;
         const int window_bits = (compression == CMP_GZIP) ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
-        if (inflateInit2(compress_stream, window_bits) != Z_OK)
+        compress_stream = snort::InflatePool::acquire(window_bits);
+        if (compress_stream == nullptr)
         {
             assert(false);
             compression = CMP_NONE;
-            delete compress_stream;
-            compress_stream = nullptr;
         }
     }
 }
 
 HttpBodyCutter::~HttpBodyCutter()
 {
-    if (compress_stream != nullptr)
-    {
-        inflateEnd(compress_stream);
-        delete compress_stream;
-    }
+    snort::InflatePool::release(compress_stream);
 }
 
 ScanResult HttpBodyClCutter::cut(const uint8_t* buffer, uint32_t length, HttpInfractions*,
@@ -766,10 +758,13 @@ bool HttpBodyCutter::dangerous(const uint8_t* data, uint32_t length)
         compress_stream->next_out = decomp_output;
         compress_stream->avail_out = decomp_buffer_size;
 
-        int ret_val = inflate(compress_stream, Z_SYNC_FLUSH);
+        int ret_val = snort::InflatePool::inflate(compress_stream, Z_SYNC_FLUSH);
 
         // Not going to be subtle about this and try to fix decompression problems. If it doesn't
         // work out we assume it could be dangerous.
+        // Input past an exhausted time budget (Z_BUDGET_EXCEEDED) can't be checked, so it is
+        // treated as dangerous regardless of what the output inflated so far contains. The
+        // output itself is kept by reassemble(), which also raises the budget event.
         if (((ret_val != Z_OK) && (ret_val != Z_STREAM_END)) || (compress_stream->avail_in > 0))
         {
             delete[] decomp_output;
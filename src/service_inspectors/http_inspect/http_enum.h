@@ -227,6 +227,7 @@ enum Infraction
     INF_VERSION_NOT_UPPERCASE,
     INF_CHUNK_LEADING_WS,
     INF_BAD_HEADER_WHITESPACE,
+    INF_GZIP_BUDGET,
     INF__MAX_VALUE
 };
 
@@ -345,6 +346,7 @@ enum EventSid
     EVENT_BAD_HEADER_WHITESPACE,
     EVENT_GZIP_EARLY_END,                  // 248
     EVENT_EXCESS_REPEAT_PARAMS,
+    EVENT_GZIP_BUDGET,                     // 250
     EVENT__MAX_VALUE
 };
 
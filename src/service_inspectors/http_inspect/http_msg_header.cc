@@ -26,6 +26,7 @@
 #include "http_msg_header.h"
 
 #include "decompress/file_decomp.h"
+#include "decompress/inflate_pool.h"
 #include "file_api/file_flows.h"
 #include "file_api/file_service.h"
 #include "http_api.h"
@@ -428,18 +429,12 @@ void HttpMsgHeader::setup_encoding_decompression()
     if (compression == CMP_NONE)
         return;
 
-    session_data->compress_stream[source_id] = new z_stream;
-    session_data->compress_stream[source_id]->zalloc = Z_NULL;
-    session_data->compress_stream[source_id]->zfree = Z_NULL;
-    session_data->compress_stream[source_id]->next_in = Z_NULL;
-    session_data->compress_stream[source_id]->avail_in = 0;
     const int window_bits = (compression == CMP_GZIP) ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
-    if (inflateInit2(session_data->compress_stream[source_id], window_bits) != Z_OK)
+    session_data->compress_stream[source_id] = InflatePool::acquire(window_bits);
+    if (session_data->compress_stream[source_id] == nullptr)
     {
         assert(false);
         session_data->compression[source_id] = CMP_NONE;
-        delete session_data->compress_stream[source_id];
-        session_data->compress_stream[source_id] = nullptr;
     }
 }
 
@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 
+#include "decompress/inflate_pool.h"
 #include "protocols/packet.h"
 
 #include "http_inspect.h"
@@ -149,7 +150,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
         compress_stream->avail_in = length;
         compress_stream->next_out = buffer + offset;
         compress_stream->avail_out = MAX_OCTETS - offset;
-        int ret_val = inflate(compress_stream, Z_SYNC_FLUSH);
+        int ret_val = InflatePool::inflate(compress_stream, Z_SYNC_FLUSH);
 
         if ((ret_val == Z_OK) || (ret_val == Z_STREAM_END))
         {
@@ -176,8 +177,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
                     events->create_event(EVENT_GZIP_OVERRUN);
                 }
                 compression = CMP_NONE;
-                inflateEnd(compress_stream);
-                delete compress_stream;
+                InflatePool::release(compress_stream);
                 compress_stream = nullptr;
             }
             return;
@@ -198,13 +198,26 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
                 infractions, events);
             return;
         }
+        else if (ret_val == Z_BUDGET_EXCEEDED)
+        {
+            // Keep what was decompressed before the time budget ran out and pass the rest of the
+            // body through as is
+            offset = MAX_OCTETS - compress_stream->avail_out;
+            const uint32_t consumed = length - compress_stream->avail_in;
+            data += consumed;
+            length -= consumed;
+            *infractions += INF_GZIP_BUDGET;
+            events->create_event(EVENT_GZIP_BUDGET);
+            compression = CMP_NONE;
+            InflatePool::release(compress_stream);
+            compress_stream = nullptr;
+        }
         else
         {
             *infractions += INF_GZIP_FAILURE;
             events->create_event(EVENT_GZIP_FAILURE);
             compression = CMP_NONE;
-            inflateEnd(compress_stream);
-            delete compress_stream;
+            InflatePool::release(compress_stream);
             compress_stream = nullptr;
             // Since we failed to uncompress the data, fall through
         }
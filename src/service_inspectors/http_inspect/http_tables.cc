@@ -380,6 +380,7 @@ const RuleMap HttpModule::http_events[] =
     { EVENT_GZIP_EARLY_END,             "gzip compressed data followed by unexpected non-gzip "
                                         "data" },
     { EVENT_EXCESS_REPEAT_PARAMS,       "excessive HTTP parameter key repeats" },
+    { EVENT_GZIP_BUDGET,                "gzip decompression exceeded its time budget" },
     { 0, nullptr }
 };
 
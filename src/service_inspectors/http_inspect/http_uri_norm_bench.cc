@@ -0,0 +1,65 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_uri_norm_bench.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+#include <string>
+
+#include "catch/snort_catch.h"
+
+#include "http_uri_norm.h"
+
+TEST_CASE("uri normalizer", "[http_inspect][.benchmark]")
+{
+    static const struct { const char* name; const char* uri; } uris[] =
+    {
+        { "clean", "/images/logo/header_small.png?version=20200415&size=large" },
+        { "percent", "/search%20results/%7Euser/index%2Ehtml?q=%41%42%43+%44%45" },
+        { "path", "/a/./b/../c//d/.//e/../../f/%2e%2e/g/index.html?x=../y" },
+        { "double", "/scripts/%252e%252e/%252fwinnt/%u0073ystem32/cmd.exe?/c+dir" },
+    };
+    HttpParaList::UriParam uri_param;
+    uri_param.percent_u = true;
+    uint8_t buffer[1024];
+
+    for ( const auto& u : uris )
+    {
+        const Field input(strlen(u.uri), (const uint8_t*)u.uri);
+
+        BENCHMARK(std::string("need norm ") + u.name)
+        {
+            HttpInfractions infractions;
+            HttpEventGen events;
+            return UriNormalizer::need_norm(input, true, uri_param, &infractions, &events);
+        };
+
+        BENCHMARK(std::string("normalize ") + u.name)
+        {
+            HttpInfractions infractions;
+            HttpEventGen events;
+            Field result;
+            UriNormalizer::normalize(input, result, true, buffer, uri_param, &infractions,
+                &events);
+            return result.length();
+        };
+    }
+}
@@ -23,6 +23,7 @@
 #include "config.h"
 #endif
 
+#include "decompress/inflate_pool.h"
 #include "service_inspectors/http_inspect/http_common.h"
 #include "service_inspectors/http_inspect/http_enum.h"
 #include "service_inspectors/http_inspect/http_flow_data.h"
@@ -45,6 +46,7 @@ FlowData::FlowData(unsigned, Inspector*) {}
 FlowData::~FlowData() = default;
 int DetectionEngine::queue_event(unsigned int, unsigned int, Actions::Type) { return 0; }
 fd_status_t File_Decomp_StopFree(fd_session_t*) { return File_Decomp_OK; }
+void InflatePool::release(z_stream*) { }
 size_t str_to_hash(unsigned char const*, size_t) { return 0; }
 }
 
@@ -20,6 +20,7 @@
 #include "config.h"
 #endif
 
+#include <cinttypes>
 #include <functional>
 
 #include "flow/expect_cache.h"
@@ -34,6 +35,7 @@
 #include "protocols/packet.h"
 #include "protocols/tcp.h"
 #include "stream/flush_bucket.h"
+#include "stream/stream.h"
 
 #include "stream_ha.h"
 #include "stream_module.h"
@@ -66,6 +68,8 @@ const PegInfo base_pegs[] =
     { CountType::SUM, "expected_realized", "number of expected flows realized" },
     { CountType::SUM, "expected_pruned", "number of expected flows pruned" },
     { CountType::SUM, "expected_overflows", "number of expected cache overflows" },
+    { CountType::SUM, "expected_expired", "number of expected flows that timed out" },
+    { CountType::SUM, "expected_cross_thread", "expected flows realized on another thread" },
     { CountType::SUM, "reload_tuning_idle", "number of times stream resource tuner called while idle" },
     { CountType::SUM, "reload_tuning_packets", "number of times stream resource tuner called while processing packets" },
     { CountType::SUM, "reload_total_adds", "number of flows added by config reloads" },
@@ -74,6 +78,8 @@ const PegInfo base_pegs[] =
     { CountType::SUM, "reload_allowed_deletes", "number of allowed flows deleted by config reloads" },
     { CountType::SUM, "reload_blocked_deletes", "number of blocked flows deleted by config reloads" },
     { CountType::SUM, "reload_offloaded_deletes", "number of offloaded flows deleted by config reloads" },
+    { CountType::SUM, "elephant_flows", "flows offloaded after meeting the elephant criteria" },
+    { CountType::SUM, "elephant_inspected_bytes", "bytes inspected on flows before they were offloaded as elephants" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -104,6 +110,8 @@ void base_sum()
         stream_base_stats.expected_realized = exp_cache->get_realized();
         stream_base_stats.expected_pruned = exp_cache->get_prunes();
         stream_base_stats.expected_overflows = exp_cache->get_overflows();
+        stream_base_stats.expected_expired = exp_cache->get_expired();
+        stream_base_stats.expected_cross_thread = exp_cache->get_cross_thread();
     }
 
     sum_stats((PegCount*)&g_stats, (PegCount*)&stream_base_stats,
@@ -192,7 +200,7 @@ void StreamBase::tinit()
         flow_con->init_proto(PktType::FILE, f);
 
     if ( config.flow_cache_cfg.max_flows > 0 )
-        flow_con->init_exp(config.flow_cache_cfg.max_flows);
+        flow_con->init_exp(config.flow_cache_cfg.max_flows, config.flow_cache_cfg.shared_expect);
 
 #ifdef REG_TEST
     FlushBucket::set(config.footprint);
@@ -211,6 +219,16 @@ void StreamBase::show(SnortConfig*)
 {
     LogMessage("    Max flows: %d\n", config.flow_cache_cfg.max_flows);
     LogMessage("    Pruning timeout: %d\n", config.flow_cache_cfg.pruning_timeout);
+
+    const ElephantConfig& ec = config.flow_cache_cfg.elephant;
+
+    if ( ec.enabled() )
+    {
+        LogMessage("    Elephant min bytes: %" PRIu64 "\n", ec.min_bytes);
+        LogMessage("    Elephant min rate: %u\n", ec.min_rate);
+        LogMessage("    Elephant min age: %u\n", ec.min_age);
+        LogMessage("    Elephant require service: %s\n", ec.require_service ? "yes" : "no");
+    }
 }
 
 void StreamBase::eval(Packet* p)
@@ -276,6 +294,10 @@ void StreamBase::eval(Packet* p)
     case PktType::MAX:
         break;
     }
+
+    // decided here so any flush it does is inspected and acted on with
+    // this packet; the verdict then just sees both directions ignored
+    Stream::offload_elephant(p);
 }
 
 //-------------------------------------------------------------------------
@@ -58,6 +58,23 @@ FLOW_TYPE_PARAMS(udp_params, "180", "128");
 FLOW_TYPE_PARAMS(user_params,"180", "256");
 FLOW_TYPE_PARAMS(file_params, "180", "32");
 
+static const Parameter elephant_params[] =
+{
+    { "min_bytes", Parameter::PT_INT, "0:max53", "0",
+      "offload flows with at least this many bytes in both directions (0 disables)" },
+
+    { "min_rate", Parameter::PT_INT, "0:max32", "0",
+      "offload flows with at least this many bytes per second" },
+
+    { "min_age", Parameter::PT_INT, "0:max32", "0",
+      "offload flows at least this many seconds old" },
+
+    { "require_service", Parameter::PT_BOOL, nullptr, "true",
+      "offload only flows with an identified service" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 #define FLOW_TYPE_TABLE(flow_type, proto, params) \
     { flow_type, Parameter::PT_TABLE, params, nullptr, \
       "configure " proto " cache limits" }
@@ -78,6 +95,12 @@ static const Parameter s_params[] =
     { "pruning_timeout", Parameter::PT_INT, "1:max32", "30",
                     "minimum inactive time before being eligible for pruning" },
 
+    { "shared_expect", Parameter::PT_BOOL, nullptr, "false",
+                    "share expected flows so they can be realized on any packet thread" },
+
+    { "elephant", Parameter::PT_TABLE, elephant_params, nullptr,
+      "whitelist bulk flows once inspection is done with them" },
+
     FLOW_TYPE_TABLE("ip_cache",   "ip",   ip_params),
     FLOW_TYPE_TABLE("icmp_cache", "icmp", icmp_params),
     FLOW_TYPE_TABLE("tcp_cache",  "tcp",  tcp_params),
@@ -156,6 +179,28 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
         config.flow_cache_cfg.pruning_timeout = v.get_uint32();
         return true;
     }
+    else if ( v.is("shared_expect") )
+    {
+        config.flow_cache_cfg.shared_expect = v.get_bool();
+        return true;
+    }
+    else if ( strstr(fqn, "elephant") )
+    {
+        ElephantConfig& ec = config.flow_cache_cfg.elephant;
+
+        if ( v.is("min_bytes") )
+            ec.min_bytes = v.get_uint64();
+        else if ( v.is("min_rate") )
+            ec.min_rate = v.get_uint32();
+        else if ( v.is("min_age") )
+            ec.min_age = v.get_uint32();
+        else if ( v.is("require_service") )
+            ec.require_service = v.get_bool();
+        else
+            return false;
+
+        return true;
+    }
     else if ( strstr(fqn, "ip_cache") )
         type = PktType::IP;
     else if ( strstr(fqn, "icmp_cache") )
@@ -216,6 +261,11 @@ bool StreamReloadResourceManager::initialize(const StreamModuleConfig& config_)
         return false;
     }
 #endif
+    if ( config.flow_cache_cfg.shared_expect != config_.flow_cache_cfg.shared_expect )
+    {
+        ReloadError("Changing of stream.shared_expect requires a restart\n");
+        return false;
+    }
     config = config_;
     return true;
 }
@@ -235,6 +285,11 @@ bool StreamReloadResourceManager::tinit()
         return true;
     }
 
+    // the elephant criteria apply to new packets right away
+    FlowCacheConfig cfg = flow_con->get_flow_cache_config();
+    cfg.elephant = config.flow_cache_cfg.elephant;
+    flow_con->set_flow_cache_config(cfg);
+
     return false;
 }
 
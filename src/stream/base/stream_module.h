@@ -58,6 +58,8 @@ struct BaseStats
      PegCount expected_realized;
      PegCount expected_pruned;
      PegCount expected_overflows;
+     PegCount expected_expired;
+     PegCount expected_cross_thread;
      PegCount reload_tuning_idle;
      PegCount reload_tuning_packets;
      PegCount reload_total_adds;
@@ -66,6 +68,8 @@ struct BaseStats
      PegCount reload_allowed_flow_deletes;
      PegCount reload_blocked_flow_deletes;
      PegCount reload_offloaded_flow_deletes;
+     PegCount elephant_flows;
+     PegCount elephant_inspected_bytes;
 };
 
 extern const PegInfo base_pegs[];
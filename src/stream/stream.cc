@@ -26,6 +26,7 @@
 #include <cassert>
 
 #include "detection/detection_engine.h"
+#include "file_api/file_flows.h"
 #include "flow/flow_control.h"
 #include "flow/flow_key.h"
 #include "flow/ha.h"
@@ -246,6 +247,65 @@ void Stream::stop_inspection(
     flow->set_state(Flow::FlowState::ALLOW);
 }
 
+static bool is_elephant(const ElephantConfig& ec, Flow* flow, time_t now)
+{
+    const FlowStats& fs = flow->flowstats;
+    uint64_t bytes = fs.client_bytes + fs.server_bytes;
+
+    if ( bytes < ec.min_bytes or fs.byte_rate < ec.min_rate )
+        return false;
+
+    if ( now - fs.start_time.tv_sec < (time_t)ec.min_age )
+        return false;
+
+    if ( ec.require_service and !flow->service )
+        return false;
+
+    // detection still pending on an offload thread
+    if ( flow->is_suspended() )
+        return false;
+
+    FileFlows* files = (FileFlows*)flow->get_flow_data(FileFlows::file_flow_data_id);
+
+    if ( files and files->has_pending_file() )
+        return false;
+
+    return true;
+}
+
+bool Stream::offload_elephant(Packet* p)
+{
+    Flow* flow = p->flow;
+
+    if ( !flow or !flow_con or p->is_cooked() or flow->flow_state != Flow::FlowState::INSPECT )
+        return false;
+
+    const ElephantConfig& ec = flow_con->get_flow_cache_config().elephant;
+
+    if ( !ec.enabled() or !is_elephant(ec, flow, p->pkth->ts.tv_sec) )
+        return false;
+
+    // inspect anything still queued for reassembly before handing off the
+    // flow, same as stop_inspection(); that may change the flow's state
+    if ( flow->pkt_type == PktType::TCP and flow->session )
+    {
+        flow->session->flush_client(p);
+        flow->session->flush_server(p);
+
+        if ( flow->flow_state != Flow::FlowState::INSPECT or p->active->packet_was_dropped() )
+            return false;
+    }
+
+    flow->ssn_state.ignore_direction = SSN_DIR_BOTH;
+    flow->set_state(Flow::FlowState::ALLOW);
+
+    const FlowStats& fs = flow->flowstats;
+    stream_base_stats.elephant_flows++;
+    stream_base_stats.elephant_inspected_bytes += fs.client_bytes + fs.server_bytes;
+
+    return true;
+}
+
 void Stream::resume_inspection(Flow* flow, char dir)
 {
     if (!flow)
@@ -793,6 +853,7 @@ void Stream::set_no_ack_mode(Flow* flow, bool on_off)
 #ifdef UNIT_TEST
 
 #include "catch/snort_catch.h"
+#include "detection/ips_context.h"
 #include "tcp/test/stream_tcp_test_utils.h"
 
 TEST_CASE("Stream API", "[stream_api][stream]")
@@ -910,5 +971,96 @@ TEST_CASE("Stream API", "[stream_api][stream]")
     delete flow;
 }
 
+TEST_CASE("elephant criteria", "[stream]")
+{
+    Flow* flow = new Flow;
+    FlowStats& fs = flow->flowstats;
+
+    ElephantConfig ec;
+    ec.min_bytes = 1000;
+    ec.min_rate = 100;
+    ec.min_age = 10;
+
+    fs.client_bytes = 600;
+    fs.server_bytes = 400;
+    fs.byte_rate = 100;
+    fs.start_time.tv_sec = 100;
+    flow->service = "http";
+
+    CHECK(is_elephant(ec, flow, 110));
+
+    SECTION("min_bytes")
+    {
+        fs.server_bytes--;
+        CHECK(!is_elephant(ec, flow, 110));
+    }
+
+    SECTION("min_rate")
+    {
+        fs.byte_rate--;
+        CHECK(!is_elephant(ec, flow, 110));
+    }
+
+    SECTION("min_age")
+    {
+        CHECK(!is_elephant(ec, flow, 109));
+    }
+
+    SECTION("require_service")
+    {
+        flow->service = nullptr;
+        CHECK(!is_elephant(ec, flow, 110));
+
+        ec.require_service = false;
+        CHECK(is_elephant(ec, flow, 110));
+    }
+
+    SECTION("suspended")
+    {
+        IpsContext c;
+        flow->context_chain.push_back(&c);
+        CHECK(!is_elephant(ec, flow, 110));
+
+        flow->context_chain.abort();
+        CHECK(is_elephant(ec, flow, 110));
+    }
+
+    SECTION("pending file")
+    {
+        FileFlows* files = new FileFlows(flow, nullptr);
+        flow->set_flow_data(files);
+        CHECK(is_elephant(ec, flow, 110));
+
+        files->add_pending_file(1);
+        CHECK(!is_elephant(ec, flow, 110));
+    }
+
+    delete flow;
+}
+
+TEST_CASE("flow byte rate", "[stream]")
+{
+    FlowStats fs;
+    memset(&fs, 0, sizeof(fs));
+
+    // the first window has no rate until it ends
+    fs.update_rate(100, 500);
+    fs.update_rate(100, 700);
+    CHECK(fs.byte_rate == 0);
+
+    fs.update_rate(101, 100);
+    CHECK(fs.byte_rate == 1200);
+    CHECK(fs.window_bytes == 100);
+
+    // a gap spreads the last window over the idle seconds
+    fs.update_rate(105, 100);
+    CHECK(fs.byte_rate == 25);
+
+    // earlier timestamps stay in the current window
+    fs.update_rate(104, 300);
+    CHECK(fs.window_start == 105);
+    CHECK(fs.window_bytes == 400);
+}
+
 #endif
 
@@ -106,6 +106,11 @@ public:
     // FIXIT-L stop_inspection() does not currently support the bytes/response parameters
     static void stop_inspection(Flow*, Packet*, char dir, int32_t bytes, int rspFlag);
 
+    // Called by stream for each wire packet.  If the flow meets the stream.elephant criteria,
+    // flush and inspect any queued data, then ignore both directions and return true so the
+    // packet's verdict whitelists the flow.  Nothing changes if the flush blocks or drops.
+    static bool offload_elephant(Packet*);
+
     // Adds entry to the expected session cache with a flow key generated from the network
     // n-tuple parameters specified.  Inspection will be turned off for this expected session
     // when it arrives.
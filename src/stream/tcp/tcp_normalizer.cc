@@ -26,6 +26,7 @@
 #include "tcp_normalizer.h"
 
 #include "packet_io/active.h"
+#include "protocols/packet_manager.h"
 
 #include "tcp_stream_session.h"
 #include "tcp_stream_tracker.h"
@@ -83,8 +84,12 @@ bool TcpNormalizer::strip_tcp_timestamp(
     if (mode == NORM_MODE_ON)
     {
         // set raw option bytes to nops
-        memset((void*)opt, (uint32_t)tcp::TcpOptCode::NOP, tcp::TCPOLEN_TIMESTAMP);
-        tsd.get_pkt()->packet_flags |= PKT_MODIFIED;
+        uint8_t* start = (uint8_t*)opt;
+        uint8_t old[tcp::TCPOLEN_TIMESTAMP];
+        memcpy(old, start, sizeof(old));
+
+        memset(start, (uint32_t)tcp::TcpOptCode::NOP, tcp::TCPOLEN_TIMESTAMP);
+        PacketManager::encode_rewrite(tsd.get_pkt(), start, old, sizeof(old));
         return true;
     }
 
@@ -155,8 +160,11 @@ void TcpNormalizer::ecn_stripper(
     {
         if (tns.strip_ecn == NORM_MODE_ON)
         {
-            (const_cast<tcp::TCPHdr*>(p->ptrs.tcph))->th_flags &= ~(TH_ECE | TH_CWR);
-            p->packet_flags |= PKT_MODIFIED;
+            uint8_t* flags = &(const_cast<tcp::TCPHdr*>(p->ptrs.tcph))->th_flags;
+            const uint8_t old = *flags;
+
+            *flags &= ~(TH_ECE | TH_CWR);
+            PacketManager::encode_rewrite(p, flags, &old, sizeof(old));
         }
 
         tcp_norm_stats[PC_TCP_ECN_SSN][tns.strip_ecn]++;
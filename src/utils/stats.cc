@@ -201,6 +201,8 @@ const PegInfo pc_names[] =
     { CountType::SUM, "pcre_match_limit", "total number of times pcre hit the match limit" },
     { CountType::SUM, "pcre_recursion_limit", "total number of times pcre hit the recursion limit" },
     { CountType::SUM, "pcre_error", "total number of times pcre returns error" },
+    { CountType::SUM, "pcre_prefilter_rejects", "total number of times the hyperscan prefilter "
+      "ruled out a pcre match" },
     { CountType::END, nullptr, nullptr }
 };
 
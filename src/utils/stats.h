@@ -63,6 +63,7 @@ struct PacketCount
     PegCount pcre_match_limit;
     PegCount pcre_recursion_limit;
     PegCount pcre_error;
+    PegCount pcre_prefilter_rejects;
 };
 
 struct ProcessCount
@@ -0,0 +1,127 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// util_unfold_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "utils/util_unfold.h"
+
+using namespace snort;
+
+// straightforward versions of the stripping functions to check against
+static std::string strip_crlf(const std::string& in, uint32_t max)
+{
+    std::string out;
+
+    for ( char c : in )
+    {
+        if ( out.size() >= max )
+            break;
+
+        if ( c != '\r' and c != '\n' )
+            out += c;
+    }
+    return out;
+}
+
+static std::string strip_lws(const std::string& in, uint32_t max)
+{
+    std::string out;
+    bool lws = false;
+
+    for ( char c : in )
+    {
+        if ( out.size() >= max )
+            break;
+
+        if ( c != '\r' and c != '\n' )
+            lws = (c == ' ' or c == '\t');
+
+        else if ( lws )
+        {
+            lws = false;
+            while ( !out.empty() and (out.back() == ' ' or out.back() == '\t') )
+                out.pop_back();
+        }
+        out += c;
+    }
+    return out;
+}
+
+static std::string make_text(unsigned len, unsigned seed)
+{
+    static const char* words[] = { "line of text", " ", "\t", "\r\n", "\n", "x", "  \r\n" };
+    std::string s;
+
+    while ( s.size() < len )
+    {
+        seed = seed * 1103515245 + 12345;
+        s += words[(seed >> 16) % (sizeof(words) / sizeof(*words))];
+    }
+    s.resize(len);
+    return s;
+}
+
+TEST_CASE("strip CRLF", "[util_unfold]")
+{
+    for ( unsigned len : { 0, 5, 16, 17, 40, 100, 1000 } )
+    {
+        for ( unsigned seed = 1; seed < 20; ++seed )
+        {
+            std::string in = make_text(len, seed);
+
+            for ( uint32_t max : { 7u, len / 2 + 1, len + 1 } )
+            {
+                std::vector<uint8_t> out(max);
+                uint32_t n = 0;
+
+                CHECK(sf_strip_CRLF((const uint8_t*)in.data(), in.size(), out.data(), max, &n)
+                    == 0);
+                CHECK(std::string((char*)out.data(), n) == strip_crlf(in, max));
+            }
+        }
+    }
+}
+
+TEST_CASE("strip LWS", "[util_unfold]")
+{
+    for ( unsigned len : { 0, 5, 16, 17, 40, 100, 1000 } )
+    {
+        for ( unsigned seed = 1; seed < 20; ++seed )
+        {
+            std::string in = make_text(len, seed);
+
+            for ( uint32_t max : { 7u, len / 2 + 1, len + 1 } )
+            {
+                std::vector<uint8_t> out(max);
+                uint32_t n = 0;
+
+                CHECK(sf_strip_LWS((const uint8_t*)in.data(), in.size(), out.data(), max, &n)
+                    == 0);
+                CHECK(std::string((char*)out.data(), n) == strip_lws(in, max));
+            }
+        }
+    }
+}
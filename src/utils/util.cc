@@ -116,7 +116,11 @@ int DisplayBanner()
     LogMessage("           Using %s\n", SSLeay_version(SSLEAY_VERSION));
     LogMessage("           Using %s\n", pcap_lib_version());
     LogMessage("           Using PCRE version %s\n", pcre_version());
+#ifdef HAVE_ZLIB_NG
+    LogMessage("           Using zlib-ng version %s\n", zlibng_version());
+#else
     LogMessage("           Using ZLIB version %s\n", zlib_version);
+#endif
 #ifdef HAVE_FLATBUFFERS
     LogMessage("           Using %s\n", flatbuffers::flatbuffer_version_string);
 #endif
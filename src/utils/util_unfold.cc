@@ -24,6 +24,52 @@
 
 #include "util_unfold.h"
 
+#include <cstring>
+
+#include "cpu_features.h"
+
+#ifdef HAVE_X86_SIMD
+#include <emmintrin.h>
+#endif
+
+// returns the length of the leading run of bytes that are neither CR nor LF.
+// only full 16 byte blocks are scanned; the caller handles the remainder.
+typedef uint32_t (*SpanFunc)(const uint8_t*, uint32_t);
+
+#ifdef HAVE_X86_SIMD
+SIMD_TARGET("sse2")
+static uint32_t span_no_crlf_sse2(const uint8_t* buf, uint32_t len)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    uint32_t n = 0;
+
+    while ( len - n >= 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(buf + n));
+        __m128i eol = _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf));
+        unsigned mask = _mm_movemask_epi8(eol);
+
+        if ( mask )
+            return n + __builtin_ctz(mask);
+
+        n += 16;
+    }
+    return n;
+}
+#endif
+
+static SpanFunc get_span_no_crlf()
+{
+#ifdef HAVE_X86_SIMD
+    if ( snort::cpu_has_sse2() )
+        return span_no_crlf_sse2;
+#endif
+    return nullptr;
+}
+
+static const SpanFunc span_no_crlf = get_span_no_crlf();
+
 namespace snort
 {
 /* Given a string, removes header folding (\r\n followed by linear whitespace)
@@ -120,6 +166,20 @@ int sf_strip_CRLF(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
+        if (span_no_crlf)
+        {
+            uint32_t avail = endofinbuf - cursor;
+            uint32_t run = span_no_crlf(cursor, (avail < outbuf_size - n) ? avail : outbuf_size - n);
+
+            if (run)
+            {
+                memcpy(outbuf_ptr, cursor, run);
+                outbuf_ptr += run;
+                cursor += run;
+                n += run;
+                continue;
+            }
+        }
         if ((*cursor != '\n') && (*cursor != '\r'))
         {
             *outbuf_ptr++ = *cursor;
@@ -154,6 +214,21 @@ int sf_strip_LWS(const uint8_t* inbuf, uint32_t inbuf_size, uint8_t* outbuf,
     outbuf_ptr = outbuf;
     while ((cursor < endofinbuf) && (n < outbuf_size))
     {
+        if (span_no_crlf)
+        {
+            uint32_t avail = endofinbuf - cursor;
+            uint32_t run = span_no_crlf(cursor, (avail < outbuf_size - n) ? avail : outbuf_size - n);
+
+            if (run)
+            {
+                memcpy(outbuf_ptr, cursor, run);
+                outbuf_ptr += run;
+                cursor += run;
+                n += run;
+                lws = (cursor[-1] == ' ') || (cursor[-1] == '\t');
+                continue;
+            }
+        }
         if ((*cursor != '\n') && (*cursor != '\r'))
         {
             if ((*cursor != ' ') && (*cursor != '\t'))
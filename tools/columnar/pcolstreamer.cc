@@ -0,0 +1,233 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2020-2020 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// pcolstreamer.cc
+
+//  This program is a simple utility for reading the columnar perf_monitor
+//  files Snort generates.  The file is mapped into memory and the records
+//  in the requested time range are converted into a YAML array for further
+//  data processing.  The index at the end of the file, if present, is used
+//  to skip directly to the first record of interest.
+
+#include <fcntl.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <iostream>
+
+#include "src/network_inspectors/perf_monitor/columnar_format.h"
+
+#define OPT_INFILE     0x1
+#define OPT_BEFORE     0x2
+#define OPT_AFTER      0x4
+#define OPT_SCHEMA     0x8
+
+using namespace std;
+
+static string in_file;
+static uint64_t b_stamp = 0, a_stamp = 0;
+static uint8_t opt_flags = 0;
+static vector<string> fields;
+
+static void help()
+{
+    cout << "Columnar Perf Monitor Streamer for Snort 3\n\n"
+         << "Records are output as YAML objects with timestamp and field values\n\n"
+         << "Usage: pcolstreamer -i file [-b time] [-a time] [-f prefix]... [-s]\n"
+         << "-i: columnar records file from Snort (required)\n"
+         << "-b: Stream all records before or equal to this timestamp\n"
+         << "-a: Stream all records after or equal to this timestamp\n"
+         << "-f: Only output fields starting with this prefix (repeatable)\n"
+         << "-s: Output the schema only\n";
+}
+
+static int error(const string& e)
+{
+    cerr << "{ error: \"" << e << "\" }\n";
+    cout << "]\n";
+    return -1;
+}
+
+static bool handle_options(int argc, char* argv[])
+{
+    int opt;
+    while( (opt = getopt(argc, argv, "i:b:a:f:s")) != -1 )
+    {
+        switch(opt)
+        {
+            case 'i':
+                in_file = optarg;
+                opt_flags |= OPT_INFILE;
+                break;
+
+            case 'b':
+                b_stamp = strtoull(optarg, nullptr, 10);
+                opt_flags |= OPT_BEFORE;
+                break;
+
+            case 'a':
+                a_stamp = strtoull(optarg, nullptr, 10);
+                opt_flags |= OPT_AFTER;
+                break;
+
+            case 'f':
+                fields.emplace_back(optarg);
+                break;
+
+            case 's':
+                opt_flags |= OPT_SCHEMA;
+                break;
+
+            default:
+                help();
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool selected(const string& name)
+{
+    if( fields.empty() )
+        return true;
+
+    for( const auto& f : fields )
+        if( !name.compare(0, f.size(), f) )
+            return true;
+
+    return false;
+}
+
+static void print_record(uint64_t timestamp, const vector<columnar::Column>& cols,
+    const vector<bool>& mask)
+{
+    cout << "{ timestamp: " << timestamp;
+
+    for( unsigned i = 0; i < cols.size(); i++ )
+    {
+        if( !mask[i] )
+            continue;
+
+        const columnar::Column& c = cols[i];
+        cout << ", \"" << c.name << "\": ";
+
+        switch( c.type )
+        {
+            case columnar::CT_PEG:
+                cout << c.peg;
+                break;
+
+            case columnar::CT_STRING:
+                cout << "\"" << c.str << "\"";
+                break;
+
+            case columnar::CT_INDEXED:
+            {
+                cout << "{";
+                bool first = true;
+
+                for( unsigned j = 0; j < c.vec.size(); j++ )
+                {
+                    if( !c.vec[j] )
+                        continue;
+
+                    cout << (first ? " " : ", ") << j << ": " << c.vec[j];
+                    first = false;
+                }
+                cout << " }";
+                break;
+            }
+        }
+    }
+    cout << " },\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if( !handle_options(argc, argv) )
+        return 1;
+
+    cout << "[\n";
+
+    if( !(opt_flags & OPT_INFILE) )
+        return error("-i is required");
+
+    int fd = open(in_file.c_str(), O_RDONLY);
+    if( fd < 0 )
+        return error("Unable to open file");
+
+    struct stat st;
+    if( fstat(fd, &st) or !st.st_size )
+    {
+        close(fd);
+        return error("Unable to read file");
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if( map == MAP_FAILED )
+        return error("Unable to map file");
+
+    columnar::Reader reader;
+
+    if( !reader.open((const uint8_t*)map, st.st_size) )
+    {
+        munmap(map, st.st_size);
+        return error("Unknown file format");
+    }
+
+    const auto& cols = reader.get_columns();
+    vector<bool> mask;
+
+    for( const auto& c : cols )
+        mask.push_back(selected(c.name));
+
+    if( opt_flags & OPT_SCHEMA )
+    {
+        for( unsigned i = 0; i < cols.size(); i++ )
+            if( mask[i] )
+                cout << "{ name: \"" << cols[i].name << "\", type: "
+                     << columnar::get_type_name(cols[i].type) << " },\n";
+    }
+    else
+    {
+        if( opt_flags & OPT_AFTER )
+            reader.seek(a_stamp);
+
+        uint64_t timestamp;
+
+        while( reader.next(timestamp) )
+        {
+            if( (opt_flags & OPT_BEFORE) && timestamp > b_stamp )
+                break;
+
+            if( (opt_flags & OPT_AFTER) && timestamp < a_stamp )
+                continue;
+
+            print_record(timestamp, cols, mask);
+        }
+    }
+
+    munmap(map, st.st_size);
+    cout << "{ status: \"done\" }\n]\n";
+    return 0;
+}
+